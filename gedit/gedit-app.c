@@ -49,6 +49,7 @@
 #include "gedit-plugins-engine.h"
 #include "gedit-commands.h"
 #include "gedit-preferences-dialog.h"
+#include "gedit-remote.h"
 #include "gedit-tab.h"
 #include "gedit-tab-private.h"
 
@@ -85,12 +86,17 @@ typedef struct
 	/* command line parsing */
 	gboolean new_window;
 	gboolean new_document;
+	gboolean follow;
 	const GtkSourceEncoding *encoding;
 	GInputStream *stdin_stream;
 	GSList *file_list;
 	gint line_position;
 	gint column_position;
-	GApplicationCommandLine *command_line;
+	GObject *wait_object;
+
+	/* org.gnome.gedit.Remote */
+	guint remote_registration_id;
+	gboolean remote_published;
 } GeditAppPrivate;
 
 enum
@@ -138,6 +144,13 @@ static const GOptionEntry options[] =
 		NULL
 	},
 
+	/* Follow the files and stdin */
+	{
+		"follow", 'f', 0, G_OPTION_ARG_NONE, NULL,
+		N_("Append to the documents what is written to the files or to stdin, like \"tail -f\""),
+		NULL
+	},
+
 	/* Wait for closing documents */
 	{
 		"wait", 'w', 0, G_OPTION_ARG_NONE, NULL,
@@ -385,6 +398,10 @@ get_active_window (GtkApplication *app)
 	return NULL;
 }
 
+/* The wait object is either the GApplicationCommandLine of a "gedit --wait"
+ * invocation or the object holding the pending org.gnome.gedit.Remote call:
+ * the caller is released when the last tab referencing it is destroyed.
+ */
 static void
 set_command_line_wait (GeditApp *app,
 		       GeditTab *tab)
@@ -395,7 +412,7 @@ set_command_line_wait (GeditApp *app,
 
 	g_object_set_data_full (G_OBJECT (tab),
 	                        "GeditTabCommandLineWait",
-	                        g_object_ref (priv->command_line),
+	                        g_object_ref (priv->wait_object),
 	                        (GDestroyNotify)g_object_unref);
 }
 
@@ -408,16 +425,23 @@ set_command_line_wait_doc (GeditDocument *doc,
 	set_command_line_wait (app, tab);
 }
 
+static void
+set_follow_doc (GeditDocument *doc)
+{
+	_gedit_tab_set_follow (gedit_tab_get_from_document (doc), TRUE);
+}
+
 static void
 open_files (GApplication            *application,
 	    gboolean                 new_window,
 	    gboolean                 new_document,
+	    gboolean                 follow,
 	    gint                     line_position,
 	    gint                     column_position,
 	    const GtkSourceEncoding *encoding,
 	    GInputStream            *stdin_stream,
 	    GSList                  *file_list,
-	    GApplicationCommandLine *command_line)
+	    GObject                 *wait_object)
 {
 	GeditWindow *window = NULL;
 	GeditTab *tab;
@@ -437,7 +461,21 @@ open_files (GApplication            *application,
 		gtk_widget_show (GTK_WIDGET (window));
 	}
 
-	if (stdin_stream)
+	if (stdin_stream && follow)
+	{
+		gedit_debug_message (DEBUG_APP, "Follow stdin");
+
+		tab = gedit_window_create_tab (window, TRUE);
+		_gedit_tab_follow_stream (tab, stdin_stream, encoding);
+		doc_created = TRUE;
+
+		if (wait_object)
+		{
+			set_command_line_wait (GEDIT_APP (application),
+					       tab);
+		}
+	}
+	else if (stdin_stream)
 	{
 		gedit_debug_message (DEBUG_APP, "Load stdin");
 
@@ -449,7 +487,7 @@ open_files (GApplication            *application,
 		                                           TRUE);
 		doc_created = tab != NULL;
 
-		if (doc_created && command_line)
+		if (doc_created && wait_object)
 		{
 			set_command_line_wait (GEDIT_APP (application),
 					       tab);
@@ -470,10 +508,15 @@ open_files (GApplication            *application,
 
 		doc_created = doc_created || loaded != NULL;
 
-		if (command_line)
+		if (wait_object)
 		{
 			g_slist_foreach (loaded, (GFunc)set_command_line_wait_doc, GEDIT_APP (application));
 		}
+
+		if (follow)
+		{
+			g_slist_foreach (loaded, (GFunc)set_follow_doc, NULL);
+		}
 		g_slist_free (loaded);
 	}
 
@@ -482,7 +525,7 @@ open_files (GApplication            *application,
 		gedit_debug_message (DEBUG_APP, "Create tab");
 		tab = gedit_window_create_tab (window, TRUE);
 
-		if (command_line)
+		if (wait_object)
 		{
 			set_command_line_wait (GEDIT_APP (application),
 					       tab);
@@ -772,6 +815,14 @@ gedit_app_startup (GApplication *application)
 	gedit_debug_init ();
 	gedit_debug_message (DEBUG_APP, "Startup");
 
+	/* Only the primary instance runs startup, --standalone aside */
+	if (g_application_get_dbus_connection (application) != NULL &&
+	    (g_application_get_flags (application) & G_APPLICATION_NON_UNIQUE) == 0)
+	{
+		_gedit_remote_publish ();
+		priv->remote_published = TRUE;
+	}
+
 	setup_theme_extensions (GEDIT_APP (application));
 
 #ifndef ENABLE_GVFS_METADATA
@@ -884,12 +935,13 @@ gedit_app_activate (GApplication *application)
 	open_files (application,
 	            priv->new_window,
 	            priv->new_document,
+	            priv->follow,
 	            priv->line_position,
 	            priv->column_position,
 	            priv->encoding,
 	            priv->stdin_stream,
 	            priv->file_list,
-	            priv->command_line);
+	            priv->wait_object);
 }
 
 static void
@@ -904,11 +956,12 @@ clear_options (GeditApp *app)
 
 	priv->new_window = FALSE;
 	priv->new_document = FALSE;
+	priv->follow = FALSE;
 	priv->encoding = NULL;
 	priv->file_list = NULL;
 	priv->line_position = 0;
 	priv->column_position = 0;
-	priv->command_line = NULL;
+	priv->wait_object = NULL;
 }
 
 static void
@@ -951,10 +1004,11 @@ gedit_app_command_line (GApplication            *application,
 
 	g_variant_dict_lookup (options, "new-window", "b", &priv->new_window);
 	g_variant_dict_lookup (options, "new-document", "b", &priv->new_document);
+	g_variant_dict_lookup (options, "follow", "b", &priv->follow);
 
 	if (g_variant_dict_contains (options, "wait"))
 	{
-		priv->command_line = cl;
+		priv->wait_object = G_OBJECT (cl);
 	}
 
 	if (g_variant_dict_lookup (options, "encoding", "&s", &encoding_charset))
@@ -1089,6 +1143,7 @@ gedit_app_open (GApplication  *application,
 	file_list = g_slist_reverse (file_list);
 
 	open_files (application,
+	            FALSE,
 	            FALSE,
 	            FALSE,
 	            0,
@@ -1101,6 +1156,176 @@ gedit_app_open (GApplication  *application,
 	g_slist_free (file_list);
 }
 
+static void
+remote_wait_done (GDBusMethodInvocation *invocation)
+{
+	g_dbus_method_invocation_return_value (invocation, NULL);
+}
+
+/* The lean counterpart of gedit_app_command_line (), called by the client
+ * path in gedit-remote.c: the files are already resolved to uris and the
+ * options come in a plain dictionary.
+ */
+static void
+remote_open (GApplication          *application,
+             GVariant              *parameters,
+             GDBusMethodInvocation *invocation)
+{
+	GeditAppPrivate *priv;
+	GApplicationClass *app_class;
+	const gchar **uris;
+	GVariant *options_variant;
+	GVariant *platform_data;
+	GVariantDict options;
+	const gchar *encoding_charset;
+	gboolean wait = FALSE;
+	gint i;
+
+	priv = gedit_app_get_instance_private (GEDIT_APP (application));
+	app_class = G_APPLICATION_GET_CLASS (application);
+
+	g_variant_get (parameters, "(^a&s@a{sv}@a{sv})",
+	               &uris, &options_variant, &platform_data);
+	g_variant_dict_init (&options, options_variant);
+
+	if (g_variant_dict_lookup (&options, "encoding", "&s", &encoding_charset))
+	{
+		priv->encoding = gtk_source_encoding_get_from_charset (encoding_charset);
+
+		if (priv->encoding == NULL)
+		{
+			/* The client falls back to the regular command line,
+			 * which reports the error to the user.
+			 */
+			g_dbus_method_invocation_return_error (invocation,
+			                                       G_DBUS_ERROR,
+			                                       G_DBUS_ERROR_INVALID_ARGS,
+			                                       "%s: invalid encoding.",
+			                                       encoding_charset);
+			goto out;
+		}
+	}
+
+	g_variant_dict_lookup (&options, "new-window", "b", &priv->new_window);
+	g_variant_dict_lookup (&options, "new-document", "b", &priv->new_document);
+	g_variant_dict_lookup (&options, "follow", "b", &priv->follow);
+	g_variant_dict_lookup (&options, "line", "i", &priv->line_position);
+	g_variant_dict_lookup (&options, "column", "i", &priv->column_position);
+	g_variant_dict_lookup (&options, "wait", "b", &wait);
+
+	for (i = 0; uris[i] != NULL; i++)
+	{
+		priv->file_list = g_slist_prepend (priv->file_list,
+		                                   g_file_new_for_uri (uris[i]));
+	}
+
+	priv->file_list = g_slist_reverse (priv->file_list);
+
+	if (wait)
+	{
+		priv->wait_object = g_object_new (G_TYPE_OBJECT, NULL);
+		g_object_set_data_full (priv->wait_object,
+		                        "gedit-remote-invocation",
+		                        invocation,
+		                        (GDestroyNotify)remote_wait_done);
+	}
+
+	app_class->before_emit (application, platform_data);
+	g_application_activate (application);
+	app_class->after_emit (application, platform_data);
+
+	if (wait)
+	{
+		/* Answers the call right away if no tab was opened */
+		g_object_unref (priv->wait_object);
+	}
+	else
+	{
+		g_dbus_method_invocation_return_value (invocation, NULL);
+	}
+
+out:
+	clear_options (GEDIT_APP (application));
+	g_variant_dict_clear (&options);
+	g_variant_unref (options_variant);
+	g_variant_unref (platform_data);
+	g_free (uris);
+}
+
+static void
+remote_method_call (GDBusConnection       *connection,
+                    const gchar           *sender,
+                    const gchar           *object_path,
+                    const gchar           *interface_name,
+                    const gchar           *method_name,
+                    GVariant              *parameters,
+                    GDBusMethodInvocation *invocation,
+                    gpointer               user_data)
+{
+	if (g_strcmp0 (method_name, "Open") == 0)
+	{
+		remote_open (G_APPLICATION (user_data), parameters, invocation);
+	}
+}
+
+static const GDBusInterfaceVTable remote_vtable =
+{
+	remote_method_call,
+	NULL,
+	NULL
+};
+
+static gboolean
+gedit_app_dbus_register (GApplication     *application,
+                         GDBusConnection  *connection,
+                         const gchar      *object_path,
+                         GError          **error)
+{
+	GeditAppPrivate *priv;
+
+	priv = gedit_app_get_instance_private (GEDIT_APP (application));
+
+	if (!G_APPLICATION_CLASS (gedit_app_parent_class)->dbus_register (application,
+	                                                                   connection,
+	                                                                   object_path,
+	                                                                   error))
+	{
+		return FALSE;
+	}
+
+	priv->remote_registration_id =
+		g_dbus_connection_register_object (connection,
+		                                   object_path,
+		                                   _gedit_remote_get_interface_info (),
+		                                   &remote_vtable,
+		                                   application,
+		                                   NULL,
+		                                   error);
+
+	return priv->remote_registration_id != 0;
+}
+
+static void
+gedit_app_dbus_unregister (GApplication    *application,
+                           GDBusConnection *connection,
+                           const gchar     *object_path)
+{
+	GeditAppPrivate *priv;
+
+	priv = gedit_app_get_instance_private (GEDIT_APP (application));
+
+	if (priv->remote_registration_id != 0)
+	{
+		g_dbus_connection_unregister_object (connection,
+		                                     priv->remote_registration_id);
+		priv->remote_registration_id = 0;
+	}
+
+	G_APPLICATION_CLASS (gedit_app_parent_class)->dbus_unregister (application,
+	                                                               connection,
+	                                                               object_path);
+}
+
 static gboolean
 ensure_user_config_dir (void)
 {
@@ -1234,8 +1459,18 @@ save_print_settings (GeditApp *app)
 static void
 gedit_app_shutdown (GApplication *app)
 {
+	GeditAppPrivate *priv;
+
+	priv = gedit_app_get_instance_private (GEDIT_APP (app));
+
 	gedit_debug_message (DEBUG_APP, "Quitting\n");
 
+	if (priv->remote_published)
+	{
+		_gedit_remote_unpublish ();
+		priv->remote_published = FALSE;
+	}
+
 	/* Last window is gone... save some settings and exit */
 	ensure_user_config_dir ();
 
@@ -1308,6 +1543,8 @@ gedit_app_class_init (GeditAppClass *klass)
 	app_class->command_line = gedit_app_command_line;
 	app_class->handle_local_options = gedit_app_handle_local_options;
 	app_class->open = gedit_app_open;
+	app_class->dbus_register = gedit_app_dbus_register;
+	app_class->dbus_unregister = gedit_app_dbus_unregister;
 	app_class->shutdown = gedit_app_shutdown;
 
 	klass->show_help = gedit_app_show_help_impl;
@@ -0,0 +1,102 @@
+/*
+ * gedit-client.c
+ * This file is part of gedit
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* The gedit command, where the application is X11 based. "gedit FILE..."
+ * is mostly run while gedit is already running, and then only needs to
+ * hand the files over to it: this program only links gio, so that neither
+ * libgedit nor gtk are loaded for that. Otherwise it replaces itself with
+ * the application, installed in the private libexec directory, with the
+ * same arguments and the same process.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <errno.h>
+#include <locale.h>
+#include <libintl.h>
+#include <unistd.h>
+#include <gio/gio.h>
+
+#include "gedit-remote.h"
+
+#define GEDIT_APP_NAME "gedit-app"
+
+static gchar *
+get_app_path (void)
+{
+	gchar *exe;
+	gchar *path = NULL;
+
+	/* Next to the client in the build tree */
+	exe = g_file_read_link ("/proc/self/exe", NULL);
+
+	if (exe != NULL)
+	{
+		gchar *dirname;
+
+		dirname = g_path_get_dirname (exe);
+		path = g_build_filename (dirname, GEDIT_APP_NAME, NULL);
+
+		if (!g_file_test (path, G_FILE_TEST_IS_EXECUTABLE))
+		{
+			g_clear_pointer (&path, g_free);
+		}
+
+		g_free (dirname);
+		g_free (exe);
+	}
+
+	if (path == NULL)
+	{
+		path = g_build_filename (PKGLIBEXECDIR, GEDIT_APP_NAME, NULL);
+	}
+
+	return path;
+}
+
+int
+main (int argc, char *argv[])
+{
+	gint status;
+	gchar *app;
+
+	/* The errors of the forward are printed. The locale dir is the one
+	 * of gedit_dirs_init(), without the rest of it.
+	 */
+	setlocale (LC_ALL, "");
+	bindtextdomain (GETTEXT_PACKAGE, DATADIR "/locale");
+	bind_textdomain_codeset (GETTEXT_PACKAGE, "UTF-8");
+	textdomain (GETTEXT_PACKAGE);
+
+	if (_gedit_remote_forward (argc, argv, &status))
+	{
+		return status;
+	}
+
+	app = get_app_path ();
+	execv (app, argv);
+
+	g_printerr ("Cannot run %s: %s\n", app, g_strerror (errno));
+	g_free (app);
+
+	return 1;
+}
+
+/* ex:set ts=8 noet: */
@@ -1000,8 +1000,10 @@ gedit_commands_save_document_async (GeditDocument       *document,
 	tab = gedit_tab_get_from_document (document);
 	file = gedit_document_get_file (document);
 
+	/* A document trimmed while following only holds the end of its file */
 	if (gedit_document_is_untitled (document) ||
-	    gtk_source_file_is_readonly (file))
+	    gtk_source_file_is_readonly (file) ||
+	    _gedit_tab_get_trimmed (tab))
 	{
 		gedit_debug_message (DEBUG_COMMANDS, "Untitled or Readonly");
 
@@ -1296,7 +1298,8 @@ save_documents_list (GeditWindow *window,
 				/* FIXME: manage the case of local readonly files owned by the
 				   user is running gedit - Paolo (Dec. 8, 2005) */
 				if (gedit_document_is_untitled (doc) ||
-				    gtk_source_file_is_readonly (file))
+				    gtk_source_file_is_readonly (file) ||
+				    _gedit_tab_get_trimmed (tab))
 				{
 					if (data == NULL)
 					{
@@ -1740,7 +1743,8 @@ save_and_close_documents (GList         *docs,
 				/* FIXME: manage the case of local readonly files owned by the
 				 * user is running gedit - Paolo (Dec. 8, 2005) */
 				if (gedit_document_is_untitled (doc) ||
-				    gtk_source_file_is_readonly (file))
+				    gtk_source_file_is_readonly (file) ||
+				    _gedit_tab_get_trimmed (tab))
 				{
 					if (data == NULL)
 					{
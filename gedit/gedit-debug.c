@@ -104,6 +104,10 @@ gedit_debug_init (void)
 	{
 		enabled_sections |= GEDIT_DEBUG_METADATA;
 	}
+	if (g_getenv ("GEDIT_DEBUG_MESSAGE_BUS") != NULL)
+	{
+		enabled_sections |= GEDIT_DEBUG_MESSAGE_BUS;
+	}
 
 out:
 
@@ -115,6 +119,21 @@ out:
 #endif
 }
 
+/**
+ * gedit_debug_is_enabled:
+ * @section: debug section.
+ *
+ * Returns whether output is enabled for @section, for the debugging code
+ * that is too expensive to run otherwise.
+ *
+ * Return value: %TRUE if @section is enabled
+ */
+gboolean
+gedit_debug_is_enabled (GeditDebugSection section)
+{
+	return DEBUG_IS_ENABLED (section) != 0;
+}
+
 /**
  * gedit_debug:
  * @section: debug section.
@@ -49,6 +49,7 @@ typedef enum {
 	GEDIT_DEBUG_APP      = 1 << 8,
 	GEDIT_DEBUG_UTILS    = 1 << 9,
 	GEDIT_DEBUG_METADATA = 1 << 10,
+	GEDIT_DEBUG_MESSAGE_BUS = 1 << 11,
 } GeditDebugSection;
 
 #define	DEBUG_VIEW	GEDIT_DEBUG_VIEW,    __FILE__, __LINE__, G_STRFUNC
@@ -62,9 +63,12 @@ typedef enum {
 #define	DEBUG_APP	GEDIT_DEBUG_APP,     __FILE__, __LINE__, G_STRFUNC
 #define	DEBUG_UTILS	GEDIT_DEBUG_UTILS,   __FILE__, __LINE__, G_STRFUNC
 #define	DEBUG_METADATA	GEDIT_DEBUG_METADATA,__FILE__, __LINE__, G_STRFUNC
+#define	DEBUG_MESSAGE_BUS	GEDIT_DEBUG_MESSAGE_BUS,__FILE__, __LINE__, G_STRFUNC
 
 void gedit_debug_init (void);
 
+gboolean gedit_debug_is_enabled (GeditDebugSection section);
+
 void gedit_debug (GeditDebugSection  section,
 		  const gchar       *file,
 		  gint               line,
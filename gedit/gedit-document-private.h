@@ -49,6 +49,13 @@ void		 _gedit_document_set_create				(GeditDocument       *doc,
 
 gboolean	 _gedit_document_get_create				(GeditDocument       *doc);
 
+gboolean	 _gedit_document_get_has_long_lines			(GeditDocument       *doc);
+
+void		 _gedit_document_set_long_line_profile			(GeditDocument       *doc,
+									 gboolean             enabled);
+
+gboolean	 _gedit_document_get_long_line_profile			(GeditDocument       *doc);
+
 G_END_DECLS
 
 #endif /* GEDIT_DOCUMENT_PRIVATE_H */
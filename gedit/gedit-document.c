@@ -82,6 +82,12 @@ typedef struct
 	 * when opened from the command line).
 	 */
 	guint create : 1;
+
+	/* Set on load when a line exceeds the long-line-threshold setting. */
+	guint has_long_lines : 1;
+
+	/* Whether the expensive features are disabled for the document. */
+	guint long_line_profile : 1;
 } GeditDocumentPrivate;
 
 enum
@@ -829,6 +835,26 @@ on_readonly_changed (GtkSourceFile *file,
 	g_object_notify_by_pspec (G_OBJECT (doc), properties[PROP_READ_ONLY]);
 }
 
+static void
+bind_highlight_settings (GeditDocument *doc)
+{
+	GeditDocumentPrivate *priv;
+
+	priv = gedit_document_get_instance_private (doc);
+
+	g_settings_bind (priv->editor_settings,
+			 GEDIT_SETTINGS_SYNTAX_HIGHLIGHTING,
+			 doc,
+			 "highlight-syntax",
+			 G_SETTINGS_BIND_GET | G_SETTINGS_BIND_NO_SENSITIVITY);
+
+	g_settings_bind (priv->editor_settings,
+	                 GEDIT_SETTINGS_BRACKET_MATCHING,
+	                 doc,
+	                 "highlight-matching-brackets",
+	                 G_SETTINGS_BIND_GET | G_SETTINGS_BIND_NO_SENSITIVITY);
+}
+
 static void
 gedit_document_init (GeditDocument *doc)
 {
@@ -868,17 +894,7 @@ gedit_document_init (GeditDocument *doc)
 	                 "max-undo-levels",
 	                 G_SETTINGS_BIND_GET | G_SETTINGS_BIND_NO_SENSITIVITY);
 
-	g_settings_bind (priv->editor_settings,
-			 GEDIT_SETTINGS_SYNTAX_HIGHLIGHTING,
-			 doc,
-			 "highlight-syntax",
-			 G_SETTINGS_BIND_GET | G_SETTINGS_BIND_NO_SENSITIVITY);
-
-	g_settings_bind (priv->editor_settings,
-	                 GEDIT_SETTINGS_BRACKET_MATCHING,
-	                 doc,
-	                 "highlight-matching-brackets",
-	                 G_SETTINGS_BIND_GET | G_SETTINGS_BIND_NO_SENSITIVITY);
+	bind_highlight_settings (doc);
 
 	style_scheme = get_default_style_scheme (priv->editor_settings);
 	if (style_scheme != NULL)
@@ -1262,6 +1278,44 @@ loaded_query_info_cb (GFile         *location,
 	g_object_unref (doc);
 }
 
+/* Minified files can consist of a single line of several megabytes. Wrapping,
+ * highlighting and column computations all scale with the length of the line,
+ * so such documents get a reduced set of features, see
+ * _gedit_document_set_long_line_profile().
+ */
+static gboolean
+detect_long_lines (GeditDocument *doc)
+{
+	GeditDocumentPrivate *priv;
+	GtkTextBuffer *buffer = GTK_TEXT_BUFFER (doc);
+	GtkTextIter iter;
+	guint threshold;
+
+	priv = gedit_document_get_instance_private (doc);
+
+	threshold = g_settings_get_uint (priv->editor_settings,
+					 GEDIT_SETTINGS_LONG_LINE_THRESHOLD);
+
+	if (threshold == 0 ||
+	    (guint) gtk_text_buffer_get_char_count (buffer) <= threshold)
+	{
+		return FALSE;
+	}
+
+	gtk_text_buffer_get_start_iter (buffer, &iter);
+
+	do
+	{
+		if ((guint) gtk_text_iter_get_chars_in_line (&iter) > threshold)
+		{
+			return TRUE;
+		}
+	}
+	while (gtk_text_iter_forward_line (&iter));
+
+	return FALSE;
+}
+
 static void
 gedit_document_loaded_real (GeditDocument *doc)
 {
@@ -1282,6 +1336,8 @@ gedit_document_loaded_real (GeditDocument *doc)
 
 	g_get_current_time (&priv->time_of_last_save_or_load);
 
+	priv->has_long_lines = detect_long_lines (doc);
+
 	set_content_type (doc, NULL);
 
 	location = gtk_source_file_get_location (priv->file);
@@ -1988,4 +2044,64 @@ _gedit_document_get_create (GeditDocument *doc)
 	return priv->create;
 }
 
+gboolean
+_gedit_document_get_has_long_lines (GeditDocument *doc)
+{
+	GeditDocumentPrivate *priv;
+
+	g_return_val_if_fail (GEDIT_IS_DOCUMENT (doc), FALSE);
+
+	priv = gedit_document_get_instance_private (doc);
+
+	return priv->has_long_lines;
+}
+
+/* When enabled, syntax highlighting and bracket matching are turned off and
+ * no longer follow the settings, until the profile is disabled again.
+ */
+void
+_gedit_document_set_long_line_profile (GeditDocument *doc,
+				       gboolean       enabled)
+{
+	GeditDocumentPrivate *priv;
+
+	g_return_if_fail (GEDIT_IS_DOCUMENT (doc));
+
+	priv = gedit_document_get_instance_private (doc);
+
+	enabled = enabled != FALSE;
+
+	if (priv->long_line_profile == enabled)
+	{
+		return;
+	}
+
+	priv->long_line_profile = enabled;
+
+	if (enabled)
+	{
+		g_settings_unbind (doc, "highlight-syntax");
+		g_settings_unbind (doc, "highlight-matching-brackets");
+
+		gtk_source_buffer_set_highlight_syntax (GTK_SOURCE_BUFFER (doc), FALSE);
+		gtk_source_buffer_set_highlight_matching_brackets (GTK_SOURCE_BUFFER (doc), FALSE);
+	}
+	else
+	{
+		bind_highlight_settings (doc);
+	}
+}
+
+gboolean
+_gedit_document_get_long_line_profile (GeditDocument *doc)
+{
+	GeditDocumentPrivate *priv;
+
+	g_return_val_if_fail (GEDIT_IS_DOCUMENT (doc), FALSE);
+
+	priv = gedit_document_get_instance_private (doc);
+
+	return priv->long_line_profile;
+}
+
 /* ex:set ts=8 noet: */
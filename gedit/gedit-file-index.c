@@ -0,0 +1,2397 @@
+/*
+ * gedit-file-index.c
+ * This file is part of gedit
+ *
+ * gedit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gedit. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gedit-file-index.h"
+
+#include <string.h>
+
+#include "gedit-debug.h"
+#include "gedit-dirs.h"
+
+/**
+ * SECTION:gedit-file-index
+ * @short_description: background index of the files below directories
+ * @include: gedit/gedit-file-index.h
+ *
+ * #GeditFileIndex keeps the paths of the directories and text files
+ * below some root directories, so that they can be searched without
+ * enumerating the directories again.
+ *
+ * The roots are crawled breadth first from a thread. Hidden files are
+ * left out and links to directories are not followed. The shallowest
+ * directories are monitored to keep the index up to date, and the index
+ * is saved in the user cache dir, so that it is available at once the
+ * next time gedit is started, while the root is crawled again.
+ */
+
+/* Stop indexing huge trees rather than use up the memory. The index
+ * tells how deep it is complete.
+ */
+#define MAX_PATHS_PER_ROOT 100000
+
+/* Each monitor uses an inotify watch */
+#define MAX_MONITORS_PER_ROOT 256
+
+/* The roots used the least recently are dropped past this number */
+#define MAX_ROOTS 8
+
+/* Paths are handed to the main loop in batches, at most this often or
+ * when that many paths are waiting.
+ */
+#define CRAWL_BATCH_INTERVAL (200 * G_TIME_SPAN_MILLISECOND)
+#define CRAWL_BATCH_SIZE 2000
+
+/* Milliseconds to wait for more files to be created before crawling them */
+#define PENDING_CRAWL_DELAY 500
+
+/* A root is crawled again when it is added and its last crawl is older */
+#define RECRAWL_INTERVAL (10 * G_TIME_SPAN_MINUTE)
+
+/* Seconds before the changes are saved */
+#define SAVE_DELAY 10
+
+#define INDEX_DIR_NAME "file-index"
+#define INDEX_FILE_VERSION 1
+#define INDEX_FILE_FORMAT "(uua(sy))"
+
+#define CRAWL_ATTRIBUTES G_FILE_ATTRIBUTE_STANDARD_NAME "," \
+			 G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
+			 G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN "," \
+			 G_FILE_ATTRIBUTE_STANDARD_IS_BACKUP "," \
+			 G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE
+
+enum
+{
+	ENTRY_IS_DIR = 1 << 0,
+	ENTRY_REMOVED = 1 << 1,
+	ENTRY_IS_ASCII = 1 << 2
+};
+
+/* The strings of the entries. Queries running in threads keep a
+ * reference, the strings do not move when more are inserted.
+ */
+typedef struct
+{
+	GStringChunk *chunk;
+	gint ref_count;
+} IndexStrings;
+
+typedef struct
+{
+	/* Relative to the root, in the strings of the root. The key is
+	 * the path folded by fold_case(), it is the path itself when they
+	 * are the same.
+	 */
+	const gchar *path;
+	const gchar *key;
+
+	/* The serial of the last crawl which found the entry */
+	guint32 serial;
+
+	guint16 depth;
+	guint8 flags;
+} IndexEntry;
+
+typedef struct
+{
+	GeditFileIndex *index;
+	GFile *location;
+	gchar *filename;
+
+	IndexStrings *strings;
+	GArray *entries;
+	GHashTable *by_path;
+	guint n_removed;
+
+	/* A copy of the entries shared by the queries, until they change */
+	GArray *snapshot;
+
+	guint32 serial;
+	guint complete_depth;
+	gint64 crawl_time;
+	gint64 used_time;
+	gboolean crawling;
+	gboolean ready;
+	gboolean dirty;
+
+	GCancellable *cancellable;
+
+	/* path -> GFileMonitor */
+	GHashTable *monitors;
+
+	/* The paths created, waiting to be crawled */
+	GPtrArray *pending;
+	guint pending_id;
+} IndexRoot;
+
+struct _GeditFileIndex
+{
+	GObject parent_instance;
+
+	/* uri -> IndexRoot */
+	GHashTable *roots;
+
+	guint save_id;
+};
+
+/* Owned by the crawling thread */
+typedef struct
+{
+	IndexRoot *root;
+	GFile *location;
+	GCancellable *cancellable;
+
+	/* Where to load the saved index from first, if not NULL */
+	gchar *filename;
+
+	/* The paths to crawl, "" for the whole root */
+	gchar **starts;
+
+	GArray *batch;
+	gint64 last_flush;
+	guint n_paths;
+} CrawlJob;
+
+typedef struct
+{
+	gchar *path;
+	gchar *key;
+	guint8 flags;
+} FoundPath;
+
+/* Handed from the crawling thread to the main loop. The root may be gone
+ * by then, which the cancellable tells.
+ */
+typedef struct
+{
+	IndexRoot *root;
+	GCancellable *cancellable;
+	GArray *paths;
+
+	guint complete_depth;
+
+	guint from_file : 1;
+	guint last : 1;
+	guint full : 1;
+} CrawlBatch;
+
+enum
+{
+	ROOT_READY,
+	LAST_SIGNAL
+};
+
+static guint signals[LAST_SIGNAL];
+
+G_DEFINE_TYPE (GeditFileIndex, gedit_file_index, G_TYPE_OBJECT)
+
+static void root_add_pending (IndexRoot *root, gchar *path);
+static void schedule_save (GeditFileIndex *index);
+
+static gboolean
+content_type_is_text (const gchar *content_type)
+{
+#ifdef G_OS_WIN32
+	gchar *mime;
+	gboolean ret;
+#endif
+
+	if (content_type == NULL || g_content_type_is_unknown (content_type))
+	{
+		return TRUE;
+	}
+
+#ifndef G_OS_WIN32
+	return g_content_type_is_a (content_type, "text/plain");
+#else
+	if (g_content_type_is_a (content_type, "text"))
+	{
+		return TRUE;
+	}
+
+	mime = g_content_type_get_mime_type (content_type);
+	ret = g_strcmp0 (mime, "text/plain") == 0;
+	g_free (mime);
+
+	return ret;
+#endif
+}
+
+static IndexStrings *
+index_strings_new (void)
+{
+	IndexStrings *strings;
+
+	strings = g_slice_new (IndexStrings);
+	strings->chunk = g_string_chunk_new (64 * 1024);
+	strings->ref_count = 1;
+
+	return strings;
+}
+
+static IndexStrings *
+index_strings_ref (IndexStrings *strings)
+{
+	g_atomic_int_inc (&strings->ref_count);
+
+	return strings;
+}
+
+static void
+index_strings_unref (IndexStrings *strings)
+{
+	if (g_atomic_int_dec_and_test (&strings->ref_count))
+	{
+		g_string_chunk_free (strings->chunk);
+		g_slice_free (IndexStrings, strings);
+	}
+}
+
+static gboolean
+is_ascii (const gchar *str)
+{
+	for (; *str != '\0'; str++)
+	{
+		if ((guchar) *str >= 0x80)
+		{
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/* Lowercases @str one character for one, unlike g_utf8_strdown(), so
+ * that the character offsets of a match in the key are the ones in the
+ * path.
+ */
+static gchar *
+fold_case (const gchar *str)
+{
+	GString *folded;
+	const gchar *p;
+
+	if (is_ascii (str))
+	{
+		return g_ascii_strdown (str, -1);
+	}
+
+	folded = g_string_sized_new (strlen (str));
+
+	for (p = str; *p != '\0'; p = g_utf8_next_char (p))
+	{
+		g_string_append_unichar (folded, g_unichar_tolower (g_utf8_get_char (p)));
+	}
+
+	return g_string_free (folded, FALSE);
+}
+
+static guint
+get_depth (const gchar *path)
+{
+	guint depth = 1;
+
+	for (; *path != '\0'; path++)
+	{
+		if (*path == '/')
+		{
+			depth++;
+		}
+	}
+
+	return depth;
+}
+
+static void
+found_path_clear (FoundPath *found)
+{
+	g_free (found->path);
+	g_free (found->key);
+}
+
+static GArray *
+found_paths_new (void)
+{
+	GArray *paths;
+
+	paths = g_array_new (FALSE, FALSE, sizeof (FoundPath));
+	g_array_set_clear_func (paths, (GDestroyNotify) found_path_clear);
+
+	return paths;
+}
+
+static void
+crawl_job_free (CrawlJob *job)
+{
+	g_object_unref (job->location);
+	g_object_unref (job->cancellable);
+	g_free (job->filename);
+	g_strfreev (job->starts);
+	g_array_unref (job->batch);
+	g_slice_free (CrawlJob, job);
+}
+
+static void
+crawl_batch_free (CrawlBatch *batch)
+{
+	g_object_unref (batch->cancellable);
+	g_array_unref (batch->paths);
+	g_slice_free (CrawlBatch, batch);
+}
+
+static void
+monitor_free (GFileMonitor *monitor)
+{
+	g_file_monitor_cancel (monitor);
+	g_object_unref (monitor);
+}
+
+/* Main thread side */
+
+static void
+on_dir_changed (GFileMonitor      *monitor,
+                GFile             *file,
+                GFile             *other_file,
+                GFileMonitorEvent  event_type,
+                IndexRoot         *root);
+
+static void
+root_monitor_dir (IndexRoot   *root,
+                  const gchar *path)
+{
+	GFileMonitor *monitor;
+	GFile *dir;
+
+	if (g_hash_table_size (root->monitors) >= MAX_MONITORS_PER_ROOT ||
+	    g_hash_table_contains (root->monitors, path))
+	{
+		return;
+	}
+
+	if (*path == '\0')
+	{
+		dir = g_object_ref (root->location);
+	}
+	else
+	{
+		dir = g_file_resolve_relative_path (root->location, path);
+	}
+
+	monitor = g_file_monitor_directory (dir, G_FILE_MONITOR_NONE, NULL, NULL);
+	g_object_unref (dir);
+
+	if (monitor == NULL)
+	{
+		return;
+	}
+
+	g_signal_connect (monitor,
+	                  "changed",
+	                  G_CALLBACK (on_dir_changed),
+	                  root);
+
+	g_hash_table_insert (root->monitors, g_strdup (path), monitor);
+}
+
+static void
+root_entries_changed (IndexRoot *root)
+{
+	g_clear_pointer (&root->snapshot, g_array_unref);
+}
+
+static void
+root_add_path (IndexRoot   *root,
+               const gchar *path,
+               const gchar *key,
+               guint8       flags,
+               guint32      serial)
+{
+	IndexEntry entry;
+	guint i;
+
+	root_entries_changed (root);
+
+	i = GPOINTER_TO_UINT (g_hash_table_lookup (root->by_path, path));
+
+	if (i != 0)
+	{
+		IndexEntry *existing = &g_array_index (root->entries, IndexEntry, i - 1);
+
+		existing->flags = (existing->flags & ENTRY_IS_ASCII) | flags;
+
+		if (serial != 0)
+		{
+			existing->serial = serial;
+		}
+
+		return;
+	}
+
+	entry.path = g_string_chunk_insert (root->strings->chunk, path);
+	entry.key = key != NULL ? g_string_chunk_insert (root->strings->chunk, key) : entry.path;
+	entry.serial = serial;
+	entry.depth = MIN (get_depth (path), G_MAXUINT16);
+	entry.flags = flags;
+
+	if (is_ascii (entry.key))
+	{
+		entry.flags |= ENTRY_IS_ASCII;
+	}
+
+	g_array_append_val (root->entries, entry);
+	g_hash_table_insert (root->by_path,
+	                     (gpointer) entry.path,
+	                     GUINT_TO_POINTER (root->entries->len));
+
+	if (flags & ENTRY_IS_DIR)
+	{
+		root_monitor_dir (root, entry.path);
+	}
+}
+
+static void
+root_remove_entry (IndexRoot  *root,
+                   IndexEntry *entry)
+{
+	if (entry->flags & ENTRY_REMOVED)
+	{
+		return;
+	}
+
+	root_entries_changed (root);
+
+	if (entry->flags & ENTRY_IS_DIR)
+	{
+		g_hash_table_remove (root->monitors, entry->path);
+	}
+
+	g_hash_table_remove (root->by_path, entry->path);
+	entry->flags |= ENTRY_REMOVED;
+	root->n_removed++;
+}
+
+/* Copies the entries left to new strings */
+static void
+root_compact (IndexRoot *root)
+{
+	IndexStrings *strings;
+	GArray *entries;
+	guint i;
+
+	root_entries_changed (root);
+
+	strings = index_strings_new ();
+	entries = g_array_sized_new (FALSE,
+	                             FALSE,
+	                             sizeof (IndexEntry),
+	                             root->entries->len - root->n_removed);
+
+	g_hash_table_remove_all (root->by_path);
+
+	for (i = 0; i < root->entries->len; i++)
+	{
+		IndexEntry entry = g_array_index (root->entries, IndexEntry, i);
+
+		if (entry.flags & ENTRY_REMOVED)
+		{
+			continue;
+		}
+
+		if (entry.key == entry.path)
+		{
+			entry.path = entry.key = g_string_chunk_insert (strings->chunk, entry.path);
+		}
+		else
+		{
+			entry.path = g_string_chunk_insert (strings->chunk, entry.path);
+			entry.key = g_string_chunk_insert (strings->chunk, entry.key);
+		}
+
+		g_array_append_val (entries, entry);
+		g_hash_table_insert (root->by_path,
+		                     (gpointer) entry.path,
+		                     GUINT_TO_POINTER (entries->len));
+	}
+
+	index_strings_unref (root->strings);
+	g_array_unref (root->entries);
+
+	root->strings = strings;
+	root->entries = entries;
+	root->n_removed = 0;
+}
+
+static void
+root_remove_path (IndexRoot   *root,
+                  const gchar *path)
+{
+	IndexEntry *entry;
+	gchar *prefix;
+	guint i;
+
+	i = GPOINTER_TO_UINT (g_hash_table_lookup (root->by_path, path));
+
+	if (i == 0)
+	{
+		return;
+	}
+
+	entry = &g_array_index (root->entries, IndexEntry, i - 1);
+
+	if (entry->flags & ENTRY_IS_DIR)
+	{
+		prefix = g_strconcat (path, "/", NULL);
+
+		for (i = 0; i < root->entries->len; i++)
+		{
+			IndexEntry *child = &g_array_index (root->entries, IndexEntry, i);
+
+			if (g_str_has_prefix (child->path, prefix))
+			{
+				root_remove_entry (root, child);
+			}
+		}
+
+		g_free (prefix);
+	}
+
+	root_remove_entry (root, entry);
+
+	if (root->n_removed > root->entries->len / 4)
+	{
+		root_compact (root);
+	}
+
+	root->dirty = TRUE;
+	schedule_save (root->index);
+}
+
+/* Drops what the last crawl of the whole root did not find */
+static void
+root_remove_stale (IndexRoot *root)
+{
+	guint i;
+
+	for (i = 0; i < root->entries->len; i++)
+	{
+		IndexEntry *entry = &g_array_index (root->entries, IndexEntry, i);
+
+		if (entry->serial != root->serial)
+		{
+			root_remove_entry (root, entry);
+		}
+	}
+
+	if (root->n_removed > 0)
+	{
+		root_compact (root);
+	}
+}
+
+static gboolean
+deliver_batch (CrawlBatch *batch)
+{
+	IndexRoot *root;
+	guint32 serial;
+	guint i;
+
+	if (g_cancellable_is_cancelled (batch->cancellable))
+	{
+		return G_SOURCE_REMOVE;
+	}
+
+	root = batch->root;
+
+	/* The saved paths are stale until a crawl finds them again */
+	serial = batch->from_file ? 0 : root->serial;
+
+	for (i = 0; i < batch->paths->len; i++)
+	{
+		FoundPath *found = &g_array_index (batch->paths, FoundPath, i);
+
+		root_add_path (root, found->path, found->key, found->flags, serial);
+	}
+
+	if (!batch->last)
+	{
+		return G_SOURCE_REMOVE;
+	}
+
+	if (batch->from_file || batch->full)
+	{
+		root->complete_depth = batch->complete_depth;
+	}
+	else
+	{
+		/* The crawl of the created paths reached the limit */
+		root->complete_depth = MIN (root->complete_depth, batch->complete_depth);
+	}
+
+	if (batch->full)
+	{
+		root_remove_stale (root);
+		root->crawling = FALSE;
+	}
+
+	if (!batch->from_file)
+	{
+		root->dirty = TRUE;
+		schedule_save (root->index);
+	}
+
+	gedit_debug_message (DEBUG_APP, "%s: %u paths, complete to depth %u",
+	                     root->filename,
+	                     root->entries->len - root->n_removed,
+	                     root->complete_depth);
+
+	if (!root->ready && (batch->from_file || batch->full))
+	{
+		root->ready = TRUE;
+		g_signal_emit (root->index, signals[ROOT_READY], 0, root->location);
+	}
+
+	return G_SOURCE_REMOVE;
+}
+
+/* Crawling thread side */
+
+static void
+crawl_flush (CrawlJob *job,
+             gboolean  from_file,
+             gboolean  last,
+             gboolean  full,
+             guint     complete_depth)
+{
+	CrawlBatch *batch;
+
+	if (job->batch->len == 0 && !last)
+	{
+		return;
+	}
+
+	batch = g_slice_new0 (CrawlBatch);
+	batch->root = job->root;
+	batch->cancellable = g_object_ref (job->cancellable);
+	batch->paths = job->batch;
+	batch->complete_depth = complete_depth;
+	batch->from_file = from_file;
+	batch->last = last;
+	batch->full = full;
+
+	job->batch = found_paths_new ();
+	job->last_flush = g_get_monotonic_time ();
+
+	g_main_context_invoke_full (NULL,
+	                            G_PRIORITY_DEFAULT_IDLE,
+	                            (GSourceFunc) deliver_batch,
+	                            batch,
+	                            (GDestroyNotify) crawl_batch_free);
+}
+
+static void
+crawl_add (CrawlJob    *job,
+           gchar       *path,
+           guint8       flags,
+           gboolean     from_file)
+{
+	FoundPath found;
+
+	found.path = path;
+	found.key = fold_case (path);
+	found.flags = flags;
+
+	if (strcmp (found.key, path) == 0)
+	{
+		g_clear_pointer (&found.key, g_free);
+	}
+
+	g_array_append_val (job->batch, found);
+	job->n_paths++;
+
+	if (job->batch->len >= CRAWL_BATCH_SIZE ||
+	    g_get_monotonic_time () - job->last_flush > CRAWL_BATCH_INTERVAL)
+	{
+		crawl_flush (job, from_file, FALSE, FALSE, 0);
+	}
+}
+
+static void
+crawl_load (CrawlJob *job)
+{
+	gchar *contents;
+	gsize length;
+	GVariant *variant;
+	GVariantIter *iter;
+	const gchar *path;
+	guint8 flags;
+	guint32 version;
+	guint32 complete_depth;
+
+	if (!g_file_get_contents (job->filename, &contents, &length, NULL))
+	{
+		return;
+	}
+
+	variant = g_variant_new_from_data (G_VARIANT_TYPE (INDEX_FILE_FORMAT),
+	                                   contents,
+	                                   length,
+	                                   FALSE,
+	                                   g_free,
+	                                   contents);
+	g_variant_ref_sink (variant);
+
+	g_variant_get (variant, INDEX_FILE_FORMAT, &version, &complete_depth, &iter);
+
+	if (version == INDEX_FILE_VERSION)
+	{
+		while (g_variant_iter_next (iter, "(&sy)", &path, &flags))
+		{
+			crawl_add (job, g_strdup (path), flags & ENTRY_IS_DIR, TRUE);
+		}
+
+		crawl_flush (job, TRUE, TRUE, FALSE, complete_depth);
+	}
+
+	g_variant_iter_free (iter);
+	g_variant_unref (variant);
+
+	job->n_paths = 0;
+}
+
+/* Returns the flags of the entry for @info, or -1 to leave it out */
+static gint
+get_entry_flags (GFileInfo *info)
+{
+	const gchar *content_type;
+	gchar *guessed;
+	gboolean is_text;
+
+	if (g_file_info_get_is_hidden (info) || g_file_info_get_is_backup (info))
+	{
+		return -1;
+	}
+
+	switch (g_file_info_get_file_type (info))
+	{
+		case G_FILE_TYPE_DIRECTORY:
+			return ENTRY_IS_DIR;
+		case G_FILE_TYPE_REGULAR:
+			content_type = g_file_info_get_attribute_string (info,
+			                                                 G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE);
+			return content_type_is_text (content_type) ? 0 : -1;
+		case G_FILE_TYPE_SYMBOLIC_LINK:
+			/* Links are not followed, guess from their name */
+			guessed = g_content_type_guess (g_file_info_get_name (info), NULL, 0, NULL);
+			is_text = content_type_is_text (guessed);
+			g_free (guessed);
+			return is_text ? 0 : -1;
+		default:
+			return -1;
+	}
+}
+
+typedef struct
+{
+	gchar *path;
+	guint depth;
+} CrawlDir;
+
+static CrawlDir *
+crawl_dir_new (const gchar *path,
+               guint        depth)
+{
+	CrawlDir *dir;
+
+	dir = g_slice_new (CrawlDir);
+	dir->path = g_strdup (path);
+	dir->depth = depth;
+
+	return dir;
+}
+
+static void
+crawl_dir_free (CrawlDir *dir)
+{
+	g_free (dir->path);
+	g_slice_free (CrawlDir, dir);
+}
+
+static void
+crawl_start (CrawlJob    *job,
+             const gchar *path,
+             GQueue      *dirs)
+{
+	GFile *file;
+	GFileInfo *info;
+	gint flags;
+
+	file = g_file_resolve_relative_path (job->location, path);
+	info = g_file_query_info (file,
+	                          CRAWL_ATTRIBUTES,
+	                          G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+	                          job->cancellable,
+	                          NULL);
+	g_object_unref (file);
+
+	if (info == NULL)
+	{
+		return;
+	}
+
+	flags = get_entry_flags (info);
+	g_object_unref (info);
+
+	if (flags == -1)
+	{
+		return;
+	}
+
+	crawl_add (job, g_strdup (path), flags, FALSE);
+
+	if (flags & ENTRY_IS_DIR)
+	{
+		g_queue_push_tail (dirs, crawl_dir_new (path, get_depth (path)));
+	}
+}
+
+static gboolean
+crawl_directory (CrawlJob *job,
+                 CrawlDir *dir,
+                 GQueue   *dirs)
+{
+	GFile *file;
+	GFileEnumerator *enumerator;
+	GFileInfo *info;
+
+	if (*dir->path == '\0')
+	{
+		file = g_object_ref (job->location);
+	}
+	else
+	{
+		file = g_file_resolve_relative_path (job->location, dir->path);
+	}
+
+	/* Do not follow links to directories, they may loop */
+	enumerator = g_file_enumerate_children (file,
+	                                        CRAWL_ATTRIBUTES,
+	                                        G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+	                                        job->cancellable,
+	                                        NULL);
+	g_object_unref (file);
+
+	/* Unreadable directories are simply left out */
+	if (enumerator == NULL)
+	{
+		return TRUE;
+	}
+
+	while ((info = g_file_enumerator_next_file (enumerator, job->cancellable, NULL)) != NULL)
+	{
+		gint flags;
+		gchar *path;
+
+		flags = get_entry_flags (info);
+
+		if (flags == -1)
+		{
+			g_object_unref (info);
+			continue;
+		}
+
+		if (*dir->path == '\0')
+		{
+			path = g_strdup (g_file_info_get_name (info));
+		}
+		else
+		{
+			path = g_strconcat (dir->path, "/", g_file_info_get_name (info), NULL);
+		}
+
+		g_object_unref (info);
+
+		if (flags & ENTRY_IS_DIR)
+		{
+			g_queue_push_tail (dirs, crawl_dir_new (path, dir->depth + 1));
+		}
+
+		crawl_add (job, path, flags, FALSE);
+
+		if (job->n_paths >= MAX_PATHS_PER_ROOT)
+		{
+			break;
+		}
+	}
+
+	g_file_enumerator_close (enumerator, NULL, NULL);
+	g_object_unref (enumerator);
+
+	return job->n_paths < MAX_PATHS_PER_ROOT;
+}
+
+static void
+crawl_thread (GTask        *task,
+              gpointer      source_object,
+              CrawlJob     *job,
+              GCancellable *cancellable)
+{
+	GQueue dirs = G_QUEUE_INIT;
+	CrawlDir *dir;
+	gboolean full = FALSE;
+	guint complete_depth = G_MAXUINT;
+	gint i;
+
+	if (job->filename != NULL)
+	{
+		crawl_load (job);
+	}
+
+	/* Breadth first: when the crawl stops, the index is complete up
+	 * to the depth of the directory being crawled.
+	 */
+	for (i = 0; job->starts[i] != NULL; i++)
+	{
+		if (*job->starts[i] == '\0')
+		{
+			g_queue_push_tail (&dirs, crawl_dir_new ("", 0));
+			full = TRUE;
+		}
+		else if (job->n_paths < MAX_PATHS_PER_ROOT)
+		{
+			crawl_start (job, job->starts[i], &dirs);
+		}
+	}
+
+	while ((dir = g_queue_pop_head (&dirs)) != NULL)
+	{
+		gboolean go_on;
+
+		go_on = !g_cancellable_is_cancelled (cancellable) &&
+		        crawl_directory (job, dir, &dirs);
+
+		if (!go_on)
+		{
+			complete_depth = dir->depth;
+		}
+
+		crawl_dir_free (dir);
+
+		if (!go_on)
+		{
+			break;
+		}
+	}
+
+	g_queue_foreach (&dirs, (GFunc) crawl_dir_free, NULL);
+	g_queue_clear (&dirs);
+
+	crawl_flush (job, FALSE, TRUE, full, complete_depth);
+	g_task_return_boolean (task, TRUE);
+}
+
+static guint
+root_n_paths (IndexRoot *root)
+{
+	return root->entries->len - root->n_removed;
+}
+
+/* @n_paths: the paths already indexed that count against the limit */
+static void
+root_crawl (IndexRoot  *root,
+            gchar     **starts,
+            guint       n_paths,
+            gboolean    load)
+{
+	CrawlJob *job;
+	GTask *task;
+
+	job = g_slice_new0 (CrawlJob);
+	job->root = root;
+	job->location = g_object_ref (root->location);
+	job->cancellable = g_object_ref (root->cancellable);
+	job->filename = load ? g_strdup (root->filename) : NULL;
+	job->starts = starts;
+	job->n_paths = n_paths;
+	job->batch = found_paths_new ();
+	job->last_flush = g_get_monotonic_time ();
+
+	task = g_task_new (NULL, root->cancellable, NULL, NULL);
+	g_task_set_task_data (task, job, (GDestroyNotify) crawl_job_free);
+	g_task_run_in_thread (task, (GTaskThreadFunc) crawl_thread);
+	g_object_unref (task);
+}
+
+static void
+root_crawl_all (IndexRoot *root,
+                gboolean   load)
+{
+	gchar **starts;
+
+	starts = g_new0 (gchar *, 2);
+	starts[0] = g_strdup ("");
+
+	root->serial++;
+	root->crawling = TRUE;
+	root->crawl_time = g_get_monotonic_time ();
+
+	root_crawl (root, starts, 0, load);
+}
+
+static gboolean
+crawl_pending (IndexRoot *root)
+{
+	root->pending_id = 0;
+
+	/* The created paths add up to the paths already indexed */
+	g_ptr_array_add (root->pending, NULL);
+	root_crawl (root,
+	            (gchar **) g_ptr_array_free (root->pending, FALSE),
+	            root_n_paths (root),
+	            FALSE);
+	root->pending = g_ptr_array_new ();
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+root_add_pending (IndexRoot *root,
+                  gchar     *path)
+{
+	/* The index is already as big as it gets */
+	if (root_n_paths (root) + root->pending->len >= MAX_PATHS_PER_ROOT)
+	{
+		root->complete_depth = MIN (root->complete_depth, get_depth (path) - 1);
+		g_free (path);
+		return;
+	}
+
+	g_ptr_array_add (root->pending, path);
+
+	if (root->pending_id == 0)
+	{
+		root->pending_id = g_timeout_add (PENDING_CRAWL_DELAY,
+		                                  (GSourceFunc) crawl_pending,
+		                                  root);
+	}
+}
+
+static void
+on_dir_changed (GFileMonitor      *monitor,
+                GFile             *file,
+                GFile             *other_file,
+                GFileMonitorEvent  event_type,
+                IndexRoot         *root)
+{
+	gchar *path;
+
+	if (event_type != G_FILE_MONITOR_EVENT_CREATED &&
+	    event_type != G_FILE_MONITOR_EVENT_DELETED)
+	{
+		return;
+	}
+
+	path = g_file_get_relative_path (root->location, file);
+
+	if (path == NULL)
+	{
+		return;
+	}
+
+	if (event_type == G_FILE_MONITOR_EVENT_CREATED)
+	{
+		root_add_pending (root, path);
+	}
+	else
+	{
+		root_remove_path (root, path);
+		g_free (path);
+	}
+}
+
+static void
+save_ready_cb (GFile        *file,
+               GAsyncResult *result,
+               gpointer      user_data)
+{
+	GError *error = NULL;
+
+	if (!g_file_replace_contents_finish (file, result, NULL, &error))
+	{
+		gedit_debug_message (DEBUG_APP, "Failed to save the file index: %s", error->message);
+		g_error_free (error);
+	}
+}
+
+static void
+root_save (IndexRoot *root)
+{
+	GVariantBuilder builder;
+	GVariant *variant;
+	GBytes *bytes;
+	GFile *file;
+	gchar *dirname;
+	guint i;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(sy)"));
+
+	for (i = 0; i < root->entries->len; i++)
+	{
+		IndexEntry *entry = &g_array_index (root->entries, IndexEntry, i);
+
+		if (!(entry->flags & ENTRY_REMOVED))
+		{
+			g_variant_builder_add (&builder, "(sy)", entry->path, entry->flags & ENTRY_IS_DIR);
+		}
+	}
+
+	variant = g_variant_new (INDEX_FILE_FORMAT,
+	                         INDEX_FILE_VERSION,
+	                         root->complete_depth,
+	                         &builder);
+	g_variant_ref_sink (variant);
+	bytes = g_variant_get_data_as_bytes (variant);
+
+	dirname = g_path_get_dirname (root->filename);
+	g_mkdir_with_parents (dirname, 0755);
+	g_free (dirname);
+
+	file = g_file_new_for_path (root->filename);
+	g_file_replace_contents_bytes_async (file,
+	                                     bytes,
+	                                     NULL,
+	                                     FALSE,
+	                                     G_FILE_CREATE_NONE,
+	                                     NULL,
+	                                     (GAsyncReadyCallback) save_ready_cb,
+	                                     NULL);
+
+	g_object_unref (file);
+	g_bytes_unref (bytes);
+	g_variant_unref (variant);
+
+	root->dirty = FALSE;
+}
+
+static gboolean
+save_timeout (GeditFileIndex *index)
+{
+	GHashTableIter iter;
+	IndexRoot *root;
+
+	index->save_id = 0;
+
+	g_hash_table_iter_init (&iter, index->roots);
+
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &root))
+	{
+		/* The crawl schedules a save when it is done */
+		if (root->dirty && root->ready && !root->crawling)
+		{
+			root_save (root);
+		}
+	}
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+schedule_save (GeditFileIndex *index)
+{
+	if (index->save_id == 0)
+	{
+		index->save_id = g_timeout_add_seconds (SAVE_DELAY,
+		                                        (GSourceFunc) save_timeout,
+		                                        index);
+	}
+}
+
+static IndexRoot *
+root_new (GeditFileIndex *index,
+          GFile          *location,
+          const gchar    *uri)
+{
+	IndexRoot *root;
+	gchar *checksum;
+
+	root = g_slice_new0 (IndexRoot);
+	root->index = index;
+	root->location = g_object_ref (location);
+
+	checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, uri, -1);
+	root->filename = g_build_filename (gedit_dirs_get_user_cache_dir (),
+	                                   INDEX_DIR_NAME,
+	                                   checksum,
+	                                   NULL);
+	g_free (checksum);
+
+	root->strings = index_strings_new ();
+	root->entries = g_array_new (FALSE, FALSE, sizeof (IndexEntry));
+	root->by_path = g_hash_table_new (g_str_hash, g_str_equal);
+	root->cancellable = g_cancellable_new ();
+	root->monitors = g_hash_table_new_full (g_str_hash,
+	                                        g_str_equal,
+	                                        g_free,
+	                                        (GDestroyNotify) monitor_free);
+	root->pending = g_ptr_array_new ();
+
+	root_monitor_dir (root, "");
+
+	return root;
+}
+
+static void
+root_free (IndexRoot *root)
+{
+	/* Stops the threads and drops the batches not delivered yet */
+	g_cancellable_cancel (root->cancellable);
+	g_object_unref (root->cancellable);
+
+	if (root->pending_id != 0)
+	{
+		g_source_remove (root->pending_id);
+	}
+
+	g_ptr_array_free (root->pending, TRUE);
+	g_hash_table_destroy (root->monitors);
+	g_hash_table_destroy (root->by_path);
+	g_clear_pointer (&root->snapshot, g_array_unref);
+	g_array_unref (root->entries);
+	index_strings_unref (root->strings);
+	g_free (root->filename);
+	g_object_unref (root->location);
+
+	g_slice_free (IndexRoot, root);
+}
+
+static void
+gedit_file_index_finalize (GObject *object)
+{
+	GeditFileIndex *index = GEDIT_FILE_INDEX (object);
+
+	if (index->save_id != 0)
+	{
+		g_source_remove (index->save_id);
+	}
+
+	g_hash_table_destroy (index->roots);
+
+	G_OBJECT_CLASS (gedit_file_index_parent_class)->finalize (object);
+}
+
+static void
+gedit_file_index_class_init (GeditFileIndexClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->finalize = gedit_file_index_finalize;
+
+	/**
+	 * GeditFileIndex::root-ready:
+	 * @index: the #GeditFileIndex
+	 * @root: the root
+	 *
+	 * Emitted when @root can be queried, that is when its saved index
+	 * is loaded or when it has been crawled for the first time.
+	 */
+	signals[ROOT_READY] =
+		g_signal_new ("root-ready",
+		              G_OBJECT_CLASS_TYPE (object_class),
+		              G_SIGNAL_RUN_LAST,
+		              0,
+		              NULL, NULL, NULL,
+		              G_TYPE_NONE,
+		              1,
+		              G_TYPE_FILE);
+}
+
+static void
+gedit_file_index_init (GeditFileIndex *index)
+{
+	index->roots = g_hash_table_new_full (g_str_hash,
+	                                      g_str_equal,
+	                                      g_free,
+	                                      (GDestroyNotify) root_free);
+}
+
+/**
+ * gedit_file_index_get_default:
+ *
+ * Gets the application wide #GeditFileIndex.
+ *
+ * Returns: (transfer none): the default #GeditFileIndex
+ */
+GeditFileIndex *
+gedit_file_index_get_default (void)
+{
+	static GeditFileIndex *default_index = NULL;
+
+	if (G_UNLIKELY (default_index == NULL))
+	{
+		default_index = g_object_new (GEDIT_TYPE_FILE_INDEX, NULL);
+
+		g_object_add_weak_pointer (G_OBJECT (default_index),
+		                           (gpointer) &default_index);
+	}
+
+	return default_index;
+}
+
+static IndexRoot *
+lookup_root (GeditFileIndex *index,
+             GFile          *location)
+{
+	IndexRoot *root;
+	gchar *uri;
+
+	uri = g_file_get_uri (location);
+	root = g_hash_table_lookup (index->roots, uri);
+	g_free (uri);
+
+	if (root != NULL)
+	{
+		root->used_time = g_get_monotonic_time ();
+	}
+
+	return root;
+}
+
+/* Saves the changes not saved yet, if the index is in a state to be saved */
+static void
+root_drop (GeditFileIndex *index,
+           const gchar    *uri,
+           IndexRoot      *root)
+{
+	if (root->dirty && root->ready && !root->crawling)
+	{
+		root_save (root);
+	}
+
+	g_hash_table_remove (index->roots, uri);
+}
+
+static void
+drop_least_recently_used (GeditFileIndex *index)
+{
+	GHashTableIter iter;
+	const gchar *uri;
+	IndexRoot *root;
+	const gchar *oldest_uri = NULL;
+	IndexRoot *oldest = NULL;
+
+	g_hash_table_iter_init (&iter, index->roots);
+
+	while (g_hash_table_iter_next (&iter, (gpointer *) &uri, (gpointer *) &root))
+	{
+		if (oldest == NULL || root->used_time < oldest->used_time)
+		{
+			oldest_uri = uri;
+			oldest = root;
+		}
+	}
+
+	if (oldest != NULL)
+	{
+		gedit_debug_message (DEBUG_APP, "Dropping the file index of %s", oldest_uri);
+		root_drop (index, oldest_uri, oldest);
+	}
+}
+
+/**
+ * gedit_file_index_add_root:
+ * @index: a #GeditFileIndex
+ * @root: a directory
+ *
+ * Starts indexing the files below @root, if it is not indexed yet. The
+ * saved index of @root is loaded first, if any.
+ *
+ * Only a few roots are kept: the one used the least recently is removed
+ * when there are too many, see gedit_file_index_remove_root().
+ */
+void
+gedit_file_index_add_root (GeditFileIndex *index,
+                           GFile          *root)
+{
+	IndexRoot *index_root;
+	gchar *uri;
+
+	g_return_if_fail (GEDIT_IS_FILE_INDEX (index));
+	g_return_if_fail (G_IS_FILE (root));
+
+	uri = g_file_get_uri (root);
+	index_root = g_hash_table_lookup (index->roots, uri);
+
+	if (index_root == NULL)
+	{
+		while (g_hash_table_size (index->roots) >= MAX_ROOTS)
+		{
+			drop_least_recently_used (index);
+		}
+
+		index_root = root_new (index, root, uri);
+		index_root->used_time = g_get_monotonic_time ();
+		g_hash_table_insert (index->roots, uri, index_root);
+
+		root_crawl_all (index_root, TRUE);
+		return;
+	}
+
+	g_free (uri);
+	index_root->used_time = g_get_monotonic_time ();
+
+	/* The directories not monitored may have changed */
+	if (!index_root->crawling &&
+	    g_get_monotonic_time () - index_root->crawl_time > RECRAWL_INTERVAL)
+	{
+		root_crawl_all (index_root, FALSE);
+	}
+}
+
+/**
+ * gedit_file_index_remove_root:
+ * @index: a #GeditFileIndex
+ * @root: a directory
+ *
+ * Stops indexing the files below @root and frees its index. The saved
+ * index of @root is kept for the next time it is added.
+ */
+void
+gedit_file_index_remove_root (GeditFileIndex *index,
+                              GFile          *root)
+{
+	IndexRoot *index_root;
+	gchar *uri;
+
+	g_return_if_fail (GEDIT_IS_FILE_INDEX (index));
+	g_return_if_fail (G_IS_FILE (root));
+
+	uri = g_file_get_uri (root);
+	index_root = g_hash_table_lookup (index->roots, uri);
+
+	if (index_root != NULL)
+	{
+		root_drop (index, uri, index_root);
+	}
+
+	g_free (uri);
+}
+
+/**
+ * gedit_file_index_is_ready:
+ * @index: a #GeditFileIndex
+ * @root: a directory
+ *
+ * Returns: whether @root is indexed and can be queried
+ */
+gboolean
+gedit_file_index_is_ready (GeditFileIndex *index,
+                           GFile          *root)
+{
+	IndexRoot *index_root;
+
+	g_return_val_if_fail (GEDIT_IS_FILE_INDEX (index), FALSE);
+	g_return_val_if_fail (G_IS_FILE (root), FALSE);
+
+	index_root = lookup_root (index, root);
+
+	return index_root != NULL && index_root->ready;
+}
+
+/* Queries: the entries are scored in chunks by a pool of threads, which
+ * skip the ones not at the depth of the query, each chunk keeping its
+ * best matches in a heap, merged at the end. The threads work on a copy
+ * of the entries, made once and shared by the queries until the entries
+ * change.
+ */
+
+#define QUERY_CHUNK_SIZE 8192
+
+/* How often the threads check that the query is not cancelled */
+#define QUERY_CANCEL_CHECK 1024
+
+#define SCORE_SUBSTRING 1000
+#define SCORE_SUBSEQUENCE 400
+#define SCORE_PATTERN 100
+
+struct _GeditFileIndexMatch
+{
+	gchar *path;
+	gint score;
+	gboolean is_dir;
+
+	guint *offsets;
+	guint n_offsets;
+};
+
+typedef struct
+{
+	/* Folded by fold_case() */
+	gchar *text;
+	gunichar *chars;
+	glong n_chars;
+	gboolean is_ascii;
+
+	/* Only for the parts with wildcards */
+	GPatternSpec *spec;
+} QueryPart;
+
+typedef struct
+{
+	gint score;
+	guint candidate;
+} Scored;
+
+typedef struct
+{
+	/* A snapshot of the entries, filtered by depth in the threads */
+	IndexStrings *strings;
+	GArray *candidates;
+
+	QueryPart *parts;
+	guint n_parts;
+	guint max_results;
+
+	/* The best matches of the chunks scored so far */
+	GMutex mutex;
+	GArray *best;
+	gint n_pending;
+} QueryJob;
+
+typedef struct
+{
+	GTask *task;
+	guint start;
+	guint end;
+} QueryChunk;
+
+G_DEFINE_BOXED_TYPE (GeditFileIndexMatch,
+                     gedit_file_index_match,
+                     gedit_file_index_match_copy,
+                     gedit_file_index_match_free)
+
+static GThreadPool *query_pool = NULL;
+
+static void
+query_job_free (QueryJob *job)
+{
+	guint i;
+
+	for (i = 0; i < job->n_parts; i++)
+	{
+		g_free (job->parts[i].text);
+		g_free (job->parts[i].chars);
+
+		if (job->parts[i].spec != NULL)
+		{
+			g_pattern_spec_free (job->parts[i].spec);
+		}
+	}
+
+	g_free (job->parts);
+	g_array_unref (job->candidates);
+	g_array_unref (job->best);
+	index_strings_unref (job->strings);
+	g_mutex_clear (&job->mutex);
+
+	g_slice_free (QueryJob, job);
+}
+
+/* Returns NULL if the index cannot answer: @root is not ready, the index
+ * is not complete at the depth of @parts, or a part is "..".
+ */
+static QueryJob *
+query_job_new (IndexRoot           *root,
+               const gchar * const *parts,
+               guint                max_results)
+{
+	QueryJob *job;
+	guint n_parts;
+	guint i;
+
+	n_parts = g_strv_length ((gchar **) parts);
+
+	if (root == NULL || !root->ready ||
+	    n_parts == 0 || n_parts > root->complete_depth)
+	{
+		return NULL;
+	}
+
+	for (i = 0; i < n_parts; i++)
+	{
+		if (strcmp (parts[i], "..") == 0)
+		{
+			return NULL;
+		}
+	}
+
+	/* The snapshot points to the current strings, they are copied to
+	 * new ones by root_compact() which drops the snapshot.
+	 */
+	if (root->snapshot == NULL)
+	{
+		root->snapshot = g_array_sized_new (FALSE,
+		                                    FALSE,
+		                                    sizeof (IndexEntry),
+		                                    root->entries->len);
+		g_array_append_vals (root->snapshot,
+		                     root->entries->data,
+		                     root->entries->len);
+	}
+
+	job = g_slice_new0 (QueryJob);
+	job->strings = index_strings_ref (root->strings);
+	job->candidates = g_array_ref (root->snapshot);
+	job->parts = g_new0 (QueryPart, n_parts);
+	job->n_parts = n_parts;
+	job->max_results = max_results;
+	job->best = g_array_new (FALSE, FALSE, sizeof (Scored));
+	g_mutex_init (&job->mutex);
+
+	for (i = 0; i < n_parts; i++)
+	{
+		QueryPart *part = &job->parts[i];
+
+		part->text = fold_case (parts[i]);
+		part->chars = g_utf8_to_ucs4_fast (part->text, -1, &part->n_chars);
+		part->is_ascii = is_ascii (part->text);
+
+		if (strpbrk (part->text, "*?") != NULL)
+		{
+			gchar *pattern;
+
+			pattern = g_strconcat (part->text, "*", NULL);
+			part->spec = g_pattern_spec_new (pattern);
+			g_free (pattern);
+		}
+	}
+
+	return job;
+}
+
+static gint
+score_substring (glong position,
+                 glong part_length,
+                 glong length)
+{
+	gint score = SCORE_SUBSTRING - 5 * MIN (position, 100);
+
+	if (position == 0)
+	{
+		score += 200;
+	}
+
+	if (part_length == length)
+	{
+		score += 300;
+	}
+
+	return score;
+}
+
+static gint
+score_subsequence (glong first,
+                   glong gaps)
+{
+	return MAX (SCORE_SUBSEQUENCE - 6 * MIN (gaps, 50) - 2 * MIN (first, 50), 1);
+}
+
+static gboolean
+match_pattern (GPatternSpec *spec,
+               const gchar  *component,
+               gsize         length)
+{
+	gchar *name;
+	gboolean matched;
+
+	name = g_strndup (component, length);
+	matched = g_pattern_match_string (spec, name);
+	g_free (name);
+
+	return matched;
+}
+
+static void
+add_offsets (GArray *offsets,
+             guint   first,
+             guint   n)
+{
+	guint i;
+
+	for (i = 0; i < n; i++)
+	{
+		guint offset = first + i;
+
+		g_array_append_val (offsets, offset);
+	}
+}
+
+/* Each part is searched as a substring of its component, then as a glob
+ * pattern if it has wildcards, or else as a subsequence. The offsets of
+ * the characters matched, from @base, are added to @offsets if not NULL.
+ * Returns -1 if the component does not match.
+ */
+static gint
+score_component_ascii (const QueryPart *part,
+                       const gchar     *component,
+                       gsize            length,
+                       GArray          *offsets,
+                       guint            base)
+{
+	const gchar *found;
+	glong first = -1;
+	glong last = -1;
+	glong gaps = 0;
+	gsize i;
+	glong j = 0;
+
+	found = g_strstr_len (component, length, part->text);
+
+	if (found != NULL)
+	{
+		if (offsets != NULL)
+		{
+			add_offsets (offsets, base + (found - component), part->n_chars);
+		}
+
+		return score_substring (found - component, part->n_chars, length);
+	}
+
+	if (part->spec != NULL)
+	{
+		return match_pattern (part->spec, component, length) ? SCORE_PATTERN : -1;
+	}
+
+	for (i = 0; i < length && j < part->n_chars; i++)
+	{
+		if (component[i] != part->text[j])
+		{
+			continue;
+		}
+
+		if (first < 0)
+		{
+			first = i;
+		}
+		else
+		{
+			gaps += i - last - 1;
+		}
+
+		last = i;
+		j++;
+
+		if (offsets != NULL)
+		{
+			add_offsets (offsets, base + i, 1);
+		}
+	}
+
+	return j == part->n_chars ? score_subsequence (first, gaps) : -1;
+}
+
+static gint
+score_component_unichar (const QueryPart *part,
+                         const gchar     *component,
+                         gsize            length,
+                         GArray          *offsets,
+                         guint            base)
+{
+	gunichar *chars;
+	glong n_chars;
+	glong first = -1;
+	glong last = -1;
+	glong gaps = 0;
+	glong i;
+	glong j = 0;
+	gint score = -1;
+
+	chars = g_utf8_to_ucs4_fast (component, length, &n_chars);
+
+	for (i = 0; i + part->n_chars <= n_chars; i++)
+	{
+		if (memcmp (chars + i, part->chars, part->n_chars * sizeof (gunichar)) == 0)
+		{
+			if (offsets != NULL)
+			{
+				add_offsets (offsets, base + i, part->n_chars);
+			}
+
+			score = score_substring (i, part->n_chars, n_chars);
+			goto out;
+		}
+	}
+
+	if (part->spec != NULL)
+	{
+		score = match_pattern (part->spec, component, length) ? SCORE_PATTERN : -1;
+		goto out;
+	}
+
+	for (i = 0; i < n_chars && j < part->n_chars; i++)
+	{
+		if (chars[i] != part->chars[j])
+		{
+			continue;
+		}
+
+		if (first < 0)
+		{
+			first = i;
+		}
+		else
+		{
+			gaps += i - last - 1;
+		}
+
+		last = i;
+		j++;
+
+		if (offsets != NULL)
+		{
+			add_offsets (offsets, base + i, 1);
+		}
+	}
+
+	if (j == part->n_chars)
+	{
+		score = score_subsequence (first, gaps);
+	}
+
+out:
+	g_free (chars);
+
+	return score;
+}
+
+/* The last component, the name, counts twice, and shorter names win */
+static gint
+score_candidate (const QueryJob   *job,
+                 const IndexEntry *candidate,
+                 GArray           *offsets)
+{
+	const gchar *component = candidate->key;
+	gboolean ascii = (candidate->flags & ENTRY_IS_ASCII) != 0;
+	guint base = 0;
+	gint total = 0;
+	glong n_chars = 0;
+	guint i;
+
+	for (i = 0; i < job->n_parts; i++)
+	{
+		const QueryPart *part = &job->parts[i];
+		const gchar *end;
+		gsize length;
+		gint score;
+
+		end = strchr (component, '/');
+		length = end != NULL ? (gsize) (end - component) : strlen (component);
+
+		if (part->text[0] == '\0')
+		{
+			score = 0;
+		}
+		else if (ascii && part->is_ascii)
+		{
+			score = score_component_ascii (part, component, length, offsets, base);
+		}
+		else
+		{
+			score = score_component_unichar (part, component, length, offsets, base);
+		}
+
+		if (score < 0)
+		{
+			return -1;
+		}
+
+		total += i == job->n_parts - 1 ? 2 * score : score;
+
+		n_chars = ascii ? (glong) length : g_utf8_strlen (component, length);
+		base += n_chars + 1;
+		component = end != NULL ? end + 1 : component + length;
+	}
+
+	return total - MIN (n_chars, 100);
+}
+
+/* Whether @a ranks before @b */
+static gboolean
+ranks_before (const Scored     *a,
+              const Scored     *b,
+              const IndexEntry *candidates)
+{
+	if (a->score != b->score)
+	{
+		return a->score > b->score;
+	}
+
+	return strcmp (candidates[a->candidate].key, candidates[b->candidate].key) < 0;
+}
+
+static gint
+compare_scored (const Scored     *a,
+                const Scored     *b,
+                const IndexEntry *candidates)
+{
+	if (ranks_before (a, b, candidates))
+	{
+		return -1;
+	}
+
+	return ranks_before (b, a, candidates) ? 1 : 0;
+}
+
+static void
+heap_swap (GArray *heap,
+           guint   i,
+           guint   j)
+{
+	Scored tmp = g_array_index (heap, Scored, i);
+
+	g_array_index (heap, Scored, i) = g_array_index (heap, Scored, j);
+	g_array_index (heap, Scored, j) = tmp;
+}
+
+/* The top of the heap is the match ranking last, the one to replace */
+static void
+heap_offer (GArray           *heap,
+            guint             max_size,
+            const Scored     *scored,
+            const IndexEntry *candidates)
+{
+	Scored *items;
+	guint i;
+
+	if (max_size == 0 || heap->len < max_size)
+	{
+		g_array_append_val (heap, *scored);
+
+		items = (Scored *) heap->data;
+
+		for (i = heap->len - 1; i > 0; i = (i - 1) / 2)
+		{
+			if (!ranks_before (&items[(i - 1) / 2], &items[i], candidates))
+			{
+				break;
+			}
+
+			heap_swap (heap, i, (i - 1) / 2);
+		}
+
+		return;
+	}
+
+	items = (Scored *) heap->data;
+
+	if (!ranks_before (scored, &items[0], candidates))
+	{
+		return;
+	}
+
+	items[0] = *scored;
+	i = 0;
+
+	while (TRUE)
+	{
+		guint child = 2 * i + 1;
+
+		if (child >= heap->len)
+		{
+			break;
+		}
+
+		if (child + 1 < heap->len &&
+		    ranks_before (&items[child], &items[child + 1], candidates))
+		{
+			child++;
+		}
+
+		if (!ranks_before (&items[i], &items[child], candidates))
+		{
+			break;
+		}
+
+		heap_swap (heap, i, child);
+		i = child;
+	}
+}
+
+static void
+query_score_range (QueryJob     *job,
+                   guint         start,
+                   guint         end,
+                   GCancellable *cancellable,
+                   GArray       *heap)
+{
+	const IndexEntry *candidates = (const IndexEntry *) job->candidates->data;
+	guint i;
+
+	for (i = start; i < end; i++)
+	{
+		Scored scored;
+
+		if ((i - start) % QUERY_CANCEL_CHECK == 0 &&
+		    g_cancellable_is_cancelled (cancellable))
+		{
+			return;
+		}
+
+		if (candidates[i].depth != job->n_parts ||
+		    (candidates[i].flags & ENTRY_REMOVED))
+		{
+			continue;
+		}
+
+		scored.score = score_candidate (job, &candidates[i], NULL);
+
+		if (scored.score >= 0)
+		{
+			scored.candidate = i;
+			heap_offer (heap, job->max_results, &scored, candidates);
+		}
+	}
+}
+
+static GPtrArray *
+query_job_get_matches (QueryJob *job)
+{
+	const IndexEntry *candidates = (const IndexEntry *) job->candidates->data;
+	GPtrArray *matches;
+	guint i;
+
+	g_array_sort_with_data (job->best,
+	                        (GCompareDataFunc) compare_scored,
+	                        (gpointer) candidates);
+
+	matches = g_ptr_array_new_full (job->best->len,
+	                                (GDestroyNotify) gedit_file_index_match_free);
+
+	for (i = 0; i < job->best->len; i++)
+	{
+		const Scored *scored = &g_array_index (job->best, Scored, i);
+		const IndexEntry *candidate = &candidates[scored->candidate];
+		GeditFileIndexMatch *match;
+		GArray *offsets;
+
+		offsets = g_array_new (FALSE, FALSE, sizeof (guint));
+		score_candidate (job, candidate, offsets);
+
+		match = g_slice_new (GeditFileIndexMatch);
+		match->path = g_strdup (candidate->path);
+		match->score = scored->score;
+		match->is_dir = (candidate->flags & ENTRY_IS_DIR) != 0;
+		match->n_offsets = offsets->len;
+		match->offsets = (guint *) g_array_free (offsets, FALSE);
+
+		g_ptr_array_add (matches, match);
+	}
+
+	return matches;
+}
+
+static void
+query_chunk_run (QueryChunk *chunk,
+                 gpointer    user_data)
+{
+	GTask *task = chunk->task;
+	QueryJob *job = g_task_get_task_data (task);
+	GArray *heap;
+	guint i;
+
+	heap = g_array_new (FALSE, FALSE, sizeof (Scored));
+
+	query_score_range (job,
+	                   chunk->start,
+	                   chunk->end,
+	                   g_task_get_cancellable (task),
+	                   heap);
+
+	g_mutex_lock (&job->mutex);
+
+	for (i = 0; i < heap->len; i++)
+	{
+		heap_offer (job->best,
+		            job->max_results,
+		            &g_array_index (heap, Scored, i),
+		            (const IndexEntry *) job->candidates->data);
+	}
+
+	g_mutex_unlock (&job->mutex);
+
+	g_array_unref (heap);
+
+	/* The last chunk returns */
+	if (g_atomic_int_dec_and_test (&job->n_pending) &&
+	    !g_task_return_error_if_cancelled (task))
+	{
+		g_task_return_pointer (task,
+		                       query_job_get_matches (job),
+		                       (GDestroyNotify) g_ptr_array_unref);
+	}
+
+	g_object_unref (task);
+	g_slice_free (QueryChunk, chunk);
+}
+
+/**
+ * gedit_file_index_query:
+ * @index: a #GeditFileIndex
+ * @root: an indexed directory
+ * @parts: (array zero-terminated=1): the parts of the path to search for
+ * @max_results: the maximum number of results, or 0 for all of them
+ * @matches: (out) (array zero-terminated=1) (transfer full) (nullable):
+ *   the matching paths, relative to @root
+ *
+ * Searches the paths below @root made of as many components as @parts,
+ * case insensitively. Each component must contain its part, match it as
+ * a glob pattern if it has wildcards, or else contain its characters in
+ * order. An empty part matches every component. The paths of directories
+ * end with a '/', and they are sorted from the best match.
+ *
+ * See gedit_file_index_query_async() to search from threads.
+ *
+ * Returns: %FALSE if the index cannot answer: @root is not ready, the
+ *   index is not complete at the depth of @parts, or a part is "..".
+ */
+gboolean
+gedit_file_index_query (GeditFileIndex       *index,
+                        GFile                *root,
+                        const gchar * const  *parts,
+                        guint                 max_results,
+                        gchar              ***matches)
+{
+	QueryJob *job;
+	GPtrArray *found;
+	guint i;
+
+	g_return_val_if_fail (GEDIT_IS_FILE_INDEX (index), FALSE);
+	g_return_val_if_fail (G_IS_FILE (root), FALSE);
+	g_return_val_if_fail (parts != NULL, FALSE);
+	g_return_val_if_fail (matches != NULL, FALSE);
+
+	*matches = NULL;
+
+	job = query_job_new (lookup_root (index, root), parts, max_results);
+
+	if (job == NULL)
+	{
+		return FALSE;
+	}
+
+	query_score_range (job, 0, job->candidates->len, NULL, job->best);
+	found = query_job_get_matches (job);
+
+	*matches = g_new (gchar *, found->len + 1);
+
+	for (i = 0; i < found->len; i++)
+	{
+		GeditFileIndexMatch *match = g_ptr_array_index (found, i);
+
+		(*matches)[i] = g_strconcat (match->path, match->is_dir ? "/" : "", NULL);
+	}
+
+	(*matches)[found->len] = NULL;
+
+	g_ptr_array_unref (found);
+	query_job_free (job);
+
+	return TRUE;
+}
+
+/**
+ * gedit_file_index_query_async:
+ * @index: a #GeditFileIndex
+ * @root: an indexed directory
+ * @parts: (array zero-terminated=1): the parts of the path to search for
+ * @max_results: the maximum number of results, or 0 for all of them
+ * @cancellable: (nullable): a #GCancellable, to cancel a query superseded
+ *   by a new one
+ * @callback: a #GAsyncReadyCallback
+ * @user_data: user data for @callback
+ *
+ * Searches like gedit_file_index_query(), from a pool of threads. The
+ * index may change while the query runs, the query searches the index
+ * as it was when it started.
+ */
+void
+gedit_file_index_query_async (GeditFileIndex       *index,
+                              GFile                *root,
+                              const gchar * const  *parts,
+                              guint                 max_results,
+                              GCancellable         *cancellable,
+                              GAsyncReadyCallback   callback,
+                              gpointer              user_data)
+{
+	GTask *task;
+	QueryJob *job;
+	guint start;
+
+	g_return_if_fail (GEDIT_IS_FILE_INDEX (index));
+	g_return_if_fail (G_IS_FILE (root));
+	g_return_if_fail (parts != NULL);
+
+	task = g_task_new (index, cancellable, callback, user_data);
+	g_task_set_source_tag (task, gedit_file_index_query_async);
+
+	job = query_job_new (lookup_root (index, root), parts, max_results);
+
+	if (job == NULL)
+	{
+		g_task_return_new_error (task,
+		                         G_IO_ERROR,
+		                         G_IO_ERROR_NOT_SUPPORTED,
+		                         "The index cannot answer the query");
+		g_object_unref (task);
+		return;
+	}
+
+	g_task_set_task_data (task, job, (GDestroyNotify) query_job_free);
+
+	if (job->candidates->len == 0)
+	{
+		g_task_return_pointer (task,
+		                       query_job_get_matches (job),
+		                       (GDestroyNotify) g_ptr_array_unref);
+		g_object_unref (task);
+		return;
+	}
+
+	if (query_pool == NULL)
+	{
+		query_pool = g_thread_pool_new ((GFunc) query_chunk_run,
+		                                NULL,
+		                                g_get_num_processors (),
+		                                FALSE,
+		                                NULL);
+	}
+
+	job->n_pending = (job->candidates->len + QUERY_CHUNK_SIZE - 1) / QUERY_CHUNK_SIZE;
+
+	for (start = 0; start < job->candidates->len; start += QUERY_CHUNK_SIZE)
+	{
+		QueryChunk *chunk;
+
+		chunk = g_slice_new (QueryChunk);
+		chunk->task = g_object_ref (task);
+		chunk->start = start;
+		chunk->end = MIN (start + QUERY_CHUNK_SIZE, job->candidates->len);
+
+		g_thread_pool_push (query_pool, chunk, NULL);
+	}
+
+	g_object_unref (task);
+}
+
+/**
+ * gedit_file_index_query_finish:
+ * @index: a #GeditFileIndex
+ * @result: a #GAsyncResult
+ * @error: a #GError, %G_IO_ERROR_NOT_SUPPORTED if the index cannot answer
+ *   the query, see gedit_file_index_query()
+ *
+ * Returns: (transfer container) (element-type GeditFileIndexMatch): the
+ *   matches, from the best one
+ */
+GPtrArray *
+gedit_file_index_query_finish (GeditFileIndex  *index,
+                               GAsyncResult    *result,
+                               GError         **error)
+{
+	g_return_val_if_fail (g_task_is_valid (result, index), NULL);
+
+	return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+GeditFileIndexMatch *
+gedit_file_index_match_copy (const GeditFileIndexMatch *match)
+{
+	GeditFileIndexMatch *copy;
+
+	copy = g_slice_dup (GeditFileIndexMatch, match);
+	copy->path = g_strdup (match->path);
+	copy->offsets = g_memdup (match->offsets, match->n_offsets * sizeof (guint));
+
+	return copy;
+}
+
+void
+gedit_file_index_match_free (GeditFileIndexMatch *match)
+{
+	if (match == NULL)
+	{
+		return;
+	}
+
+	g_free (match->path);
+	g_free (match->offsets);
+	g_slice_free (GeditFileIndexMatch, match);
+}
+
+/**
+ * gedit_file_index_match_get_path:
+ * @match: a #GeditFileIndexMatch
+ *
+ * Returns: the path of @match, relative to the root
+ */
+const gchar *
+gedit_file_index_match_get_path (const GeditFileIndexMatch *match)
+{
+	g_return_val_if_fail (match != NULL, NULL);
+
+	return match->path;
+}
+
+gboolean
+gedit_file_index_match_is_dir (const GeditFileIndexMatch *match)
+{
+	g_return_val_if_fail (match != NULL, FALSE);
+
+	return match->is_dir;
+}
+
+gint
+gedit_file_index_match_get_score (const GeditFileIndexMatch *match)
+{
+	g_return_val_if_fail (match != NULL, 0);
+
+	return match->score;
+}
+
+/**
+ * gedit_file_index_match_get_offsets:
+ * @match: a #GeditFileIndexMatch
+ * @n_offsets: (out): the number of offsets
+ *
+ * Gets the offsets of the characters of the path which matched, to
+ * highlight them.
+ *
+ * Returns: (array length=n_offsets) (transfer none): the offsets, in
+ *   characters
+ */
+const guint *
+gedit_file_index_match_get_offsets (const GeditFileIndexMatch *match,
+                                    guint                     *n_offsets)
+{
+	g_return_val_if_fail (match != NULL, NULL);
+	g_return_val_if_fail (n_offsets != NULL, NULL);
+
+	*n_offsets = match->n_offsets;
+
+	return match->offsets;
+}
+
+/* ex:set ts=8 noet: */
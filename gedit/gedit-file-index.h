@@ -0,0 +1,83 @@
+/*
+ * gedit-file-index.h
+ * This file is part of gedit
+ *
+ * gedit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gedit. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GEDIT_FILE_INDEX_H
+#define GEDIT_FILE_INDEX_H
+
+#include <glib-object.h>
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define GEDIT_TYPE_FILE_INDEX (gedit_file_index_get_type ())
+
+G_DECLARE_FINAL_TYPE (GeditFileIndex, gedit_file_index, GEDIT, FILE_INDEX, GObject)
+
+#define GEDIT_TYPE_FILE_INDEX_MATCH (gedit_file_index_match_get_type ())
+
+typedef struct _GeditFileIndexMatch GeditFileIndexMatch;
+
+GeditFileIndex           *gedit_file_index_get_default             (void);
+
+void                      gedit_file_index_add_root                (GeditFileIndex       *index,
+                                                                    GFile                *root);
+
+void                      gedit_file_index_remove_root             (GeditFileIndex       *index,
+                                                                    GFile                *root);
+
+gboolean                  gedit_file_index_is_ready                (GeditFileIndex       *index,
+                                                                    GFile                *root);
+
+gboolean                  gedit_file_index_query                   (GeditFileIndex       *index,
+                                                                    GFile                *root,
+                                                                    const gchar * const  *parts,
+                                                                    guint                 max_results,
+                                                                    gchar              ***matches);
+
+void                      gedit_file_index_query_async             (GeditFileIndex       *index,
+                                                                    GFile                *root,
+                                                                    const gchar * const  *parts,
+                                                                    guint                 max_results,
+                                                                    GCancellable         *cancellable,
+                                                                    GAsyncReadyCallback   callback,
+                                                                    gpointer              user_data);
+
+GPtrArray                *gedit_file_index_query_finish            (GeditFileIndex       *index,
+                                                                    GAsyncResult         *result,
+                                                                    GError              **error);
+
+GType                     gedit_file_index_match_get_type          (void) G_GNUC_CONST;
+
+GeditFileIndexMatch      *gedit_file_index_match_copy              (const GeditFileIndexMatch *match);
+
+void                      gedit_file_index_match_free              (GeditFileIndexMatch       *match);
+
+const gchar              *gedit_file_index_match_get_path          (const GeditFileIndexMatch *match);
+
+gboolean                  gedit_file_index_match_is_dir            (const GeditFileIndexMatch *match);
+
+gint                      gedit_file_index_match_get_score         (const GeditFileIndexMatch *match);
+
+const guint              *gedit_file_index_match_get_offsets       (const GeditFileIndexMatch *match,
+                                                                    guint                     *n_offsets);
+
+G_END_DECLS
+
+#endif /* GEDIT_FILE_INDEX_H */
+
+/* ex:set ts=8 noet: */
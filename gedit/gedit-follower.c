@@ -0,0 +1,757 @@
+/*
+ * gedit-follower.c
+ * This file is part of gedit
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gedit-follower.h"
+
+#include <string.h>
+
+#include "gedit-debug.h"
+
+/* GeditFollower appends to a document what is written at the end of a file
+ * or read from a stream, like "tail -f". The pending reads hold a reference
+ * on the follower, so its owner stops it with g_object_run_dispose().
+ *
+ * For a file, the offset up to which the document is in sync is tracked:
+ * each time the file monitor reports a change, only the bytes after it are
+ * read. A file that shrinks was truncated or replaced (log rotation), so
+ * the document is emptied and the file is followed from its beginning.
+ *
+ * The bytes are converted to UTF-8 incrementally, so that a character split
+ * between two reads is not lost. The appended text is not undoable: as when
+ * a file is loaded, this clears the undo history, so the owner must not let
+ * the user edit the document while it is followed. The modified state of the
+ * document is kept. When a maximum number of lines is set, the oldest lines
+ * are removed from the beginning of the document, see
+ * gedit_follower_get_trimmed().
+ */
+
+#define READ_CHUNK_SIZE 65536
+
+struct _GeditFollower
+{
+	GObject parent_instance;
+
+	GeditDocument *doc;
+
+	/* NULL when following a stream */
+	GFile *location;
+	GFileMonitor *monitor;
+
+	/* The followed stream, or the file opened for the current read */
+	GInputStream *stream;
+
+	GCancellable *cancellable;
+
+	GCharsetConverter *converter;
+	gchar *charset;
+
+	/* Incomplete characters left over by the previous read */
+	GByteArray *pending_input;
+
+	/* The last newline of the file, not inserted in the buffer until
+	 * more text comes, see gtk_source_buffer_get_implicit_trailing_newline()
+	 */
+	const gchar *held_newline;
+
+	goffset offset;
+	guint max_lines;
+
+	guint reading : 1;
+	guint changed_while_reading : 1;
+	guint trimmed : 1;
+
+	/* The first read starts up to two bytes before the offset, to know
+	 * whether the loaded contents ended with a newline.
+	 */
+	guint check_last_newline : 1;
+	guint newline_check_bytes : 2;
+};
+
+enum
+{
+	APPENDED,
+	FINISHED,
+	LAST_SIGNAL
+};
+
+static guint signals[LAST_SIGNAL];
+
+G_DEFINE_TYPE (GeditFollower, gedit_follower, G_TYPE_OBJECT)
+
+static void read_next_chunk (GeditFollower *follower);
+
+static void
+gedit_follower_dispose (GObject *object)
+{
+	GeditFollower *follower = GEDIT_FOLLOWER (object);
+
+	if (follower->cancellable != NULL)
+	{
+		g_cancellable_cancel (follower->cancellable);
+		g_clear_object (&follower->cancellable);
+	}
+
+	if (follower->monitor != NULL)
+	{
+		g_file_monitor_cancel (follower->monitor);
+		g_clear_object (&follower->monitor);
+	}
+
+	g_clear_object (&follower->stream);
+	g_clear_object (&follower->converter);
+	g_clear_object (&follower->location);
+	g_clear_object (&follower->doc);
+
+	G_OBJECT_CLASS (gedit_follower_parent_class)->dispose (object);
+}
+
+static void
+gedit_follower_finalize (GObject *object)
+{
+	GeditFollower *follower = GEDIT_FOLLOWER (object);
+
+	g_byte_array_unref (follower->pending_input);
+	g_free (follower->charset);
+
+	G_OBJECT_CLASS (gedit_follower_parent_class)->finalize (object);
+}
+
+static void
+gedit_follower_class_init (GeditFollowerClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	object_class->dispose = gedit_follower_dispose;
+	object_class->finalize = gedit_follower_finalize;
+
+	/* Emitted after text was appended to the document */
+	signals[APPENDED] =
+		g_signal_new ("appended",
+		              G_TYPE_FROM_CLASS (klass),
+		              G_SIGNAL_RUN_LAST,
+		              0,
+		              NULL, NULL, NULL,
+		              G_TYPE_NONE, 0);
+
+	/* Emitted when the followed stream reached its end or failed */
+	signals[FINISHED] =
+		g_signal_new ("finished",
+		              G_TYPE_FROM_CLASS (klass),
+		              G_SIGNAL_RUN_LAST,
+		              0,
+		              NULL, NULL, NULL,
+		              G_TYPE_NONE, 0);
+}
+
+static void
+gedit_follower_init (GeditFollower *follower)
+{
+	follower->cancellable = g_cancellable_new ();
+	follower->pending_input = g_byte_array_new ();
+}
+
+static void
+reset_converter (GeditFollower *follower)
+{
+	GError *error = NULL;
+
+	g_clear_object (&follower->converter);
+	g_byte_array_set_size (follower->pending_input, 0);
+
+	follower->converter = g_charset_converter_new ("UTF-8", follower->charset, &error);
+
+	if (error != NULL)
+	{
+		gedit_debug_message (DEBUG_DOCUMENT, "Follow as UTF-8: %s", error->message);
+		g_clear_error (&error);
+
+		follower->converter = g_charset_converter_new ("UTF-8", "UTF-8", NULL);
+	}
+}
+
+static gchar *
+convert (GeditFollower *follower,
+         const guint8  *data,
+         gsize          len,
+         gsize         *text_len)
+{
+	GString *text;
+	const guint8 *in;
+	gsize in_len;
+
+	g_byte_array_append (follower->pending_input, data, len);
+
+	in = follower->pending_input->data;
+	in_len = follower->pending_input->len;
+
+	text = g_string_sized_new (in_len);
+
+	while (in_len > 0)
+	{
+		gchar out[8192];
+		gsize bytes_read = 0;
+		gsize bytes_written = 0;
+		GError *error = NULL;
+
+		g_converter_convert (G_CONVERTER (follower->converter),
+		                     in, in_len,
+		                     out, sizeof (out),
+		                     G_CONVERTER_NO_FLAGS,
+		                     &bytes_read,
+		                     &bytes_written,
+		                     &error);
+
+		if (error != NULL)
+		{
+			gboolean partial;
+
+			partial = g_error_matches (error, G_IO_ERROR, G_IO_ERROR_PARTIAL_INPUT);
+			g_error_free (error);
+
+			/* Wait for the rest of the character */
+			if (partial)
+			{
+				break;
+			}
+
+			/* Invalid byte: replace it, as the loader does */
+			g_string_append (text, "\357\277\275");
+			bytes_read = 1;
+			g_converter_reset (G_CONVERTER (follower->converter));
+		}
+
+		g_string_append_len (text, out, bytes_written);
+
+		in += bytes_read;
+		in_len -= bytes_read;
+	}
+
+	g_byte_array_remove_range (follower->pending_input,
+	                           0,
+	                           follower->pending_input->len - in_len);
+
+	*text_len = text->len;
+	return g_string_free (text, FALSE);
+}
+
+static void
+trim_head (GeditFollower *follower)
+{
+	GtkTextBuffer *buffer = GTK_TEXT_BUFFER (follower->doc);
+	gint line_count;
+	GtkTextIter start;
+	GtkTextIter end;
+
+	if (follower->max_lines == 0)
+	{
+		return;
+	}
+
+	line_count = gtk_text_buffer_get_line_count (buffer);
+
+	if ((guint) line_count <= follower->max_lines)
+	{
+		return;
+	}
+
+	gtk_text_buffer_get_start_iter (buffer, &start);
+	gtk_text_buffer_get_iter_at_line (buffer, &end, line_count - follower->max_lines);
+	gtk_text_buffer_delete (buffer, &start, &end);
+
+	follower->trimmed = TRUE;
+}
+
+static void
+append_text (GeditFollower *follower,
+             gchar         *text,
+             gsize          len)
+{
+	GtkTextBuffer *buffer = GTK_TEXT_BUFFER (follower->doc);
+	GtkSourceBuffer *source_buffer = GTK_SOURCE_BUFFER (follower->doc);
+	const gchar *held_newline = NULL;
+	gboolean was_modified;
+	gboolean at_end;
+	GtkTextIter iter;
+
+	if (len == 0)
+	{
+		return;
+	}
+
+	/* Keep the last newline out of the buffer, as the loader does */
+	if (gtk_source_buffer_get_implicit_trailing_newline (source_buffer))
+	{
+		if (len >= 2 && text[len - 2] == '\r' && text[len - 1] == '\n')
+		{
+			held_newline = "\r\n";
+			len -= 2;
+		}
+		else if (text[len - 1] == '\n')
+		{
+			held_newline = "\n";
+			len -= 1;
+		}
+	}
+
+	was_modified = gtk_text_buffer_get_modified (buffer);
+
+	gtk_text_buffer_get_iter_at_mark (buffer, &iter, gtk_text_buffer_get_insert (buffer));
+	at_end = gtk_text_iter_is_end (&iter);
+
+	gtk_source_buffer_begin_not_undoable_action (source_buffer);
+
+	gtk_text_buffer_get_end_iter (buffer, &iter);
+
+	if (follower->held_newline != NULL)
+	{
+		gtk_text_buffer_insert (buffer, &iter, follower->held_newline, -1);
+	}
+
+	gtk_text_buffer_insert (buffer, &iter, text, len);
+	follower->held_newline = held_newline;
+
+	trim_head (follower);
+
+	gtk_source_buffer_end_not_undoable_action (source_buffer);
+
+	/* Stay pinned to the end, unless the user moved away from it */
+	if (at_end)
+	{
+		gtk_text_buffer_get_end_iter (buffer, &iter);
+		gtk_text_buffer_place_cursor (buffer, &iter);
+	}
+
+	if (!was_modified)
+	{
+		gtk_text_buffer_set_modified (buffer, FALSE);
+	}
+
+	g_signal_emit (follower, signals[APPENDED], 0);
+}
+
+static void
+append_bytes (GeditFollower *follower,
+              GBytes        *bytes)
+{
+	const guint8 *data;
+	gsize len;
+	gchar *text;
+	gsize text_len;
+
+	data = g_bytes_get_data (bytes, &len);
+
+	if (follower->newline_check_bytes > 0)
+	{
+		gsize skip = MIN (len, follower->newline_check_bytes);
+
+		follower->newline_check_bytes = 0;
+
+		if (skip > 0 && data[skip - 1] == '\n')
+		{
+			follower->held_newline = (skip == 2 && data[0] == '\r') ? "\r\n" : "\n";
+		}
+
+		data += skip;
+		len -= skip;
+	}
+
+	text = convert (follower, data, len, &text_len);
+	append_text (follower, text, text_len);
+	g_free (text);
+}
+
+static void
+clear_document (GeditFollower *follower)
+{
+	GtkTextBuffer *buffer = GTK_TEXT_BUFFER (follower->doc);
+	gboolean was_modified;
+
+	was_modified = gtk_text_buffer_get_modified (buffer);
+
+	gtk_source_buffer_begin_not_undoable_action (GTK_SOURCE_BUFFER (buffer));
+	gtk_text_buffer_set_text (buffer, "", 0);
+	gtk_source_buffer_end_not_undoable_action (GTK_SOURCE_BUFFER (buffer));
+
+	if (!was_modified)
+	{
+		gtk_text_buffer_set_modified (buffer, FALSE);
+	}
+
+	follower->held_newline = NULL;
+	follower->check_last_newline = FALSE;
+	follower->newline_check_bytes = 0;
+	reset_converter (follower);
+}
+
+static void start_reading_file (GeditFollower *follower);
+
+static void
+finish_reading_file (GeditFollower *follower)
+{
+	g_clear_object (&follower->stream);
+	follower->reading = FALSE;
+
+	if (follower->changed_while_reading)
+	{
+		follower->changed_while_reading = FALSE;
+		start_reading_file (follower);
+	}
+}
+
+static void
+read_cb (GInputStream  *stream,
+         GAsyncResult  *result,
+         GeditFollower *follower)
+{
+	GBytes *bytes;
+	GError *error = NULL;
+
+	bytes = g_input_stream_read_bytes_finish (stream, result, &error);
+
+	if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED) ||
+	    follower->stream != stream)
+	{
+		g_clear_error (&error);
+		g_clear_pointer (&bytes, g_bytes_unref);
+		g_object_unref (follower);
+		return;
+	}
+
+	if (error != NULL || g_bytes_get_size (bytes) == 0)
+	{
+		if (error != NULL)
+		{
+			gedit_debug_message (DEBUG_DOCUMENT, "Follow: %s", error->message);
+			g_error_free (error);
+		}
+
+		if (follower->location != NULL)
+		{
+			finish_reading_file (follower);
+		}
+		else
+		{
+			g_clear_object (&follower->stream);
+			g_signal_emit (follower, signals[FINISHED], 0);
+		}
+	}
+	else
+	{
+		follower->offset += g_bytes_get_size (bytes);
+		append_bytes (follower, bytes);
+
+		read_next_chunk (follower);
+	}
+
+	g_clear_pointer (&bytes, g_bytes_unref);
+	g_object_unref (follower);
+}
+
+static void
+read_next_chunk (GeditFollower *follower)
+{
+	g_input_stream_read_bytes_async (follower->stream,
+	                                 READ_CHUNK_SIZE,
+	                                 G_PRIORITY_DEFAULT,
+	                                 follower->cancellable,
+	                                 (GAsyncReadyCallback) read_cb,
+	                                 g_object_ref (follower));
+}
+
+static void
+query_size_cb (GFileInputStream *stream,
+               GAsyncResult     *result,
+               GeditFollower    *follower)
+{
+	GFileInfo *info;
+	goffset size;
+	goffset start;
+	GError *error = NULL;
+
+	info = g_file_input_stream_query_info_finish (stream, result, &error);
+
+	if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED) ||
+	    follower->stream != G_INPUT_STREAM (stream))
+	{
+		g_clear_error (&error);
+		g_clear_object (&info);
+		g_object_unref (follower);
+		return;
+	}
+
+	if (error != NULL)
+	{
+		gedit_debug_message (DEBUG_DOCUMENT, "Follow: %s", error->message);
+		g_error_free (error);
+		finish_reading_file (follower);
+		g_object_unref (follower);
+		return;
+	}
+
+	size = g_file_info_get_size (info);
+	g_object_unref (info);
+
+	if (size < follower->offset)
+	{
+		gedit_debug_message (DEBUG_DOCUMENT, "Followed file truncated, starting over");
+
+		clear_document (follower);
+		follower->offset = 0;
+	}
+
+	if (size == follower->offset)
+	{
+		finish_reading_file (follower);
+		g_object_unref (follower);
+		return;
+	}
+
+	start = follower->offset;
+
+	if (follower->check_last_newline)
+	{
+		follower->check_last_newline = FALSE;
+		follower->newline_check_bytes = MIN (follower->offset, 2);
+
+		start -= follower->newline_check_bytes;
+		follower->offset = start;
+	}
+
+	if (start > 0 &&
+	    !g_seekable_seek (G_SEEKABLE (stream), start, G_SEEK_SET, NULL, &error))
+	{
+		gedit_debug_message (DEBUG_DOCUMENT, "Follow: %s", error->message);
+		g_error_free (error);
+		finish_reading_file (follower);
+		g_object_unref (follower);
+		return;
+	}
+
+	read_next_chunk (follower);
+	g_object_unref (follower);
+}
+
+static void
+file_read_cb (GFile         *location,
+              GAsyncResult  *result,
+              GeditFollower *follower)
+{
+	GFileInputStream *stream;
+	GError *error = NULL;
+
+	stream = g_file_read_finish (location, result, &error);
+
+	if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED) ||
+	    follower->cancellable == NULL)
+	{
+		g_clear_error (&error);
+		g_clear_object (&stream);
+		g_object_unref (follower);
+		return;
+	}
+
+	/* Between a rotation and the creation of the new file */
+	if (error != NULL)
+	{
+		gedit_debug_message (DEBUG_DOCUMENT, "Follow: %s", error->message);
+		g_error_free (error);
+		finish_reading_file (follower);
+		g_object_unref (follower);
+		return;
+	}
+
+	follower->stream = G_INPUT_STREAM (stream);
+
+	g_file_input_stream_query_info_async (stream,
+	                                      G_FILE_ATTRIBUTE_STANDARD_SIZE,
+	                                      G_PRIORITY_DEFAULT,
+	                                      follower->cancellable,
+	                                      (GAsyncReadyCallback) query_size_cb,
+	                                      follower);
+}
+
+static void
+start_reading_file (GeditFollower *follower)
+{
+	if (follower->reading)
+	{
+		follower->changed_while_reading = TRUE;
+		return;
+	}
+
+	follower->reading = TRUE;
+
+	g_file_read_async (follower->location,
+	                   G_PRIORITY_DEFAULT,
+	                   follower->cancellable,
+	                   (GAsyncReadyCallback) file_read_cb,
+	                   g_object_ref (follower));
+}
+
+static void
+monitor_changed_cb (GFileMonitor      *monitor,
+                    GFile             *file,
+                    GFile             *other_file,
+                    GFileMonitorEvent  event_type,
+                    GeditFollower     *follower)
+{
+	switch (event_type)
+	{
+		case G_FILE_MONITOR_EVENT_CHANGED:
+		case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+		case G_FILE_MONITOR_EVENT_CREATED:
+			start_reading_file (follower);
+			break;
+
+		default:
+			break;
+	}
+}
+
+static GeditFollower *
+follower_new (GeditDocument           *doc,
+              const GtkSourceEncoding *encoding)
+{
+	GeditFollower *follower;
+
+	follower = g_object_new (GEDIT_TYPE_FOLLOWER, NULL);
+
+	follower->doc = g_object_ref (doc);
+	follower->charset = g_strdup (encoding != NULL ?
+	                              gtk_source_encoding_get_charset (encoding) :
+	                              "UTF-8");
+
+	reset_converter (follower);
+
+	return follower;
+}
+
+/**
+ * gedit_follower_new_for_file:
+ * @doc: the #GeditDocument to append to.
+ * @location: the file to follow.
+ * @encoding: (allow-none): the encoding of the file, or %NULL for UTF-8.
+ * @offset: the number of bytes of @location already in @doc.
+ *
+ * Returns: a new #GeditFollower, which follows @location until it is
+ * disposed.
+ */
+GeditFollower *
+gedit_follower_new_for_file (GeditDocument           *doc,
+                             GFile                   *location,
+                             const GtkSourceEncoding *encoding,
+                             goffset                  offset)
+{
+	GeditFollower *follower;
+	GError *error = NULL;
+
+	g_return_val_if_fail (GEDIT_IS_DOCUMENT (doc), NULL);
+	g_return_val_if_fail (G_IS_FILE (location), NULL);
+
+	follower = follower_new (doc, encoding);
+	follower->location = g_object_ref (location);
+	follower->offset = offset;
+	follower->check_last_newline =
+		offset > 0 &&
+		gtk_source_buffer_get_implicit_trailing_newline (GTK_SOURCE_BUFFER (doc));
+
+	follower->monitor = g_file_monitor_file (location,
+	                                         G_FILE_MONITOR_NONE,
+	                                         follower->cancellable,
+	                                         &error);
+
+	if (follower->monitor != NULL)
+	{
+		g_signal_connect (follower->monitor,
+		                  "changed",
+		                  G_CALLBACK (monitor_changed_cb),
+		                  follower);
+	}
+	else
+	{
+		g_warning ("Cannot follow the file: %s", error->message);
+		g_error_free (error);
+	}
+
+	/* Catch up with what was written since the document was loaded */
+	start_reading_file (follower);
+
+	return follower;
+}
+
+/**
+ * gedit_follower_new_for_stream:
+ * @doc: the #GeditDocument to append to.
+ * @stream: the stream to follow.
+ * @encoding: (allow-none): the encoding of the stream, or %NULL for UTF-8.
+ *
+ * Returns: a new #GeditFollower, which reads @stream until its end or
+ * until it is disposed. #GeditFollower::finished is emitted at the end
+ * of @stream.
+ */
+GeditFollower *
+gedit_follower_new_for_stream (GeditDocument           *doc,
+                               GInputStream            *stream,
+                               const GtkSourceEncoding *encoding)
+{
+	GeditFollower *follower;
+
+	g_return_val_if_fail (GEDIT_IS_DOCUMENT (doc), NULL);
+	g_return_val_if_fail (G_IS_INPUT_STREAM (stream), NULL);
+
+	follower = follower_new (doc, encoding);
+	follower->stream = g_object_ref (stream);
+
+	read_next_chunk (follower);
+
+	return follower;
+}
+
+/**
+ * gedit_follower_set_max_lines:
+ * @follower: a #GeditFollower.
+ * @max_lines: the maximum number of lines of the document, or 0.
+ *
+ * Sets how many lines are kept when text is appended. The oldest lines
+ * are removed first. 0 means that nothing is ever removed.
+ */
+void
+gedit_follower_set_max_lines (GeditFollower *follower,
+                              guint          max_lines)
+{
+	g_return_if_fail (GEDIT_IS_FOLLOWER (follower));
+
+	follower->max_lines = max_lines;
+}
+
+/**
+ * gedit_follower_get_trimmed:
+ * @follower: a #GeditFollower.
+ *
+ * Returns: whether lines were removed from the beginning of the document,
+ * which then no longer holds the whole file.
+ */
+gboolean
+gedit_follower_get_trimmed (GeditFollower *follower)
+{
+	g_return_val_if_fail (GEDIT_IS_FOLLOWER (follower), FALSE);
+
+	return follower->trimmed;
+}
+
+/* ex:set ts=8 noet: */
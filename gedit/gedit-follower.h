@@ -0,0 +1,50 @@
+/*
+ * gedit-follower.h
+ * This file is part of gedit
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GEDIT_FOLLOWER_H
+#define GEDIT_FOLLOWER_H
+
+#include <gtksourceview/gtksource.h>
+
+#include "gedit-document.h"
+
+G_BEGIN_DECLS
+
+#define GEDIT_TYPE_FOLLOWER (gedit_follower_get_type ())
+
+G_DECLARE_FINAL_TYPE (GeditFollower, gedit_follower, GEDIT, FOLLOWER, GObject)
+
+GeditFollower	*gedit_follower_new_for_file		(GeditDocument           *doc,
+							 GFile                   *location,
+							 const GtkSourceEncoding *encoding,
+							 goffset                  offset);
+
+GeditFollower	*gedit_follower_new_for_stream		(GeditDocument           *doc,
+							 GInputStream            *stream,
+							 const GtkSourceEncoding *encoding);
+
+void		 gedit_follower_set_max_lines		(GeditFollower           *follower,
+							 guint                    max_lines);
+
+gboolean	 gedit_follower_get_trimmed		(GeditFollower           *follower);
+
+G_END_DECLS
+
+#endif /* GEDIT_FOLLOWER_H */
+
+/* ex:set ts=8 noet: */
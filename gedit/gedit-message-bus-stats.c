@@ -0,0 +1,156 @@
+/*
+ * gedit-message-bus-stats.c
+ * This file is part of gedit
+ *
+ * gedit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gedit; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA  02110-1301  USA
+ */
+
+#include "gedit-message-bus-stats.h"
+
+/* The message answering /core/bus.stats: "enabled" turns the collection of
+ * the statistics on (the default) or off, "reset" clears them after they
+ * were read, and "stats" is set to their dump.
+ */
+
+enum
+{
+	PROP_0,
+
+	PROP_ENABLED,
+	PROP_RESET,
+	PROP_STATS,
+};
+
+struct _GeditMessageBusStatsPrivate
+{
+	gchar *stats;
+	guint enabled : 1;
+	guint reset : 1;
+};
+
+G_DEFINE_TYPE_EXTENDED (GeditMessageBusStats,
+                        gedit_message_bus_stats,
+                        GEDIT_TYPE_MESSAGE,
+                        0,
+                        G_ADD_PRIVATE (GeditMessageBusStats))
+
+static void
+gedit_message_bus_stats_finalize (GObject *obj)
+{
+	GeditMessageBusStats *msg = GEDIT_MESSAGE_BUS_STATS (obj);
+
+	g_free (msg->priv->stats);
+
+	G_OBJECT_CLASS (gedit_message_bus_stats_parent_class)->finalize (obj);
+}
+
+static void
+gedit_message_bus_stats_get_property (GObject    *obj,
+                                      guint       prop_id,
+                                      GValue     *value,
+                                      GParamSpec *pspec)
+{
+	GeditMessageBusStats *msg;
+
+	msg = GEDIT_MESSAGE_BUS_STATS (obj);
+
+	switch (prop_id)
+	{
+		case PROP_ENABLED:
+			g_value_set_boolean (value, msg->priv->enabled);
+			break;
+		case PROP_RESET:
+			g_value_set_boolean (value, msg->priv->reset);
+			break;
+		case PROP_STATS:
+			g_value_set_string (value, msg->priv->stats);
+			break;
+	}
+}
+
+static void
+gedit_message_bus_stats_set_property (GObject      *obj,
+                                      guint         prop_id,
+                                      GValue const *value,
+                                      GParamSpec   *pspec)
+{
+	GeditMessageBusStats *msg;
+
+	msg = GEDIT_MESSAGE_BUS_STATS (obj);
+
+	switch (prop_id)
+	{
+		case PROP_ENABLED:
+			msg->priv->enabled = g_value_get_boolean (value);
+			break;
+		case PROP_RESET:
+			msg->priv->reset = g_value_get_boolean (value);
+			break;
+		case PROP_STATS:
+		{
+			g_free (msg->priv->stats);
+			msg->priv->stats = g_value_dup_string (value);
+			break;
+		}
+	}
+}
+
+static void
+gedit_message_bus_stats_class_init (GeditMessageBusStatsClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS(klass);
+
+	object_class->finalize = gedit_message_bus_stats_finalize;
+
+	object_class->get_property = gedit_message_bus_stats_get_property;
+	object_class->set_property = gedit_message_bus_stats_set_property;
+
+	g_object_class_install_property (object_class,
+	                                 PROP_ENABLED,
+	                                 g_param_spec_boolean ("enabled",
+	                                                       "Enabled",
+	                                                       "Enabled",
+	                                                       TRUE,
+	                                                       G_PARAM_READWRITE |
+	                                                       G_PARAM_CONSTRUCT |
+	                                                       G_PARAM_STATIC_STRINGS));
+
+	g_object_class_install_property (object_class,
+	                                 PROP_RESET,
+	                                 g_param_spec_boolean ("reset",
+	                                                       "Reset",
+	                                                       "Reset",
+	                                                       FALSE,
+	                                                       G_PARAM_READWRITE |
+	                                                       G_PARAM_CONSTRUCT |
+	                                                       G_PARAM_STATIC_STRINGS));
+
+	g_object_class_install_property (object_class,
+	                                 PROP_STATS,
+	                                 g_param_spec_string ("stats",
+	                                                      "Stats",
+	                                                      "Stats",
+	                                                      NULL,
+	                                                      G_PARAM_READWRITE |
+	                                                      G_PARAM_CONSTRUCT |
+	                                                      G_PARAM_STATIC_STRINGS));
+}
+
+static void
+gedit_message_bus_stats_init (GeditMessageBusStats *message)
+{
+	message->priv = gedit_message_bus_stats_get_instance_private (message);
+}
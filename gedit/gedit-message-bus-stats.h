@@ -0,0 +1,69 @@
+/*
+ * gedit-message-bus-stats.h
+ * This file is part of gedit
+ *
+ * gedit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gedit; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA  02110-1301  USA
+ */
+
+#ifndef GEDIT_MESSAGE_BUS_STATS_H
+#define GEDIT_MESSAGE_BUS_STATS_H
+
+#include "gedit-message.h"
+
+G_BEGIN_DECLS
+
+#define GEDIT_MESSAGE_BUS_STATS_OBJECT_PATH "/core/bus"
+#define GEDIT_MESSAGE_BUS_STATS_METHOD      "stats"
+
+#define GEDIT_TYPE_MESSAGE_BUS_STATS            (gedit_message_bus_stats_get_type ())
+#define GEDIT_MESSAGE_BUS_STATS(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj),\
+                                                 GEDIT_TYPE_MESSAGE_BUS_STATS,\
+                                                 GeditMessageBusStats))
+#define GEDIT_MESSAGE_BUS_STATS_CONST(obj)      (G_TYPE_CHECK_INSTANCE_CAST ((obj),\
+                                                 GEDIT_TYPE_MESSAGE_BUS_STATS,\
+                                                 GeditMessageBusStats const))
+#define GEDIT_MESSAGE_BUS_STATS_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),\
+                                                 GEDIT_TYPE_MESSAGE_BUS_STATS,\
+                                                 GeditMessageBusStatsClass))
+#define GEDIT_IS_MESSAGE_BUS_STATS(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj),\
+                                                 GEDIT_TYPE_MESSAGE_BUS_STATS))
+#define GEDIT_IS_MESSAGE_BUS_STATS_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),\
+                                                 GEDIT_TYPE_MESSAGE_BUS_STATS))
+#define GEDIT_MESSAGE_BUS_STATS_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),\
+                                                 GEDIT_TYPE_MESSAGE_BUS_STATS,\
+                                                 GeditMessageBusStatsClass))
+
+typedef struct _GeditMessageBusStats        GeditMessageBusStats;
+typedef struct _GeditMessageBusStatsClass   GeditMessageBusStatsClass;
+typedef struct _GeditMessageBusStatsPrivate GeditMessageBusStatsPrivate;
+
+struct _GeditMessageBusStats
+{
+	GeditMessage parent;
+
+	GeditMessageBusStatsPrivate *priv;
+};
+
+struct _GeditMessageBusStatsClass
+{
+	GeditMessageClass parent_class;
+};
+
+GType gedit_message_bus_stats_get_type (void) G_GNUC_CONST;
+
+G_END_DECLS
+
+#endif /* GEDIT_MESSAGE_BUS_STATS_H */
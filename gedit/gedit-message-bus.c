@@ -21,6 +21,9 @@
  */
 
 #include "gedit-message-bus.h"
+#include "gedit-message-bus-stats.h"
+#include "gedit-message-private.h"
+#include "gedit-debug.h"
 
 #include <string.h>
 #include <stdarg.h>
@@ -113,12 +116,14 @@
  *
  */
 
+/* The object path and the method are interned when a message is registered
+ * or connected to, so that looking messages up only hashes two integers and
+ * never allocates.
+ */
 typedef struct
 {
-	gchar *object_path;
-	gchar *method;
-
-	gchar *identifier;
+	GQuark object_path;
+	GQuark method;
 } MessageIdentifier;
 
 typedef struct
@@ -144,12 +149,72 @@ typedef struct
 	GList *listener;
 } IdMap;
 
+/* The messages sent asynchronously are dispatched from an idle, as many as
+ * fit in the time budget per main loop iteration. When some are left, the
+ * idle goes on at a lower priority so that input and redraws get a turn.
+ */
+#define DISPATCH_TIME_BUDGET (5 * G_TIME_SPAN_MILLISECOND)
+
+#define DEFAULT_HIGH_WATER_MARK 1024
+
+#define N_PRIORITIES (GEDIT_MESSAGE_BUS_PRIORITY_LOW + 1)
+
+#define RING_MIN_SIZE 16
+#define RING_MAX_IDLE_SIZE 256
+
+/* listener calls below 10us, 100us, 1ms, 10ms, 100ms and above */
+#define N_LATENCY_BUCKETS 6
+
+/* The statistics of an object path and method. They are only collected
+ * when asked for through /core/bus.stats or the GEDIT_DEBUG_MESSAGE_BUS
+ * debug section, otherwise the bus does not even look them up.
+ */
+typedef struct
+{
+	guint64 n_sent;
+	guint64 n_coalesced;
+	guint64 n_dispatched;
+	guint n_queued;
+	guint max_queued;
+
+	guint64 n_calls;
+	gint64 total_time;
+	gint64 max_time;
+	guint64 latency[N_LATENCY_BUCKETS];
+} RouteStats;
+
+typedef struct
+{
+	/* NULL when a message sent later at another priority took over */
+	GeditMessage *message;
+
+	GeditMessageBusPriority priority;
+	GQuark object_path;
+	GQuark method;
+	gchar *key;
+} QueuedMessage;
+
+typedef struct
+{
+	QueuedMessage **items;
+	guint head;
+	guint length;
+	guint size;
+} MessageRing;
+
 struct _GeditMessageBusPrivate
 {
 	GHashTable *messages;
 	GHashTable *idmap;
 
-	GList *message_queue;
+	MessageRing queues[N_PRIORITIES];
+	GHashTable *pending_keys; /* the queued messages with a coalesce key */
+	guint n_pending;
+	guint high_water_mark;
+	gboolean above_high_water;
+
+	GHashTable *stats; /* NULL unless collecting statistics */
+	guint max_pending;
 	guint idle_id;
 
 	guint next_id;
@@ -163,6 +228,7 @@ enum
 	DISPATCH,
 	REGISTERED,
 	UNREGISTERED,
+	HIGH_WATER_MARK,
 	LAST_SIGNAL
 };
 
@@ -181,36 +247,49 @@ message_identifier_new (const gchar *object_path,
 
 	ret = g_slice_new (MessageIdentifier);
 
-	ret->object_path = g_strdup (object_path);
-	ret->method = g_strdup (method);
-
-	ret->identifier = gedit_message_type_identifier (object_path, method);
+	ret->object_path = g_quark_from_string (object_path);
+	ret->method = g_quark_from_string (method);
 
 	return ret;
 }
 
+/* Fills a lookup key, returns FALSE when nothing can be registered for
+ * @method at @object_path since they were never interned.
+ */
+static gboolean
+message_identifier_init (MessageIdentifier *identifier,
+                         const gchar       *object_path,
+                         const gchar       *method)
+{
+	identifier->object_path = g_quark_try_string (object_path);
+	identifier->method = g_quark_try_string (method);
+
+	return identifier->object_path != 0 && identifier->method != 0;
+}
+
 static void
 message_identifier_free (MessageIdentifier *identifier)
 {
-	g_free (identifier->object_path);
-	g_free (identifier->method);
-	g_free (identifier->identifier);
-
 	g_slice_free (MessageIdentifier, identifier);
 }
 
 static guint
 message_identifier_hash (gconstpointer id)
 {
-	return g_str_hash (((MessageIdentifier *)id)->identifier);
+	const MessageIdentifier *identifier = id;
+
+	return identifier->object_path * 31 + identifier->method;
 }
 
 static gboolean
 message_identifier_equal (gconstpointer id1,
                           gconstpointer id2)
 {
-	return g_str_equal (((MessageIdentifier *)id1)->identifier,
-	                    ((MessageIdentifier *)id2)->identifier);
+	const MessageIdentifier *identifier1 = id1;
+	const MessageIdentifier *identifier2 = id2;
+
+	return identifier1->object_path == identifier2->object_path &&
+	       identifier1->method == identifier2->method;
 }
 
 static void
@@ -234,22 +313,298 @@ message_free (Message *message)
 }
 
 static void
-message_queue_free (GList *queue)
+queued_message_free (QueuedMessage *queued)
+{
+	if (queued->message != NULL)
+	{
+		g_object_unref (queued->message);
+	}
+
+	g_free (queued->key);
+	g_slice_free (QueuedMessage, queued);
+}
+
+static guint
+queued_message_hash (gconstpointer data)
+{
+	const QueuedMessage *queued = data;
+
+	return (queued->object_path * 31 + queued->method) * 31 +
+	       g_str_hash (queued->key);
+}
+
+static gboolean
+queued_message_equal (gconstpointer data1,
+                      gconstpointer data2)
+{
+	const QueuedMessage *queued1 = data1;
+	const QueuedMessage *queued2 = data2;
+
+	return queued1->object_path == queued2->object_path &&
+	       queued1->method == queued2->method &&
+	       strcmp (queued1->key, queued2->key) == 0;
+}
+
+static void
+message_ring_push (MessageRing   *ring,
+                   QueuedMessage *queued)
+{
+	if (ring->length == ring->size)
+	{
+		QueuedMessage **items;
+		guint size;
+		guint i;
+
+		size = ring->size == 0 ? RING_MIN_SIZE : ring->size * 2;
+		items = g_new (QueuedMessage *, size);
+
+		for (i = 0; i < ring->length; i++)
+		{
+			items[i] = ring->items[(ring->head + i) % ring->size];
+		}
+
+		g_free (ring->items);
+
+		ring->items = items;
+		ring->head = 0;
+		ring->size = size;
+	}
+
+	ring->items[(ring->head + ring->length) % ring->size] = queued;
+	ring->length++;
+}
+
+static QueuedMessage *
+message_ring_pop (MessageRing *ring)
+{
+	QueuedMessage *queued;
+
+	if (ring->length == 0)
+	{
+		return NULL;
+	}
+
+	queued = ring->items[ring->head];
+	ring->head = (ring->head + 1) % ring->size;
+	ring->length--;
+
+	/* do not keep the memory of a burst around */
+	if (ring->length == 0 && ring->size > RING_MAX_IDLE_SIZE)
+	{
+		g_free (ring->items);
+		ring->items = NULL;
+		ring->head = 0;
+		ring->size = 0;
+	}
+
+	return queued;
+}
+
+static void
+message_ring_clear (MessageRing *ring)
+{
+	QueuedMessage *queued;
+
+	while ((queued = message_ring_pop (ring)) != NULL)
+	{
+		queued_message_free (queued);
+	}
+
+	g_free (ring->items);
+	ring->items = NULL;
+	ring->size = 0;
+}
+
+static void
+route_stats_free (RouteStats *stats)
+{
+	g_slice_free (RouteStats, stats);
+}
+
+static RouteStats *
+route_stats_lookup (GeditMessageBus *bus,
+                    GQuark           object_path,
+                    GQuark           method)
+{
+	MessageIdentifier identifier;
+	RouteStats *stats;
+
+	identifier.object_path = object_path;
+	identifier.method = method;
+
+	stats = g_hash_table_lookup (bus->priv->stats, &identifier);
+
+	if (stats == NULL)
+	{
+		MessageIdentifier *key;
+
+		key = g_slice_new (MessageIdentifier);
+		*key = identifier;
+
+		stats = g_slice_new0 (RouteStats);
+		g_hash_table_insert (bus->priv->stats, key, stats);
+	}
+
+	return stats;
+}
+
+static void
+route_stats_add_call (RouteStats *stats,
+                      gint64      elapsed)
+{
+	gint64 limit = 10;
+	guint bucket = 0;
+
+	while (bucket < N_LATENCY_BUCKETS - 1 && elapsed >= limit)
+	{
+		limit *= 10;
+		bucket++;
+	}
+
+	stats->latency[bucket]++;
+	stats->n_calls++;
+	stats->total_time += elapsed;
+	stats->max_time = MAX (stats->max_time, elapsed);
+}
+
+static void
+set_stats_enabled (GeditMessageBus *bus,
+                   gboolean         enabled)
+{
+	if (enabled && bus->priv->stats == NULL)
+	{
+		bus->priv->stats = g_hash_table_new_full (message_identifier_hash,
+		                                          message_identifier_equal,
+		                                          (GDestroyNotify) message_identifier_free,
+		                                          (GDestroyNotify) route_stats_free);
+		bus->priv->max_pending = bus->priv->n_pending;
+	}
+	else if (!enabled && bus->priv->stats != NULL)
+	{
+		g_hash_table_destroy (bus->priv->stats);
+		bus->priv->stats = NULL;
+	}
+}
+
+static gint
+compare_route_stats (MessageIdentifier *identifier1,
+                     MessageIdentifier *identifier2,
+                     GHashTable        *table)
 {
-	g_list_free_full (queue, g_object_unref);
+	RouteStats *stats1 = g_hash_table_lookup (table, identifier1);
+	RouteStats *stats2 = g_hash_table_lookup (table, identifier2);
+
+	/* the routes where the most time went first */
+	if (stats1->total_time != stats2->total_time)
+	{
+		return stats1->total_time < stats2->total_time ? 1 : -1;
+	}
+
+	if (stats1->n_sent != stats2->n_sent)
+	{
+		return stats1->n_sent < stats2->n_sent ? 1 : -1;
+	}
+
+	return 0;
+}
+
+static gchar *
+stats_dump (GeditMessageBus *bus)
+{
+	static const gchar *bucket_names[N_LATENCY_BUCKETS] = {
+		"<10us", "<100us", "<1ms", "<10ms", "<100ms", ">=100ms"
+	};
+	GString *str;
+	GList *routes;
+	GList *item;
+
+	str = g_string_new (NULL);
+
+	g_string_append_printf (str,
+	                        "pending %u (max %u)\n",
+	                        bus->priv->n_pending,
+	                        bus->priv->max_pending);
+
+	routes = g_hash_table_get_keys (bus->priv->stats);
+	routes = g_list_sort_with_data (routes,
+	                                (GCompareDataFunc) compare_route_stats,
+	                                bus->priv->stats);
+
+	for (item = routes; item != NULL; item = item->next)
+	{
+		MessageIdentifier *identifier = item->data;
+		RouteStats *stats;
+		guint i;
+
+		stats = g_hash_table_lookup (bus->priv->stats, identifier);
+
+		g_string_append_printf (str,
+		                        "%s.%s: sent %" G_GUINT64_FORMAT
+		                        ", coalesced %" G_GUINT64_FORMAT
+		                        ", queued %u (max %u)"
+		                        ", dispatched %" G_GUINT64_FORMAT
+		                        ", %" G_GUINT64_FORMAT " listener calls"
+		                        " in %.3fms (max %.3fms)",
+		                        g_quark_to_string (identifier->object_path),
+		                        g_quark_to_string (identifier->method),
+		                        stats->n_sent,
+		                        stats->n_coalesced,
+		                        stats->n_queued,
+		                        stats->max_queued,
+		                        stats->n_dispatched,
+		                        stats->n_calls,
+		                        stats->total_time / 1000.0,
+		                        stats->max_time / 1000.0);
+
+		for (i = 0; i < N_LATENCY_BUCKETS; i++)
+		{
+			g_string_append_printf (str,
+			                        "%s %s %" G_GUINT64_FORMAT,
+			                        i == 0 ? ":" : ",",
+			                        bucket_names[i],
+			                        stats->latency[i]);
+		}
+
+		g_string_append_c (str, '\n');
+	}
+
+	g_list_free (routes);
+
+	return g_string_free (str, FALSE);
 }
 
 static void
 gedit_message_bus_finalize (GObject *object)
 {
 	GeditMessageBus *bus = GEDIT_MESSAGE_BUS (object);
+	gint i;
 
 	if (bus->priv->idle_id != 0)
 	{
 		g_source_remove (bus->priv->idle_id);
 	}
 
-	message_queue_free (bus->priv->message_queue);
+	if (bus->priv->stats != NULL)
+	{
+		if (gedit_debug_is_enabled (GEDIT_DEBUG_MESSAGE_BUS))
+		{
+			gchar *dump;
+
+			dump = stats_dump (bus);
+			gedit_debug_message (DEBUG_MESSAGE_BUS, "\n%s", dump);
+			g_free (dump);
+		}
+
+		g_hash_table_destroy (bus->priv->stats);
+	}
+
+	/* the keys are owned by the queued messages */
+	g_hash_table_destroy (bus->priv->pending_keys);
+
+	for (i = 0; i < N_PRIORITIES; i++)
+	{
+		message_ring_clear (&bus->priv->queues[i]);
+	}
 
 	g_hash_table_destroy (bus->priv->messages);
 	g_hash_table_destroy (bus->priv->idmap);
@@ -329,6 +684,28 @@ gedit_message_bus_class_init (GeditMessageBusClass *klass)
 		              2,
 		              G_TYPE_STRING,
 		              G_TYPE_STRING);
+
+	/**
+	 * GeditMessageBus::high-water-mark:
+	 * @bus: a #GeditMessageBus
+	 * @reached: whether the high water mark was reached
+	 *
+	 * The "high-water-mark" signal is emitted with @reached set to %TRUE
+	 * when the number of messages waiting to be dispatched reaches the
+	 * high water mark (see gedit_message_bus_set_high_water_mark()), and
+	 * with @reached set to %FALSE once it has dropped back to half of it.
+	 * Producers of many asynchronous messages can use it to throttle.
+	 *
+	 */
+	message_bus_signals[HIGH_WATER_MARK] =
+		g_signal_new ("high-water-mark",
+		              G_OBJECT_CLASS_TYPE (object_class),
+		              G_SIGNAL_RUN_LAST,
+		              0,
+		              NULL, NULL, NULL,
+		              G_TYPE_NONE,
+		              1,
+		              G_TYPE_BOOLEAN);
 }
 
 static Message *
@@ -354,12 +731,13 @@ lookup_message (GeditMessageBus *bus,
                 const gchar      *method,
                 gboolean          create)
 {
-	MessageIdentifier *identifier;
-	Message *message;
+	MessageIdentifier identifier;
+	Message *message = NULL;
 
-	identifier = message_identifier_new (object_path, method);
-	message = g_hash_table_lookup (bus->priv->messages, identifier);
-	message_identifier_free (identifier);
+	if (message_identifier_init (&identifier, object_path, method))
+	{
+		message = g_hash_table_lookup (bus->priv->messages, &identifier);
+	}
 
 	if (!message && !create)
 	{
@@ -453,15 +831,47 @@ dispatch_message_real (GeditMessageBus *bus,
                        GeditMessage    *message)
 {
 	GList *item;
+	GQuark object_path;
+	GQuark method;
+
+	/* a callback removing the last listener frees msg */
+	object_path = msg->identifier->object_path;
+	method = msg->identifier->method;
+
+	if (G_UNLIKELY (bus->priv->stats != NULL))
+	{
+		route_stats_lookup (bus, object_path, method)->n_dispatched++;
+	}
 
 	for (item = msg->listeners; item; item = item->next)
 	{
 		Listener *listener = (Listener *)item->data;
 
-		if (!listener->blocked)
+		if (listener->blocked)
+		{
+			continue;
+		}
+
+		if (G_LIKELY (bus->priv->stats == NULL))
 		{
 			listener->callback (bus, message, listener->user_data);
 		}
+		else
+		{
+			gint64 start;
+			gint64 elapsed;
+
+			start = g_get_monotonic_time ();
+			listener->callback (bus, message, listener->user_data);
+			elapsed = g_get_monotonic_time () - start;
+
+			/* the listener may have turned the statistics off */
+			if (bus->priv->stats != NULL)
+			{
+				route_stats_add_call (route_stats_lookup (bus, object_path, method),
+				                      elapsed);
+			}
+		}
 	}
 }
 
@@ -469,17 +879,16 @@ static void
 gedit_message_bus_dispatch_real (GeditMessageBus *bus,
                                  GeditMessage    *message)
 {
-	const gchar *object_path;
-	const gchar *method;
+	MessageIdentifier identifier;
 	Message *msg;
 
-	object_path = gedit_message_get_object_path (message);
-	method = gedit_message_get_method (message);
+	identifier.object_path = _gedit_message_get_object_path_quark (message);
+	identifier.method = _gedit_message_get_method_quark (message);
 
-	g_return_if_fail (object_path != NULL);
-	g_return_if_fail (method != NULL);
+	g_return_if_fail (identifier.object_path != 0);
+	g_return_if_fail (identifier.method != 0);
 
-	msg = lookup_message (bus, object_path, method, FALSE);
+	msg = g_hash_table_lookup (bus->priv->messages, &identifier);
 
 	if (msg)
 	{
@@ -487,6 +896,18 @@ gedit_message_bus_dispatch_real (GeditMessageBus *bus,
 	}
 }
 
+static void
+count_sync_send (GeditMessageBus *bus,
+                 GeditMessage    *message)
+{
+	if (G_UNLIKELY (bus->priv->stats != NULL))
+	{
+		route_stats_lookup (bus,
+		                    _gedit_message_get_object_path_quark (message),
+		                    _gedit_message_get_method_quark (message))->n_sent++;
+	}
+}
+
 static void
 dispatch_message (GeditMessageBus *bus,
                   GeditMessage    *message)
@@ -494,28 +915,120 @@ dispatch_message (GeditMessageBus *bus,
 	g_signal_emit (bus, message_bus_signals[DISPATCH], 0, message);
 }
 
+static void
+update_high_water (GeditMessageBus *bus)
+{
+	guint mark = bus->priv->high_water_mark;
+	gboolean above = bus->priv->above_high_water;
+
+	if (!above && mark > 0 && bus->priv->n_pending >= mark)
+	{
+		above = TRUE;
+	}
+	else if (above && (mark == 0 || bus->priv->n_pending <= mark / 2))
+	{
+		above = FALSE;
+	}
+
+	if (above != bus->priv->above_high_water)
+	{
+		bus->priv->above_high_water = above;
+
+		g_signal_emit (bus, message_bus_signals[HIGH_WATER_MARK], 0, above);
+	}
+}
+
+static QueuedMessage *
+pop_message (GeditMessageBus *bus)
+{
+	gint i;
+
+	for (i = 0; i < N_PRIORITIES; i++)
+	{
+		QueuedMessage *queued;
+
+		queued = message_ring_pop (&bus->priv->queues[i]);
+
+		if (queued == NULL)
+		{
+			continue;
+		}
+
+		/* superseded messages were already taken off the count */
+		if (queued->message != NULL)
+		{
+			if (queued->key != NULL)
+			{
+				g_hash_table_remove (bus->priv->pending_keys, queued);
+			}
+
+			if (G_UNLIKELY (bus->priv->stats != NULL))
+			{
+				RouteStats *stats;
+
+				stats = route_stats_lookup (bus,
+				                            queued->object_path,
+				                            queued->method);
+
+				if (stats->n_queued > 0)
+				{
+					stats->n_queued--;
+				}
+			}
+
+			bus->priv->n_pending--;
+		}
+
+		return queued;
+	}
+
+	return NULL;
+}
+
 static gboolean
 idle_dispatch (GeditMessageBus *bus)
 {
-	GList *list;
-	GList *item;
+	QueuedMessage *queued;
+	gint64 deadline;
 
-	/* make sure to set idle_id to 0 first so that any new async messages
-	   will be queued properly */
-	bus->priv->idle_id = 0;
+	deadline = g_get_monotonic_time () + DISPATCH_TIME_BUDGET;
 
-	/* reverse queue to get correct delivery order */
-	list = g_list_reverse (bus->priv->message_queue);
-	bus->priv->message_queue = NULL;
+	/* a listener may drop the last reference to the bus */
+	g_object_ref (bus);
 
-	for (item = list; item; item = item->next)
+	/* messages sent by the listeners go to the queues and are picked up
+	   by this same loop, idle_id stays set until it is done */
+	while ((queued = pop_message (bus)) != NULL)
 	{
-		GeditMessage *msg = GEDIT_MESSAGE (item->data);
+		if (queued->message != NULL)
+		{
+			dispatch_message (bus, queued->message);
+		}
+
+		queued_message_free (queued);
 
-		dispatch_message (bus, msg);
+		update_high_water (bus);
+
+		if (g_get_monotonic_time () >= deadline)
+		{
+			break;
+		}
 	}
 
-	message_queue_free (list);
+	if (bus->priv->n_pending > 0)
+	{
+		bus->priv->idle_id = g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
+		                                      (GSourceFunc)idle_dispatch,
+		                                      bus,
+		                                      NULL);
+	}
+	else
+	{
+		bus->priv->idle_id = 0;
+	}
+
+	g_object_unref (bus);
+
 	return FALSE;
 }
 
@@ -579,6 +1092,37 @@ free_type (gpointer data)
 	g_slice_free (GType, data);
 }
 
+static void
+on_stats_message (GeditMessageBus *bus,
+                  GeditMessage    *message,
+                  gpointer         user_data)
+{
+	gboolean enabled;
+	gboolean reset;
+	gchar *dump = NULL;
+
+	g_object_get (message,
+	              "enabled", &enabled,
+	              "reset", &reset,
+	              NULL);
+
+	if (bus->priv->stats != NULL)
+	{
+		dump = stats_dump (bus);
+
+		if (reset)
+		{
+			g_hash_table_remove_all (bus->priv->stats);
+			bus->priv->max_pending = bus->priv->n_pending;
+		}
+	}
+
+	set_stats_enabled (bus, enabled);
+
+	g_object_set (message, "stats", dump, NULL);
+	g_free (dump);
+}
+
 static void
 gedit_message_bus_init (GeditMessageBus *self)
 {
@@ -598,6 +1142,28 @@ gedit_message_bus_init (GeditMessageBus *self)
 	                                           message_identifier_equal,
 	                                           (GDestroyNotify) message_identifier_free,
 	                                           (GDestroyNotify) free_type);
+
+	self->priv->pending_keys = g_hash_table_new (queued_message_hash,
+	                                             queued_message_equal);
+
+	self->priv->high_water_mark = DEFAULT_HIGH_WATER_MARK;
+
+	gedit_message_bus_register (self,
+	                            GEDIT_TYPE_MESSAGE_BUS_STATS,
+	                            GEDIT_MESSAGE_BUS_STATS_OBJECT_PATH,
+	                            GEDIT_MESSAGE_BUS_STATS_METHOD);
+
+	gedit_message_bus_connect (self,
+	                           GEDIT_MESSAGE_BUS_STATS_OBJECT_PATH,
+	                           GEDIT_MESSAGE_BUS_STATS_METHOD,
+	                           on_stats_message,
+	                           NULL,
+	                           NULL);
+
+	if (gedit_debug_is_enabled (GEDIT_DEBUG_MESSAGE_BUS))
+	{
+		set_stats_enabled (self, TRUE);
+	}
 }
 
 /**
@@ -658,16 +1224,19 @@ gedit_message_bus_lookup (GeditMessageBus *bus,
                           const gchar	  *object_path,
                           const gchar	  *method)
 {
-	MessageIdentifier *identifier;
+	MessageIdentifier identifier;
 	GType *message_type;
 
 	g_return_val_if_fail (GEDIT_IS_MESSAGE_BUS (bus), G_TYPE_INVALID);
 	g_return_val_if_fail (object_path != NULL, G_TYPE_INVALID);
 	g_return_val_if_fail (method != NULL, G_TYPE_INVALID);
 
-	identifier = message_identifier_new (object_path, method);
-	message_type = g_hash_table_lookup (bus->priv->types, identifier);
-	message_identifier_free (identifier);
+	if (!message_identifier_init (&identifier, object_path, method))
+	{
+		return G_TYPE_INVALID;
+	}
+
+	message_type = g_hash_table_lookup (bus->priv->types, &identifier);
 
 	if (!message_type)
 	{
@@ -735,12 +1304,11 @@ gedit_message_bus_unregister_real (GeditMessageBus  *bus,
                                    const gchar      *method,
                                    gboolean          remove_from_store)
 {
-	MessageIdentifier *identifier;
-
-	identifier = message_identifier_new (object_path, method);
+	MessageIdentifier identifier;
 
-	if (!remove_from_store || g_hash_table_remove (bus->priv->types,
-	                                               identifier))
+	if (!remove_from_store ||
+	    (message_identifier_init (&identifier, object_path, method) &&
+	     g_hash_table_remove (bus->priv->types, &identifier)))
 	{
 		g_signal_emit (bus,
 		               message_bus_signals[UNREGISTERED],
@@ -748,8 +1316,6 @@ gedit_message_bus_unregister_real (GeditMessageBus  *bus,
 		               object_path,
 		               method);
 	}
-
-	message_identifier_free (identifier);
 }
 
 /**
@@ -782,7 +1348,7 @@ gedit_message_bus_unregister (GeditMessageBus  *bus,
 typedef struct
 {
 	GeditMessageBus *bus;
-	const gchar *object_path;
+	GQuark object_path;
 } UnregisterInfo;
 
 static gboolean
@@ -790,11 +1356,11 @@ unregister_each (MessageIdentifier *identifier,
                  GType             *gtype,
                  UnregisterInfo    *info)
 {
-	if (g_strcmp0 (identifier->object_path, info->object_path) == 0)
+	if (identifier->object_path == info->object_path)
 	{
 		gedit_message_bus_unregister_real (info->bus,
-		                                   identifier->object_path,
-		                                   identifier->method,
+		                                   g_quark_to_string (identifier->object_path),
+		                                   g_quark_to_string (identifier->method),
 		                                   FALSE);
 
 		return TRUE;
@@ -819,11 +1385,18 @@ void
 gedit_message_bus_unregister_all (GeditMessageBus *bus,
                                   const gchar     *object_path)
 {
-	UnregisterInfo info = {bus, object_path};
+	UnregisterInfo info = {bus, 0};
 
 	g_return_if_fail (GEDIT_IS_MESSAGE_BUS (bus));
 	g_return_if_fail (object_path != NULL);
 
+	info.object_path = g_quark_try_string (object_path);
+
+	if (info.object_path == 0)
+	{
+		return;
+	}
+
 	g_hash_table_foreach_remove (bus->priv->types,
 	                             (GHRFunc)unregister_each,
 	                             &info);
@@ -847,18 +1420,14 @@ gedit_message_bus_is_registered (GeditMessageBus  *bus,
                                  const gchar	  *object_path,
                                  const gchar      *method)
 {
-	MessageIdentifier *identifier;
-	gboolean ret;
+	MessageIdentifier identifier;
 
 	g_return_val_if_fail (GEDIT_IS_MESSAGE_BUS (bus), FALSE);
 	g_return_val_if_fail (object_path != NULL, FALSE);
 	g_return_val_if_fail (method != NULL, FALSE);
 
-	identifier = message_identifier_new (object_path, method);
-	ret = g_hash_table_lookup (bus->priv->types, identifier) != NULL;
-	message_identifier_free (identifier);
-
-	return ret;
+	return message_identifier_init (&identifier, object_path, method) &&
+	       g_hash_table_lookup (bus->priv->types, &identifier) != NULL;
 }
 
 typedef struct
@@ -872,8 +1441,8 @@ foreach_type (MessageIdentifier *identifier,
               GType              *message_type,
               ForeachInfo       *info)
 {
-	info->func (identifier->object_path,
-	            identifier->method,
+	info->func (g_quark_to_string (identifier->object_path),
+	            g_quark_to_string (identifier->method),
 	            info->user_data);
 }
 
@@ -1076,11 +1645,83 @@ gedit_message_bus_unblock_by_func (GeditMessageBus      *bus,
 }
 
 static void
-send_message_real (GeditMessageBus *bus,
-                   GeditMessage    *message)
+send_message_real (GeditMessageBus         *bus,
+                   GeditMessage            *message,
+                   GeditMessageBusPriority  priority,
+                   const gchar             *coalesce_key)
 {
-	bus->priv->message_queue = g_list_prepend (bus->priv->message_queue,
-	                                           g_object_ref (message));
+	QueuedMessage *queued;
+	RouteStats *stats = NULL;
+
+	queued = g_slice_new (QueuedMessage);
+	queued->message = g_object_ref (message);
+	queued->priority = priority;
+	queued->object_path = _gedit_message_get_object_path_quark (message);
+	queued->method = _gedit_message_get_method_quark (message);
+	queued->key = g_strdup (coalesce_key);
+
+	if (G_UNLIKELY (bus->priv->stats != NULL))
+	{
+		stats = route_stats_lookup (bus, queued->object_path, queued->method);
+		stats->n_sent++;
+	}
+
+	if (coalesce_key != NULL)
+	{
+		QueuedMessage *pending;
+
+		pending = g_hash_table_lookup (bus->priv->pending_keys, queued);
+
+		if (pending != NULL && pending->priority == priority)
+		{
+			/* the new message replaces the pending one in place */
+			g_object_unref (pending->message);
+			pending->message = queued->message;
+			queued->message = NULL;
+
+			if (stats != NULL)
+			{
+				stats->n_coalesced++;
+			}
+
+			queued_message_free (queued);
+			return;
+		}
+
+		if (pending != NULL)
+		{
+			/* the pending one is skipped, the new one is queued
+			   at its own priority */
+			g_object_unref (pending->message);
+			pending->message = NULL;
+			bus->priv->n_pending--;
+
+			if (stats != NULL)
+			{
+				stats->n_coalesced++;
+
+				if (stats->n_queued > 0)
+				{
+					stats->n_queued--;
+				}
+			}
+		}
+
+		g_hash_table_replace (bus->priv->pending_keys, queued, queued);
+	}
+
+	message_ring_push (&bus->priv->queues[priority], queued);
+	bus->priv->n_pending++;
+
+	if (stats != NULL)
+	{
+		stats->n_queued++;
+		stats->max_queued = MAX (stats->max_queued, stats->n_queued);
+		bus->priv->max_pending = MAX (bus->priv->max_pending,
+		                              bus->priv->n_pending);
+	}
+
+	update_high_water (bus);
 
 	if (bus->priv->idle_id == 0)
 	{
@@ -1109,7 +1750,97 @@ gedit_message_bus_send_message (GeditMessageBus *bus,
 	g_return_if_fail (GEDIT_IS_MESSAGE_BUS (bus));
 	g_return_if_fail (GEDIT_IS_MESSAGE (message));
 
-	send_message_real (bus, message);
+	send_message_real (bus,
+	                   message,
+	                   GEDIT_MESSAGE_BUS_PRIORITY_DEFAULT,
+	                   NULL);
+}
+
+/**
+ * gedit_message_bus_send_message_full:
+ * @bus: a #GeditMessageBus
+ * @message: the message to send
+ * @priority: the priority class of the message
+ * @coalesce_key: (allow-none): a key to coalesce the message with, or %NULL
+ *
+ * This sends the provided @message asynchronously over the bus, like
+ * gedit_message_bus_send_message(). Messages of a higher @priority are
+ * dispatched first, messages of the same priority in the order they were
+ * sent.
+ *
+ * When @coalesce_key is not %NULL and a message for the same method at the
+ * same object path was sent with the same key and is still waiting to be
+ * dispatched, only @message is dispatched. This is useful for messages
+ * which only carry the latest state of something.
+ *
+ */
+void
+gedit_message_bus_send_message_full (GeditMessageBus         *bus,
+                                     GeditMessage            *message,
+                                     GeditMessageBusPriority  priority,
+                                     const gchar             *coalesce_key)
+{
+	g_return_if_fail (GEDIT_IS_MESSAGE_BUS (bus));
+	g_return_if_fail (GEDIT_IS_MESSAGE (message));
+	g_return_if_fail (priority <= GEDIT_MESSAGE_BUS_PRIORITY_LOW);
+
+	send_message_real (bus, message, priority, coalesce_key);
+}
+
+/**
+ * gedit_message_bus_get_n_pending:
+ * @bus: a #GeditMessageBus
+ *
+ * Get the number of messages sent asynchronously which are still waiting
+ * to be dispatched.
+ *
+ * Return value: the number of pending messages
+ *
+ */
+guint
+gedit_message_bus_get_n_pending (GeditMessageBus *bus)
+{
+	g_return_val_if_fail (GEDIT_IS_MESSAGE_BUS (bus), 0);
+
+	return bus->priv->n_pending;
+}
+
+/**
+ * gedit_message_bus_get_high_water_mark:
+ * @bus: a #GeditMessageBus
+ *
+ * Get the number of pending messages at which the
+ * #GeditMessageBus::high-water-mark signal is emitted.
+ *
+ * Return value: the high water mark, 0 when disabled
+ *
+ */
+guint
+gedit_message_bus_get_high_water_mark (GeditMessageBus *bus)
+{
+	g_return_val_if_fail (GEDIT_IS_MESSAGE_BUS (bus), 0);
+
+	return bus->priv->high_water_mark;
+}
+
+/**
+ * gedit_message_bus_set_high_water_mark:
+ * @bus: a #GeditMessageBus
+ * @high_water_mark: the number of pending messages, or 0 to disable
+ *
+ * Sets the number of pending messages at which the
+ * #GeditMessageBus::high-water-mark signal is emitted. The default is 1024.
+ *
+ */
+void
+gedit_message_bus_set_high_water_mark (GeditMessageBus *bus,
+                                       guint            high_water_mark)
+{
+	g_return_if_fail (GEDIT_IS_MESSAGE_BUS (bus));
+
+	bus->priv->high_water_mark = high_water_mark;
+
+	update_high_water (bus);
 }
 
 /**
@@ -1130,6 +1861,7 @@ gedit_message_bus_send_message_sync (GeditMessageBus *bus,
 	g_return_if_fail (GEDIT_IS_MESSAGE_BUS (bus));
 	g_return_if_fail (GEDIT_IS_MESSAGE (message));
 
+	count_sync_send (bus, message);
 	dispatch_message (bus, message);
 }
 
@@ -1204,7 +1936,10 @@ gedit_message_bus_send (GeditMessageBus *bus,
 
 	if (message)
 	{
-		send_message_real (bus, message);
+		send_message_real (bus,
+		                   message,
+		                   GEDIT_MESSAGE_BUS_PRIORITY_DEFAULT,
+		                   NULL);
 		g_object_unref (message);
 	}
 	else
@@ -1251,6 +1986,7 @@ gedit_message_bus_send_sync (GeditMessageBus *bus,
 
 	if (message)
 	{
+		count_sync_send (bus, message);
 		dispatch_message (bus, message);
 	}
 
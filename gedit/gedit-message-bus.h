@@ -36,6 +36,22 @@ G_BEGIN_DECLS
 #define GEDIT_IS_MESSAGE_BUS_CLASS(klass)	(G_TYPE_CHECK_CLASS_TYPE ((klass), GEDIT_TYPE_MESSAGE_BUS))
 #define GEDIT_MESSAGE_BUS_GET_CLASS(obj)	(G_TYPE_INSTANCE_GET_CLASS ((obj), GEDIT_TYPE_MESSAGE_BUS, GeditMessageBusClass))
 
+/**
+ * GeditMessageBusPriority:
+ * @GEDIT_MESSAGE_BUS_PRIORITY_HIGH: dispatched before the other messages
+ * @GEDIT_MESSAGE_BUS_PRIORITY_DEFAULT: the priority of
+ * gedit_message_bus_send_message()
+ * @GEDIT_MESSAGE_BUS_PRIORITY_LOW: dispatched after the other messages
+ *
+ * The priority classes of the messages sent asynchronously.
+ */
+typedef enum
+{
+	GEDIT_MESSAGE_BUS_PRIORITY_HIGH,
+	GEDIT_MESSAGE_BUS_PRIORITY_DEFAULT,
+	GEDIT_MESSAGE_BUS_PRIORITY_LOW
+} GeditMessageBusPriority;
+
 typedef struct _GeditMessageBus		GeditMessageBus;
 typedef struct _GeditMessageBusClass	GeditMessageBusClass;
 typedef struct _GeditMessageBusPrivate	GeditMessageBusPrivate;
@@ -134,6 +150,15 @@ void              gedit_message_bus_send_message       (GeditMessageBus        *
                                                         GeditMessage           *message);
 void              gedit_message_bus_send_message_sync  (GeditMessageBus        *bus,
                                                         GeditMessage           *message);
+void              gedit_message_bus_send_message_full  (GeditMessageBus        *bus,
+                                                        GeditMessage           *message,
+                                                        GeditMessageBusPriority priority,
+                                                        const gchar            *coalesce_key);
+
+guint             gedit_message_bus_get_n_pending      (GeditMessageBus        *bus);
+guint             gedit_message_bus_get_high_water_mark (GeditMessageBus       *bus);
+void              gedit_message_bus_set_high_water_mark (GeditMessageBus       *bus,
+                                                        guint                   high_water_mark);
 
 void              gedit_message_bus_send               (GeditMessageBus        *bus,
                                                         const gchar            *object_path,
@@ -0,0 +1,35 @@
+/*
+ * gedit-message-private.h
+ * This file is part of gedit
+ *
+ * gedit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gedit; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA  02110-1301  USA
+ */
+
+#ifndef GEDIT_MESSAGE_PRIVATE_H
+#define GEDIT_MESSAGE_PRIVATE_H
+
+#include "gedit-message.h"
+
+G_BEGIN_DECLS
+
+GQuark		 _gedit_message_get_object_path_quark	(GeditMessage *message);
+GQuark		 _gedit_message_get_method_quark	(GeditMessage *message);
+
+G_END_DECLS
+
+#endif /* GEDIT_MESSAGE_PRIVATE_H */
+
+/* ex:set ts=8 noet: */
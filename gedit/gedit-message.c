@@ -21,6 +21,7 @@
  */
 
 #include "gedit-message.h"
+#include "gedit-message-private.h"
 
 #include <string.h>
 
@@ -41,10 +42,13 @@
  * Since: 2.26
  */
 
+/* The object path and the method are interned, the bus looks messages up
+ * by these quarks.
+ */
 struct _GeditMessagePrivate
 {
-	gchar *object_path;
-	gchar *method;
+	GQuark object_path;
+	GQuark method;
 };
 
 enum
@@ -59,17 +63,6 @@ static GParamSpec *properties[LAST_PROP];
 
 G_DEFINE_TYPE_WITH_PRIVATE (GeditMessage, gedit_message, G_TYPE_OBJECT)
 
-static void
-gedit_message_finalize (GObject *object)
-{
-	GeditMessage *message = GEDIT_MESSAGE (object);
-
-	g_free (message->priv->object_path);
-	g_free (message->priv->method);
-
-	G_OBJECT_CLASS (gedit_message_parent_class)->finalize (object);
-}
-
 static void
 gedit_message_get_property (GObject    *object,
                             guint       prop_id,
@@ -81,12 +74,12 @@ gedit_message_get_property (GObject    *object,
 	switch (prop_id)
 	{
 		case PROP_OBJECT_PATH:
-			g_value_set_string (value,
-			                    msg->priv->object_path);
+			g_value_set_static_string (value,
+			                           g_quark_to_string (msg->priv->object_path));
 			break;
 		case PROP_METHOD:
-			g_value_set_string (value,
-			                    msg->priv->method);
+			g_value_set_static_string (value,
+			                           g_quark_to_string (msg->priv->method));
 			break;
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -105,12 +98,10 @@ gedit_message_set_property (GObject      *object,
 	switch (prop_id)
 	{
 		case PROP_OBJECT_PATH:
-			g_free (msg->priv->object_path);
-			msg->priv->object_path = g_value_dup_string (value);
+			msg->priv->object_path = g_quark_from_string (g_value_get_string (value));
 			break;
 		case PROP_METHOD:
-			g_free (msg->priv->method);
-			msg->priv->method = g_value_dup_string (value);
+			msg->priv->method = g_quark_from_string (g_value_get_string (value));
 			break;
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -123,8 +114,6 @@ gedit_message_class_init (GeditMessageClass *klass)
 {
 	GObjectClass *object_class = G_OBJECT_CLASS(klass);
 
-	object_class->finalize = gedit_message_finalize;
-
 	object_class->get_property = gedit_message_get_property;
 	object_class->set_property = gedit_message_set_property;
 
@@ -177,6 +166,12 @@ gedit_message_get_method (GeditMessage *message)
 {
 	g_return_val_if_fail (GEDIT_IS_MESSAGE (message), NULL);
 
+	return g_quark_to_string (message->priv->method);
+}
+
+GQuark
+_gedit_message_get_method_quark (GeditMessage *message)
+{
 	return message->priv->method;
 }
 
@@ -194,6 +189,12 @@ gedit_message_get_object_path (GeditMessage *message)
 {
 	g_return_val_if_fail (GEDIT_IS_MESSAGE (message), NULL);
 
+	return g_quark_to_string (message->priv->object_path);
+}
+
+GQuark
+_gedit_message_get_object_path_quark (GeditMessage *message)
+{
 	return message->priv->object_path;
 }
 
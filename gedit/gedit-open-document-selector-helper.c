@@ -20,6 +20,8 @@
 
 #include "gedit-open-document-selector-helper.h"
 
+#include "gedit-utils.h"
+
 void
 gedit_open_document_selector_debug_print_list (const gchar *title,
                                                GList       *fileitem_list)
@@ -62,6 +64,7 @@ gedit_open_document_selector_free_fileitem_item (FileItem *item)
 	g_free (item->uri);
 	g_free (item->name);
 	g_free (item->path);
+	g_free (item->key);
 
 	g_slice_free (FileItem, item);
 }
@@ -78,6 +81,13 @@ gedit_open_document_selector_copy_fileitem_item (FileItem *item)
 	new_item->path = g_strdup (item->path);
 	new_item->access_time = item->access_time;
 
+	if (item->key != NULL)
+	{
+		new_item->key = g_memdup (item->key, item->key_len * sizeof (gunichar));
+		new_item->key_len = item->key_len;
+		new_item->name_start = item->name_start;
+	}
+
 	return new_item;
 }
 
@@ -100,4 +110,130 @@ gedit_open_document_selector_free_file_items_list (GList *file_items_list)
 	                  (GDestroyNotify)gedit_open_document_selector_free_fileitem_item);
 }
 
+/* The character compared when searching: normalized then casefolded,
+ * keeping one character so that offsets in the key are offsets in the
+ * displayed text.
+ */
+static gunichar
+fold_char (gunichar c)
+{
+	gchar buf[6];
+	gint len;
+	gchar *normalized;
+	gchar *folded;
+	gunichar result;
+
+	if (c < 128)
+	{
+		return g_ascii_tolower (c);
+	}
+
+	len = g_unichar_to_utf8 (c, buf);
+	normalized = g_utf8_normalize (buf, len, G_NORMALIZE_ALL);
+
+	if (normalized == NULL)
+	{
+		return c;
+	}
+
+	folded = g_utf8_casefold (normalized, -1);
+	result = g_utf8_get_char (folded);
+
+	g_free (normalized);
+	g_free (folded);
+
+	return result;
+}
+
+gunichar *
+gedit_open_document_selector_fold_string (const gchar *str,
+                                          gboolean     skip_spaces,
+                                          glong       *len)
+{
+	gunichar *folded;
+	const gchar *p;
+	glong i = 0;
+
+	folded = g_new (gunichar, g_utf8_strlen (str, -1) + 1);
+
+	for (p = str; *p != '\0'; p = g_utf8_next_char (p))
+	{
+		gunichar c = g_utf8_get_char (p);
+
+		if (skip_spaces && g_unichar_isspace (c))
+		{
+			continue;
+		}
+
+		folded[i++] = fold_char (c);
+	}
+
+	folded[i] = 0;
+	*len = i;
+
+	return folded;
+}
+
+/* Setup the fileitem, depending uri's scheme: the name and path to
+ * display and the search key. Done once, items without a key can not
+ * be displayed.
+ */
+void
+gedit_open_document_selector_fileitem_setup (FileItem *item)
+{
+	gchar *scheme;
+	gchar *filename;
+	gchar *path;
+	gchar *name;
+	gchar *display;
+
+	if (item->key != NULL)
+	{
+		return;
+	}
+
+	scheme = g_uri_parse_scheme (item->uri);
+	if (g_strcmp0 (scheme, "file") == 0)
+	{
+		filename = g_filename_from_uri ((const gchar *)item->uri, NULL, NULL);
+		if (filename)
+		{
+			g_free (item->path);
+			path = g_path_get_dirname (filename);
+			item->path = g_filename_to_utf8 (path, -1, NULL, NULL, NULL);
+			g_free (path);
+
+			g_free (item->name);
+			name = g_path_get_basename (filename);
+			item->name = g_filename_to_utf8 (name, -1, NULL, NULL, NULL);
+			g_free (name);
+
+			g_free (filename);
+		}
+	}
+	else
+	{
+		GFile *file;
+
+		file = g_file_new_for_uri (item->uri);
+		g_free (item->path);
+		item->path = gedit_utils_location_get_dirname_for_display (file);
+		g_free (item->name);
+		item->name  = gedit_utils_basename_for_display (file);
+		g_object_unref (file);
+	}
+
+	g_free (scheme);
+
+	if (item->path == NULL || item->name == NULL)
+	{
+		return;
+	}
+
+	display = g_build_filename (item->path, item->name, NULL);
+	item->key = gedit_open_document_selector_fold_string (display, FALSE, &item->key_len);
+	item->name_start = item->key_len - g_utf8_strlen (item->name, -1);
+	g_free (display);
+}
+
 /* ex:set ts=8 noet: */
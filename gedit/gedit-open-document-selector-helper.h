@@ -33,6 +33,14 @@ typedef struct
 	gchar *name;
 	gchar *path;
 	GTimeVal access_time;
+
+	/* The search key, set up once by the selector: one normalized and
+	 * casefolded character per character of the path and name joined,
+	 * the name starting at name_start.
+	 */
+	gunichar *key;
+	glong key_len;
+	glong name_start;
 } FileItem;
 
 typedef enum
@@ -96,6 +104,12 @@ void		 gedit_open_document_selector_free_fileitem_item	(FileItem *item);
 
 FileItem	*gedit_open_document_selector_copy_fileitem_item	(FileItem *item);
 
+void		 gedit_open_document_selector_fileitem_setup		(FileItem *item);
+
+gunichar	*gedit_open_document_selector_fold_string		(const gchar *str,
+                                                                         gboolean     skip_spaces,
+                                                                         glong       *len);
+
 G_END_DECLS
 
 #endif /* GEDIT_OPEN_DOCUMENT_SELECTOR_HELPER_H */
@@ -46,6 +46,12 @@
  * The original setting is stored in gsettings at :
  * org.gnome.gedit.preferences.ui
  * with the key : max-recents
+ *
+ * The children of the directories are cached, and the cache of a
+ * directory is dropped when its GFileMonitor tells that files were
+ * added or removed, so that showing the selector again does not
+ * enumerate them again. The access times of the current documents
+ * are taken from the recent files list when it has them.
  */
 
 #include "gedit-open-document-selector-store.h"
@@ -74,9 +80,41 @@ struct _GeditOpenDocumentSelectorStore
 	GList *recent_items;
 	gint recent_config_limit;
 	gboolean recent_items_need_update;
+
+	/* uri -> DirCache, under store_cache_lock as the lists are
+	 * computed in threads, as is recent_items.
+	 */
+	GHashTable *dir_caches;
+	guint64 dir_caches_clock;
 };
 
+/* The directories cached at most, the least recently used go first */
+#define MAX_DIR_CACHES 32
+
+typedef struct
+{
+	GFile *dir;
+	GFileMonitor *monitor;
+	GList *items;
+
+	/* bumped on each invalidation, an enumeration started before
+	 * is not kept
+	 */
+	guint stamp;
+	guint64 last_used;
+
+	guint valid : 1;
+	guint monitor_requested : 1;
+} DirCache;
+
+typedef struct
+{
+	GeditOpenDocumentSelectorStore *selector_store;
+	gchar *uri;
+} MonitorRequest;
+
 G_LOCK_DEFINE_STATIC (recent_files_filter_lock);
+G_LOCK_DEFINE_STATIC (store_cache_lock);
 
 G_DEFINE_TYPE (GeditOpenDocumentSelectorStore, gedit_open_document_selector_store, G_TYPE_OBJECT)
 
@@ -84,7 +122,7 @@ G_DEFINE_QUARK (gedit-open-document-selector-store-error-quark,
                 gedit_open_document_selector_store_error)
 
 static GList *
-get_current_docs_list (GeditOpenDocumentSelectorStore *selector_store G_GNUC_UNUSED,
+get_current_docs_list (GeditOpenDocumentSelectorStore *selector_store,
                        GeditOpenDocumentSelector      *selector)
 {
 	GeditWindow *window;
@@ -95,11 +133,32 @@ get_current_docs_list (GeditOpenDocumentSelectorStore *selector_store G_GNUC_UNU
 	FileItem *item;
 	GList *file_items_list = NULL;
 
+	GHashTable *recent_times;
+
 	window = gedit_open_document_selector_get_window (selector);
 
+	/* The documents open are mostly in the recent files list, which is
+	 * kept up to date by the recent manager signals.
+	 */
+	recent_times = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+	G_LOCK (store_cache_lock);
+
+	for (l = selector_store->recent_items; l != NULL; l = l->next)
+	{
+		item = l->data;
+		g_hash_table_insert (recent_times,
+		                     g_strdup (item->uri),
+		                     g_memdup (&item->access_time, sizeof (GTimeVal)));
+	}
+
+	G_UNLOCK (store_cache_lock);
+
 	docs = gedit_window_get_documents (window);
 	for (l = docs; l != NULL; l = l->next)
 	{
+		GTimeVal *access_time;
+
 		file = gtk_source_file_get_location (gedit_document_get_file (l->data));
 		if (file == NULL)
 		{
@@ -107,6 +166,18 @@ get_current_docs_list (GeditOpenDocumentSelectorStore *selector_store G_GNUC_UNU
 			continue;
 		}
 
+		item = gedit_open_document_selector_create_fileitem_item ();
+		item->uri = g_file_get_uri (file);
+		gedit_open_document_selector_fileitem_setup (item);
+
+		access_time = g_hash_table_lookup (recent_times, item->uri);
+		if (access_time != NULL)
+		{
+			item->access_time = *access_time;
+			file_items_list = g_list_prepend (file_items_list, item);
+			continue;
+		}
+
 		info = g_file_query_info (file,
 		                          "time::access,time::access-usec",
 		                          G_FILE_QUERY_INFO_NONE,
@@ -114,20 +185,19 @@ get_current_docs_list (GeditOpenDocumentSelectorStore *selector_store G_GNUC_UNU
 		                          NULL);
 		if (info == NULL)
 		{
+			gedit_open_document_selector_free_fileitem_item (item);
 			continue;
 		}
 
-		item = gedit_open_document_selector_create_fileitem_item ();
-
 		item->access_time.tv_sec = g_file_info_get_attribute_uint64 (info, "time::access");
 		item->access_time.tv_usec = g_file_info_get_attribute_uint32 (info, "time::access-usec");
-		item->uri = g_file_get_uri (file);
 
 		file_items_list = g_list_prepend (file_items_list, item);
 
 		g_object_unref (info);
 	}
 
+	g_hash_table_destroy (recent_times);
 	g_list_free (docs);
 	return file_items_list;
 }
@@ -173,9 +243,150 @@ check_mime_type (GFileInfo *info)
 	return FALSE;
 }
 
+static void
+dir_cache_free (DirCache *cache)
+{
+	if (cache->monitor != NULL)
+	{
+		g_file_monitor_cancel (cache->monitor);
+		g_object_unref (cache->monitor);
+	}
+
+	gedit_open_document_selector_free_file_items_list (cache->items);
+	g_object_unref (cache->dir);
+
+	g_slice_free (DirCache, cache);
+}
+
+/* Called with store_cache_lock held */
+static void
+dir_cache_invalidate (DirCache *cache)
+{
+	cache->stamp++;
+	cache->valid = FALSE;
+
+	gedit_open_document_selector_free_file_items_list (cache->items);
+	cache->items = NULL;
+}
+
+static void
+on_dir_changed (GFileMonitor      *monitor G_GNUC_UNUSED,
+                GFile             *file G_GNUC_UNUSED,
+                GFile             *other_file G_GNUC_UNUSED,
+                GFileMonitorEvent  event_type,
+                MonitorRequest    *request)
+{
+	DirCache *cache;
+
+	/* Only the files coming and going change the list */
+	if (event_type == G_FILE_MONITOR_EVENT_CHANGED ||
+	    event_type == G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT ||
+	    event_type == G_FILE_MONITOR_EVENT_ATTRIBUTE_CHANGED)
+	{
+		return;
+	}
+
+	G_LOCK (store_cache_lock);
+
+	cache = g_hash_table_lookup (request->selector_store->dir_caches, request->uri);
+	if (cache != NULL)
+	{
+		DEBUG_SELECTOR (g_print ("\tStore(%p): dir cache invalidated: %s\n",
+		                         request->selector_store, request->uri););
+
+		dir_cache_invalidate (cache);
+	}
+
+	G_UNLOCK (store_cache_lock);
+}
+
+static void
+monitor_request_free (MonitorRequest *request)
+{
+	g_free (request->uri);
+	g_slice_free (MonitorRequest, request);
+}
+
+/* Called with store_cache_lock held, in the main thread since the monitors
+ * of the dropped caches are destroyed.
+ */
+static void
+dir_caches_evict (GeditOpenDocumentSelectorStore *selector_store)
+{
+	while (g_hash_table_size (selector_store->dir_caches) > MAX_DIR_CACHES)
+	{
+		GHashTableIter iter;
+		gpointer key;
+		gpointer value;
+		gpointer oldest_key = NULL;
+		guint64 oldest = G_MAXUINT64;
+
+		g_hash_table_iter_init (&iter, selector_store->dir_caches);
+		while (g_hash_table_iter_next (&iter, &key, &value))
+		{
+			DirCache *cache = value;
+
+			if (cache->last_used < oldest)
+			{
+				oldest = cache->last_used;
+				oldest_key = key;
+			}
+		}
+
+		g_hash_table_remove (selector_store->dir_caches, oldest_key);
+	}
+}
+
+/* The monitors are created in the main thread so that their events are
+ * delivered there.
+ */
+static gboolean
+install_dir_monitor (MonitorRequest *request)
+{
+	GeditOpenDocumentSelectorStore *selector_store = request->selector_store;
+	DirCache *cache;
+
+	G_LOCK (store_cache_lock);
+
+	cache = g_hash_table_lookup (selector_store->dir_caches, request->uri);
+	if (cache != NULL && cache->monitor == NULL)
+	{
+		cache->monitor = g_file_monitor_directory (cache->dir,
+		                                           G_FILE_MONITOR_NONE,
+		                                           NULL,
+		                                           NULL);
+
+		if (cache->monitor != NULL)
+		{
+			MonitorRequest *data;
+
+			data = g_slice_new (MonitorRequest);
+			data->selector_store = selector_store;
+			data->uri = g_strdup (request->uri);
+
+			g_signal_connect_data (cache->monitor,
+			                       "changed",
+			                       G_CALLBACK (on_dir_changed),
+			                       data,
+			                       (GClosureNotify)monitor_request_free,
+			                       0);
+		}
+
+		/* What was enumerated before the monitor existed may have
+		 * missed changes.
+		 */
+		dir_cache_invalidate (cache);
+	}
+
+	dir_caches_evict (selector_store);
+
+	G_UNLOCK (store_cache_lock);
+
+	return G_SOURCE_REMOVE;
+}
+
 static GList *
-get_children_from_dir (GeditOpenDocumentSelectorStore *selector_store G_GNUC_UNUSED,
-                       GFile                          *dir)
+enumerate_children_from_dir (GFile *dir)
 {
 	GList *file_items_list = NULL;
 	GFileEnumerator *file_enum;
@@ -219,6 +430,9 @@ get_children_from_dir (GeditOpenDocumentSelectorStore *selector_store G_GNUC_UNU
 			item->access_time.tv_sec = g_file_info_get_attribute_uint64 (info, "time::access");
 			item->access_time.tv_usec = g_file_info_get_attribute_uint32 (info, "time::access-usec");
 
+			/* Done here, off the main thread and once per cached item */
+			gedit_open_document_selector_fileitem_setup (item);
+
 			file_items_list = g_list_prepend (file_items_list, item);
 			g_object_unref (file);
 		}
@@ -232,6 +446,86 @@ get_children_from_dir (GeditOpenDocumentSelectorStore *selector_store G_GNUC_UNU
 	return file_items_list;
 }
 
+static GList *
+get_children_from_dir (GeditOpenDocumentSelectorStore *selector_store,
+                       GFile                          *dir)
+{
+	DirCache *cache;
+	GList *file_items_list;
+	gchar *uri;
+	guint stamp;
+	gboolean request_monitor = FALSE;
+
+	g_return_val_if_fail (G_IS_FILE (dir), NULL);
+
+	uri = g_file_get_uri (dir);
+
+	G_LOCK (store_cache_lock);
+
+	cache = g_hash_table_lookup (selector_store->dir_caches, uri);
+	if (cache == NULL)
+	{
+		cache = g_slice_new0 (DirCache);
+		cache->dir = g_object_ref (dir);
+		g_hash_table_insert (selector_store->dir_caches, g_strdup (uri), cache);
+	}
+
+	cache->last_used = ++selector_store->dir_caches_clock;
+
+	if (cache->valid)
+	{
+		file_items_list = gedit_open_document_selector_copy_file_items_list (cache->items);
+
+		G_UNLOCK (store_cache_lock);
+		g_free (uri);
+
+		return file_items_list;
+	}
+
+	if (!cache->monitor_requested)
+	{
+		cache->monitor_requested = TRUE;
+		request_monitor = TRUE;
+	}
+
+	stamp = cache->stamp;
+
+	G_UNLOCK (store_cache_lock);
+
+	if (request_monitor)
+	{
+		MonitorRequest *request;
+
+		request = g_slice_new (MonitorRequest);
+		request->selector_store = selector_store;
+		request->uri = g_strdup (uri);
+
+		g_main_context_invoke_full (NULL,
+		                            G_PRIORITY_DEFAULT,
+		                            (GSourceFunc)install_dir_monitor,
+		                            request,
+		                            (GDestroyNotify)monitor_request_free);
+	}
+
+	file_items_list = enumerate_children_from_dir (dir);
+
+	G_LOCK (store_cache_lock);
+
+	/* The cache may have been invalidated, or even evicted, meanwhile */
+	cache = g_hash_table_lookup (selector_store->dir_caches, uri);
+	if (cache != NULL && cache->stamp == stamp && cache->monitor != NULL)
+	{
+		gedit_open_document_selector_free_file_items_list (cache->items);
+		cache->items = gedit_open_document_selector_copy_file_items_list (file_items_list);
+		cache->valid = TRUE;
+	}
+
+	G_UNLOCK (store_cache_lock);
+	g_free (uri);
+
+	return file_items_list;
+}
+
 static GList *
 get_active_doc_dir_list (GeditOpenDocumentSelectorStore *selector_store,
                          GeditOpenDocumentSelector      *selector)
@@ -483,6 +777,8 @@ convert_recent_item_list_to_fileitem_list (GList *uri_list)
 		item->access_time.tv_sec = gtk_recent_info_get_visited (l->data);
 		item->access_time.tv_usec = 0;
 
+		gedit_open_document_selector_fileitem_setup (item);
+
 		fileitem_list = g_list_prepend (fileitem_list, item);
 	}
 
@@ -525,8 +821,10 @@ update_list_cb (GeditOpenDocumentSelectorStore *selector_store,
 	switch (type)
 	{
 		case GEDIT_OPEN_DOCUMENT_SELECTOR_RECENT_FILES_LIST:
+			G_LOCK (store_cache_lock);
 			gedit_open_document_selector_free_file_items_list (selector_store->recent_items);
 			selector_store->recent_items = list;
+			G_UNLOCK (store_cache_lock);
 
 			DEBUG_SELECTOR (g_print ("\tStore(%p): update_list_cb: type:%s, length:%i\n",
 			                         selector_store, list_type_string[type], g_list_length (list)););
@@ -568,6 +866,8 @@ gedit_open_document_selector_store_dispose (GObject *object)
 		selector_store->recent_items = NULL;
 	}
 
+	g_clear_pointer (&selector_store->dir_caches, g_hash_table_destroy);
+
 	G_OBJECT_CLASS (gedit_open_document_selector_store_parent_class)->dispose (object);
 }
 
@@ -631,7 +931,9 @@ update_recent_list (gpointer user_data)
 
 		if (selector_store->recent_items == NULL)
 		{
+			G_LOCK (store_cache_lock);
 			selector_store->recent_items = gedit_open_document_selector_copy_file_items_list (file_items_list);
+			G_UNLOCK (store_cache_lock);
 		}
 	}
 
@@ -756,6 +1058,11 @@ gedit_open_document_selector_store_init (GeditOpenDocumentSelectorStore *selecto
 	                         0);
 
 	selector_store->recent_items_need_update = TRUE;
+
+	selector_store->dir_caches = g_hash_table_new_full (g_str_hash,
+	                                                    g_str_equal,
+	                                                    g_free,
+	                                                    (GDestroyNotify)dir_cache_free);
 }
 
 gint
@@ -22,6 +22,7 @@
 #include "gedit-open-document-selector-store.h"
 #include "gedit-open-document-selector-helper.h"
 
+#include <string.h>
 #include <time.h>
 
 #include <glib.h>
@@ -66,16 +67,15 @@ struct _GeditOpenDocumentSelector
 	GList *current_docs_items;
 	GList *all_items;
 
+	/* The previous search, to narrow the next one */
+	gunichar *last_query;
+	glong last_query_len;
+	GPtrArray *last_matched;
+
 	guint populate_liststore_is_idle : 1;
 	guint populate_scheduled : 1;
 };
 
-typedef enum
-{
-	SELECTOR_TAG_NONE,
-	SELECTOR_TAG_MATCH
-} SelectorTag;
-
 enum
 {
 	NAME_COLUMN,
@@ -101,172 +101,85 @@ enum
 
 static guint signals[LAST_SIGNAL];
 
-/* Value 0xFF is reserved to mark the end of the array */
-#define BYTE_ARRAY_END 0xFF
-
 #define OPEN_DOCUMENT_SELECTOR_WIDTH 400
 #define OPEN_DOCUMENT_SELECTOR_MAX_VISIBLE_ROWS 10
 
 G_DEFINE_TYPE (GeditOpenDocumentSelector, gedit_open_document_selector, GTK_TYPE_BOX)
 
-static inline const guint8 *
-get_byte_run (const guint8 *byte_array,
-              gsize        *count,
-              SelectorTag  *tag)
+static void
+append_markup_run (GString     *string,
+                   const gchar *run,
+                   gsize        length,
+                   gboolean     matched)
 {
-	guint8 tag_found;
-	gsize c = 1;
-
-	tag_found = *byte_array++;
+	gchar *txt;
 
-	while ( *byte_array != BYTE_ARRAY_END && *byte_array == tag_found)
+	if (length == 0)
 	{
-		c++;
-		byte_array++;
+		return;
 	}
 
-	*count = c;
-	*tag = tag_found;
+	txt = g_markup_escape_text (run, length);
+
+	if (matched)
+	{
+		g_string_append_printf (string, "<span weight =\"heavy\" color =\"black\">%s</span>", txt);
+	}
+	else
+	{
+		g_string_append (string, txt);
+	}
 
-	return ( *byte_array != BYTE_ARRAY_END) ? byte_array : NULL;
+	g_free (txt);
 }
 
-static gchar*
-get_markup_from_tagged_byte_array (const gchar  *str,
-                                   const guint8 *byte_array)
+/* @positions are the sorted key offsets of the matched characters, @offset
+ * the key offset of the first character of @str.
+ */
+static gchar *
+get_markup_from_positions (const gchar *str,
+                           glong        offset,
+                           const guint *positions,
+                           glong        n_positions)
 {
-	gchar *txt;
 	GString *string;
-	gchar *result_str;
-	SelectorTag tag;
-	gsize count;
+	const gchar *run;
+	const gchar *p;
+	gboolean run_matched = FALSE;
+	glong i = 0;
 
 	string = g_string_sized_new (255);
+	run = str;
 
-	while (TRUE)
+	for (p = str; *p != '\0'; p = g_utf8_next_char (p), offset++)
 	{
-		byte_array = get_byte_run (byte_array, &count, &tag);
-		txt = g_markup_escape_text (str, count);
-		if (tag == SELECTOR_TAG_MATCH)
-		{
-			g_string_append_printf (string, "<span weight =\"heavy\" color =\"black\">%s</span>", txt);
-		}
-		else
-		{
-			g_string_append (string, txt);
-		}
-
-		g_free (txt);
+		gboolean matched;
 
-		if (!byte_array)
+		while (i < n_positions && (glong)positions[i] < offset)
 		{
-			break;
+			i++;
 		}
 
-		str = (const gchar *)((gsize)str + count);
-	}
+		matched = i < n_positions && (glong)positions[i] == offset;
 
-	result_str = g_string_free (string, FALSE);
-	return result_str;
-}
-
-static guint8 *
-get_tagged_byte_array (const gchar *uri,
-                       GRegex      *filter_regex)
-{
-	guint8 *byte_array;
-	gsize uri_len;
-	GMatchInfo *match_info;
-	gboolean no_match = TRUE;
-
-	g_return_val_if_fail (uri != NULL, NULL);
-
-	uri_len = strlen (uri);
-	byte_array = g_malloc0 (uri_len + 1);
-	byte_array[uri_len] = BYTE_ARRAY_END;
-
-	if (g_regex_match (filter_regex, uri, 0, &match_info) == TRUE)
-	{
-		while (g_match_info_matches (match_info) == TRUE)
+		if (matched != run_matched)
 		{
-			guint8 *p;
-			gint match_len;
-			gint start_pos;
-			gint end_pos;
-
-			if (g_match_info_fetch_pos (match_info, 0, &start_pos, &end_pos) == TRUE)
-			{
-				match_len = end_pos - start_pos;
-				no_match = FALSE;
-
-				p = (guint8 *)((gsize)byte_array + start_pos);
-				memset (p, SELECTOR_TAG_MATCH, match_len);
-			}
-
-			g_match_info_next (match_info, NULL);
+			append_markup_run (string, run, p - run, run_matched);
+			run = p;
+			run_matched = matched;
 		}
 	}
 
-	g_match_info_free (match_info);
-
-	if (no_match)
-	{
-		g_free (byte_array);
-		return NULL;
-	}
-
-	return byte_array;
-}
-
-static void
-get_markup_for_path_and_name (GRegex       *filter_regex,
-                              const gchar  *src_path,
-                              const gchar  *src_name,
-                              gchar       **dst_path,
-                              gchar       **dst_name)
-{
-	gchar *filename;
-	gsize path_len;
-	gsize name_len;
-	gsize path_separator_len;
-	guint8 *byte_array;
-	guint8 *path_byte_array;
-	guint8 *name_byte_array;
-
-	filename = g_build_filename (src_path, src_name, NULL);
-
-	path_len = g_utf8_strlen (src_path, -1);
-	name_len = g_utf8_strlen (src_name, -1);
-	path_separator_len = g_utf8_strlen (filename, -1) - ( path_len + name_len);
-
-	byte_array = get_tagged_byte_array (filename, filter_regex);
-	if (byte_array)
-	{
-		path_byte_array = g_memdup (byte_array, path_len + 1);
-		path_byte_array[path_len] = BYTE_ARRAY_END;
-
-		/* name_byte_array is part of byte_array, so released with it */
-		name_byte_array = (guint8 *)((gsize)byte_array + path_len + path_separator_len);
-
-		*dst_path = get_markup_from_tagged_byte_array (src_path, path_byte_array);
-		*dst_name = get_markup_from_tagged_byte_array (src_name, name_byte_array);
-
-		g_free (byte_array);
-		g_free (path_byte_array);
-	}
-	else
-	{
-		*dst_path = g_strdup (src_path);
-		*dst_name = g_strdup (src_name);
-	}
+	append_markup_run (string, run, p - run, run_matched);
 
-	g_free (filename);
+	return g_string_free (string, FALSE);
 }
 
 static void
 create_row (GeditOpenDocumentSelector *selector,
             const FileItem            *item,
-            GRegex                    *filter_regex)
+            const guint               *positions,
+            glong                      n_positions)
 {
 	GtkTreeIter iter;
 	gchar *uri;
@@ -275,13 +188,10 @@ create_row (GeditOpenDocumentSelector *selector,
 
 	uri =item->uri;
 
-	if (filter_regex)
+	if (positions != NULL)
 	{
-		get_markup_for_path_and_name (filter_regex,
-		                              (const gchar *)item->path,
-		                              (const gchar *)item->name,
-		                              &dst_path,
-		                              &dst_name);
+		dst_path = get_markup_from_positions (item->path, 0, positions, n_positions);
+		dst_name = get_markup_from_positions (item->name, item->name_start, positions, n_positions);
 	}
 	else
 	{
@@ -320,26 +230,23 @@ sort_items_by_mru (FileItem *a,
 	}
 }
 
+/* Merges the lists, keeping the most recent access of each uri */
 static GList *
 compute_all_items_list (GeditOpenDocumentSelector *selector)
 {
-	GList *recent_items;
-	GList *home_dir_items;
-	GList *desktop_dir_items;
-	GList *local_bookmarks_dir_items;
-	GList *file_browser_root_items;
-	GList *active_doc_dir_items;
-	GList *current_docs_items;
+	GList *lists[] = {
+		selector->recent_items,
+		selector->home_dir_items,
+		selector->desktop_dir_items,
+		selector->local_bookmarks_dir_items,
+		selector->file_browser_root_items,
+		selector->active_doc_dir_items,
+		selector->current_docs_items
+	};
+	GHashTable *seen;
 	GList *all_items = NULL;
-
-	/* Copy/concat the whole list */
-	recent_items = gedit_open_document_selector_copy_file_items_list ((const GList *)selector->recent_items);
-	home_dir_items = gedit_open_document_selector_copy_file_items_list ((const GList *)selector->home_dir_items);
-	desktop_dir_items = gedit_open_document_selector_copy_file_items_list ((const GList *)selector->desktop_dir_items);
-	local_bookmarks_dir_items = gedit_open_document_selector_copy_file_items_list ((const GList *)selector->local_bookmarks_dir_items);
-	file_browser_root_items = gedit_open_document_selector_copy_file_items_list ((const GList *)selector->file_browser_root_items);
-	active_doc_dir_items = gedit_open_document_selector_copy_file_items_list ((const GList *)selector->active_doc_dir_items);
-	current_docs_items = gedit_open_document_selector_copy_file_items_list ((const GList *)selector->current_docs_items);
+	GList *l;
+	guint i;
 
 	if (selector->all_items)
 	{
@@ -347,15 +254,42 @@ compute_all_items_list (GeditOpenDocumentSelector *selector)
 		selector->all_items = NULL;
 	}
 
-	all_items = g_list_concat (all_items, recent_items);
-	all_items = g_list_concat (all_items, home_dir_items);
-	all_items = g_list_concat (all_items, desktop_dir_items);
-	all_items = g_list_concat (all_items, local_bookmarks_dir_items);
-	all_items = g_list_concat (all_items, file_browser_root_items);
-	all_items = g_list_concat (all_items, active_doc_dir_items);
-	all_items = g_list_concat (all_items, current_docs_items);
+	seen = g_hash_table_new (g_str_hash, g_str_equal);
 
-	return all_items;
+	for (i = 0; i < G_N_ELEMENTS (lists); i++)
+	{
+		for (l = lists[i]; l != NULL; l = l->next)
+		{
+			FileItem *item = l->data;
+			FileItem *copy;
+			GList *link;
+
+			if (item->key == NULL)
+			{
+				continue;
+			}
+
+			link = g_hash_table_lookup (seen, item->uri);
+
+			if (link == NULL)
+			{
+				copy = gedit_open_document_selector_copy_fileitem_item (item);
+				all_items = g_list_prepend (all_items, copy);
+				g_hash_table_insert (seen, copy->uri, all_items);
+			}
+			else if (sort_items_by_mru (item, link->data, NULL) < 0)
+			{
+				copy = gedit_open_document_selector_copy_fileitem_item (item);
+				g_hash_table_replace (seen, copy->uri, link);
+				gedit_open_document_selector_free_fileitem_item (link->data);
+				link->data = copy;
+			}
+		}
+	}
+
+	g_hash_table_destroy (seen);
+
+	return g_list_reverse (all_items);
 }
 
 static GList *
@@ -366,12 +300,25 @@ clamp_recent_items_list (GList *recent_items,
 	GList *l;
 	FileItem *item;
 
+	/* limit <= 0 means no limit */
+	if (limit <= 0)
+	{
+		limit = -1;
+	}
+
 	l = recent_items;
-	while (limit > 0 && l != NULL)
+	while (limit != 0 && l != NULL)
 	{
-		item = gedit_open_document_selector_copy_fileitem_item (l->data);
-		recent_items_capped = g_list_prepend (recent_items_capped, item);
+		item = l->data;
 		l = l->next;
+
+		if (item->key == NULL)
+		{
+			continue;
+		}
+
+		item = gedit_open_document_selector_copy_fileitem_item (item);
+		recent_items_capped = g_list_prepend (recent_items_capped, item);
 		limit -= 1;
 	}
 
@@ -379,126 +326,266 @@ clamp_recent_items_list (GList *recent_items,
 	return recent_items_capped;
 }
 
-/* Setup the fileitem, depending uri's scheme
- * Return a string to search in.
- */
-static gchar *
-fileitem_setup (FileItem *item)
+static void
+fileitem_list_setup (GList *items)
 {
-	gchar *scheme;
-	gchar *filename;
-	gchar *normalized_filename = NULL;
-	gchar *candidate = NULL;
-	gchar *path;
-	gchar *name;
-
-	scheme = g_uri_parse_scheme (item->uri);
-	if (g_strcmp0 (scheme, "file") == 0)
+	GList *l;
+
+	for (l = items; l != NULL; l = l->next)
 	{
-		filename = g_filename_from_uri ((const gchar *)item->uri, NULL, NULL);
-		if (filename)
-		{
-			path = g_path_get_dirname (filename);
-			item->path = g_filename_to_utf8 (path, -1, NULL, NULL, NULL);
-			g_free (path);
+		gedit_open_document_selector_fileitem_setup (l->data);
+	}
+}
+
+#define SCORE_MATCH 16
+#define SCORE_BOUNDARY 8
+#define SCORE_CONSECUTIVE 8
+#define SCORE_NAME 4
+#define SCORE_MAX_GAP_PENALTY 8
 
-			name = g_path_get_basename (filename);
-			item->name = g_filename_to_utf8 (name, -1, NULL, NULL, NULL);
-			g_free (name);
+typedef struct
+{
+	FileItem *item;
+	gint score;
+	guint *positions;
+} SelectorMatch;
+
+static inline gboolean
+is_boundary (gunichar c)
+{
+	return c == '/' || c == '-' || c == '_' || c == '.' || c == ' ';
+}
+
+/* Looks for the query as a subsequence of key[start, end): the first
+ * occurrence is found going forward, then tightened from its end going
+ * backward, and the positions are taken greedily from there.
+ */
+static gboolean
+fuzzy_match_range (const gunichar *key,
+                   glong           start,
+                   glong           end,
+                   const gunichar *query,
+                   glong           query_len,
+                   guint          *positions)
+{
+	glong i;
+	glong q = 0;
+	glong last;
 
-			normalized_filename = g_utf8_normalize (filename, -1, G_NORMALIZE_ALL);
-			g_free (filename);
+	for (i = start; i < end && q < query_len; i++)
+	{
+		if (key[i] == query[q])
+		{
+			q++;
 		}
 	}
-	else
+
+	if (q < query_len)
 	{
-		GFile *file;
-		gchar *parse_name;
+		return FALSE;
+	}
 
-		file = g_file_new_for_uri (item->uri);
-		item->path = gedit_utils_location_get_dirname_for_display (file);
-		item->name  = gedit_utils_basename_for_display (file);
-		parse_name = g_file_get_parse_name (file);
-		g_object_unref (file);
+	last = i - 1;
+	q = query_len - 1;
 
-		normalized_filename = g_utf8_normalize (parse_name, -1, G_NORMALIZE_ALL);
-		g_free (parse_name);
+	for (i = last; i > start; i--)
+	{
+		if (key[i] == query[q])
+		{
+			if (q == 0)
+			{
+				break;
+			}
+
+			q--;
+		}
 	}
 
-        if (normalized_filename)
+	for (q = 0; q < query_len; i++)
 	{
-		candidate = g_utf8_casefold (normalized_filename, -1);
-		g_free (normalized_filename);
+		if (key[i] == query[q])
+		{
+			positions[q++] = i;
+		}
 	}
 
-	g_free (scheme);
-
-	return candidate;
+	return TRUE;
 }
 
-/* If filter == NULL then items are
- * not checked against the filter.
- */
-static GList *
-fileitem_list_filter (GList       *items,
-                      const gchar *filter)
+static gint
+fuzzy_score (const FileItem *item,
+             const guint    *positions,
+             glong           query_len)
 {
-	GList *new_items = NULL;
-	GList *l;
+	gint score = 0;
+	glong i;
 
-	for (l = items; l != NULL; l = l->next)
+	for (i = 0; i < query_len; i++)
 	{
-		FileItem *item;
-		gchar *candidate;
+		guint pos = positions[i];
 
-		item = l->data;
-		candidate = fileitem_setup (item);
+		score += SCORE_MATCH;
+
+		if (pos == 0 || is_boundary (item->key[pos - 1]))
+		{
+			score += SCORE_BOUNDARY;
+		}
 
-		if (candidate && (filter ==  NULL || strstr (candidate, filter)))
+		if ((glong)pos >= item->name_start)
 		{
-			new_items = g_list_prepend (new_items,
-			                            gedit_open_document_selector_copy_fileitem_item (item));
+			score += SCORE_NAME;
 		}
 
-		g_free (candidate);
+		if (i > 0)
+		{
+			guint gap = pos - positions[i - 1] - 1;
+
+			if (gap == 0)
+			{
+				score += SCORE_CONSECUTIVE;
+			}
+			else
+			{
+				score -= MIN (gap, SCORE_MAX_GAP_PENALTY);
+			}
+		}
 	}
 
-	new_items = g_list_reverse (new_items);
-	return new_items;
+	return score;
 }
 
-/* Remove duplicated, the HEAD of the list never change,
- * the list passed in is modified.
+/* Matches in the name are tried first, they are the most likely to be
+ * what is looked for, but the whole path may still score better.
  */
-static void
-fileitem_list_remove_duplicates (GList *items)
+static gboolean
+fuzzy_match (FileItem       *item,
+             const gunichar *query,
+             glong           query_len,
+             SelectorMatch  *match)
 {
-	GList *l;
-	G_GNUC_UNUSED GList *dummy_ptr;
+	guint *positions;
+	gint score;
 
-	l = items;
-	while (l != NULL)
+	if (query_len == 0)
 	{
-		gchar *l_uri, *l1_uri;
-		GList *l1;
+		match->item = item;
+		match->score = 0;
+		match->positions = NULL;
+		return TRUE;
+	}
 
-		if ((l1 = l->next) == NULL)
-		{
-			break;
-		}
+	positions = g_new (guint, query_len);
+
+	if (!fuzzy_match_range (item->key, 0, item->key_len, query, query_len, positions))
+	{
+		g_free (positions);
+		return FALSE;
+	}
+
+	match->item = item;
+	match->score = fuzzy_score (item, positions, query_len);
+	match->positions = positions;
+
+	positions = g_new (guint, query_len);
+
+	if (fuzzy_match_range (item->key, item->name_start, item->key_len, query, query_len, positions) &&
+	    (score = fuzzy_score (item, positions, query_len)) > match->score)
+	{
+		g_free (match->positions);
+		match->score = score;
+		match->positions = positions;
+	}
+	else
+	{
+		g_free (positions);
+	}
+
+	return TRUE;
+}
 
-		l_uri = ((FileItem *)l->data)->uri;
-		l1_uri = ((FileItem *)l1->data)->uri;
-		if (g_strcmp0 (l_uri, l1_uri) == 0)
+static gint
+sort_matches (SelectorMatch *a,
+              SelectorMatch *b)
+{
+	if (a->score != b->score)
+	{
+		return b->score - a->score;
+	}
+
+	return sort_items_by_mru (a->item, b->item, NULL);
+}
+
+/* Keeps the items matching the filter. When the filter only got longer
+ * since the previous search, only the items that matched then can match
+ * now, so only those are looked at.
+ */
+static GArray *
+fileitem_list_filter (GeditOpenDocumentSelector *selector,
+                      const gchar               *filter)
+{
+	GArray *matches;
+	GPtrArray *candidates;
+	GPtrArray *matched;
+	gunichar *query;
+	glong query_len;
+	guint i;
+
+	query = gedit_open_document_selector_fold_string (filter, TRUE, &query_len);
+
+	if (selector->last_matched != NULL &&
+	    query_len >= selector->last_query_len &&
+	    memcmp (query, selector->last_query, selector->last_query_len * sizeof (gunichar)) == 0)
+	{
+		candidates = g_ptr_array_ref (selector->last_matched);
+	}
+	else
+	{
+		GList *l;
+
+		candidates = g_ptr_array_new ();
+
+		for (l = selector->all_items; l != NULL; l = l->next)
 		{
-			gedit_open_document_selector_free_fileitem_item ((FileItem *)l1->data);
-			dummy_ptr = g_list_delete_link (items, l1);
+			if (((FileItem *)l->data)->key != NULL)
+			{
+				g_ptr_array_add (candidates, l->data);
+			}
 		}
-		else
+	}
+
+	matches = g_array_new (FALSE, FALSE, sizeof (SelectorMatch));
+	matched = g_ptr_array_new ();
+
+	for (i = 0; i < candidates->len; i++)
+	{
+		SelectorMatch match;
+
+		if (fuzzy_match (g_ptr_array_index (candidates, i), query, query_len, &match))
 		{
-			l = l->next;
+			g_array_append_val (matches, match);
+			g_ptr_array_add (matched, match.item);
 		}
 	}
+
+	g_ptr_array_unref (candidates);
+
+	g_clear_pointer (&selector->last_matched, g_ptr_array_unref);
+	g_free (selector->last_query);
+	selector->last_matched = matched;
+	selector->last_query = query;
+	selector->last_query_len = query_len;
+
+	g_array_sort (matches, (GCompareFunc)sort_matches);
+
+	return matches;
+}
+
+static void
+reset_last_search (GeditOpenDocumentSelector *selector)
+{
+	g_clear_pointer (&selector->last_matched, g_ptr_array_unref);
+	g_clear_pointer (&selector->last_query, g_free);
+	selector->last_query_len = 0;
 }
 
 static gboolean
@@ -508,8 +595,9 @@ real_populate_liststore (gpointer data)
 	GeditOpenDocumentSelectorStore *selector_store;
 	GList *l;
 	GList *filter_items = NULL;
+	GArray *matches = NULL;
 	gchar *filter;
-	GRegex *filter_regex = NULL;
+	gboolean has_results;
 	selector->populate_liststore_is_idle = FALSE;
 
 	DEBUG_SELECTOR_TIMER_DECL
@@ -523,53 +611,56 @@ real_populate_liststore (gpointer data)
 	{
 		DEBUG_SELECTOR (g_print ("Selector(%p): populate liststore: all lists\n", selector););
 
-		filter_items = fileitem_list_filter (selector->all_items, (const gchar *)filter);
-		filter_items = g_list_sort_with_data (filter_items, (GCompareDataFunc)sort_items_by_mru, NULL);
-		fileitem_list_remove_duplicates (filter_items);
-
-		filter_regex = g_regex_new (filter, G_REGEX_CASELESS, 0, NULL);
+		matches = fileitem_list_filter (selector, (const gchar *)filter);
+		has_results = matches->len > 0;
 	}
 	else
 	{
 		gint recent_limit;
-		GList *recent_items;
 
 		DEBUG_SELECTOR (g_print ("Selector(%p): populate liststore: recent files list\n", selector););
 
-		recent_limit = gedit_open_document_selector_store_get_recent_limit (selector_store);
+		reset_last_search (selector);
 
-		if (recent_limit > 0 )
-		{
-			recent_items = fileitem_list_filter (selector->recent_items, NULL);
-			filter_items = clamp_recent_items_list (recent_items, recent_limit);
-			gedit_open_document_selector_free_file_items_list (recent_items);
-		}
-		else
-		{
-			filter_items = fileitem_list_filter (selector->recent_items, NULL);
-		}
+		recent_limit = gedit_open_document_selector_store_get_recent_limit (selector_store);
+		filter_items = clamp_recent_items_list (selector->recent_items, recent_limit);
+		has_results = filter_items != NULL;
 	}
 
 	g_free (filter);
 
 	DEBUG_SELECTOR (g_print ("Selector(%p): populate liststore: length:%i\n",
-	                         selector, g_list_length (filter_items)););
+	                         selector, matches ? (gint)matches->len : (gint)g_list_length (filter_items)););
 
 	/* Show the placeholder if no results, show the treeview otherwise */
-	gtk_widget_set_visible (selector->scrolled_window, (filter_items != NULL));
-	gtk_widget_set_visible (selector->placeholder_box, (filter_items == NULL));
+	gtk_widget_set_visible (selector->scrolled_window, has_results);
+	gtk_widget_set_visible (selector->placeholder_box, !has_results);
 
-	for (l = filter_items; l != NULL; l = l->next)
+	if (matches != NULL)
 	{
-		FileItem *item;
+		guint i;
 
-		item = l->data;
-		create_row (selector, (const FileItem *)item, filter_regex);
+		for (i = 0; i < matches->len; i++)
+		{
+			SelectorMatch *match = &g_array_index (matches, SelectorMatch, i);
+
+			create_row (selector,
+			            (const FileItem *)match->item,
+			            match->positions,
+			            selector->last_query_len);
+
+			g_free (match->positions);
+		}
+
+		g_array_unref (matches);
 	}
 
-	if (filter_regex)
+	for (l = filter_items; l != NULL; l = l->next)
 	{
-		g_regex_unref (filter_regex);
+		FileItem *item;
+
+		item = l->data;
+		create_row (selector, (const FileItem *)item, NULL, 0);
 	}
 
 	gedit_open_document_selector_free_file_items_list (filter_items);
@@ -766,6 +857,8 @@ gedit_open_document_selector_dispose (GObject *object)
 		selector->all_items = NULL;
 	}
 
+	reset_last_search (selector);
+
 	G_OBJECT_CLASS (gedit_open_document_selector_parent_class)->dispose (object);
 }
 
@@ -811,6 +904,8 @@ update_list_cb (GeditOpenDocumentSelectorStore *selector_store,
 	DEBUG_SELECTOR (g_print ("Selector(%p): update_list_cb - type:%s, length:%i\n",
 	                         selector, list_type_string[type], g_list_length (list)););
 
+	fileitem_list_setup (list);
+
 	switch (type)
 	{
 		case GEDIT_OPEN_DOCUMENT_SELECTOR_RECENT_FILES_LIST:
@@ -853,6 +948,7 @@ update_list_cb (GeditOpenDocumentSelectorStore *selector_store,
 	}
 
 	selector->all_items = compute_all_items_list (selector);
+	reset_last_search (selector);
 	populate_liststore (selector);
 }
 
@@ -0,0 +1,736 @@
+/*
+ * gedit-recent-index.c
+ * This file is part of gedit
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gedit-recent-index.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "gedit-debug.h"
+#include "gedit-dirs.h"
+
+/* The recent files, kept by GtkRecentManager, indexed by gedit: the uris
+ * are normalized and casefolded once, and the files are ranked by
+ * frecency, that is how often and how recently they were used.
+ *
+ * Each use adds a weight which doubles every FRECENCY_HALF_LIFE, the
+ * score is the log2 of the sum of the weights. That way the scores of
+ * the files not used do not need to decay: only the order matters and
+ * it does not depend on the time of the query.
+ *
+ * GtkRecentManager::changed does not tell what changed, so the index is
+ * only marked as stale then, and it is synced on the next query: a use
+ * is counted when the modification time of an item increased. The
+ * scores are saved in the cache dir, GtkRecentManager only knows about
+ * the last use.
+ */
+
+#define FRECENCY_HALF_LIFE (7 * 24 * 60 * 60)
+
+#define INDEX_FILE_NAME "gedit-recent-index"
+#define INDEX_FILE_VERSION 1
+#define INDEX_FILE_FORMAT "(ua(sdxu))"
+
+/* Seconds before the scores are saved after a change */
+#define INDEX_SAVE_DELAY 5
+
+typedef struct
+{
+	/* NULL for the entries loaded from the index file and not synced */
+	GtkRecentInfo *info;
+
+	/* The normalized and casefolded uri for display */
+	gchar *key;
+
+	gdouble score;
+	gint64 modified;
+	guint n_visits;
+
+	/* passes_filter is valid if filter_serial is the one of the index */
+	guint filter_serial;
+	guint passes_filter : 1;
+
+	guint is_local : 1;
+	guint is_private : 1;
+	guint seen : 1;
+} IndexEntry;
+
+struct _GeditRecentIndex
+{
+	GtkRecentManager *manager;
+
+	GMutex mutex;
+
+	/* uri -> IndexEntry, and the same entries from the best score */
+	GHashTable *entries;
+	GPtrArray *ranked;
+	gboolean stale;
+
+	/* The entries loaded from the index file, until the first sync */
+	GHashTable *history;
+
+	GtkRecentFilter *filter;
+	guint filter_serial;
+
+	/* The entries matching the last substring, to narrow it down */
+	gchar *last_key;
+	GPtrArray *last_matches;
+
+	guint save_id;
+};
+
+G_LOCK_DEFINE_STATIC (index_lock);
+
+static void
+index_entry_free (IndexEntry *entry)
+{
+	if (entry->info != NULL)
+	{
+		gtk_recent_info_unref (entry->info);
+	}
+
+	g_free (entry->key);
+	g_slice_free (IndexEntry, entry);
+}
+
+/* log2 (2^score + 2^weight), without overflowing */
+static gdouble
+add_weight (gdouble score,
+            gdouble weight)
+{
+	gdouble high = MAX (score, weight);
+	gdouble low = MIN (score, weight);
+
+	return high + log2 (1.0 + exp2 (low - high));
+}
+
+static gdouble
+get_visit_weight (gint64 time)
+{
+	return (gdouble) time / FRECENCY_HALF_LIFE;
+}
+
+static void
+index_entry_add_visit (IndexEntry *entry,
+                       gint64      time)
+{
+	entry->score = add_weight (entry->score, get_visit_weight (time));
+	entry->modified = time;
+	entry->n_visits++;
+	entry->filter_serial = 0;
+}
+
+static gchar *
+get_key (GtkRecentInfo *info)
+{
+	gchar *uri_display;
+	gchar *normalized;
+	gchar *key;
+
+	uri_display = gtk_recent_info_get_uri_display (info);
+	normalized = g_utf8_normalize (uri_display != NULL ? uri_display : gtk_recent_info_get_uri (info),
+	                               -1,
+	                               G_NORMALIZE_ALL);
+	key = g_utf8_casefold (normalized, -1);
+
+	g_free (normalized);
+	g_free (uri_display);
+
+	return key;
+}
+
+static IndexEntry *
+index_entry_new (GtkRecentInfo *info,
+                 IndexEntry    *history)
+{
+	IndexEntry *entry;
+	gint64 modified;
+
+	entry = g_slice_new0 (IndexEntry);
+	entry->key = get_key (info);
+
+	modified = gtk_recent_info_get_modified (info);
+
+	if (history != NULL)
+	{
+		entry->score = history->score;
+		entry->modified = history->modified;
+		entry->n_visits = history->n_visits;
+
+		if (modified > entry->modified)
+		{
+			index_entry_add_visit (entry, modified);
+		}
+	}
+	else
+	{
+		guint count = 0;
+
+		/* Seed the score with what the recent manager knows */
+		gtk_recent_info_get_application_info (info,
+		                                      g_get_application_name (),
+		                                      NULL,
+		                                      &count,
+		                                      NULL);
+
+		entry->n_visits = MAX (count, 1);
+		entry->modified = modified;
+		entry->score = log2 (entry->n_visits) + get_visit_weight (modified);
+	}
+
+	return entry;
+}
+
+static gint
+compare_entries (IndexEntry **a,
+                 IndexEntry **b)
+{
+	if ((*a)->score != (*b)->score)
+	{
+		return (*a)->score < (*b)->score ? 1 : -1;
+	}
+
+	if ((*a)->modified != (*b)->modified)
+	{
+		return (*a)->modified < (*b)->modified ? 1 : -1;
+	}
+
+	return 0;
+}
+
+static gchar *
+get_index_filename (void)
+{
+	return g_build_filename (gedit_dirs_get_user_cache_dir (), INDEX_FILE_NAME, NULL);
+}
+
+static void
+index_load (GeditRecentIndex *index)
+{
+	gchar *filename;
+	gchar *contents;
+	gsize length;
+	GVariant *variant;
+	GVariantIter *iter;
+	const gchar *uri;
+	gdouble score;
+	gint64 modified;
+	guint32 n_visits;
+	guint32 version;
+
+	filename = get_index_filename ();
+
+	if (!g_file_get_contents (filename, &contents, &length, NULL))
+	{
+		g_free (filename);
+		return;
+	}
+
+	g_free (filename);
+
+	variant = g_variant_new_from_data (G_VARIANT_TYPE (INDEX_FILE_FORMAT),
+	                                   contents,
+	                                   length,
+	                                   FALSE,
+	                                   g_free,
+	                                   contents);
+	g_variant_ref_sink (variant);
+
+	g_variant_get (variant, INDEX_FILE_FORMAT, &version, &iter);
+
+	if (version == INDEX_FILE_VERSION)
+	{
+		while (g_variant_iter_next (iter, "(&sdxu)", &uri, &score, &modified, &n_visits))
+		{
+			IndexEntry *entry;
+
+			entry = g_slice_new0 (IndexEntry);
+			entry->score = score;
+			entry->modified = modified;
+			entry->n_visits = n_visits;
+
+			g_hash_table_replace (index->history, g_strdup (uri), entry);
+		}
+	}
+
+	g_variant_iter_free (iter);
+	g_variant_unref (variant);
+
+	gedit_debug_message (DEBUG_APP, "Loaded %u recent files scores",
+	                     g_hash_table_size (index->history));
+}
+
+static gboolean
+index_save (GeditRecentIndex *index)
+{
+	GVariantBuilder builder;
+	GVariant *variant;
+	gchar *filename;
+	guint i;
+
+	g_mutex_lock (&index->mutex);
+
+	index->save_id = 0;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(sdxu)"));
+
+	for (i = 0; i < index->ranked->len; i++)
+	{
+		IndexEntry *entry = g_ptr_array_index (index->ranked, i);
+
+		g_variant_builder_add (&builder,
+		                       "(sdxu)",
+		                       gtk_recent_info_get_uri (entry->info),
+		                       entry->score,
+		                       entry->modified,
+		                       entry->n_visits);
+	}
+
+	g_mutex_unlock (&index->mutex);
+
+	variant = g_variant_new (INDEX_FILE_FORMAT, INDEX_FILE_VERSION, &builder);
+	g_variant_ref_sink (variant);
+
+	filename = get_index_filename ();
+	g_mkdir_with_parents (gedit_dirs_get_user_cache_dir (), 0755);
+
+	if (!g_file_set_contents (filename,
+	                          g_variant_get_data (variant),
+	                          g_variant_get_size (variant),
+	                          NULL))
+	{
+		g_warning ("Failed to save the recent files scores to '%s'", filename);
+	}
+
+	g_free (filename);
+	g_variant_unref (variant);
+
+	return G_SOURCE_REMOVE;
+}
+
+/* Called with the mutex held */
+static void
+index_schedule_save (GeditRecentIndex *index)
+{
+	if (index->save_id == 0)
+	{
+		index->save_id = g_timeout_add_seconds (INDEX_SAVE_DELAY,
+		                                        (GSourceFunc) index_save,
+		                                        index);
+	}
+}
+
+/* Called with the mutex held */
+static void
+index_sync (GeditRecentIndex *index)
+{
+	GList *items;
+	GList *l;
+	GHashTableIter iter;
+	IndexEntry *entry;
+	gboolean changed = FALSE;
+
+	items = gtk_recent_manager_get_items (index->manager);
+
+	g_hash_table_iter_init (&iter, index->entries);
+
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry))
+	{
+		entry->seen = FALSE;
+	}
+
+	for (l = items; l != NULL; l = l->next)
+	{
+		GtkRecentInfo *info = l->data;
+		const gchar *uri;
+		gint64 modified;
+
+		uri = gtk_recent_info_get_uri (info);
+		modified = gtk_recent_info_get_modified (info);
+		entry = g_hash_table_lookup (index->entries, uri);
+
+		if (entry == NULL)
+		{
+			IndexEntry *history = NULL;
+
+			if (index->history != NULL)
+			{
+				history = g_hash_table_lookup (index->history, uri);
+			}
+
+			entry = index_entry_new (info, history);
+			g_hash_table_insert (index->entries, g_strdup (uri), entry);
+			changed = TRUE;
+		}
+		else if (modified > entry->modified)
+		{
+			index_entry_add_visit (entry, modified);
+			changed = TRUE;
+		}
+
+		/* The recent manager gives new infos each time */
+		if (entry->info != NULL)
+		{
+			gtk_recent_info_unref (entry->info);
+		}
+
+		entry->info = info;
+		entry->is_local = gtk_recent_info_is_local (info);
+		entry->is_private = gtk_recent_info_get_private_hint (info);
+		entry->seen = TRUE;
+	}
+
+	g_list_free (items);
+
+	g_hash_table_iter_init (&iter, index->entries);
+
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry))
+	{
+		if (!entry->seen)
+		{
+			g_hash_table_iter_remove (&iter);
+			changed = TRUE;
+		}
+	}
+
+	g_clear_pointer (&index->history, g_hash_table_unref);
+
+	g_ptr_array_set_size (index->ranked, 0);
+	g_hash_table_iter_init (&iter, index->entries);
+
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry))
+	{
+		g_ptr_array_add (index->ranked, entry);
+	}
+
+	g_ptr_array_sort (index->ranked, (GCompareFunc) compare_entries);
+
+	g_clear_pointer (&index->last_key, g_free);
+	g_clear_pointer (&index->last_matches, g_ptr_array_unref);
+
+	index->stale = FALSE;
+
+	if (changed)
+	{
+		index_schedule_save (index);
+	}
+}
+
+static void
+on_recent_manager_changed (GtkRecentManager *manager,
+                           GeditRecentIndex *index)
+{
+	g_mutex_lock (&index->mutex);
+	index->stale = TRUE;
+	g_mutex_unlock (&index->mutex);
+}
+
+static void
+index_free (GeditRecentIndex *index)
+{
+	if (index->save_id != 0)
+	{
+		g_source_remove (index->save_id);
+		index_save (index);
+	}
+
+	g_hash_table_unref (index->entries);
+	g_ptr_array_unref (index->ranked);
+	g_clear_pointer (&index->history, g_hash_table_unref);
+	g_clear_object (&index->filter);
+	g_free (index->last_key);
+	g_clear_pointer (&index->last_matches, g_ptr_array_unref);
+	g_mutex_clear (&index->mutex);
+
+	g_slice_free (GeditRecentIndex, index);
+}
+
+/**
+ * gedit_recent_index_get_for_manager:
+ * @manager: a #GtkRecentManager
+ *
+ * Returns the index of the items of @manager, which lives as long as
+ * @manager. It can be queried from any thread.
+ */
+GeditRecentIndex *
+gedit_recent_index_get_for_manager (GtkRecentManager *manager)
+{
+	GeditRecentIndex *index;
+
+	g_return_val_if_fail (GTK_IS_RECENT_MANAGER (manager), NULL);
+
+	G_LOCK (index_lock);
+
+	index = g_object_get_data (G_OBJECT (manager), "gedit-recent-index");
+
+	if (index == NULL)
+	{
+		index = g_slice_new0 (GeditRecentIndex);
+		index->manager = manager;
+		g_mutex_init (&index->mutex);
+		index->entries = g_hash_table_new_full (g_str_hash,
+		                                        g_str_equal,
+		                                        g_free,
+		                                        (GDestroyNotify) index_entry_free);
+		index->ranked = g_ptr_array_new ();
+		index->history = g_hash_table_new_full (g_str_hash,
+		                                        g_str_equal,
+		                                        g_free,
+		                                        (GDestroyNotify) index_entry_free);
+		index->filter_serial = 1;
+		index->stale = TRUE;
+
+		index_load (index);
+
+		g_signal_connect (manager,
+		                  "changed",
+		                  G_CALLBACK (on_recent_manager_changed),
+		                  index);
+
+		g_object_set_data_full (G_OBJECT (manager),
+		                        "gedit-recent-index",
+		                        index,
+		                        (GDestroyNotify) index_free);
+	}
+
+	G_UNLOCK (index_lock);
+
+	return index;
+}
+
+static void
+populate_filter_info (GtkRecentInfo        *info,
+                      GtkRecentFilterInfo  *filter_info,
+                      GtkRecentFilterFlags  needed)
+{
+	filter_info->uri = gtk_recent_info_get_uri (info);
+	filter_info->mime_type = gtk_recent_info_get_mime_type (info);
+
+	filter_info->contains = GTK_RECENT_FILTER_URI | GTK_RECENT_FILTER_MIME_TYPE;
+
+	if (needed & GTK_RECENT_FILTER_DISPLAY_NAME)
+	{
+		filter_info->display_name = gtk_recent_info_get_display_name (info);
+		filter_info->contains |= GTK_RECENT_FILTER_DISPLAY_NAME;
+	}
+	else
+	{
+		filter_info->display_name = NULL;
+	}
+
+	if (needed & GTK_RECENT_FILTER_APPLICATION)
+	{
+		filter_info->applications = (const gchar **) gtk_recent_info_get_applications (info, NULL);
+		filter_info->contains |= GTK_RECENT_FILTER_APPLICATION;
+	}
+	else
+	{
+		filter_info->applications = NULL;
+	}
+
+	if (needed & GTK_RECENT_FILTER_GROUP)
+	{
+		filter_info->groups = (const gchar **) gtk_recent_info_get_groups (info, NULL);
+		filter_info->contains |= GTK_RECENT_FILTER_GROUP;
+	}
+	else
+	{
+		filter_info->groups = NULL;
+	}
+
+	if (needed & GTK_RECENT_FILTER_AGE)
+	{
+		filter_info->age = gtk_recent_info_get_age (info);
+		filter_info->contains |= GTK_RECENT_FILTER_AGE;
+	}
+	else
+	{
+		filter_info->age = -1;
+	}
+}
+
+/* The result is cached in the entry, for the filter of the index */
+static gboolean
+index_entry_passes_filter (GeditRecentIndex *index,
+                           IndexEntry       *entry)
+{
+	GtkRecentFilterInfo filter_info;
+
+	if (entry->filter_serial == index->filter_serial)
+	{
+		return entry->passes_filter;
+	}
+
+	populate_filter_info (entry->info,
+	                      &filter_info,
+	                      gtk_recent_filter_get_needed (index->filter));
+
+	entry->passes_filter = gtk_recent_filter_filter (index->filter, &filter_info);
+	entry->filter_serial = index->filter_serial;
+
+	/* these we own */
+	if (filter_info.applications)
+	{
+		g_strfreev ((gchar **) filter_info.applications);
+	}
+
+	if (filter_info.groups)
+	{
+		g_strfreev ((gchar **) filter_info.groups);
+	}
+
+	return entry->passes_filter;
+}
+
+/* Returns the entries whose key contains @key, from the best score. When
+ * @key contains the previous one, only the previous matches are searched.
+ */
+static GPtrArray *
+index_get_matches (GeditRecentIndex *index,
+                   const gchar      *key)
+{
+	GPtrArray *candidates;
+	GPtrArray *matches;
+	guint i;
+
+	if (key == NULL)
+	{
+		return index->ranked;
+	}
+
+	if (index->last_key != NULL && g_str_equal (key, index->last_key))
+	{
+		return index->last_matches;
+	}
+
+	if (index->last_key != NULL && strstr (key, index->last_key) != NULL)
+	{
+		candidates = index->last_matches;
+	}
+	else
+	{
+		candidates = index->ranked;
+	}
+
+	matches = g_ptr_array_new ();
+
+	for (i = 0; i < candidates->len; i++)
+	{
+		IndexEntry *entry = g_ptr_array_index (candidates, i);
+
+		if (strstr (entry->key, key) != NULL)
+		{
+			g_ptr_array_add (matches, entry);
+		}
+	}
+
+	g_free (index->last_key);
+	index->last_key = g_strdup (key);
+
+	if (index->last_matches != NULL)
+	{
+		g_ptr_array_unref (index->last_matches);
+	}
+
+	index->last_matches = matches;
+
+	return matches;
+}
+
+/**
+ * gedit_recent_index_query:
+ * @index: a #GeditRecentIndex
+ * @config: the configuration of the query
+ *
+ * Returns the #GtkRecentInfo of the items matching @config, from the
+ * best frecency score, and at most config->limit of them. The search
+ * stops as soon as enough items are found.
+ *
+ * Returns: (transfer full): a list of #GtkRecentInfo
+ */
+GList *
+gedit_recent_index_query (GeditRecentIndex         *index,
+                          GeditRecentConfiguration *config)
+{
+	GPtrArray *matches;
+	GList *items = NULL;
+	gchar *key = NULL;
+	gint n_items = 0;
+	guint i;
+
+	g_return_val_if_fail (index != NULL, NULL);
+	g_return_val_if_fail (config != NULL, NULL);
+
+	if (config->limit == 0)
+	{
+		return NULL;
+	}
+
+	if (config->substring_filter != NULL && *config->substring_filter != '\0')
+	{
+		gchar *normalized;
+
+		normalized = g_utf8_normalize (config->substring_filter, -1, G_NORMALIZE_ALL);
+		key = g_utf8_casefold (normalized, -1);
+		g_free (normalized);
+	}
+
+	g_mutex_lock (&index->mutex);
+
+	if (index->stale)
+	{
+		index_sync (index);
+	}
+
+	if (index->filter != config->filter)
+	{
+		g_clear_object (&index->filter);
+		index->filter = config->filter != NULL ? g_object_ref (config->filter) : NULL;
+		index->filter_serial++;
+	}
+
+	matches = index_get_matches (index, key);
+
+	for (i = 0; i < matches->len; i++)
+	{
+		IndexEntry *entry = g_ptr_array_index (matches, i);
+
+		if ((config->local_only && !entry->is_local) ||
+		    (!config->show_private && entry->is_private) ||
+		    (index->filter != NULL && !index_entry_passes_filter (index, entry)) ||
+		    (!config->show_not_found && !gtk_recent_info_exists (entry->info)))
+		{
+			continue;
+		}
+
+		items = g_list_prepend (items, gtk_recent_info_ref (entry->info));
+
+		if (++n_items == config->limit)
+		{
+			break;
+		}
+	}
+
+	g_mutex_unlock (&index->mutex);
+
+	g_free (key);
+
+	return g_list_reverse (items);
+}
+
+/* ex:set ts=8 noet: */
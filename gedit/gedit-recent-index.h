@@ -0,0 +1,39 @@
+/*
+ * gedit-recent-index.h
+ * This file is part of gedit
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GEDIT_RECENT_INDEX_H
+#define GEDIT_RECENT_INDEX_H
+
+#include <gtk/gtk.h>
+
+#include "gedit-recent.h"
+
+G_BEGIN_DECLS
+
+typedef struct _GeditRecentIndex GeditRecentIndex;
+
+GeditRecentIndex	*gedit_recent_index_get_for_manager	(GtkRecentManager         *manager);
+
+GList			*gedit_recent_index_query		(GeditRecentIndex         *index,
+								 GeditRecentConfiguration *config);
+
+G_END_DECLS
+
+#endif /* GEDIT_RECENT_INDEX_H */
+
+/* ex:set ts=8 noet: */
@@ -24,8 +24,7 @@
 
 #include <gtk/gtk.h>
 #include <gedit/gedit-document.h>
-#include <string.h>
-
+#include "gedit-recent-index.h"
 #include "gedit-settings.h"
 
 void
@@ -96,64 +95,23 @@ gedit_recent_remove_if_local (GFile *location)
 	}
 }
 
-static gint
-sort_recent_items_mru (GtkRecentInfo *a,
-                       GtkRecentInfo *b,
-                       gpointer       unused)
-{
-	g_assert (a != NULL && b != NULL);
-	return gtk_recent_info_get_modified (b) - gtk_recent_info_get_modified (a);
-}
-
-static void
-populate_filter_info (GtkRecentInfo        *info,
-                      GtkRecentFilterInfo  *filter_info,
-                      GtkRecentFilterFlags  needed)
+static GtkRecentFilter *
+get_default_filter (void)
 {
-	filter_info->uri = gtk_recent_info_get_uri (info);
-	filter_info->mime_type = gtk_recent_info_get_mime_type (info);
-
-	filter_info->contains = GTK_RECENT_FILTER_URI | GTK_RECENT_FILTER_MIME_TYPE;
-
-	if (needed & GTK_RECENT_FILTER_DISPLAY_NAME)
-	{
-		filter_info->display_name = gtk_recent_info_get_display_name (info);
-		filter_info->contains |= GTK_RECENT_FILTER_DISPLAY_NAME;
-	}
-	else
-	{
-		filter_info->uri = NULL;
-	}
-
-	if (needed & GTK_RECENT_FILTER_APPLICATION)
-	{
-		filter_info->applications = (const gchar **) gtk_recent_info_get_applications (info, NULL);
-		filter_info->contains |= GTK_RECENT_FILTER_APPLICATION;
-	}
-	else
-	{
-		filter_info->applications = NULL;
-	}
+	static GtkRecentFilter *filter = NULL;
 
-	if (needed & GTK_RECENT_FILTER_GROUP)
-	{
-		filter_info->groups = (const gchar **) gtk_recent_info_get_groups (info, NULL);
-		filter_info->contains |= GTK_RECENT_FILTER_GROUP;
-	}
-	else
+	/* Shared by all the configurations, so that the recent index keeps
+	 * the result of the filter for each item.
+	 */
+	if (filter == NULL)
 	{
-		filter_info->groups = NULL;
+		filter = gtk_recent_filter_new ();
+		gtk_recent_filter_add_application (filter, g_get_application_name ());
+		gtk_recent_filter_add_mime_type (filter, "text/plain");
+		g_object_ref_sink (filter);
 	}
 
-	if (needed & GTK_RECENT_FILTER_AGE)
-	{
-		filter_info->age = gtk_recent_info_get_age (info);
-		filter_info->contains |= GTK_RECENT_FILTER_AGE;
-	}
-	else
-	{
-		filter_info->age = -1;
-	}
+	return filter;
 }
 
 /* The GeditRecentConfiguration struct is allocated and owned by the caller */
@@ -169,10 +127,7 @@ gedit_recent_configuration_init_default (GeditRecentConfiguration *config)
 		g_object_unref (config->filter);
 	}
 
-	config->filter = gtk_recent_filter_new ();
-	gtk_recent_filter_add_application (config->filter, g_get_application_name ());
-	gtk_recent_filter_add_mime_type (config->filter, "text/plain");
-	g_object_ref_sink (config->filter);
+	config->filter = g_object_ref (get_default_filter ());
 
 	settings = g_settings_new ("org.gnome.gedit.preferences.ui");
 
@@ -188,6 +143,9 @@ gedit_recent_configuration_init_default (GeditRecentConfiguration *config)
 	config->local_only = FALSE;
 
 	config->substring_filter = NULL;
+
+	/* Build the index from the main thread, before it is queried */
+	gedit_recent_index_get_for_manager (config->manager);
 }
 
 /* The GeditRecentConfiguration struct is owned and destroyed by the caller */
@@ -200,135 +158,20 @@ gedit_recent_configuration_destroy (GeditRecentConfiguration *config)
 	g_clear_pointer (&config->substring_filter, (GDestroyNotify)g_free);
 }
 
+/* Returns the items from the best frecency score, see gedit-recent-index.c */
 GList *
 gedit_recent_get_items (GeditRecentConfiguration *config)
 {
-	GtkRecentFilterFlags needed;
-	GList *items;
-	GList *retitems = NULL;
-	gint length;
-	char *substring_filter = NULL;
+	GeditRecentIndex *index;
 
 	if (config->limit == 0)
 	{
 		return NULL;
 	}
 
-	items = gtk_recent_manager_get_items (config->manager);
-
-	if (!items)
-	{
-		return NULL;
-	}
-
-	needed = gtk_recent_filter_get_needed (config->filter);
-	if (config->substring_filter && *config->substring_filter != '\0')
-	{
-		gchar *filter_normalized;
-
-		filter_normalized = g_utf8_normalize (config->substring_filter, -1, G_NORMALIZE_ALL);
-		substring_filter = g_utf8_casefold (filter_normalized, -1);
-		g_free (filter_normalized);
-	}
-
-	while (items)
-	{
-		GtkRecentInfo *info;
-		GtkRecentFilterInfo filter_info;
-		gboolean is_filtered;
-
-		info = items->data;
-		is_filtered = FALSE;
-
-		if (config->local_only && !gtk_recent_info_is_local (info))
-		{
-			is_filtered = TRUE;
-		}
-		else if (!config->show_private && gtk_recent_info_get_private_hint (info))
-		{
-			is_filtered = TRUE;
-		}
-		else if (!config->show_not_found && !gtk_recent_info_exists (info))
-		{
-			is_filtered = TRUE;
-		}
-		else
-		{
-			if (substring_filter)
-			{
-				gchar *uri_normalized;
-				gchar *uri_casefolded;
-
-				uri_normalized = g_utf8_normalize (gtk_recent_info_get_uri_display (info), -1, G_NORMALIZE_ALL);
-				uri_casefolded = g_utf8_casefold (uri_normalized, -1);
-				g_free (uri_normalized);
-
-				if (strstr (uri_casefolded, substring_filter) == NULL)
-				{
-					is_filtered = TRUE;
-				}
-
-				g_free (uri_casefolded);
-			}
-
-			if (!is_filtered)
-			{
-				populate_filter_info (info, &filter_info, needed);
-				is_filtered = !gtk_recent_filter_filter (config->filter, &filter_info);
-
-				/* these we own */
-				if (filter_info.applications)
-				{
-					g_strfreev ((gchar **) filter_info.applications);
-				}
-
-				if (filter_info.groups)
-				{
-					g_strfreev ((gchar **) filter_info.groups);
-				}
-			}
-		}
-
-		if (!is_filtered)
-		{
-			retitems = g_list_prepend (retitems, info);
-		}
-		else
-		{
-			gtk_recent_info_unref (info);
-		}
-
-		items = g_list_delete_link (items, items);
-	}
-
-	g_free (substring_filter);
-
-	if (!retitems)
-	{
-		return NULL;
-	}
-
-	retitems = g_list_sort_with_data (retitems, (GCompareDataFunc) sort_recent_items_mru, NULL);
-	length = g_list_length (retitems);
-
-	if ((config->limit != -1) && (length > config->limit))
-	{
-		GList *clamp, *l;
-
-		clamp = g_list_nth (retitems, config->limit - 1);
-
-		if (!clamp)
-		{
-			return retitems;
-		}
-
-		l = clamp->next;
-		clamp->next = NULL;
-
-		g_list_free_full (l, (GDestroyNotify) gtk_recent_info_unref);
-	}
+	index = gedit_recent_index_get_for_manager (config->manager);
 
-	return retitems;
+	return gedit_recent_index_query (index, config);
 }
 
 /* ex:set ts=8 noet: */
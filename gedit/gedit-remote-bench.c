@@ -0,0 +1,181 @@
+/*
+ * gedit-remote-bench.c
+ * This file is part of gedit
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Times "gedit FILE..." against a running gedit:
+ *
+ *   gedit-remote-bench [--count=N] [--client=PATH] FILE...
+ *
+ * The client (gedit/gedit by default) is run N times (100 by default)
+ * with FILE..., then _gedit_remote_forward() is called N times in this
+ * process, which leaves out the start of the client process. Both are
+ * printed in invocations per second.
+ *
+ * The exit status is 1 if an invocation fails or was not forwarded,
+ * 2 if gedit is not running.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <gio/gio.h>
+
+#include "gedit-remote.h"
+
+static gint count = 100;
+static gchar *client = NULL;
+
+static GOptionEntry options[] =
+{
+	{ "count", 'n', 0, G_OPTION_ARG_INT, &count,
+	  "Number of invocations", "N" },
+	{ "client", 'c', 0, G_OPTION_ARG_FILENAME, &client,
+	  "The gedit client to run", "PATH" },
+	{ NULL }
+};
+
+static void
+print_rate (const gchar *what,
+	    gdouble      elapsed)
+{
+	g_print ("%s: %d in %.3f s, %.1f per second, %.2f ms each\n",
+		 what,
+		 count,
+		 elapsed,
+		 count / elapsed,
+		 elapsed * 1000 / count);
+}
+
+static gboolean
+run_client (gchar **argv)
+{
+	GTimer *timer;
+	gint i;
+
+	timer = g_timer_new ();
+
+	for (i = 0; i < count; i++)
+	{
+		gint status;
+		GError *error = NULL;
+
+		if (!g_spawn_sync (NULL, argv, NULL,
+				   G_SPAWN_DEFAULT,
+				   NULL, NULL,
+				   NULL, NULL,
+				   &status,
+				   &error))
+		{
+			g_printerr ("%s\n", error->message);
+			g_error_free (error);
+			g_timer_destroy (timer);
+			return FALSE;
+		}
+
+		if (!g_spawn_check_exit_status (status, &error))
+		{
+			g_printerr ("%s: %s\n", argv[0], error->message);
+			g_error_free (error);
+			g_timer_destroy (timer);
+			return FALSE;
+		}
+	}
+
+	print_rate (argv[0], g_timer_elapsed (timer, NULL));
+	g_timer_destroy (timer);
+
+	return TRUE;
+}
+
+static gboolean
+run_forward (gint    argc,
+	     gchar **argv)
+{
+	GTimer *timer;
+	gint i;
+
+	timer = g_timer_new ();
+
+	for (i = 0; i < count; i++)
+	{
+		gint status;
+
+		if (!_gedit_remote_forward (argc, argv, &status) || status != 0)
+		{
+			g_printerr ("_gedit_remote_forward: not forwarded\n");
+			g_timer_destroy (timer);
+			return FALSE;
+		}
+	}
+
+	print_rate ("_gedit_remote_forward", g_timer_elapsed (timer, NULL));
+	g_timer_destroy (timer);
+
+	return TRUE;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+	GOptionContext *context;
+	GError *error = NULL;
+	gint status;
+	gboolean ok;
+
+	context = g_option_context_new ("FILE...");
+	g_option_context_add_main_entries (context, options, NULL);
+
+	if (!g_option_context_parse (context, &argc, &argv, &error))
+	{
+		g_printerr ("%s\n", error->message);
+		g_error_free (error);
+		g_option_context_free (context);
+		return 2;
+	}
+
+	g_option_context_free (context);
+
+	if (argc < 2 || count <= 0)
+	{
+		g_printerr ("Usage: %s [--count=N] [--client=PATH] FILE...\n", argv[0]);
+		return 2;
+	}
+
+	if (client == NULL)
+	{
+		client = g_strdup ("gedit/gedit");
+	}
+
+	/* The files are also opened once before the timings */
+	argv[0] = client;
+
+	if (!_gedit_remote_forward (argc, argv, &status))
+	{
+		g_printerr ("gedit is not running\n");
+		return 2;
+	}
+
+	ok = run_client (argv) && run_forward (argc, argv);
+
+	g_free (client);
+
+	return ok ? 0 : 1;
+}
+
+/* ex:set ts=8 noet: */
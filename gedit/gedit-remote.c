@@ -0,0 +1,385 @@
+/*
+ * gedit-remote.c
+ * This file is part of gedit
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* A lean client for the common "gedit FILE..." invocation from a terminal.
+ *
+ * When a primary instance is already running, the command line is parsed
+ * here, before gtk, the settings or the plugins are initialized, and handed
+ * over with a single call to the org.gnome.gedit.Remote interface exported
+ * by GeditApp. Anything this parser does not understand (stdin, --help,
+ * --standalone, gtk options...) or any failure to reach the primary
+ * instance makes _gedit_remote_forward() return FALSE, and the regular
+ * GApplication path takes over.
+ *
+ * Asking the bus whether the primary instance runs costs a round trip,
+ * as much as the call itself, on top of connecting to the bus. The
+ * primary instance rather keeps a file in the user runtime dir while it
+ * runs, see _gedit_remote_publish(): without it, the bus is not even
+ * connected to. A file left behind by a crash only costs the call.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "gedit-remote.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <glib/gstdio.h>
+
+static const gchar introspection_xml[] =
+	"<node>"
+	"  <interface name='" GEDIT_REMOTE_INTERFACE "'>"
+	"    <method name='Open'>"
+	"      <arg type='as' name='uris' direction='in'/>"
+	"      <arg type='a{sv}' name='options' direction='in'/>"
+	"      <arg type='a{sv}' name='platform_data' direction='in'/>"
+	"    </method>"
+	"  </interface>"
+	"</node>";
+
+GDBusInterfaceInfo *
+_gedit_remote_get_interface_info (void)
+{
+	static GDBusInterfaceInfo *info = NULL;
+
+	if (g_once_init_enter (&info))
+	{
+		GDBusNodeInfo *node;
+		GDBusInterfaceInfo *iface;
+
+		node = g_dbus_node_info_new_for_xml (introspection_xml, NULL);
+		iface = g_dbus_interface_info_ref (node->interfaces[0]);
+		g_dbus_node_info_unref (node);
+
+		g_once_init_leave (&info, iface);
+	}
+
+	return info;
+}
+
+/* One primary instance per session bus */
+static gchar *
+get_published_path (void)
+{
+	const gchar *address;
+	gchar *checksum;
+	gchar *path;
+
+	address = g_getenv ("DBUS_SESSION_BUS_ADDRESS");
+	checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1,
+	                                          address != NULL ? address : "",
+	                                          -1);
+	path = g_build_filename (g_get_user_runtime_dir (), "gedit", checksum, NULL);
+	g_free (checksum);
+
+	return path;
+}
+
+/*
+ * _gedit_remote_publish:
+ *
+ * Tells _gedit_remote_forward() that this process is the primary
+ * instance, until _gedit_remote_unpublish() is called.
+ */
+void
+_gedit_remote_publish (void)
+{
+	gchar *path;
+	gchar *dirname;
+
+	path = get_published_path ();
+	dirname = g_path_get_dirname (path);
+
+	if (g_mkdir_with_parents (dirname, 0700) == 0)
+	{
+		g_file_set_contents (path, "", 0, NULL);
+	}
+
+	g_free (dirname);
+	g_free (path);
+}
+
+void
+_gedit_remote_unpublish (void)
+{
+	gchar *path;
+
+	path = get_published_path ();
+	g_unlink (path);
+	g_free (path);
+}
+
+static gboolean
+is_published (void)
+{
+	gchar *path;
+	gboolean published;
+
+	path = get_published_path ();
+	published = g_file_test (path, G_FILE_TEST_EXISTS);
+	g_free (path);
+
+	return published;
+}
+
+static void
+parse_position (const gchar  *arg,
+                GVariantDict *options)
+{
+	gint line = 0;
+	gint column = 0;
+
+	/* Same rules as the GApplicationCommandLine path in gedit-app.c */
+	if (*arg == '\0')
+	{
+		line = G_MAXINT;
+	}
+	else
+	{
+		gchar **split;
+
+		split = g_strsplit (arg, ":", 2);
+
+		if (split[0] != NULL)
+		{
+			line = atoi (split[0]);
+
+			if (split[1] != NULL)
+			{
+				column = atoi (split[1]);
+			}
+		}
+
+		g_strfreev (split);
+	}
+
+	g_variant_dict_insert (options, "line", "i", line);
+	g_variant_dict_insert (options, "column", "i", column);
+}
+
+static gboolean
+parse_args (gint          argc,
+            gchar       **argv,
+            GPtrArray    *uris,
+            GVariantDict *options)
+{
+	gboolean only_files = FALSE;
+	gint i;
+
+	for (i = 1; i < argc; i++)
+	{
+		const gchar *arg = argv[i];
+
+		if (*arg == '+')
+		{
+			parse_position (arg + 1, options);
+		}
+		else if (*arg == '-' && !only_files)
+		{
+			if (strcmp (arg, "--") == 0)
+			{
+				only_files = TRUE;
+			}
+			else if (strcmp (arg, "--wait") == 0 ||
+			         strcmp (arg, "-w") == 0)
+			{
+				g_variant_dict_insert (options, "wait", "b", TRUE);
+			}
+			else if (strcmp (arg, "--new-window") == 0)
+			{
+				g_variant_dict_insert (options, "new-window", "b", TRUE);
+			}
+			else if (strcmp (arg, "--new-document") == 0)
+			{
+				g_variant_dict_insert (options, "new-document", "b", TRUE);
+			}
+			else if (strcmp (arg, "--follow") == 0 ||
+			         strcmp (arg, "-f") == 0)
+			{
+				g_variant_dict_insert (options, "follow", "b", TRUE);
+			}
+			else if (g_str_has_prefix (arg, "--encoding="))
+			{
+				g_variant_dict_insert (options, "encoding", "s",
+				                       arg + strlen ("--encoding="));
+			}
+			else if (strcmp (arg, "--encoding") == 0 && i + 1 < argc)
+			{
+				g_variant_dict_insert (options, "encoding", "s", argv[++i]);
+			}
+			else
+			{
+				/* stdin, --help, --standalone, gtk and
+				 * GApplication options, typos... */
+				return FALSE;
+			}
+		}
+		else if (strcmp (arg, "-") == 0)
+		{
+			/* stdin can only be forwarded by GApplicationCommandLine */
+			return FALSE;
+		}
+		else
+		{
+			GFile *file;
+
+			file = g_file_new_for_commandline_arg (arg);
+			g_ptr_array_add (uris, g_file_get_uri (file));
+			g_object_unref (file);
+		}
+	}
+
+	g_ptr_array_add (uris, NULL);
+
+	return TRUE;
+}
+
+static GVariant *
+get_platform_data (void)
+{
+	GVariantBuilder builder;
+	const gchar *startup_id;
+	gchar *cwd;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+
+	cwd = g_get_current_dir ();
+	g_variant_builder_add (&builder, "{sv}", "cwd",
+	                       g_variant_new_bytestring (cwd));
+	g_free (cwd);
+
+	/* Picked up by GtkApplication::before_emit in the primary instance */
+	startup_id = g_getenv ("DESKTOP_STARTUP_ID");
+	if (startup_id != NULL && g_utf8_validate (startup_id, -1, NULL))
+	{
+		g_variant_builder_add (&builder, "{sv}", "desktop-startup-id",
+		                       g_variant_new_string (startup_id));
+	}
+
+	return g_variant_builder_end (&builder);
+}
+
+static gboolean
+should_fall_back (const GError *error)
+{
+	/* Nobody owns the name, or the primary instance is older than the
+	 * remote interface, or it rejected the arguments (e.g. an invalid
+	 * encoding): let the regular path run and report it.
+	 */
+	return g_error_matches (error, G_DBUS_ERROR, G_DBUS_ERROR_SERVICE_UNKNOWN) ||
+	       g_error_matches (error, G_DBUS_ERROR, G_DBUS_ERROR_NAME_HAS_NO_OWNER) ||
+	       g_error_matches (error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD) ||
+	       g_error_matches (error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_INTERFACE) ||
+	       g_error_matches (error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_OBJECT) ||
+	       g_error_matches (error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS);
+}
+
+/*
+ * _gedit_remote_forward:
+ * @argc: the argc passed to main()
+ * @argv: the argv passed to main()
+ * @status: (out): the exit status, set when %TRUE is returned
+ *
+ * Tries to hand the command line over to the running primary instance.
+ * This must only use gio: it runs before gtk is initialized. The errors
+ * are printed, so gettext must be set up.
+ *
+ * Returns: %TRUE if the primary instance took care of the command line
+ * and the process can exit with @status.
+ */
+gboolean
+_gedit_remote_forward (gint    argc,
+                       gchar **argv,
+                       gint   *status)
+{
+	GDBusConnection *connection;
+	GPtrArray *uris;
+	GVariantDict options;
+	gboolean wait = FALSE;
+	GVariant *reply;
+	GError *error = NULL;
+	gboolean handled = FALSE;
+
+	uris = g_ptr_array_new_with_free_func (g_free);
+	g_variant_dict_init (&options, NULL);
+
+	if (!parse_args (argc, argv, uris, &options) || !is_published ())
+	{
+		goto out;
+	}
+
+	connection = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, NULL);
+	if (connection == NULL)
+	{
+		goto out;
+	}
+
+	g_variant_dict_lookup (&options, "wait", "b", &wait);
+
+	/* Do not let D-Bus activation start gedit behind our back: when
+	 * nobody is running, this process becomes the primary instance.
+	 */
+	reply = g_dbus_connection_call_sync (connection,
+	                                     GEDIT_REMOTE_BUS_NAME,
+	                                     GEDIT_REMOTE_OBJECT_PATH,
+	                                     GEDIT_REMOTE_INTERFACE,
+	                                     "Open",
+	                                     g_variant_new ("(^as@a{sv}@a{sv})",
+	                                                    (gchar **) uris->pdata,
+	                                                    g_variant_dict_end (&options),
+	                                                    get_platform_data ()),
+	                                     G_VARIANT_TYPE_UNIT,
+	                                     G_DBUS_CALL_FLAGS_NO_AUTO_START,
+	                                     wait ? G_MAXINT : -1,
+	                                     NULL,
+	                                     &error);
+
+	if (reply != NULL)
+	{
+		g_variant_unref (reply);
+		*status = 0;
+		handled = TRUE;
+	}
+	else if (wait && g_error_matches (error, G_DBUS_ERROR, G_DBUS_ERROR_NO_REPLY))
+	{
+		/* The primary instance went away while we were waiting:
+		 * the documents are closed as far as we are concerned.
+		 */
+		*status = 0;
+		handled = TRUE;
+	}
+	else if (!should_fall_back (error))
+	{
+		g_printerr ("%s\n", error->message);
+		*status = 1;
+		handled = TRUE;
+	}
+
+	g_clear_error (&error);
+	g_object_unref (connection);
+
+out:
+	g_variant_dict_clear (&options);
+	g_ptr_array_unref (uris);
+
+	return handled;
+}
+
+/* ex:set ts=8 noet: */
@@ -0,0 +1,44 @@
+/*
+ * gedit-remote.h
+ * This file is part of gedit
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GEDIT_REMOTE_H
+#define GEDIT_REMOTE_H
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define GEDIT_REMOTE_BUS_NAME		"org.gnome.gedit"
+#define GEDIT_REMOTE_OBJECT_PATH	"/org/gnome/gedit"
+#define GEDIT_REMOTE_INTERFACE		"org.gnome.gedit.Remote"
+
+GDBusInterfaceInfo	*_gedit_remote_get_interface_info	(void);
+
+void			 _gedit_remote_publish			(void);
+
+void			 _gedit_remote_unpublish		(void);
+
+gboolean		 _gedit_remote_forward			(gint       argc,
+								 gchar    **argv,
+								 gint      *status);
+
+G_END_DECLS
+
+#endif /* GEDIT_REMOTE_H */
+
+/* ex:set ts=8 noet: */
@@ -94,6 +94,8 @@ void			 gedit_settings_set_list			(GSettings     *settings,
 #define GEDIT_SETTINGS_CANDIDATE_ENCODINGS		"candidate-encodings"
 #define GEDIT_SETTINGS_ACTIVE_PLUGINS			"active-plugins"
 #define GEDIT_SETTINGS_ENSURE_TRAILING_NEWLINE		"ensure-trailing-newline"
+#define GEDIT_SETTINGS_LONG_LINE_THRESHOLD		"long-line-threshold"
+#define GEDIT_SETTINGS_FOLLOW_MAX_LINES			"follow-max-lines"
 
 /* window state keys */
 #define GEDIT_SETTINGS_WINDOW_STATE			"state"
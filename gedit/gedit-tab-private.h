@@ -49,6 +49,17 @@ void		 _gedit_tab_load_stream			(GeditTab                *tab,
 
 void		 _gedit_tab_revert			(GeditTab                *tab);
 
+gboolean	 _gedit_tab_get_follow			(GeditTab                *tab);
+
+void		 _gedit_tab_set_follow			(GeditTab                *tab,
+							 gboolean                 follow);
+
+void		 _gedit_tab_follow_stream		(GeditTab                *tab,
+							 GInputStream            *stream,
+							 const GtkSourceEncoding *encoding);
+
+gboolean	 _gedit_tab_get_trimmed			(GeditTab                *tab);
+
 void		 _gedit_tab_save_async			(GeditTab                *tab,
 							 GCancellable            *cancellable,
 							 GAsyncReadyCallback      callback,
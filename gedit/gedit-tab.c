@@ -37,8 +37,10 @@
 #include "gedit-document.h"
 #include "gedit-document-private.h"
 #include "gedit-enum-types.h"
+#include "gedit-follower.h"
 #include "gedit-settings.h"
 #include "gedit-view-frame.h"
+#include "gedit-view-private.h"
 
 #define GEDIT_TAB_KEY "GEDIT_TAB_KEY"
 
@@ -65,8 +67,18 @@ struct _GeditTab
 	gint auto_save_interval;
 	guint auto_save_timeout;
 
+	GeditFollower *follower;
+	GCancellable *follow_cancellable;
+
 	guint editable : 1;
 	guint auto_save : 1;
+	guint follow : 1;
+
+	/* The follower removed lines from the beginning of the document */
+	guint trimmed : 1;
+
+	/* Shown once the current info bar is dismissed */
+	guint long_lines_info_bar_pending : 1;
 
 	guint ask_if_externally_modified : 1;
 };
@@ -80,6 +92,9 @@ struct _SaverData
 
 	GTimer *timer;
 
+	/* The location before saving, when following it */
+	GFile *followed_location;
+
 	/* Notes about the create_backup saver flag:
 	 * - At the beginning of a new file saving, force_no_backup is FALSE.
 	 *   The create_backup flag is set to the saver if it is enabled in
@@ -107,6 +122,10 @@ struct _LoaderData
 	GTimer *timer;
 	gint line_pos;
 	gint column_pos;
+
+	/* Where a follower starts once loaded */
+	goffset num_bytes;
+
 	guint user_requested_encoding : 1;
 };
 
@@ -120,6 +139,7 @@ enum
 	PROP_AUTO_SAVE,
 	PROP_AUTO_SAVE_INTERVAL,
 	PROP_CAN_CLOSE,
+	PROP_FOLLOW,
 	LAST_PROP
 };
 
@@ -138,8 +158,19 @@ static gboolean gedit_tab_auto_save (GeditTab *tab);
 static void launch_loader (GTask                   *loading_task,
 			   const GtkSourceEncoding *encoding);
 
+static gboolean check_can_follow_file (GeditTab *tab);
+static void follow_file (GeditTab *tab,
+			 goffset   offset);
+static void start_following_file (GeditTab *tab);
+static void stop_following (GeditTab *tab);
+static void follow_max_lines_changed (GSettings   *settings,
+				      const gchar *key,
+				      GeditTab    *tab);
+
 static void launch_saver (GTask *saving_task);
 
+static void show_long_lines_info_bar (GeditTab *tab);
+
 static SaverData *
 saver_data_new (void)
 {
@@ -161,6 +192,8 @@ saver_data_free (SaverData *data)
 			g_timer_destroy (data->timer);
 		}
 
+		g_clear_object (&data->followed_location);
+
 		g_slice_free (SaverData, data);
 	}
 }
@@ -201,8 +234,10 @@ set_editable (GeditTab *tab,
 
 	view = gedit_tab_get_view (tab);
 
+	/* The follower clears the undo history */
 	val = (tab->state == GEDIT_TAB_STATE_NORMAL &&
-	       tab->editable);
+	       tab->editable &&
+	       tab->follower == NULL);
 
 	gtk_text_view_set_editable (GTK_TEXT_VIEW (view), val);
 }
@@ -286,6 +321,10 @@ gedit_tab_get_property (GObject    *object,
 			g_value_set_boolean (value, _gedit_tab_get_can_close (tab));
 			break;
 
+		case PROP_FOLLOW:
+			g_value_set_boolean (value, _gedit_tab_get_follow (tab));
+			break;
+
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 			break;
@@ -310,6 +349,10 @@ gedit_tab_set_property (GObject      *object,
 			gedit_tab_set_auto_save_interval (tab, g_value_get_int (value));
 			break;
 
+		case PROP_FOLLOW:
+			_gedit_tab_set_follow (tab, g_value_get_boolean (value));
+			break;
+
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 			break;
@@ -326,6 +369,7 @@ gedit_tab_dispose (GObject *object)
 	g_clear_object (&tab->print_preview);
 
 	remove_auto_save_timeout (tab);
+	stop_following (tab);
 
 	if (tab->idle_scroll != 0)
 	{
@@ -411,6 +455,13 @@ gedit_tab_class_init (GeditTabClass *klass)
 		                      TRUE,
 		                      G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
 
+	properties[PROP_FOLLOW] =
+		g_param_spec_boolean ("follow",
+		                      "Follow",
+		                      "Whether the text appended to the file is appended to the document",
+		                      FALSE,
+		                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
 	g_object_class_install_properties (object_class, LAST_PROP, properties);
 
 	signals[DROP_URIS] =
@@ -503,7 +554,8 @@ set_view_properties_according_to_state (GeditTab      *tab,
 	view = gedit_tab_get_view (tab);
 
 	val = ((state == GEDIT_TAB_STATE_NORMAL) &&
-	       tab->editable);
+	       tab->editable &&
+	       (tab->follower == NULL));
 	gtk_text_view_set_editable (GTK_TEXT_VIEW (view), val);
 
 	val = ((state != GEDIT_TAB_STATE_LOADING) &&
@@ -512,7 +564,8 @@ set_view_properties_according_to_state (GeditTab      *tab,
 
 	val = ((state != GEDIT_TAB_STATE_LOADING) &&
 	       (state != GEDIT_TAB_STATE_CLOSING) &&
-	       (hl_current_line));
+	       (hl_current_line) &&
+	       !_gedit_view_get_long_line_profile (view));
 	gtk_source_view_set_highlight_current_line (GTK_SOURCE_VIEW (view), val);
 }
 
@@ -608,6 +661,18 @@ set_info_bar (GeditTab        *tab,
 		gtk_widget_hide (tab->info_bar_hidden);
 
 		tab->info_bar = NULL;
+
+		/* Without it, the long line profile could not be turned off */
+		if (tab->long_lines_info_bar_pending)
+		{
+			tab->long_lines_info_bar_pending = FALSE;
+
+			if (tab->state == GEDIT_TAB_STATE_NORMAL &&
+			    _gedit_view_get_long_line_profile (gedit_tab_get_view (tab)))
+			{
+				show_long_lines_info_bar (tab);
+			}
+		}
 	}
 	else
 	{
@@ -711,6 +776,47 @@ file_already_open_warning_info_bar_response (GtkWidget *info_bar,
 	gtk_widget_grab_focus (GTK_WIDGET (view));
 }
 
+/* The document and the view each own the settings they stop following */
+static void
+set_long_line_profile (GeditTab *tab,
+		       gboolean  enabled)
+{
+	_gedit_document_set_long_line_profile (gedit_tab_get_document (tab), enabled);
+	_gedit_view_set_long_line_profile (gedit_tab_get_view (tab), enabled);
+}
+
+static void
+long_lines_info_bar_response (GtkWidget *info_bar,
+			      gint       response_id,
+			      GeditTab  *tab)
+{
+	GeditView *view = gedit_tab_get_view (tab);
+
+	if (response_id == GTK_RESPONSE_YES)
+	{
+		set_long_line_profile (tab, FALSE);
+	}
+
+	set_info_bar (tab, NULL, GTK_RESPONSE_NONE);
+
+	gtk_widget_grab_focus (GTK_WIDGET (view));
+}
+
+static void
+show_long_lines_info_bar (GeditTab *tab)
+{
+	GtkWidget *info_bar;
+
+	info_bar = gedit_long_lines_info_bar_new ();
+
+	g_signal_connect (info_bar,
+			  "response",
+			  G_CALLBACK (long_lines_info_bar_response),
+			  tab);
+
+	set_info_bar (tab, info_bar, GTK_RESPONSE_CANCEL);
+}
+
 static void
 load_cancelled (GtkWidget *bar,
 		gint       response_id,
@@ -1263,6 +1369,12 @@ view_focused_in (GtkWidget     *widget,
 		return GDK_EVENT_PROPAGATE;
 	}
 
+	/* the changes are expected, and already in the document */
+	if (tab->follower != NULL)
+	{
+		return GDK_EVENT_PROPAGATE;
+	}
+
 	doc = gedit_tab_get_document (tab);
 	file = gedit_document_get_file (doc);
 
@@ -1400,6 +1512,11 @@ gedit_tab_init (GeditTab *tab)
 			  G_CALLBACK (document_modified_changed),
 			  tab);
 
+	g_signal_connect (tab->editor_settings,
+			  "changed::" GEDIT_SETTINGS_FOLLOW_MAX_LINES,
+			  G_CALLBACK (follow_max_lines_changed),
+			  tab);
+
 	view = gedit_tab_get_view (tab);
 
 	g_signal_connect_after (view,
@@ -1660,6 +1777,8 @@ loader_progress_cb (goffset  size,
 	g_return_if_fail (tab->state == GEDIT_TAB_STATE_LOADING ||
 			  tab->state == GEDIT_TAB_STATE_REVERTING);
 
+	data->num_bytes = size;
+
 	if (should_show_progress_info (&data->timer, size, total_size))
 	{
 		show_loading_info_bar (loading_task);
@@ -1820,8 +1939,37 @@ successful_load (GTask *loading_task)
 	}
 
 	tab->ask_if_externally_modified = TRUE;
+	tab->trimmed = FALSE;
 
 	g_signal_emit_by_name (doc, "loaded");
+
+	/* The class handler of "loaded" looks for long lines. */
+	if (_gedit_document_get_has_long_lines (doc))
+	{
+		set_long_line_profile (tab, TRUE);
+
+		/* Don't hide a more important message, wait for it to be
+		 * dismissed.
+		 */
+		if (tab->info_bar == NULL)
+		{
+			show_long_lines_info_bar (tab);
+		}
+		else
+		{
+			tab->long_lines_info_bar_pending = TRUE;
+		}
+	}
+	else
+	{
+		set_long_line_profile (tab, FALSE);
+	}
+
+	/* The file may have grown since it was read */
+	if (tab->follow && check_can_follow_file (tab))
+	{
+		follow_file (tab, data->num_bytes);
+	}
 }
 
 static void
@@ -2059,6 +2207,9 @@ launch_loader (GTask                   *loading_task,
 	}
 
 	data->timer = g_timer_new ();
+	data->num_bytes = 0;
+
+	tab->long_lines_info_bar_pending = FALSE;
 
 	gtk_source_file_loader_load_async (data->loader,
 					   G_PRIORITY_DEFAULT,
@@ -2238,6 +2389,9 @@ revert_async (GeditTab            *tab,
 	location = gtk_source_file_get_location (file);
 	g_return_if_fail (location != NULL);
 
+	/* Restarted from the new end of the file once reverted */
+	stop_following (tab);
+
 	gedit_tab_set_state (tab, GEDIT_TAB_STATE_REVERTING);
 
 	loading_task = g_task_new (tab, cancellable, callback, user_data);
@@ -2267,6 +2421,317 @@ _gedit_tab_revert (GeditTab *tab)
 	g_object_unref (cancellable);
 }
 
+static void
+follower_appended (GeditFollower *follower,
+		   GeditTab      *tab)
+{
+	GtkTextBuffer *buffer;
+	GtkTextIter iter;
+
+	buffer = GTK_TEXT_BUFFER (gedit_tab_get_document (tab));
+	gtk_text_buffer_get_iter_at_mark (buffer, &iter, gtk_text_buffer_get_insert (buffer));
+
+	/* The follower keeps the cursor at the end if it was there */
+	if (gtk_text_iter_is_end (&iter) && tab->idle_scroll == 0)
+	{
+		tab->idle_scroll = g_idle_add ((GSourceFunc)scroll_to_cursor, tab);
+	}
+
+	if (gedit_follower_get_trimmed (follower))
+	{
+		tab->trimmed = TRUE;
+	}
+}
+
+static void
+follower_finished (GeditFollower *follower,
+		   GeditTab      *tab)
+{
+	_gedit_tab_set_follow (tab, FALSE);
+}
+
+static void
+follow_max_lines_changed (GSettings   *settings,
+			  const gchar *key,
+			  GeditTab    *tab)
+{
+	if (tab->follower != NULL)
+	{
+		gedit_follower_set_max_lines (tab->follower,
+					      g_settings_get_uint (settings, key));
+	}
+}
+
+static void
+set_follower (GeditTab      *tab,
+	      GeditFollower *follower)
+{
+	stop_following (tab);
+
+	tab->follower = follower;
+
+	gedit_follower_set_max_lines (follower,
+				      g_settings_get_uint (tab->editor_settings,
+							   GEDIT_SETTINGS_FOLLOW_MAX_LINES));
+
+	g_signal_connect (follower,
+			  "appended",
+			  G_CALLBACK (follower_appended),
+			  tab);
+
+	g_signal_connect (follower,
+			  "finished",
+			  G_CALLBACK (follower_finished),
+			  tab);
+
+	set_editable (tab, tab->editable);
+}
+
+static void
+stop_following (GeditTab *tab)
+{
+	if (tab->follow_cancellable != NULL)
+	{
+		g_cancellable_cancel (tab->follow_cancellable);
+		g_clear_object (&tab->follow_cancellable);
+	}
+
+	if (tab->follower != NULL)
+	{
+		g_signal_handlers_disconnect_by_data (tab->follower, tab);
+
+		/* The pending reads hold a reference */
+		g_object_run_dispose (G_OBJECT (tab->follower));
+		g_clear_object (&tab->follower);
+	}
+}
+
+/* Only plain local files can be followed: the offsets of a compressed
+ * file do not match the contents.
+ */
+static gboolean
+check_can_follow_file (GeditTab *tab)
+{
+	GeditDocument *doc;
+	GtkSourceFile *file;
+
+	doc = gedit_tab_get_document (tab);
+	file = gedit_document_get_file (doc);
+
+	if (gtk_source_file_get_location (file) == NULL ||
+	    !gtk_source_file_is_local (file) ||
+	    gtk_source_file_get_compression_type (file) != GTK_SOURCE_COMPRESSION_TYPE_NONE)
+	{
+		_gedit_tab_set_follow (tab, FALSE);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void
+follow_file (GeditTab *tab,
+	     goffset   offset)
+{
+	GeditDocument *doc;
+	GtkSourceFile *file;
+
+	doc = gedit_tab_get_document (tab);
+	file = gedit_document_get_file (doc);
+
+	set_follower (tab,
+		      gedit_follower_new_for_file (doc,
+						   gtk_source_file_get_location (file),
+						   gtk_source_file_get_encoding (file),
+						   offset));
+}
+
+static void
+query_size_cb (GFile        *location,
+	       GAsyncResult *result,
+	       GeditTab     *tab)
+{
+	GFileInfo *info;
+	GError *error = NULL;
+
+	info = g_file_query_info_finish (location, result, &error);
+
+	if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+	{
+		g_error_free (error);
+		g_object_unref (tab);
+		return;
+	}
+
+	g_clear_object (&tab->follow_cancellable);
+
+	if (error != NULL)
+	{
+		gedit_debug_message (DEBUG_TAB, "Cannot follow: %s", error->message);
+		g_error_free (error);
+
+		_gedit_tab_set_follow (tab, FALSE);
+	}
+	else
+	{
+		follow_file (tab, g_file_info_get_size (info));
+		g_object_unref (info);
+	}
+
+	g_object_unref (tab);
+}
+
+/* Outside of a load, the file on disk is the one last loaded or saved:
+ * the follower starts at its end.
+ */
+static void
+start_following_file (GeditTab *tab)
+{
+	GeditDocument *doc;
+	GtkSourceFile *file;
+
+	if (!check_can_follow_file (tab))
+	{
+		return;
+	}
+
+	stop_following (tab);
+
+	doc = gedit_tab_get_document (tab);
+	file = gedit_document_get_file (doc);
+
+	tab->follow_cancellable = g_cancellable_new ();
+
+	g_file_query_info_async (gtk_source_file_get_location (file),
+				 G_FILE_ATTRIBUTE_STANDARD_SIZE,
+				 G_FILE_QUERY_INFO_NONE,
+				 G_PRIORITY_DEFAULT,
+				 tab->follow_cancellable,
+				 (GAsyncReadyCallback) query_size_cb,
+				 g_object_ref (tab));
+}
+
+gboolean
+_gedit_tab_get_follow (GeditTab *tab)
+{
+	g_return_val_if_fail (GEDIT_IS_TAB (tab), FALSE);
+
+	return tab->follow;
+}
+
+/*
+ * _gedit_tab_set_follow:
+ * @tab: a #GeditTab
+ * @follow: whether to follow the file
+ *
+ * When following, what is appended to the file on disk is appended to the
+ * document, as with "tail -f". The setting is kept across reverts. It is
+ * turned off again if the file cannot be followed.
+ */
+void
+_gedit_tab_set_follow (GeditTab *tab,
+		       gboolean  follow)
+{
+	g_return_if_fail (GEDIT_IS_TAB (tab));
+
+	follow = follow != FALSE;
+
+	if (tab->follow == follow)
+	{
+		return;
+	}
+
+	tab->follow = follow;
+
+	if (!follow)
+	{
+		stop_following (tab);
+		set_editable (tab, tab->editable);
+	}
+	else if (tab->state == GEDIT_TAB_STATE_EXTERNALLY_MODIFIED_NOTIFICATION)
+	{
+		/* Catch up first, the follower starts once reverted */
+		_gedit_tab_revert (tab);
+	}
+	else if (tab->state == GEDIT_TAB_STATE_NORMAL)
+	{
+		GeditDocument *doc = gedit_tab_get_document (tab);
+		GtkSourceFile *file = gedit_document_get_file (doc);
+
+		if (gtk_source_file_is_local (file))
+		{
+			gtk_source_file_check_file_on_disk (file);
+		}
+
+		if (gtk_source_file_is_externally_modified (file) &&
+		    !gtk_text_buffer_get_modified (GTK_TEXT_BUFFER (doc)))
+		{
+			_gedit_tab_revert (tab);
+		}
+		else
+		{
+			start_following_file (tab);
+		}
+	}
+
+	/* When loading, the follower starts once loaded */
+
+	g_object_notify_by_pspec (G_OBJECT (tab), properties[PROP_FOLLOW]);
+}
+
+/*
+ * _gedit_tab_follow_stream:
+ * @tab: a #GeditTab
+ * @stream: the stream to follow
+ * @encoding: (allow-none): the encoding of @stream
+ *
+ * Appends the contents of @stream to the document as they arrive, until
+ * the end of the stream, instead of loading it all at once like
+ * _gedit_tab_load_stream(). Useful for something like
+ * "tail -f log | gedit --follow -".
+ */
+void
+_gedit_tab_follow_stream (GeditTab                *tab,
+			  GInputStream            *stream,
+			  const GtkSourceEncoding *encoding)
+{
+	GeditDocument *doc;
+	GtkSourceFile *file;
+
+	g_return_if_fail (GEDIT_IS_TAB (tab));
+	g_return_if_fail (G_IS_INPUT_STREAM (stream));
+	g_return_if_fail (tab->state == GEDIT_TAB_STATE_NORMAL);
+
+	doc = gedit_tab_get_document (tab);
+	file = gedit_document_get_file (doc);
+
+	gtk_source_file_set_location (file, NULL);
+
+	/* The contents may not be saved, as when loading from stdin */
+	gtk_text_buffer_set_modified (GTK_TEXT_BUFFER (doc), TRUE);
+
+	set_follower (tab, gedit_follower_new_for_stream (doc, stream, encoding));
+
+	tab->follow = TRUE;
+	g_object_notify_by_pspec (G_OBJECT (tab), properties[PROP_FOLLOW]);
+}
+
+/*
+ * _gedit_tab_get_trimmed:
+ * @tab: a #GeditTab
+ *
+ * Returns: whether lines were removed from the beginning of the document
+ * while following, since it was last loaded or saved. Saving it in place
+ * would then replace the file with its end.
+ */
+gboolean
+_gedit_tab_get_trimmed (GeditTab *tab)
+{
+	g_return_val_if_fail (GEDIT_IS_TAB (tab), FALSE);
+
+	return tab->trimmed;
+}
+
 static void
 close_printing (GeditTab *tab)
 {
@@ -2334,6 +2799,7 @@ save_cb (GtkSourceFileSaver *saver,
 		GtkWidget *info_bar;
 
 		gedit_tab_set_state (tab, GEDIT_TAB_STATE_SAVING_ERROR);
+		_gedit_tab_set_follow (tab, FALSE);
 
 		if (error->domain == GTK_SOURCE_FILE_SAVER_ERROR &&
 		    error->code == GTK_SOURCE_FILE_SAVER_ERROR_EXTERNALLY_MODIFIED)
@@ -2417,6 +2883,19 @@ save_cb (GtkSourceFileSaver *saver,
 		gedit_tab_set_state (tab, GEDIT_TAB_STATE_NORMAL);
 
 		tab->ask_if_externally_modified = TRUE;
+		tab->trimmed = FALSE;
+
+		/* Keep following the log, not a copy saved elsewhere */
+		if (tab->follow &&
+		    data->followed_location != NULL &&
+		    g_file_equal (data->followed_location, location))
+		{
+			start_following_file (tab);
+		}
+		else
+		{
+			_gedit_tab_set_follow (tab, FALSE);
+		}
 
 		g_signal_emit_by_name (doc, "saved");
 		g_task_return_boolean (saving_task, TRUE);
@@ -2438,6 +2917,21 @@ launch_saver (GTask *saving_task)
 
 	gedit_tab_set_state (tab, GEDIT_TAB_STATE_SAVING);
 
+	if (tab->follow && data->followed_location == NULL)
+	{
+		GFile *location;
+
+		location = gtk_source_file_get_location (gedit_document_get_file (doc));
+
+		if (location != NULL)
+		{
+			data->followed_location = g_object_ref (location);
+		}
+	}
+
+	/* The saved contents do not match the followed offset anymore */
+	stop_following (tab);
+
 	g_signal_emit_by_name (doc, "save");
 
 	if (data->timer != NULL)
@@ -2582,6 +3076,13 @@ gedit_tab_auto_save (GeditTab *tab)
 		return G_SOURCE_CONTINUE;
 	}
 
+	if (tab->trimmed)
+	{
+		gedit_debug_message (DEBUG_TAB, "Document trimmed by the follower");
+
+		return G_SOURCE_CONTINUE;
+	}
+
 	if (tab->state != GEDIT_TAB_STATE_NORMAL)
 	{
 		gedit_debug_message (DEBUG_TAB, "Retry after 30 seconds");
@@ -0,0 +1,35 @@
+/*
+ * gedit-view-private.h
+ * This file is part of gedit
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GEDIT_VIEW_PRIVATE_H
+#define GEDIT_VIEW_PRIVATE_H
+
+#include "gedit-view.h"
+
+G_BEGIN_DECLS
+
+void		 _gedit_view_set_long_line_profile	(GeditView *view,
+							 gboolean   enabled);
+
+gboolean	 _gedit_view_get_long_line_profile	(GeditView *view);
+
+G_END_DECLS
+
+#endif /* GEDIT_VIEW_PRIVATE_H */
+
+/* ex:set ts=8 noet: */
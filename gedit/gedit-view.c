@@ -21,6 +21,7 @@
  */
 
 #include "gedit-view.h"
+#include "gedit-view-private.h"
 
 #include <libpeas/peas-extension-set.h>
 #include <glib/gi18n.h>
@@ -47,6 +48,8 @@ struct _GeditViewPrivate
 	GtkTextBuffer *current_buffer;
 	PeasExtensionSet *extensions;
 	gchar *direct_save_uri;
+
+	guint long_line_profile : 1;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (GeditView, gedit_view, GTK_SOURCE_TYPE_VIEW)
@@ -179,6 +182,23 @@ gedit_view_dispose (GObject *object)
 	G_OBJECT_CLASS (gedit_view_parent_class)->dispose (object);
 }
 
+/* The settings that the long line profile overrides */
+static void
+bind_long_line_settings (GeditView *view)
+{
+	g_settings_bind (view->priv->editor_settings,
+	                 GEDIT_SETTINGS_HIGHLIGHT_CURRENT_LINE,
+	                 view,
+	                 "highlight-current-line",
+	                 G_SETTINGS_BIND_GET);
+
+	g_settings_bind (view->priv->editor_settings,
+	                 GEDIT_SETTINGS_WRAP_MODE,
+	                 view,
+	                 "wrap-mode",
+	                 G_SETTINGS_BIND_GET);
+}
+
 static void
 gedit_view_constructed (GObject *object)
 {
@@ -250,17 +270,7 @@ gedit_view_constructed (GObject *object)
 	                 "right-margin-position",
 	                 G_SETTINGS_BIND_GET);
 
-	g_settings_bind (priv->editor_settings,
-	                 GEDIT_SETTINGS_HIGHLIGHT_CURRENT_LINE,
-	                 view,
-	                 "highlight-current-line",
-	                 G_SETTINGS_BIND_GET);
-
-	g_settings_bind (priv->editor_settings,
-	                 GEDIT_SETTINGS_WRAP_MODE,
-	                 view,
-	                 "wrap-mode",
-	                 G_SETTINGS_BIND_GET);
+	bind_long_line_settings (view);
 
 	g_settings_bind (priv->editor_settings,
 	                 GEDIT_SETTINGS_SMART_HOME_END,
@@ -1002,4 +1012,46 @@ gedit_view_set_font (GeditView   *view,
 	pango_font_description_free (font_desc);
 }
 
+/* When enabled, the current line is not highlighted and the lines are not
+ * wrapped, whatever the settings say, until the profile is disabled again.
+ * Wrapping and highlighting the current line are what makes very long
+ * lines slow to lay out.
+ */
+void
+_gedit_view_set_long_line_profile (GeditView *view,
+				   gboolean   enabled)
+{
+	g_return_if_fail (GEDIT_IS_VIEW (view));
+
+	enabled = enabled != FALSE;
+
+	if (view->priv->long_line_profile == enabled)
+	{
+		return;
+	}
+
+	view->priv->long_line_profile = enabled;
+
+	if (enabled)
+	{
+		g_settings_unbind (view, "highlight-current-line");
+		g_settings_unbind (view, "wrap-mode");
+
+		gtk_source_view_set_highlight_current_line (GTK_SOURCE_VIEW (view), FALSE);
+		gtk_text_view_set_wrap_mode (GTK_TEXT_VIEW (view), GTK_WRAP_NONE);
+	}
+	else
+	{
+		bind_long_line_settings (view);
+	}
+}
+
+gboolean
+_gedit_view_get_long_line_profile (GeditView *view)
+{
+	g_return_val_if_fail (GEDIT_IS_VIEW (view), FALSE);
+
+	return view->priv->long_line_profile;
+}
+
 /* ex:set ts=8 noet: */
@@ -1034,7 +1034,18 @@ update_cursor_position_statusbar (GtkTextBuffer *buffer,
 					  gtk_text_buffer_get_insert (buffer));
 
 	line = 1 + gtk_text_iter_get_line (&iter);
-	col = 1 + gtk_source_view_get_visual_column (GTK_SOURCE_VIEW (view), &iter);
+
+	/* The visual column walks the line from its start, which is too
+	 * slow for each cursor move on very long lines.
+	 */
+	if (_gedit_document_get_long_line_profile (GEDIT_DOCUMENT (buffer)))
+	{
+		col = 1 + gtk_text_iter_get_line_offset (&iter);
+	}
+	else
+	{
+		col = 1 + gtk_source_view_get_visual_column (GTK_SOURCE_VIEW (view), &iter);
+	}
 
 	if ((line >= 0) || (col >= 0))
 	{
@@ -1322,6 +1333,7 @@ remove_actions (GeditWindow *window)
 	g_action_map_remove_action (G_ACTION_MAP (window), "display-right-margin");
 	g_action_map_remove_action (G_ACTION_MAP (window), "highlight-current-line");
 	g_action_map_remove_action (G_ACTION_MAP (window), "wrap-mode");
+	g_action_map_remove_action (G_ACTION_MAP (window), "follow");
 }
 
 static void
@@ -1339,6 +1351,7 @@ sync_current_tab_actions (GeditWindow *window,
 	if (new_view != NULL)
 	{
 		GPropertyAction *action;
+		GeditDocument *doc;
 
 		action = g_property_action_new ("auto-indent", new_view, "auto-indent");
 		g_action_map_add_action (G_ACTION_MAP (window), G_ACTION (action));
@@ -1364,6 +1377,11 @@ sync_current_tab_actions (GeditWindow *window,
 		g_action_map_add_action (G_ACTION_MAP (window), G_ACTION (action));
 		g_object_unref (action);
 
+		doc = GEDIT_DOCUMENT (gtk_text_view_get_buffer (GTK_TEXT_VIEW (new_view)));
+		action = g_property_action_new ("follow", gedit_tab_get_from_document (doc), "follow");
+		g_action_map_add_action (G_ACTION_MAP (window), G_ACTION (action));
+		g_object_unref (action);
+
 		g_action_map_add_action_entries (G_ACTION_MAP (window),
 		                                 text_wrapping_entrie,
 		                                 G_N_ELEMENTS (text_wrapping_entrie),
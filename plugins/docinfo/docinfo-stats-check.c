@@ -0,0 +1,284 @@
+/*
+ * docinfo-stats-check.c
+ * This file is part of gedit
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks the docinfo statistics against calculate_info(), the plain Pango
+ * count the plugin used before DocinfoStats:
+ *
+ *   docinfo-stats-check [--edits=N] [--seed=S] FILE...
+ *
+ * Every file is counted with docinfo_stats_count_text() and with Pango,
+ * and both timings are printed. The file is then loaded in a text buffer
+ * and edited at random, and the incremental counts are compared with the
+ * Pango count of the whole buffer after every edit.
+ *
+ * The exit status is 1 if any count differs.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+#include <pango/pango-break.h>
+
+#include "docinfo-stats.h"
+
+static gint n_edits = 200;
+static gint seed = 0;
+
+static GOptionEntry options[] =
+{
+	{ "edits", 'e', 0, G_OPTION_ARG_INT, &n_edits,
+	  "Number of random edits made to each file", "N" },
+	{ "seed", 's', 0, G_OPTION_ARG_INT, &seed,
+	  "Seed of the random edits", "S" },
+	{ NULL }
+};
+
+/* Same as calculate_info() in the old gedit-docinfo-plugin.c */
+static void
+calculate_info (const gchar   *text,
+		DocinfoCounts *counts)
+{
+	memset (counts, 0, sizeof (DocinfoCounts));
+
+	counts->chars = g_utf8_strlen (text, -1);
+	counts->bytes = strlen (text);
+
+	if (counts->chars > 0)
+	{
+		PangoLogAttr *attrs;
+		gint i;
+
+		attrs = g_new0 (PangoLogAttr, counts->chars + 1);
+
+		pango_get_log_attrs (text,
+				     -1,
+				     0,
+				     pango_language_from_string ("C"),
+				     attrs,
+				     counts->chars + 1);
+
+		for (i = 0; i < counts->chars; i++)
+		{
+			if (attrs[i].is_white)
+				++counts->white_chars;
+
+			if (attrs[i].is_word_start)
+				++counts->words;
+		}
+
+		g_free (attrs);
+	}
+}
+
+static gboolean
+check_counts (const gchar         *what,
+	      const DocinfoCounts *counts,
+	      const DocinfoCounts *expected)
+{
+	if (counts->chars == expected->chars &&
+	    counts->words == expected->words &&
+	    counts->white_chars == expected->white_chars &&
+	    counts->bytes == expected->bytes)
+	{
+		return TRUE;
+	}
+
+	g_printerr ("%s: got chars %d, words %d, white %d, bytes %d; "
+		    "expected chars %d, words %d, white %d, bytes %d\n",
+		    what,
+		    counts->chars, counts->words, counts->white_chars, counts->bytes,
+		    expected->chars, expected->words, expected->white_chars, expected->bytes);
+
+	return FALSE;
+}
+
+static void
+wait_for_counts (DocinfoStats  *stats,
+		 DocinfoCounts *counts)
+{
+	/* The counts are invalid until the idle recount is done */
+	while (!docinfo_stats_get_counts (stats, counts))
+	{
+		g_main_context_iteration (NULL, TRUE);
+	}
+}
+
+static void
+random_edit (GtkTextBuffer *buffer,
+	     const gchar   *sample,
+	     gint           sample_chars)
+{
+	GtkTextIter start;
+	GtkTextIter end;
+	gint n_chars;
+	gint offset;
+
+	n_chars = gtk_text_buffer_get_char_count (buffer);
+	offset = g_random_int_range (0, n_chars + 1);
+	gtk_text_buffer_get_iter_at_offset (buffer, &start, offset);
+
+	if (n_chars > 0 && g_random_boolean ())
+	{
+		end = start;
+		gtk_text_iter_forward_chars (&end, g_random_int_range (1, 32));
+		gtk_text_buffer_delete (buffer, &start, &end);
+	}
+	else if (sample_chars > 0)
+	{
+		const gchar *from;
+		const gchar *to;
+		gint first;
+
+		/* Insert a piece of the file, so that the edits contain
+		 * the same mix of scripts as the text.
+		 */
+		first = g_random_int_range (0, sample_chars);
+		from = g_utf8_offset_to_pointer (sample, first);
+		to = g_utf8_offset_to_pointer (from,
+					       MIN (g_random_int_range (1, 64),
+						    sample_chars - first));
+
+		gtk_text_buffer_insert (buffer, &start, from, to - from);
+	}
+}
+
+static gboolean
+check_file (const gchar *filename)
+{
+	gchar *text;
+	gsize len;
+	GError *error = NULL;
+	DocinfoCounts counts = { 0 };
+	DocinfoCounts expected;
+	GTimer *timer;
+	gdouble kernel_time;
+	gdouble pango_time;
+	GtkTextBuffer *buffer;
+	DocinfoStats *stats;
+	gint sample_chars;
+	gboolean ok;
+	gint i;
+
+	if (!g_file_get_contents (filename, &text, &len, &error))
+	{
+		g_printerr ("%s\n", error->message);
+		g_error_free (error);
+		return FALSE;
+	}
+
+	if (!g_utf8_validate (text, len, NULL))
+	{
+		g_printerr ("%s: not valid UTF-8, skipped\n", filename);
+		g_free (text);
+		return TRUE;
+	}
+
+	timer = g_timer_new ();
+	docinfo_stats_count_text (text, len, &counts, NULL);
+	kernel_time = g_timer_elapsed (timer, NULL);
+
+	g_timer_start (timer);
+	calculate_info (text, &expected);
+	pango_time = g_timer_elapsed (timer, NULL);
+	g_timer_destroy (timer);
+
+	g_print ("%s: %d chars, %d words, kernel %.3f ms, pango %.3f ms\n",
+		 filename,
+		 expected.chars,
+		 expected.words,
+		 kernel_time * 1000,
+		 pango_time * 1000);
+
+	ok = check_counts ("docinfo_stats_count_text", &counts, &expected);
+
+	buffer = gtk_text_buffer_new (NULL);
+	gtk_text_buffer_set_text (buffer, text, len);
+
+	stats = docinfo_stats_new (buffer, NULL, NULL);
+	sample_chars = g_utf8_strlen (text, len);
+
+	for (i = 0; ok && i <= n_edits; i++)
+	{
+		GtkTextIter start;
+		GtkTextIter end;
+		gchar *contents;
+
+		if (i > 0)
+		{
+			random_edit (buffer, text, sample_chars);
+		}
+
+		wait_for_counts (stats, &counts);
+
+		gtk_text_buffer_get_bounds (buffer, &start, &end);
+		contents = gtk_text_buffer_get_slice (buffer, &start, &end, TRUE);
+		calculate_info (contents, &expected);
+		g_free (contents);
+
+		ok = check_counts (i == 0 ? "recount" : "incremental",
+				   &counts, &expected);
+	}
+
+	docinfo_stats_free (stats);
+	g_object_unref (buffer);
+	g_free (text);
+
+	return ok;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+	GOptionContext *context;
+	GError *error = NULL;
+	gboolean ok = TRUE;
+	gint i;
+
+	context = g_option_context_new ("FILE...");
+	g_option_context_add_main_entries (context, options, NULL);
+
+	if (!g_option_context_parse (context, &argc, &argv, &error))
+	{
+		g_printerr ("%s\n", error->message);
+		g_error_free (error);
+		g_option_context_free (context);
+		return 2;
+	}
+
+	g_option_context_free (context);
+
+	if (seed != 0)
+	{
+		g_random_set_seed (seed);
+	}
+
+	for (i = 1; i < argc; i++)
+	{
+		if (!check_file (argv[i]))
+		{
+			ok = FALSE;
+		}
+	}
+
+	return ok ? 0 : 1;
+}
+
+/* ex:set ts=8 noet: */
@@ -0,0 +1,898 @@
+/*
+ * docinfo-stats.c
+ * This file is part of gedit
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* DocinfoStats keeps the word, character and byte counts of a buffer
+ * up to date while it is edited. Words never span a separator (an ASCII
+ * character that is not a letter or a digit), so the counts of a buffer
+ * are the sum of the counts of the text between separators: before an
+ * edit we subtract the run of word characters it touches and afterwards
+ * we add it back, which makes every update proportional to the size of
+ * the edit and the words around it, not to the length of the line.
+ *
+ * Edits in a run longer than RUN_MAX_CHARS and the text inserted while
+ * the document is loaded are not followed; the buffer is recounted once
+ * they are over. The recount walks the buffer a chunk at a time from an
+ * idle callback and also serves as a cross-check of the incremental
+ * counts when requested.
+ *
+ * The counting itself is done by docinfo_stats_count_text(), which does
+ * not depend on GTK+ so it can be benchmarked on its own against the Pango
+ * based count.
+ */
+
+#include "docinfo-stats.h"
+
+#include <string.h>
+#include <pango/pango-break.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <gedit/gedit-debug.h>
+
+struct _DocinfoStats
+{
+	GtkTextBuffer *buffer;
+
+	DocinfoStatsChangedFunc changed_func;
+	gpointer user_data;
+
+	DocinfoCounts counts;
+
+	/* The recount walks the buffer from an idle, scan_counts holds
+	 * the counts of the text before scan_offset.
+	 */
+	DocinfoCounts scan_counts;
+	gint scan_offset;
+	guint scan_id;
+
+	/* Recount once the edits we stopped following have settled */
+	guint recount_id;
+
+	/* Run of word characters around the edit in progress, as offsets
+	 * and as the number of characters after the edited text.
+	 */
+	gint edit_start;
+	gint edit_end;
+	gint edit_tail;
+
+	guint valid : 1;
+	guint paused : 1;
+	guint edit_counts : 1;
+	guint edit_scan : 1;
+};
+
+void
+docinfo_counts_add (DocinfoCounts       *counts,
+		    const DocinfoCounts *other)
+{
+	counts->chars += other->chars;
+	counts->words += other->words;
+	counts->white_chars += other->white_chars;
+	counts->bytes += other->bytes;
+}
+
+void
+docinfo_counts_subtract (DocinfoCounts       *counts,
+			 const DocinfoCounts *other)
+{
+	counts->chars -= other->chars;
+	counts->words -= other->words;
+	counts->white_chars -= other->white_chars;
+	counts->bytes -= other->bytes;
+}
+
+/* Character classes of the ASCII kernel */
+enum
+{
+	CLASS_OTHER  = 0,
+	CLASS_LETTER = 1 << 0,
+	CLASS_DIGIT  = 1 << 1,
+	CLASS_WHITE  = 1 << 2
+};
+
+static const guint8 ascii_class[128] =
+{
+	['\t'] = CLASS_WHITE, ['\n'] = CLASS_WHITE, ['\f'] = CLASS_WHITE,
+	['\r'] = CLASS_WHITE, [' '] = CLASS_WHITE,
+
+	['0'] = CLASS_DIGIT, ['1'] = CLASS_DIGIT, ['2'] = CLASS_DIGIT,
+	['3'] = CLASS_DIGIT, ['4'] = CLASS_DIGIT, ['5'] = CLASS_DIGIT,
+	['6'] = CLASS_DIGIT, ['7'] = CLASS_DIGIT, ['8'] = CLASS_DIGIT,
+	['9'] = CLASS_DIGIT,
+
+	['A'] = CLASS_LETTER, ['B'] = CLASS_LETTER, ['C'] = CLASS_LETTER,
+	['D'] = CLASS_LETTER, ['E'] = CLASS_LETTER, ['F'] = CLASS_LETTER,
+	['G'] = CLASS_LETTER, ['H'] = CLASS_LETTER, ['I'] = CLASS_LETTER,
+	['J'] = CLASS_LETTER, ['K'] = CLASS_LETTER, ['L'] = CLASS_LETTER,
+	['M'] = CLASS_LETTER, ['N'] = CLASS_LETTER, ['O'] = CLASS_LETTER,
+	['P'] = CLASS_LETTER, ['Q'] = CLASS_LETTER, ['R'] = CLASS_LETTER,
+	['S'] = CLASS_LETTER, ['T'] = CLASS_LETTER, ['U'] = CLASS_LETTER,
+	['V'] = CLASS_LETTER, ['W'] = CLASS_LETTER, ['X'] = CLASS_LETTER,
+	['Y'] = CLASS_LETTER, ['Z'] = CLASS_LETTER,
+
+	['a'] = CLASS_LETTER, ['b'] = CLASS_LETTER, ['c'] = CLASS_LETTER,
+	['d'] = CLASS_LETTER, ['e'] = CLASS_LETTER, ['f'] = CLASS_LETTER,
+	['g'] = CLASS_LETTER, ['h'] = CLASS_LETTER, ['i'] = CLASS_LETTER,
+	['j'] = CLASS_LETTER, ['k'] = CLASS_LETTER, ['l'] = CLASS_LETTER,
+	['m'] = CLASS_LETTER, ['n'] = CLASS_LETTER, ['o'] = CLASS_LETTER,
+	['p'] = CLASS_LETTER, ['q'] = CLASS_LETTER, ['r'] = CLASS_LETTER,
+	['s'] = CLASS_LETTER, ['t'] = CLASS_LETTER, ['u'] = CLASS_LETTER,
+	['v'] = CLASS_LETTER, ['w'] = CLASS_LETTER, ['x'] = CLASS_LETTER,
+	['y'] = CLASS_LETTER, ['z'] = CLASS_LETTER
+};
+
+/* Text is processed in blocks so that cancellation is noticed quickly */
+#define COUNT_BLOCK_SIZE (1 << 20)
+
+/* Characters counted by each iteration of the recount */
+#define SCAN_CHUNK_CHARS (256 * 1024)
+
+/* Longest run of word characters around an edit that is recounted on
+ * every keystroke.
+ */
+#define RUN_MAX_CHARS 4096
+
+/* Time in ms without edits before recounting text we stopped following */
+#define RECOUNT_DELAY 500
+
+static inline gint
+count_bits (guint32 v)
+{
+#ifdef __GNUC__
+	return __builtin_popcount (v);
+#else
+	gint n = 0;
+
+	while (v != 0)
+	{
+		v &= v - 1;
+		n++;
+	}
+
+	return n;
+#endif
+}
+
+static inline gboolean
+is_ascii_alnum (guchar c)
+{
+	return c < 0x80 && (ascii_class[c] & (CLASS_LETTER | CLASS_DIGIT)) != 0;
+}
+
+static const gchar *
+find_non_ascii (const gchar *p,
+		const gchar *end)
+{
+#ifdef __SSE2__
+	while (end - p >= 16)
+	{
+		__m128i v = _mm_loadu_si128 ((const __m128i *) p);
+		gint mask = _mm_movemask_epi8 (v);
+
+		if (mask != 0)
+		{
+			return p + __builtin_ctz (mask);
+		}
+
+		p += 16;
+	}
+#endif
+
+	while (p < end && (guchar) *p < 0x80)
+	{
+		p++;
+	}
+
+	return p;
+}
+
+/* Counts a run of ASCII text. Word starts follow Pango's character type
+ * rules: a word starts at a letter not preceded by a letter and at a digit
+ * not preceded by a digit. The run must start at the beginning of the text
+ * or at a character that is not a letter or a digit, so that no state has
+ * to be carried over from the previous run.
+ */
+static void
+count_ascii (const gchar   *p,
+	     const gchar   *end,
+	     DocinfoCounts *counts)
+{
+	guint prev = CLASS_OTHER;
+
+	counts->chars += end - p;
+	counts->bytes += end - p;
+
+#ifdef __SSE2__
+	{
+		const __m128i case_bit = _mm_set1_epi8 (0x20);
+		const __m128i before_a = _mm_set1_epi8 ('a' - 1);
+		const __m128i after_z = _mm_set1_epi8 ('z' + 1);
+		const __m128i before_0 = _mm_set1_epi8 ('0' - 1);
+		const __m128i after_9 = _mm_set1_epi8 ('9' + 1);
+		const __m128i space = _mm_set1_epi8 (' ');
+		const __m128i tab = _mm_set1_epi8 ('\t');
+		const __m128i nl = _mm_set1_epi8 ('\n');
+		const __m128i ff = _mm_set1_epi8 ('\f');
+		const __m128i cr = _mm_set1_epi8 ('\r');
+		guint32 prev_letter = 0;
+		guint32 prev_digit = 0;
+
+		while (end - p >= 16)
+		{
+			__m128i v = _mm_loadu_si128 ((const __m128i *) p);
+			__m128i lower = _mm_or_si128 (v, case_bit);
+			__m128i white;
+			guint32 letter;
+			guint32 digit;
+
+			/* All bytes are below 0x80, so signed compares are fine */
+			letter = _mm_movemask_epi8 (_mm_and_si128 (_mm_cmpgt_epi8 (lower, before_a),
+								   _mm_cmplt_epi8 (lower, after_z)));
+			digit = _mm_movemask_epi8 (_mm_and_si128 (_mm_cmpgt_epi8 (v, before_0),
+								  _mm_cmplt_epi8 (v, after_9)));
+
+			white = _mm_or_si128 (_mm_or_si128 (_mm_cmpeq_epi8 (v, space),
+							    _mm_cmpeq_epi8 (v, tab)),
+					      _mm_or_si128 (_mm_cmpeq_epi8 (v, nl),
+							    _mm_or_si128 (_mm_cmpeq_epi8 (v, ff),
+									  _mm_cmpeq_epi8 (v, cr))));
+
+			counts->white_chars += count_bits (_mm_movemask_epi8 (white));
+			counts->words += count_bits (letter & ~((letter << 1) | prev_letter));
+			counts->words += count_bits (digit & ~((digit << 1) | prev_digit));
+
+			prev_letter = (letter >> 15) & 1;
+			prev_digit = (digit >> 15) & 1;
+
+			p += 16;
+		}
+
+		prev = prev_letter ? CLASS_LETTER : prev_digit ? CLASS_DIGIT : CLASS_OTHER;
+	}
+#endif
+
+	for (; p < end; p++)
+	{
+		guint class = ascii_class[(guchar) *p];
+
+		if (class & CLASS_WHITE)
+			++counts->white_chars;
+		else if ((class & (CLASS_LETTER | CLASS_DIGIT)) && class != prev)
+			++counts->words;
+
+		prev = class;
+	}
+}
+
+/* Counts a run of text containing non-ASCII characters with Pango. The run
+ * must be delimited by ASCII characters that are not letters or digits, so
+ * that Pango's word state is the same as if the whole text was analyzed.
+ */
+static void
+count_unicode (const gchar    *p,
+	       gint            len,
+	       PangoLogAttr  **attrs,
+	       gint           *n_attrs,
+	       DocinfoCounts  *counts)
+{
+	gint chars;
+	gint i;
+
+	chars = g_utf8_strlen (p, len);
+
+	counts->chars += chars;
+	counts->bytes += len;
+
+	if (chars == 0)
+	{
+		return;
+	}
+
+	if (*n_attrs < chars + 1)
+	{
+		*n_attrs = chars + 1;
+		*attrs = g_renew (PangoLogAttr, *attrs, *n_attrs);
+	}
+
+	pango_get_log_attrs (p,
+			     len,
+			     0,
+			     pango_language_from_string ("C"),
+			     *attrs,
+			     chars + 1);
+
+	for (i = 0; i < chars; i++)
+	{
+		if ((*attrs)[i].is_white)
+			++counts->white_chars;
+
+		if ((*attrs)[i].is_word_start)
+			++counts->words;
+	}
+}
+
+/**
+ * docinfo_stats_count_text:
+ * @text: UTF-8 text.
+ * @len: length of @text in bytes, or -1 if it is nul-terminated.
+ * @counts: the counts to add the statistics of @text to.
+ * @cancellable: (nullable): a #GCancellable.
+ *
+ * ASCII text is classified with a vectorized kernel and only the runs
+ * containing non-ASCII characters go through Pango. Those runs never
+ * span a line break, so the memory needed for the Pango attributes is
+ * bounded by the longest line and not by the size of @text.
+ *
+ * Returns: %FALSE if @cancellable was cancelled, in which case @counts
+ * only contains part of the statistics.
+ */
+gboolean
+docinfo_stats_count_text (const gchar   *text,
+			  gssize         len,
+			  DocinfoCounts *counts,
+			  GCancellable  *cancellable)
+{
+	PangoLogAttr *attrs = NULL;
+	gint n_attrs = 0;
+	const gchar *p;
+	const gchar *end;
+	const gchar *block_end;
+
+	if (len < 0)
+	{
+		len = strlen (text);
+	}
+
+	p = text;
+	end = text + len;
+	block_end = text;
+
+	while (p < end)
+	{
+		const gchar *run_start;
+		const gchar *run_end;
+
+		if (p >= block_end)
+		{
+			if (g_cancellable_is_cancelled (cancellable))
+			{
+				break;
+			}
+
+			/* Blocks end on a separator so words are not split */
+			block_end = p + MIN (end - p, COUNT_BLOCK_SIZE);
+			while (block_end < end &&
+			       ((guchar) *block_end >= 0x80 || is_ascii_alnum (*block_end)))
+			{
+				block_end++;
+			}
+		}
+
+		run_start = find_non_ascii (p, block_end);
+
+		if (run_start == block_end)
+		{
+			count_ascii (p, block_end, counts);
+			p = block_end;
+			continue;
+		}
+
+		/* Extend the non-ASCII run to the enclosing word characters */
+		while (run_start > p && is_ascii_alnum (run_start[-1]))
+		{
+			run_start--;
+		}
+
+		run_end = run_start;
+		while (run_end < end &&
+		       ((guchar) *run_end >= 0x80 || is_ascii_alnum (*run_end)))
+		{
+			run_end++;
+		}
+
+		count_ascii (p, run_start, counts);
+		count_unicode (run_start, run_end - run_start, &attrs, &n_attrs, counts);
+
+		p = run_end;
+	}
+
+	g_free (attrs);
+
+	return p >= end;
+}
+
+static inline gboolean
+is_word_char (gunichar c)
+{
+	/* The characters that docinfo_stats_count_text() keeps in one run */
+	return c >= 0x80 || is_ascii_alnum ((guchar) c);
+}
+
+/* Moves @iter back to the start of the run of word characters it is in.
+ * Returns %FALSE if the run is longer than @max_chars.
+ */
+static gboolean
+backward_to_run_start (GtkTextIter *iter,
+		       gint         max_chars)
+{
+	GtkTextIter prev = *iter;
+	gint i;
+
+	for (i = 0; i < max_chars; i++)
+	{
+		if (!gtk_text_iter_backward_char (&prev) ||
+		    !is_word_char (gtk_text_iter_get_char (&prev)))
+		{
+			return TRUE;
+		}
+
+		*iter = prev;
+	}
+
+	return !gtk_text_iter_backward_char (&prev) ||
+	       !is_word_char (gtk_text_iter_get_char (&prev));
+}
+
+/* Moves @iter forward to the end of the run of word characters it is in.
+ * Returns %FALSE if the run is longer than @max_chars.
+ */
+static gboolean
+forward_to_run_end (GtkTextIter *iter,
+		    gint         max_chars)
+{
+	gint i;
+
+	for (i = 0; i < max_chars; i++)
+	{
+		if (!is_word_char (gtk_text_iter_get_char (iter)))
+		{
+			return TRUE;
+		}
+
+		gtk_text_iter_forward_char (iter);
+	}
+
+	return !is_word_char (gtk_text_iter_get_char (iter));
+}
+
+static void
+count_range (const GtkTextIter *start,
+	     const GtkTextIter *end,
+	     DocinfoCounts     *counts)
+{
+	gchar *text;
+
+	text = gtk_text_iter_get_slice (start, end);
+	docinfo_stats_count_text (text, -1, counts, NULL);
+	g_free (text);
+}
+
+static void
+notify_changed (DocinfoStats *stats)
+{
+	if (stats->changed_func != NULL)
+	{
+		stats->changed_func (stats, stats->user_data);
+	}
+}
+
+static gboolean
+counts_equal (const DocinfoCounts *a,
+	      const DocinfoCounts *b)
+{
+	return a->chars == b->chars &&
+	       a->words == b->words &&
+	       a->white_chars == b->white_chars &&
+	       a->bytes == b->bytes;
+}
+
+static gboolean
+scan_idle_cb (DocinfoStats *stats)
+{
+	GtkTextIter start;
+	GtkTextIter end;
+
+	gtk_text_buffer_get_iter_at_offset (stats->buffer, &start, stats->scan_offset);
+
+	/* Chunks end on a separator so words are not split */
+	end = start;
+	gtk_text_iter_forward_chars (&end, SCAN_CHUNK_CHARS);
+	forward_to_run_end (&end, G_MAXINT);
+
+	count_range (&start, &end, &stats->scan_counts);
+	stats->scan_offset = gtk_text_iter_get_offset (&end);
+
+	if (!gtk_text_iter_is_end (&end))
+	{
+		return G_SOURCE_CONTINUE;
+	}
+
+	stats->scan_id = 0;
+
+	if (stats->valid && !counts_equal (&stats->counts, &stats->scan_counts))
+	{
+		gedit_debug_message (DEBUG_PLUGINS,
+				     "Incremental statistics drifted: "
+				     "chars %d/%d, words %d/%d, bytes %d/%d",
+				     stats->counts.chars, stats->scan_counts.chars,
+				     stats->counts.words, stats->scan_counts.words,
+				     stats->counts.bytes, stats->scan_counts.bytes);
+	}
+
+	stats->counts = stats->scan_counts;
+	stats->valid = TRUE;
+
+	notify_changed (stats);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+start_scan (DocinfoStats *stats)
+{
+	memset (&stats->scan_counts, 0, sizeof (DocinfoCounts));
+	stats->scan_offset = 0;
+
+	if (stats->scan_id == 0)
+	{
+		stats->scan_id = g_idle_add ((GSourceFunc) scan_idle_cb, stats);
+	}
+}
+
+static void
+stop_scan (DocinfoStats *stats)
+{
+	if (stats->scan_id != 0)
+	{
+		g_source_remove (stats->scan_id);
+		stats->scan_id = 0;
+	}
+}
+
+static gboolean
+recount_timeout_cb (DocinfoStats *stats)
+{
+	stats->recount_id = 0;
+	start_scan (stats);
+
+	return G_SOURCE_REMOVE;
+}
+
+/* Stops following the edits and recounts once they have settled */
+static void
+queue_recount (DocinfoStats *stats)
+{
+	gboolean was_valid = stats->valid;
+
+	stats->valid = FALSE;
+	stop_scan (stats);
+
+	if (stats->recount_id != 0)
+	{
+		g_source_remove (stats->recount_id);
+	}
+
+	stats->recount_id = g_timeout_add (RECOUNT_DELAY,
+					   (GSourceFunc) recount_timeout_cb,
+					   stats);
+
+	if (was_valid)
+	{
+		notify_changed (stats);
+	}
+}
+
+static void
+begin_edit (DocinfoStats      *stats,
+	    const GtkTextIter *start,
+	    const GtkTextIter *end)
+{
+	GtkTextIter run_start = *start;
+	GtkTextIter run_end = *end;
+	DocinfoCounts old_counts = { 0 };
+
+	stats->edit_counts = FALSE;
+	stats->edit_scan = FALSE;
+
+	if (stats->paused)
+	{
+		return;
+	}
+
+	if (stats->recount_id != 0)
+	{
+		/* Wait until the edits have settled */
+		queue_recount (stats);
+		return;
+	}
+
+	if (!backward_to_run_start (&run_start, RUN_MAX_CHARS) ||
+	    !forward_to_run_end (&run_end, RUN_MAX_CHARS))
+	{
+		/* A very long line without separators, e.g. base64 data */
+		queue_recount (stats);
+		return;
+	}
+
+	stats->edit_start = gtk_text_iter_get_offset (&run_start);
+	stats->edit_end = gtk_text_iter_get_offset (&run_end);
+	stats->edit_tail = stats->edit_end - gtk_text_iter_get_offset (end);
+
+	if (stats->scan_id != 0)
+	{
+		if (stats->edit_end <= stats->scan_offset)
+		{
+			stats->edit_scan = TRUE;
+		}
+		else if (stats->edit_start < stats->scan_offset)
+		{
+			/* The edit straddles the counted part */
+			start_scan (stats);
+		}
+	}
+
+	stats->edit_counts = stats->valid;
+
+	if (!stats->edit_counts && !stats->edit_scan)
+	{
+		/* The scan will get to it */
+		return;
+	}
+
+	count_range (&run_start, &run_end, &old_counts);
+
+	if (stats->edit_counts)
+	{
+		docinfo_counts_subtract (&stats->counts, &old_counts);
+	}
+
+	if (stats->edit_scan)
+	{
+		docinfo_counts_subtract (&stats->scan_counts, &old_counts);
+	}
+}
+
+static void
+end_edit (DocinfoStats      *stats,
+	  const GtkTextIter *end)
+{
+	GtkTextIter run_start;
+	GtkTextIter run_end;
+	DocinfoCounts new_counts = { 0 };
+
+	if (!stats->edit_counts && !stats->edit_scan)
+	{
+		return;
+	}
+
+	/* The text around the edit is unchanged, so the run still starts
+	 * and ends at the same separators.
+	 */
+	gtk_text_buffer_get_iter_at_offset (stats->buffer, &run_start, stats->edit_start);
+	run_end = *end;
+	gtk_text_iter_forward_chars (&run_end, stats->edit_tail);
+
+	count_range (&run_start, &run_end, &new_counts);
+
+	if (stats->edit_scan)
+	{
+		docinfo_counts_add (&stats->scan_counts, &new_counts);
+		stats->scan_offset += gtk_text_iter_get_offset (&run_end) - stats->edit_end;
+	}
+
+	if (stats->edit_counts)
+	{
+		docinfo_counts_add (&stats->counts, &new_counts);
+		notify_changed (stats);
+	}
+}
+
+static void
+insert_text_before_cb (GtkTextBuffer *buffer,
+		       GtkTextIter   *location,
+		       const gchar   *text,
+		       gint           len,
+		       DocinfoStats  *stats)
+{
+	begin_edit (stats, location, location);
+}
+
+static void
+insert_text_after_cb (GtkTextBuffer *buffer,
+		      GtkTextIter   *location,
+		      const gchar   *text,
+		      gint           len,
+		      DocinfoStats  *stats)
+{
+	/* @location has been revalidated to point after the new text */
+	end_edit (stats, location);
+}
+
+static void
+delete_range_before_cb (GtkTextBuffer *buffer,
+			GtkTextIter   *start,
+			GtkTextIter   *end,
+			DocinfoStats  *stats)
+{
+	begin_edit (stats, start, end);
+}
+
+static void
+delete_range_after_cb (GtkTextBuffer *buffer,
+		       GtkTextIter   *start,
+		       GtkTextIter   *end,
+		       DocinfoStats  *stats)
+{
+	end_edit (stats, start);
+}
+
+DocinfoStats *
+docinfo_stats_new (GtkTextBuffer           *buffer,
+		   DocinfoStatsChangedFunc  changed_func,
+		   gpointer                 user_data)
+{
+	DocinfoStats *stats;
+
+	g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), NULL);
+
+	stats = g_slice_new0 (DocinfoStats);
+	stats->buffer = buffer;
+	stats->changed_func = changed_func;
+	stats->user_data = user_data;
+
+	g_signal_connect (buffer,
+			  "insert-text",
+			  G_CALLBACK (insert_text_before_cb),
+			  stats);
+	g_signal_connect_after (buffer,
+				"insert-text",
+				G_CALLBACK (insert_text_after_cb),
+				stats);
+	g_signal_connect (buffer,
+			  "delete-range",
+			  G_CALLBACK (delete_range_before_cb),
+			  stats);
+	g_signal_connect_after (buffer,
+				"delete-range",
+				G_CALLBACK (delete_range_after_cb),
+				stats);
+
+	start_scan (stats);
+
+	return stats;
+}
+
+void
+docinfo_stats_free (DocinfoStats *stats)
+{
+	if (stats == NULL)
+	{
+		return;
+	}
+
+	g_signal_handlers_disconnect_by_data (stats->buffer, stats);
+
+	stop_scan (stats);
+
+	if (stats->recount_id != 0)
+	{
+		g_source_remove (stats->recount_id);
+	}
+
+	g_slice_free (DocinfoStats, stats);
+}
+
+GtkTextBuffer *
+docinfo_stats_get_buffer (DocinfoStats *stats)
+{
+	return stats->buffer;
+}
+
+/**
+ * docinfo_stats_get_counts:
+ * @stats: a #DocinfoStats.
+ * @counts: (out): return location for the counts.
+ *
+ * Returns: %FALSE if the counts are being recounted from scratch, e.g.
+ * after the document has been loaded, in which case @counts is not set.
+ */
+gboolean
+docinfo_stats_get_counts (DocinfoStats  *stats,
+			  DocinfoCounts *counts)
+{
+	if (!stats->valid)
+	{
+		return FALSE;
+	}
+
+	*counts = stats->counts;
+	return TRUE;
+}
+
+/**
+ * docinfo_stats_set_paused:
+ * @stats: a #DocinfoStats.
+ * @paused: whether to stop following the edits.
+ *
+ * While paused the counts are not valid and the edits are not looked
+ * at. This is meant for the file loader, which inserts the whole file
+ * chunk by chunk: the buffer is recounted once when @stats is resumed.
+ */
+void
+docinfo_stats_set_paused (DocinfoStats *stats,
+			  gboolean      paused)
+{
+	paused = paused != FALSE;
+
+	if (stats->paused == paused)
+	{
+		return;
+	}
+
+	stats->paused = paused;
+
+	if (paused)
+	{
+		gboolean was_valid = stats->valid;
+
+		stats->valid = FALSE;
+		stop_scan (stats);
+
+		if (stats->recount_id != 0)
+		{
+			g_source_remove (stats->recount_id);
+			stats->recount_id = 0;
+		}
+
+		if (was_valid)
+		{
+			notify_changed (stats);
+		}
+	}
+	else
+	{
+		start_scan (stats);
+	}
+}
+
+/**
+ * docinfo_stats_recount:
+ * @stats: a #DocinfoStats.
+ *
+ * Recounts the whole buffer a chunk at a time from an idle callback, so
+ * that the buffer is never copied as a whole. Edits made to the part
+ * already counted are applied to the partial result, the others are
+ * picked up when the recount gets to them. If the incremental counts
+ * were valid they are checked against the recount and any difference is
+ * reported in the debug output.
+ */
+void
+docinfo_stats_recount (DocinfoStats *stats)
+{
+	/* A recount is already due */
+	if (stats->paused || stats->recount_id != 0)
+	{
+		return;
+	}
+
+	start_scan (stats);
+}
+
+/* ex:set ts=8 noet: */
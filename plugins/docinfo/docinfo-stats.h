@@ -0,0 +1,71 @@
+/*
+ * docinfo-stats.h
+ * This file is part of gedit
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DOCINFO_STATS_H
+#define DOCINFO_STATS_H
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+typedef struct _DocinfoCounts DocinfoCounts;
+typedef struct _DocinfoStats  DocinfoStats;
+
+struct _DocinfoCounts
+{
+	gint chars;
+	gint words;
+	gint white_chars;
+	gint bytes;
+};
+
+typedef void (* DocinfoStatsChangedFunc) (DocinfoStats *stats,
+					  gpointer      user_data);
+
+void		 docinfo_counts_add		(DocinfoCounts          *counts,
+						 const DocinfoCounts    *other);
+
+void		 docinfo_counts_subtract	(DocinfoCounts          *counts,
+						 const DocinfoCounts    *other);
+
+gboolean	 docinfo_stats_count_text	(const gchar            *text,
+						 gssize                  len,
+						 DocinfoCounts          *counts,
+						 GCancellable           *cancellable);
+
+DocinfoStats	*docinfo_stats_new		(GtkTextBuffer          *buffer,
+						 DocinfoStatsChangedFunc changed_func,
+						 gpointer                user_data);
+
+void		 docinfo_stats_free		(DocinfoStats           *stats);
+
+GtkTextBuffer	*docinfo_stats_get_buffer	(DocinfoStats           *stats);
+
+gboolean	 docinfo_stats_get_counts	(DocinfoStats           *stats,
+						 DocinfoCounts          *counts);
+
+void		 docinfo_stats_set_paused	(DocinfoStats           *stats,
+						 gboolean                paused);
+
+void		 docinfo_stats_recount		(DocinfoStats           *stats);
+
+G_END_DECLS
+
+#endif /* DOCINFO_STATS_H */
+
+/* ex:set ts=8 noet: */
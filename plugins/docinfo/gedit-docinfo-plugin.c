@@ -23,15 +23,14 @@
 #endif
 
 #include "gedit-docinfo-plugin.h"
-
-#include <string.h> /* For strlen (...) */
+#include "docinfo-stats.h"
 
 #include <glib/gi18n.h>
-#include <pango/pango-break.h>
 #include <gmodule.h>
 
 #include <gedit/gedit-app.h>
 #include <gedit/gedit-window.h>
+#include <gedit/gedit-tab.h>
 #include <gedit/gedit-debug.h>
 #include <gedit/gedit-utils.h>
 #include <gedit/gedit-menu-extension.h>
@@ -66,8 +65,25 @@ struct _GeditDocinfoPluginPrivate
 
 	GeditApp  *app;
 	GeditMenuExtension *menu_ext;
+
+	guint statusbar_context_id;
+	guint update_id;
+
+	GeditDocument *selection_doc;
+	gulong mark_set_id;
+	guint selection_timeout_id;
+	GCancellable *selection_cancellable;
+
+	gulong tab_added_id;
+	gulong tab_removed_id;
+	gulong active_tab_changed_id;
 };
 
+#define DOCINFO_STATS_KEY "GeditDocinfoPluginStats"
+
+/* Time in ms between two counts of a selection that keeps changing */
+#define SELECTION_UPDATE_DELAY 100
+
 enum
 {
 	PROP_0,
@@ -88,59 +104,24 @@ G_DEFINE_DYNAMIC_TYPE_EXTENDED (GeditDocinfoPlugin,
 							       gedit_window_activatable_iface_init)
 				G_ADD_PRIVATE_DYNAMIC (GeditDocinfoPlugin))
 
-static void
-calculate_info (GeditDocument *doc,
-		GtkTextIter   *start,
-		GtkTextIter   *end,
-		gint          *chars,
-		gint          *words,
-		gint          *white_chars,
-		gint          *bytes)
+typedef struct
 {
 	gchar *text;
+	gint lines;
+	DocinfoCounts counts;
+} SelectionInfo;
 
-	gedit_debug (DEBUG_PLUGINS);
-
-	text = gtk_text_buffer_get_slice (GTK_TEXT_BUFFER (doc),
-					  start,
-					  end,
-					  TRUE);
-
-	*chars = g_utf8_strlen (text, -1);
-	*bytes = strlen (text);
-
-	if (*chars > 0)
-	{
-		PangoLogAttr *attrs;
-		gint i;
-
-		attrs = g_new0 (PangoLogAttr, *chars + 1);
-
-		pango_get_log_attrs (text,
-				     -1,
-				     0,
-				     pango_language_from_string ("C"),
-				     attrs,
-				     *chars + 1);
-
-		for (i = 0; i < (*chars); i++)
-		{
-			if (attrs[i].is_white)
-				++(*white_chars);
-
-			if (attrs[i].is_word_start)
-				++(*words);
-		}
-
-		g_free (attrs);
-	}
-	else
-	{
-		*white_chars = 0;
-		*words = 0;
-	}
+static void
+selection_info_free (SelectionInfo *info)
+{
+	g_free (info->text);
+	g_slice_free (SelectionInfo, info);
+}
 
-	g_free (text);
+static DocinfoStats *
+get_document_stats (GeditDocument *doc)
+{
+	return g_object_get_data (G_OBJECT (doc), DOCINFO_STATS_KEY);
 }
 
 static void
@@ -148,7 +129,8 @@ update_document_info (GeditDocinfoPlugin *plugin,
 		      GeditDocument      *doc)
 {
 	GeditDocinfoPluginPrivate *priv;
-	GtkTextIter start, end;
+	DocinfoStats *stats;
+	DocinfoCounts counts;
 	gint words = 0;
 	gint chars = 0;
 	gint white_chars = 0;
@@ -161,15 +143,20 @@ update_document_info (GeditDocinfoPlugin *plugin,
 
 	priv = plugin->priv;
 
-	gtk_text_buffer_get_bounds (GTK_TEXT_BUFFER (doc),
-				    &start,
-				    &end);
+	stats = get_document_stats (doc);
+
+	/* The labels are filled in when the initial recount is done */
+	if (stats == NULL || !docinfo_stats_get_counts (stats, &counts))
+	{
+		return;
+	}
 
 	lines = gtk_text_buffer_get_line_count (GTK_TEXT_BUFFER (doc));
 
-	calculate_info (doc,
-			&start, &end,
-			&chars, &words, &white_chars, &bytes);
+	chars = counts.chars;
+	words = counts.words;
+	white_chars = counts.white_chars;
+	bytes = counts.bytes;
 
 	if (chars == 0)
 	{
@@ -208,84 +195,247 @@ update_document_info (GeditDocinfoPlugin *plugin,
 }
 
 static void
-update_selection_info (GeditDocinfoPlugin *plugin,
-		       GeditDocument      *doc)
+set_selection_labels (GeditDocinfoPlugin  *plugin,
+		      gboolean             sel,
+		      gint                 lines,
+		      const DocinfoCounts *counts)
 {
 	GeditDocinfoPluginPrivate *priv;
-	gboolean sel;
-	GtkTextIter start, end;
-	gint words = 0;
-	gint chars = 0;
-	gint white_chars = 0;
-	gint lines = 0;
-	gint bytes = 0;
 	gchar *tmp_str;
 
-	gedit_debug (DEBUG_PLUGINS);
-
 	priv = plugin->priv;
 
-	sel = gtk_text_buffer_get_selection_bounds (GTK_TEXT_BUFFER (doc),
-						    &start,
-						    &end);
-
-	if (sel)
-	{
-		lines = gtk_text_iter_get_line (&end) - gtk_text_iter_get_line (&start) + 1;
-
-		calculate_info (doc,
-				&start, &end,
-				&chars, &words, &white_chars, &bytes);
-
-		gedit_debug_message (DEBUG_PLUGINS, "Selected chars: %d", chars);
-		gedit_debug_message (DEBUG_PLUGINS, "Selected lines: %d", lines);
-		gedit_debug_message (DEBUG_PLUGINS, "Selected words: %d", words);
-		gedit_debug_message (DEBUG_PLUGINS, "Selected chars non-space: %d", chars - white_chars);
-		gedit_debug_message (DEBUG_PLUGINS, "Selected bytes: %d", bytes);
-
-		gtk_widget_set_sensitive (priv->selection_label, TRUE);
-		gtk_widget_set_sensitive (priv->selected_words_label, TRUE);
-		gtk_widget_set_sensitive (priv->selected_bytes_label, TRUE);
-		gtk_widget_set_sensitive (priv->selected_lines_label, TRUE);
-		gtk_widget_set_sensitive (priv->selected_chars_label, TRUE);
-		gtk_widget_set_sensitive (priv->selected_chars_ns_label, TRUE);
-	}
-	else
-	{
-		gedit_debug_message (DEBUG_PLUGINS, "Selection empty");
-
-		gtk_widget_set_sensitive (priv->selection_label, FALSE);
-		gtk_widget_set_sensitive (priv->selected_words_label, FALSE);
-		gtk_widget_set_sensitive (priv->selected_bytes_label, FALSE);
-		gtk_widget_set_sensitive (priv->selected_lines_label, FALSE);
-		gtk_widget_set_sensitive (priv->selected_chars_label, FALSE);
-		gtk_widget_set_sensitive (priv->selected_chars_ns_label, FALSE);
-	}
+	gtk_widget_set_sensitive (priv->selection_label, sel);
+	gtk_widget_set_sensitive (priv->selected_words_label, sel);
+	gtk_widget_set_sensitive (priv->selected_bytes_label, sel);
+	gtk_widget_set_sensitive (priv->selected_lines_label, sel);
+	gtk_widget_set_sensitive (priv->selected_chars_label, sel);
+	gtk_widget_set_sensitive (priv->selected_chars_ns_label, sel);
 
-	if (chars == 0)
+	if (counts->chars == 0)
 		lines = 0;
 
 	tmp_str = g_strdup_printf("%d", lines);
 	gtk_label_set_text (GTK_LABEL (priv->selected_lines_label), tmp_str);
 	g_free (tmp_str);
 
-	tmp_str = g_strdup_printf("%d", words);
+	tmp_str = g_strdup_printf("%d", counts->words);
 	gtk_label_set_text (GTK_LABEL (priv->selected_words_label), tmp_str);
 	g_free (tmp_str);
 
-	tmp_str = g_strdup_printf("%d", chars);
+	tmp_str = g_strdup_printf("%d", counts->chars);
 	gtk_label_set_text (GTK_LABEL (priv->selected_chars_label), tmp_str);
 	g_free (tmp_str);
 
-	tmp_str = g_strdup_printf("%d", chars - white_chars);
+	tmp_str = g_strdup_printf("%d", counts->chars - counts->white_chars);
 	gtk_label_set_text (GTK_LABEL (priv->selected_chars_ns_label), tmp_str);
 	g_free (tmp_str);
 
-	tmp_str = g_strdup_printf("%d", bytes);
+	tmp_str = g_strdup_printf("%d", counts->bytes);
 	gtk_label_set_text (GTK_LABEL (priv->selected_bytes_label), tmp_str);
 	g_free (tmp_str);
 }
 
+static void
+selection_info_thread (GTask        *task,
+		       gpointer      source_object,
+		       gpointer      task_data,
+		       GCancellable *cancellable)
+{
+	SelectionInfo *info = task_data;
+
+	if (docinfo_stats_count_text (info->text, -1, &info->counts, cancellable))
+	{
+		g_task_return_boolean (task, TRUE);
+	}
+	else
+	{
+		g_task_return_error_if_cancelled (task);
+	}
+}
+
+static void
+selection_info_ready_cb (GObject      *source_object,
+			 GAsyncResult *result,
+			 gpointer      user_data)
+{
+	GeditDocinfoPlugin *plugin;
+	SelectionInfo *info;
+	GError *error = NULL;
+
+	if (!g_task_propagate_boolean (G_TASK (result), &error))
+	{
+		/* Cancelled: the selection changed or the plugin is gone */
+		g_error_free (error);
+		return;
+	}
+
+	plugin = GEDIT_DOCINFO_PLUGIN (user_data);
+	info = g_task_get_task_data (G_TASK (result));
+
+	g_clear_object (&plugin->priv->selection_cancellable);
+
+	gedit_debug_message (DEBUG_PLUGINS, "Selected chars: %d", info->counts.chars);
+	gedit_debug_message (DEBUG_PLUGINS, "Selected lines: %d", info->lines);
+	gedit_debug_message (DEBUG_PLUGINS, "Selected words: %d", info->counts.words);
+	gedit_debug_message (DEBUG_PLUGINS, "Selected chars non-space: %d", info->counts.chars - info->counts.white_chars);
+	gedit_debug_message (DEBUG_PLUGINS, "Selected bytes: %d", info->counts.bytes);
+
+	if (plugin->priv->dialog != NULL)
+	{
+		set_selection_labels (plugin, TRUE, info->lines, &info->counts);
+	}
+}
+
+static void
+cancel_selection_info (GeditDocinfoPlugin *plugin)
+{
+	GeditDocinfoPluginPrivate *priv = plugin->priv;
+
+	if (priv->selection_cancellable != NULL)
+	{
+		g_cancellable_cancel (priv->selection_cancellable);
+		g_clear_object (&priv->selection_cancellable);
+	}
+
+	if (priv->selection_timeout_id != 0)
+	{
+		g_source_remove (priv->selection_timeout_id);
+		priv->selection_timeout_id = 0;
+	}
+}
+
+static void
+update_selection_info (GeditDocinfoPlugin *plugin,
+		       GeditDocument      *doc)
+{
+	GeditDocinfoPluginPrivate *priv;
+	GtkTextIter start, end;
+	SelectionInfo *info;
+	GTask *task;
+
+	gedit_debug (DEBUG_PLUGINS);
+
+	priv = plugin->priv;
+
+	cancel_selection_info (plugin);
+
+	if (!gtk_text_buffer_get_selection_bounds (GTK_TEXT_BUFFER (doc),
+						   &start,
+						   &end))
+	{
+		DocinfoCounts counts = { 0 };
+
+		gedit_debug_message (DEBUG_PLUGINS, "Selection empty");
+
+		set_selection_labels (plugin, FALSE, 0, &counts);
+		return;
+	}
+
+	info = g_slice_new0 (SelectionInfo);
+	info->lines = gtk_text_iter_get_line (&end) - gtk_text_iter_get_line (&start) + 1;
+	info->text = gtk_text_buffer_get_slice (GTK_TEXT_BUFFER (doc),
+						&start,
+						&end,
+						TRUE);
+
+	priv->selection_cancellable = g_cancellable_new ();
+
+	task = g_task_new (NULL, priv->selection_cancellable, selection_info_ready_cb, plugin);
+	g_task_set_task_data (task, info, (GDestroyNotify) selection_info_free);
+	g_task_run_in_thread (task, selection_info_thread);
+	g_object_unref (task);
+}
+
+static gboolean
+selection_timeout_cb (GeditDocinfoPlugin *plugin)
+{
+	GeditDocinfoPluginPrivate *priv = plugin->priv;
+
+	priv->selection_timeout_id = 0;
+
+	if (priv->dialog != NULL && priv->selection_doc != NULL)
+	{
+		update_selection_info (plugin, priv->selection_doc);
+	}
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+mark_set_cb (GtkTextBuffer      *buffer,
+	     GtkTextIter        *location,
+	     GtkTextMark        *mark,
+	     GeditDocinfoPlugin *plugin)
+{
+	GeditDocinfoPluginPrivate *priv = plugin->priv;
+
+	if (mark != gtk_text_buffer_get_insert (buffer) &&
+	    mark != gtk_text_buffer_get_selection_bound (buffer))
+	{
+		return;
+	}
+
+	/* Drop the count of the previous selection right away. The new
+	 * one is copied when the pending timeout fires: it is not restarted
+	 * here, so while the selection is being dragged it is counted at
+	 * most once every SELECTION_UPDATE_DELAY ms.
+	 */
+	if (priv->selection_cancellable != NULL)
+	{
+		g_cancellable_cancel (priv->selection_cancellable);
+		g_clear_object (&priv->selection_cancellable);
+	}
+
+	if (priv->selection_timeout_id == 0)
+	{
+		priv->selection_timeout_id =
+			g_timeout_add (SELECTION_UPDATE_DELAY,
+				       (GSourceFunc) selection_timeout_cb,
+				       plugin);
+	}
+}
+
+static void
+track_selection (GeditDocinfoPlugin *plugin,
+		 GeditDocument      *doc)
+{
+	GeditDocinfoPluginPrivate *priv = plugin->priv;
+
+	if (priv->selection_doc == doc)
+	{
+		return;
+	}
+
+	if (priv->selection_doc != NULL)
+	{
+		g_signal_handler_disconnect (priv->selection_doc, priv->mark_set_id);
+		g_object_remove_weak_pointer (G_OBJECT (priv->selection_doc),
+					      (gpointer *) &priv->selection_doc);
+		priv->selection_doc = NULL;
+		priv->mark_set_id = 0;
+	}
+
+	if (doc != NULL)
+	{
+		priv->selection_doc = doc;
+		g_object_add_weak_pointer (G_OBJECT (doc),
+					   (gpointer *) &priv->selection_doc);
+		priv->mark_set_id = g_signal_connect (doc,
+						      "mark-set",
+						      G_CALLBACK (mark_set_cb),
+						      plugin);
+	}
+}
+
+static void
+docinfo_dialog_destroy_cb (GtkWidget          *widget,
+			   GeditDocinfoPlugin *plugin)
+{
+	cancel_selection_info (plugin);
+	track_selection (plugin, NULL);
+}
+
 static void
 docinfo_dialog_response_cb (GtkDialog          *widget,
 			    gint                res_id,
@@ -311,11 +461,21 @@ docinfo_dialog_response_cb (GtkDialog          *widget,
 		case GTK_RESPONSE_OK:
 		{
 			GeditDocument *doc;
+			DocinfoStats *stats;
 
 			gedit_debug_message (DEBUG_PLUGINS, "GTK_RESPONSE_OK");
 
 			doc = gedit_window_get_active_document (priv->window);
 
+			/* Cross-check the incremental counts, the labels are
+			 * refreshed again when the recount is done.
+			 */
+			stats = get_document_stats (doc);
+			if (stats != NULL)
+			{
+				docinfo_stats_recount (stats);
+			}
+
 			update_document_info (plugin, doc);
 			update_selection_info (plugin, doc);
 
@@ -366,6 +526,10 @@ create_docinfo_dialog (GeditDocinfoPlugin *plugin)
 			  "destroy",
 			  G_CALLBACK (gtk_widget_destroyed),
 			  &priv->dialog);
+	g_signal_connect (priv->dialog,
+			  "destroy",
+			  G_CALLBACK (docinfo_dialog_destroy_cb),
+			  plugin);
 	g_signal_connect (priv->dialog,
 			  "response",
 			  G_CALLBACK (docinfo_dialog_response_cb),
@@ -421,6 +585,8 @@ docinfo_cb (GAction            *action,
 		gtk_widget_show (GTK_WIDGET (priv->dialog));
 	}
 
+	track_selection (plugin, doc);
+
 	update_document_info (plugin, doc);
 	update_selection_info (plugin, doc);
 }
@@ -440,6 +606,15 @@ gedit_docinfo_plugin_dispose (GObject *object)
 
 	gedit_debug_message (DEBUG_PLUGINS, "GeditDocinfoPlugin dispose");
 
+	if (plugin->priv->update_id != 0)
+	{
+		g_source_remove (plugin->priv->update_id);
+		plugin->priv->update_id = 0;
+	}
+
+	cancel_selection_info (plugin);
+	track_selection (plugin, NULL);
+
 	g_clear_object (&plugin->priv->action);
 	g_clear_object (&plugin->priv->window);
 	g_clear_object (&plugin->priv->menu_ext);
@@ -501,6 +676,174 @@ gedit_docinfo_plugin_get_property (GObject    *object,
 	}
 }
 
+static void
+update_statusbar (GeditDocinfoPlugin *plugin,
+		  GeditDocument      *doc)
+{
+	GeditDocinfoPluginPrivate *priv;
+	GtkWidget *statusbar;
+	DocinfoStats *stats;
+	DocinfoCounts counts;
+
+	priv = plugin->priv;
+
+	statusbar = gedit_window_get_statusbar (priv->window);
+	gtk_statusbar_remove_all (GTK_STATUSBAR (statusbar),
+				  priv->statusbar_context_id);
+
+	stats = doc != NULL ? get_document_stats (doc) : NULL;
+
+	if (stats != NULL && docinfo_stats_get_counts (stats, &counts))
+	{
+		gchar *msg;
+
+		msg = g_strdup_printf (_("Words: %d, Characters: %d"),
+				       counts.words,
+				       counts.chars);
+		gtk_statusbar_push (GTK_STATUSBAR (statusbar),
+				    priv->statusbar_context_id,
+				    msg);
+		g_free (msg);
+	}
+}
+
+static gboolean
+update_stats_idle (GeditDocinfoPlugin *plugin)
+{
+	GeditDocinfoPluginPrivate *priv;
+	GeditDocument *doc;
+
+	priv = plugin->priv;
+	priv->update_id = 0;
+
+	doc = gedit_window_get_active_document (priv->window);
+
+	update_statusbar (plugin, doc);
+
+	if (priv->dialog != NULL && doc != NULL)
+	{
+		update_document_info (plugin, doc);
+
+		if (doc != priv->selection_doc)
+		{
+			track_selection (plugin, doc);
+			update_selection_info (plugin, doc);
+		}
+	}
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+queue_stats_update (GeditDocinfoPlugin *plugin)
+{
+	if (plugin->priv->update_id == 0)
+	{
+		plugin->priv->update_id =
+			g_idle_add ((GSourceFunc) update_stats_idle, plugin);
+	}
+}
+
+static void
+stats_changed_cb (DocinfoStats       *stats,
+		  GeditDocinfoPlugin *plugin)
+{
+	GeditDocument *doc;
+
+	doc = gedit_window_get_active_document (plugin->priv->window);
+
+	if (doc != NULL && GTK_TEXT_BUFFER (doc) == docinfo_stats_get_buffer (stats))
+	{
+		queue_stats_update (plugin);
+	}
+}
+
+static void
+sync_stats_paused (GeditTab *tab)
+{
+	DocinfoStats *stats;
+	GeditTabState state;
+
+	stats = get_document_stats (gedit_tab_get_document (tab));
+	state = gedit_tab_get_state (tab);
+
+	/* The loader inserts the file chunk by chunk, count it once at
+	 * the end instead.
+	 */
+	docinfo_stats_set_paused (stats,
+				  state == GEDIT_TAB_STATE_LOADING ||
+				  state == GEDIT_TAB_STATE_REVERTING);
+}
+
+static void
+tab_state_changed_cb (GeditTab           *tab,
+		      GParamSpec         *pspec,
+		      GeditDocinfoPlugin *plugin)
+{
+	sync_stats_paused (tab);
+}
+
+static void
+attach_tab_stats (GeditDocinfoPlugin *plugin,
+		  GeditTab           *tab)
+{
+	GeditDocument *doc;
+	DocinfoStats *stats;
+
+	doc = gedit_tab_get_document (tab);
+
+	stats = docinfo_stats_new (GTK_TEXT_BUFFER (doc),
+				   (DocinfoStatsChangedFunc) stats_changed_cb,
+				   plugin);
+
+	g_object_set_data_full (G_OBJECT (doc),
+				DOCINFO_STATS_KEY,
+				stats,
+				(GDestroyNotify) docinfo_stats_free);
+
+	sync_stats_paused (tab);
+
+	g_signal_connect (tab,
+			  "notify::state",
+			  G_CALLBACK (tab_state_changed_cb),
+			  plugin);
+}
+
+static void
+detach_tab_stats (GeditDocinfoPlugin *plugin,
+		  GeditTab           *tab)
+{
+	g_signal_handlers_disconnect_by_func (tab, tab_state_changed_cb, plugin);
+
+	g_object_set_data (G_OBJECT (gedit_tab_get_document (tab)),
+			   DOCINFO_STATS_KEY,
+			   NULL);
+}
+
+static void
+tab_added_cb (GeditWindow        *window,
+	      GeditTab           *tab,
+	      GeditDocinfoPlugin *plugin)
+{
+	attach_tab_stats (plugin, tab);
+}
+
+static void
+tab_removed_cb (GeditWindow        *window,
+		GeditTab           *tab,
+		GeditDocinfoPlugin *plugin)
+{
+	detach_tab_stats (plugin, tab);
+}
+
+static void
+active_tab_changed_cb (GeditWindow        *window,
+		       GeditTab           *tab,
+		       GeditDocinfoPlugin *plugin)
+{
+	queue_stats_update (plugin);
+}
+
 static void
 update_ui (GeditDocinfoPlugin *plugin)
 {
@@ -555,6 +898,7 @@ static void
 gedit_docinfo_plugin_window_activate (GeditWindowActivatable *activatable)
 {
 	GeditDocinfoPluginPrivate *priv;
+	GList *docs, *l;
 
 	gedit_debug (DEBUG_PLUGINS);
 
@@ -566,6 +910,28 @@ gedit_docinfo_plugin_window_activate (GeditWindowActivatable *activatable)
 	g_action_map_add_action (G_ACTION_MAP (priv->window),
 	                         G_ACTION (priv->action));
 
+	priv->statusbar_context_id =
+		gtk_statusbar_get_context_id (GTK_STATUSBAR (gedit_window_get_statusbar (priv->window)),
+					      "docinfo_stats");
+
+	docs = gedit_window_get_documents (priv->window);
+	for (l = docs; l != NULL; l = l->next)
+	{
+		attach_tab_stats (GEDIT_DOCINFO_PLUGIN (activatable),
+				  gedit_tab_get_from_document (GEDIT_DOCUMENT (l->data)));
+	}
+	g_list_free (docs);
+
+	priv->tab_added_id =
+		g_signal_connect (priv->window, "tab-added",
+				  G_CALLBACK (tab_added_cb), activatable);
+	priv->tab_removed_id =
+		g_signal_connect (priv->window, "tab-removed",
+				  G_CALLBACK (tab_removed_cb), activatable);
+	priv->active_tab_changed_id =
+		g_signal_connect (priv->window, "active-tab-changed",
+				  G_CALLBACK (active_tab_changed_cb), activatable);
+
 	update_ui (GEDIT_DOCINFO_PLUGIN (activatable));
 }
 
@@ -573,11 +939,36 @@ static void
 gedit_docinfo_plugin_window_deactivate (GeditWindowActivatable *activatable)
 {
 	GeditDocinfoPluginPrivate *priv;
+	GList *docs, *l;
 
 	gedit_debug (DEBUG_PLUGINS);
 
 	priv = GEDIT_DOCINFO_PLUGIN (activatable)->priv;
 
+	g_signal_handler_disconnect (priv->window, priv->tab_added_id);
+	g_signal_handler_disconnect (priv->window, priv->tab_removed_id);
+	g_signal_handler_disconnect (priv->window, priv->active_tab_changed_id);
+
+	docs = gedit_window_get_documents (priv->window);
+	for (l = docs; l != NULL; l = l->next)
+	{
+		detach_tab_stats (GEDIT_DOCINFO_PLUGIN (activatable),
+				  gedit_tab_get_from_document (GEDIT_DOCUMENT (l->data)));
+	}
+	g_list_free (docs);
+
+	if (priv->update_id != 0)
+	{
+		g_source_remove (priv->update_id);
+		priv->update_id = 0;
+	}
+
+	cancel_selection_info (GEDIT_DOCINFO_PLUGIN (activatable));
+	track_selection (GEDIT_DOCINFO_PLUGIN (activatable), NULL);
+
+	gtk_statusbar_remove_all (GTK_STATUSBAR (gedit_window_get_statusbar (priv->window)),
+				  priv->statusbar_context_id);
+
 	g_action_map_remove_action (G_ACTION_MAP (priv->window), "docinfo");
 }
 
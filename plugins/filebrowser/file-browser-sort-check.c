@@ -0,0 +1,372 @@
+/*
+ * file-browser-sort-check.c
+ * This file is part of gedit
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Times how the file browser store lists and sorts a large directory:
+ *
+ *   file-browser-sort-check [--entries=N] [--keep] [DIRECTORY]
+ *
+ * Without DIRECTORY, a temporary directory of N empty files (100000 by
+ * default) is created, and removed at the end unless --keep is given.
+ * The directory is listed with the attributes the store asks for, then
+ * the entries are sorted with g_slist_sort() as in model_add_nodes_batch(),
+ * once computing the collation keys in every comparison, as collate_nodes()
+ * did before, and once with the keys cached in the entries, as it does now.
+ * Both timings and the number of comparisons are printed.
+ *
+ * The exit status is 1 if both orders differ.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+
+/* Same as in gedit-file-browser-store.c */
+#define STANDARD_ATTRIBUTE_TYPES G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
+				 G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN "," \
+			 	 G_FILE_ATTRIBUTE_STANDARD_IS_BACKUP "," \
+				 G_FILE_ATTRIBUTE_STANDARD_NAME "," \
+				 G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE "," \
+				 G_FILE_ATTRIBUTE_STANDARD_ICON
+
+typedef struct
+{
+	gchar *name;
+	gchar *collate_key;
+	gboolean is_dir;
+} Entry;
+
+static gint n_entries = 100000;
+static gboolean keep = FALSE;
+static guint n_comparisons;
+
+static GOptionEntry options[] =
+{
+	{ "entries", 'n', 0, G_OPTION_ARG_INT, &n_entries,
+	  "Number of files of the temporary directory", "N" },
+	{ "keep", 'k', 0, G_OPTION_ARG_NONE, &keep,
+	  "Do not remove the temporary directory", NULL },
+	{ NULL }
+};
+
+static void
+entry_free (Entry *entry)
+{
+	g_free (entry->name);
+	g_free (entry->collate_key);
+	g_slice_free (Entry, entry);
+}
+
+/* Names that exercise the filename collation: numbers, case, dots and
+ * a few non ASCII letters.
+ */
+static gchar *
+make_name (gint i)
+{
+	static const gchar * const stems[] =
+	{
+		"file", "File", "notes", "Ärger", "résumé", "image.", "_build", "zeta"
+	};
+	static const gchar * const suffixes[] =
+	{
+		".c", ".h", ".txt", "", ".tar.gz", "~", ".md", ".py"
+	};
+
+	return g_strdup_printf ("%s%d%s",
+				stems[i % G_N_ELEMENTS (stems)],
+				g_random_int_range (0, n_entries * 10),
+				suffixes[(i / 8) % G_N_ELEMENTS (suffixes)]);
+}
+
+static gboolean
+populate (const gchar *dirname)
+{
+	gint i;
+
+	for (i = 0; i < n_entries; i++)
+	{
+		gchar *name;
+		gchar *filename;
+		gboolean ok;
+
+		name = make_name (i);
+		filename = g_build_filename (dirname, name, NULL);
+
+		/* A name may come twice, that only makes one file less */
+		ok = g_file_set_contents (filename, "", 0, NULL);
+
+		g_free (filename);
+		g_free (name);
+
+		if (!ok)
+		{
+			g_printerr ("Cannot create the files of %s\n", dirname);
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+static void
+remove_dir (const gchar *dirname)
+{
+	GDir *dir;
+	const gchar *name;
+
+	dir = g_dir_open (dirname, 0, NULL);
+
+	if (dir != NULL)
+	{
+		while ((name = g_dir_read_name (dir)) != NULL)
+		{
+			gchar *filename;
+
+			filename = g_build_filename (dirname, name, NULL);
+			g_unlink (filename);
+			g_free (filename);
+		}
+
+		g_dir_close (dir);
+	}
+
+	g_rmdir (dirname);
+}
+
+static GSList *
+list_dir (const gchar *dirname)
+{
+	GFile *location;
+	GFileEnumerator *enumerator;
+	GFileInfo *info;
+	GSList *entries = NULL;
+	GError *error = NULL;
+
+	location = g_file_new_for_path (dirname);
+	enumerator = g_file_enumerate_children (location,
+						STANDARD_ATTRIBUTE_TYPES,
+						G_FILE_QUERY_INFO_NONE,
+						NULL,
+						&error);
+	g_object_unref (location);
+
+	if (enumerator == NULL)
+	{
+		g_printerr ("%s\n", error->message);
+		g_error_free (error);
+		return NULL;
+	}
+
+	while ((info = g_file_enumerator_next_file (enumerator, NULL, NULL)) != NULL)
+	{
+		Entry *entry;
+
+		entry = g_slice_new0 (Entry);
+		entry->name = g_strdup (g_file_info_get_name (info));
+		entry->is_dir = g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY;
+
+		entries = g_slist_prepend (entries, entry);
+		g_object_unref (info);
+	}
+
+	g_object_unref (enumerator);
+
+	return entries;
+}
+
+static gint
+compare_dirs_first (Entry *entry1,
+		    Entry *entry2)
+{
+	if (entry1->is_dir != entry2->is_dir)
+		return entry1->is_dir ? -1 : 1;
+
+	return 0;
+}
+
+static gint
+compare_uncached (Entry *entry1,
+		  Entry *entry2)
+{
+	gchar *key1;
+	gchar *key2;
+	gint result;
+
+	n_comparisons++;
+
+	result = compare_dirs_first (entry1, entry2);
+
+	if (result != 0)
+		return result;
+
+	key1 = g_utf8_collate_key_for_filename (entry1->name, -1);
+	key2 = g_utf8_collate_key_for_filename (entry2->name, -1);
+
+	result = strcmp (key1, key2);
+
+	g_free (key1);
+	g_free (key2);
+
+	return result;
+}
+
+static const gchar *
+get_collate_key (Entry *entry)
+{
+	if (entry->collate_key == NULL)
+		entry->collate_key = g_utf8_collate_key_for_filename (entry->name, -1);
+
+	return entry->collate_key;
+}
+
+static gint
+compare_cached (Entry *entry1,
+		Entry *entry2)
+{
+	gint result;
+
+	n_comparisons++;
+
+	result = compare_dirs_first (entry1, entry2);
+
+	if (result != 0)
+		return result;
+
+	return strcmp (get_collate_key (entry1), get_collate_key (entry2));
+}
+
+static GSList *
+time_sort (const gchar  *what,
+	   GSList       *entries,
+	   GCompareFunc  compare)
+{
+	GTimer *timer;
+
+	n_comparisons = 0;
+
+	timer = g_timer_new ();
+	entries = g_slist_sort (entries, compare);
+
+	g_print ("sort, %s keys: %.1f ms, %u comparisons\n",
+		 what,
+		 g_timer_elapsed (timer, NULL) * 1000,
+		 n_comparisons);
+
+	g_timer_destroy (timer);
+
+	return entries;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+	GOptionContext *context;
+	GError *error = NULL;
+	gchar *dirname;
+	gboolean temporary;
+	GTimer *timer;
+	GSList *entries;
+	GSList *copy;
+	GSList *l1;
+	GSList *l2;
+	gboolean ok = TRUE;
+
+	context = g_option_context_new ("[DIRECTORY]");
+	g_option_context_add_main_entries (context, options, NULL);
+
+	if (!g_option_context_parse (context, &argc, &argv, &error))
+	{
+		g_printerr ("%s\n", error->message);
+		g_error_free (error);
+		g_option_context_free (context);
+		return 2;
+	}
+
+	g_option_context_free (context);
+
+	temporary = argc < 2;
+
+	if (temporary)
+	{
+		dirname = g_dir_make_tmp ("gedit-sort-check-XXXXXX", &error);
+
+		if (dirname == NULL)
+		{
+			g_printerr ("%s\n", error->message);
+			g_error_free (error);
+			return 2;
+		}
+
+		if (!populate (dirname))
+		{
+			remove_dir (dirname);
+			g_free (dirname);
+			return 2;
+		}
+	}
+	else
+	{
+		dirname = g_strdup (argv[1]);
+	}
+
+	timer = g_timer_new ();
+	entries = list_dir (dirname);
+
+	g_print ("%s: listed %u entries in %.1f ms\n",
+		 dirname,
+		 g_slist_length (entries),
+		 g_timer_elapsed (timer, NULL) * 1000);
+
+	g_timer_destroy (timer);
+
+	/* Both sorts start from the order of the directory */
+	copy = g_slist_copy (entries);
+
+	entries = time_sort ("uncached", entries, (GCompareFunc) compare_uncached);
+	copy = time_sort ("cached", copy, (GCompareFunc) compare_cached);
+
+	for (l1 = entries, l2 = copy; l1 != NULL && l2 != NULL; l1 = l1->next, l2 = l2->next)
+	{
+		if (compare_uncached (l1->data, l2->data) != 0)
+		{
+			g_printerr ("The orders differ at %s and %s\n",
+				    ((Entry *) l1->data)->name,
+				    ((Entry *) l2->data)->name);
+			ok = FALSE;
+			break;
+		}
+	}
+
+	g_slist_free (copy);
+	g_slist_free_full (entries, (GDestroyNotify) entry_free);
+
+	if (temporary && !keep)
+	{
+		remove_dir (dirname);
+	}
+
+	g_free (dirname);
+
+	return ok ? 0 : 1;
+}
+
+/* ex:set ts=8 noet: */
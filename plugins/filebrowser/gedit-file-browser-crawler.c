@@ -0,0 +1,356 @@
+/*
+ * gedit-file-browser-crawler.c - Gedit plugin providing easy file access
+ * from the sidepanel
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "gedit-file-browser-crawler.h"
+
+/* Paths are handed to the main loop in batches, at most this often or
+ * when that many paths are waiting.
+ */
+#define CRAWLER_BATCH_INTERVAL (200 * G_TIME_SPAN_MILLISECOND)
+#define CRAWLER_BATCH_SIZE 2000
+
+/* Stop indexing huge trees rather than use up the memory */
+#define CRAWLER_MAX_PATHS 500000
+
+#define CRAWLER_ATTRIBUTES G_FILE_ATTRIBUTE_STANDARD_NAME "," \
+			   G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
+			   G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN "," \
+			   G_FILE_ATTRIBUTE_STANDARD_IS_BACKUP
+
+struct _GeditFileBrowserCrawler
+{
+	GFile *root;
+	GCancellable *cancellable;
+
+	GeditFileBrowserCrawlerFunc func;
+	gpointer user_data;
+
+	/* The index: the paths found so far, with their strings packed
+	 * together in chunk.
+	 */
+	GStringChunk *chunk;
+	GPtrArray *paths;
+
+	gboolean done;
+};
+
+/* Owned by the crawling thread */
+typedef struct
+{
+	GeditFileBrowserCrawler *crawler;
+	GFile *root;
+	GCancellable *cancellable;
+
+	GPtrArray *batch;
+	gint64 last_flush;
+} CrawlJob;
+
+/* Handed from the crawling thread to the main loop. The crawler may be
+ * gone by then, which the cancellable tells.
+ */
+typedef struct
+{
+	GeditFileBrowserCrawler *crawler;
+	GCancellable *cancellable;
+	GPtrArray *paths;
+	gboolean done;
+} CrawlBatch;
+
+static void
+crawl_job_free (CrawlJob *job)
+{
+	g_object_unref (job->root);
+	g_object_unref (job->cancellable);
+	g_ptr_array_unref (job->batch);
+	g_slice_free (CrawlJob, job);
+}
+
+static void
+crawl_batch_free (CrawlBatch *batch)
+{
+	g_object_unref (batch->cancellable);
+	g_ptr_array_unref (batch->paths);
+	g_slice_free (CrawlBatch, batch);
+}
+
+static gboolean
+deliver_batch (CrawlBatch *batch)
+{
+	GeditFileBrowserCrawler *crawler;
+	guint first;
+	guint i;
+
+	if (g_cancellable_is_cancelled (batch->cancellable))
+		return G_SOURCE_REMOVE;
+
+	crawler = batch->crawler;
+	first = crawler->paths->len;
+
+	for (i = 0; i < batch->paths->len; i++)
+	{
+		g_ptr_array_add (crawler->paths,
+				 g_string_chunk_insert (crawler->chunk,
+							g_ptr_array_index (batch->paths, i)));
+	}
+
+	crawler->done = batch->done;
+
+	/* The crawler may be freed by the callback */
+	if (crawler->func != NULL && (crawler->paths->len > first || batch->done))
+	{
+		crawler->func (crawler,
+			       (const gchar * const *) crawler->paths->pdata + first,
+			       crawler->paths->len - first,
+			       crawler->user_data);
+	}
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+crawl_flush (CrawlJob *job,
+	     gboolean  done)
+{
+	CrawlBatch *batch;
+
+	if (job->batch->len == 0 && !done)
+		return;
+
+	batch = g_slice_new (CrawlBatch);
+	batch->crawler = job->crawler;
+	batch->cancellable = g_object_ref (job->cancellable);
+	batch->paths = job->batch;
+	batch->done = done;
+
+	job->batch = g_ptr_array_new_with_free_func (g_free);
+	job->last_flush = g_get_monotonic_time ();
+
+	g_main_context_invoke_full (NULL,
+				    G_PRIORITY_DEFAULT,
+				    (GSourceFunc) deliver_batch,
+				    batch,
+				    (GDestroyNotify) crawl_batch_free);
+}
+
+static gboolean
+crawl_directory (CrawlJob    *job,
+		 const gchar *dir,
+		 GQueue      *dirs,
+		 guint       *n_paths)
+{
+	GFile *file;
+	GFileEnumerator *enumerator;
+	GFileInfo *info;
+	GFileType type;
+	gchar *path;
+
+	if (*dir == '\0')
+		file = g_object_ref (job->root);
+	else
+		file = g_file_resolve_relative_path (job->root, dir);
+
+	/* Do not follow links to directories, they may loop */
+	enumerator = g_file_enumerate_children (file,
+						CRAWLER_ATTRIBUTES,
+						G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+						job->cancellable,
+						NULL);
+	g_object_unref (file);
+
+	/* Unreadable directories are simply left out */
+	if (enumerator == NULL)
+		return TRUE;
+
+	while ((info = g_file_enumerator_next_file (enumerator, job->cancellable, NULL)) != NULL)
+	{
+		type = g_file_info_get_file_type (info);
+
+		/* Hidden files are filtered out of the tree by default,
+		 * and hidden directories are often huge (.git).
+		 */
+		if (g_file_info_get_is_hidden (info) || g_file_info_get_is_backup (info))
+		{
+			g_object_unref (info);
+			continue;
+		}
+
+		if (type == G_FILE_TYPE_DIRECTORY)
+		{
+			path = g_strconcat (dir, g_file_info_get_name (info), "/", NULL);
+			g_queue_push_tail (dirs, g_strdup (path));
+		}
+		else if (type == G_FILE_TYPE_REGULAR ||
+			 type == G_FILE_TYPE_SYMBOLIC_LINK)
+		{
+			path = g_strconcat (dir, g_file_info_get_name (info), NULL);
+		}
+		else
+		{
+			path = NULL;
+		}
+
+		g_object_unref (info);
+
+		if (path == NULL)
+			continue;
+
+		g_ptr_array_add (job->batch, path);
+
+		if (job->batch->len >= CRAWLER_BATCH_SIZE ||
+		    g_get_monotonic_time () - job->last_flush > CRAWLER_BATCH_INTERVAL)
+		{
+			crawl_flush (job, FALSE);
+		}
+
+		if (++(*n_paths) >= CRAWLER_MAX_PATHS)
+			break;
+	}
+
+	g_file_enumerator_close (enumerator, NULL, NULL);
+	g_object_unref (enumerator);
+
+	return *n_paths < CRAWLER_MAX_PATHS;
+}
+
+static void
+crawl_thread (GTask        *task,
+	      gpointer      source_object,
+	      CrawlJob     *job,
+	      GCancellable *cancellable)
+{
+	GQueue dirs = G_QUEUE_INIT;
+	gchar *dir;
+	guint n_paths = 0;
+
+	/* Breadth first, so that shallow matches come first */
+	g_queue_push_tail (&dirs, g_strdup (""));
+
+	while ((dir = g_queue_pop_head (&dirs)) != NULL)
+	{
+		gboolean go_on;
+
+		go_on = !g_cancellable_is_cancelled (cancellable) &&
+			crawl_directory (job, dir, &dirs, &n_paths);
+
+		g_free (dir);
+
+		if (!go_on)
+			break;
+	}
+
+	g_queue_foreach (&dirs, (GFunc) g_free, NULL);
+	g_queue_clear (&dirs);
+
+	crawl_flush (job, TRUE);
+	g_task_return_boolean (task, TRUE);
+}
+
+/**
+ * gedit_file_browser_crawler_new:
+ * @root: the directory to index
+ * @func: called with the paths as they are found
+ * @user_data: user data for @func
+ *
+ * Indexes the files below @root from a thread. Hidden files are left out
+ * and links to directories are not followed. The crawl stops when the
+ * crawler is freed.
+ */
+GeditFileBrowserCrawler *
+gedit_file_browser_crawler_new (GFile                       *root,
+				GeditFileBrowserCrawlerFunc  func,
+				gpointer                     user_data)
+{
+	GeditFileBrowserCrawler *crawler;
+	CrawlJob *job;
+	GTask *task;
+
+	g_return_val_if_fail (G_IS_FILE (root), NULL);
+
+	crawler = g_slice_new0 (GeditFileBrowserCrawler);
+	crawler->root = g_object_ref (root);
+	crawler->cancellable = g_cancellable_new ();
+	crawler->func = func;
+	crawler->user_data = user_data;
+	crawler->chunk = g_string_chunk_new (64 * 1024);
+	crawler->paths = g_ptr_array_new ();
+
+	job = g_slice_new0 (CrawlJob);
+	job->crawler = crawler;
+	job->root = g_object_ref (root);
+	job->cancellable = g_object_ref (crawler->cancellable);
+	job->batch = g_ptr_array_new_with_free_func (g_free);
+
+	task = g_task_new (NULL, crawler->cancellable, NULL, NULL);
+	g_task_set_task_data (task, job, (GDestroyNotify) crawl_job_free);
+	g_task_run_in_thread (task, (GTaskThreadFunc) crawl_thread);
+	g_object_unref (task);
+
+	return crawler;
+}
+
+void
+gedit_file_browser_crawler_free (GeditFileBrowserCrawler *crawler)
+{
+	if (crawler == NULL)
+		return;
+
+	/* Stops the thread and drops the batches not delivered yet */
+	g_cancellable_cancel (crawler->cancellable);
+	g_object_unref (crawler->cancellable);
+
+	g_object_unref (crawler->root);
+	g_ptr_array_unref (crawler->paths);
+	g_string_chunk_free (crawler->chunk);
+
+	g_slice_free (GeditFileBrowserCrawler, crawler);
+}
+
+GFile *
+gedit_file_browser_crawler_get_root (GeditFileBrowserCrawler *crawler)
+{
+	g_return_val_if_fail (crawler != NULL, NULL);
+
+	return crawler->root;
+}
+
+/* Returns all the paths found so far */
+const gchar * const *
+gedit_file_browser_crawler_get_paths (GeditFileBrowserCrawler *crawler,
+				      guint                   *n_paths)
+{
+	g_return_val_if_fail (crawler != NULL, NULL);
+
+	if (n_paths != NULL)
+		*n_paths = crawler->paths->len;
+
+	return (const gchar * const *) crawler->paths->pdata;
+}
+
+gboolean
+gedit_file_browser_crawler_is_done (GeditFileBrowserCrawler *crawler)
+{
+	g_return_val_if_fail (crawler != NULL, FALSE);
+
+	return crawler->done;
+}
+
+/* ex:set ts=8 noet: */
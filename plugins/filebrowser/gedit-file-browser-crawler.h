@@ -0,0 +1,53 @@
+/*
+ * gedit-file-browser-crawler.h - Gedit plugin providing easy file access
+ * from the sidepanel
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GEDIT_FILE_BROWSER_CRAWLER_H
+#define GEDIT_FILE_BROWSER_CRAWLER_H
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GeditFileBrowserCrawler GeditFileBrowserCrawler;
+
+/* Called from the main loop with the paths found since the previous call.
+ * The paths are relative to the root, the ones of directories end with a
+ * '/', and they stay valid as long as the crawler.
+ */
+typedef void (* GeditFileBrowserCrawlerFunc) (GeditFileBrowserCrawler *crawler,
+					      const gchar * const     *paths,
+					      guint                    n_paths,
+					      gpointer                 user_data);
+
+GeditFileBrowserCrawler	*gedit_file_browser_crawler_new		(GFile                       *root,
+								 GeditFileBrowserCrawlerFunc  func,
+								 gpointer                     user_data);
+
+void			 gedit_file_browser_crawler_free	(GeditFileBrowserCrawler     *crawler);
+
+GFile			*gedit_file_browser_crawler_get_root	(GeditFileBrowserCrawler     *crawler);
+
+const gchar * const	*gedit_file_browser_crawler_get_paths	(GeditFileBrowserCrawler     *crawler,
+								 guint                       *n_paths);
+
+gboolean		 gedit_file_browser_crawler_is_done	(GeditFileBrowserCrawler     *crawler);
+
+G_END_DECLS
+
+#endif /* GEDIT_FILE_BROWSER_CRAWLER_H */
+/* ex:set ts=8 noet: */
@@ -0,0 +1,394 @@
+/*
+ * gedit-file-browser-glob-set.c - Gedit plugin providing easy file access
+ * from the sidepanel
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include "gedit-file-browser-glob-set.h"
+
+/* Matches a string against several GPatternSpec-like patterns ('*' and
+ * '?' wildcards, no escaping) at once.
+ *
+ * Patterns without wildcards and patterns made of a '*' followed by a
+ * literal suffix ("*.o", "*~") are looked up in hash tables. The others
+ * are merged in a single automaton: every pattern gets a slot per token
+ * plus an accepting slot, and the set of active slots is kept as a bit
+ * vector, so that the string is walked only once for all of them.
+ */
+
+/* Bit vectors of up to that many words are kept on the stack */
+#define STACK_WORDS 8
+
+struct _GeditFileBrowserGlobSet
+{
+	GHashTable *literals;
+
+	/* The suffixes, with their distinct lengths so that each length
+	 * is probed only once.
+	 */
+	GHashTable *suffixes;
+	GArray *suffix_lengths;
+
+	/* The automaton, n_words is 0 when there is none */
+	guint n_words;
+	guint64 *start;
+	guint64 *star;
+	guint64 *accept;
+
+	/* The slots consuming a given character: ASCII ones are indexed,
+	 * the others are in a hash table, and any is for the characters
+	 * that no pattern contains.
+	 */
+	guint64 *ascii;
+	GHashTable *unichars;
+	guint64 *any;
+};
+
+static inline void
+set_bit (guint64 *words,
+	 guint    slot)
+{
+	words[slot / 64] |= G_GUINT64_CONSTANT (1) << (slot % 64);
+}
+
+/* to |= (from << 1), across the words */
+static inline void
+or_shifted (guint64       *to,
+	    const guint64 *from,
+	    guint          n_words)
+{
+	guint64 carry = 0;
+	guint i;
+
+	for (i = 0; i < n_words; i++)
+	{
+		to[i] |= (from[i] << 1) | carry;
+		carry = from[i] >> 63;
+	}
+}
+
+/* Stars match the empty string: the slot after an active star is active */
+static void
+close_stars (GeditFileBrowserGlobSet *set,
+	     guint64                 *states,
+	     guint64                 *scratch)
+{
+	guint i;
+
+	for (i = 0; i < set->n_words; i++)
+		scratch[i] = states[i] & set->star[i];
+
+	or_shifted (states, scratch, set->n_words);
+}
+
+/* Collapses runs of stars, which match the same strings */
+static gchar *
+normalize_pattern (const gchar *pattern)
+{
+	GString *str;
+	const gchar *p;
+
+	str = g_string_sized_new (strlen (pattern));
+
+	for (p = pattern; *p != '\0'; p++)
+	{
+		if (*p == '*' && p > pattern && *(p - 1) == '*')
+			continue;
+
+		g_string_append_c (str, *p);
+	}
+
+	return g_string_free (str, FALSE);
+}
+
+static guint64 *
+get_unichar_mask (GeditFileBrowserGlobSet *set,
+		  gunichar                 c)
+{
+	guint64 *mask;
+
+	mask = g_hash_table_lookup (set->unichars, GUINT_TO_POINTER (c));
+
+	if (mask == NULL)
+	{
+		mask = g_new0 (guint64, set->n_words);
+		g_hash_table_insert (set->unichars, GUINT_TO_POINTER (c), mask);
+	}
+
+	return mask;
+}
+
+static void
+compile_automaton (GeditFileBrowserGlobSet *set,
+		   GPtrArray               *patterns)
+{
+	GHashTableIter iter;
+	gpointer mask;
+	guint64 *scratch;
+	guint n_slots = 0;
+	guint slot = 0;
+	guint i;
+	guint j;
+
+	for (i = 0; i < patterns->len; i++)
+		n_slots += g_utf8_strlen (g_ptr_array_index (patterns, i), -1) + 1;
+
+	set->n_words = (n_slots + 63) / 64;
+	set->start = g_new0 (guint64, set->n_words);
+	set->star = g_new0 (guint64, set->n_words);
+	set->accept = g_new0 (guint64, set->n_words);
+	set->ascii = g_new0 (guint64, 128 * set->n_words);
+	set->any = g_new0 (guint64, set->n_words);
+
+	for (i = 0; i < patterns->len; i++)
+	{
+		const gchar *p = g_ptr_array_index (patterns, i);
+
+		set_bit (set->start, slot);
+
+		for (; *p != '\0'; p = g_utf8_next_char (p), slot++)
+		{
+			gunichar c = g_utf8_get_char (p);
+
+			if (c == '*')
+				set_bit (set->star, slot);
+			else if (c == '?')
+				set_bit (set->any, slot);
+			else if (c < 128)
+				set_bit (set->ascii + c * set->n_words, slot);
+			else
+				set_bit (get_unichar_mask (set, c), slot);
+		}
+
+		set_bit (set->accept, slot++);
+	}
+
+	/* '?' matches every character */
+	for (i = 0; i < 128; i++)
+	{
+		for (j = 0; j < set->n_words; j++)
+			set->ascii[i * set->n_words + j] |= set->any[j];
+	}
+
+	g_hash_table_iter_init (&iter, set->unichars);
+
+	while (g_hash_table_iter_next (&iter, NULL, &mask))
+	{
+		for (j = 0; j < set->n_words; j++)
+			((guint64 *) mask)[j] |= set->any[j];
+	}
+
+	scratch = g_new (guint64, set->n_words);
+	close_stars (set, set->start, scratch);
+	g_free (scratch);
+}
+
+GeditFileBrowserGlobSet *
+gedit_file_browser_glob_set_new (const gchar * const *patterns)
+{
+	GeditFileBrowserGlobSet *set;
+	GPtrArray *complex;
+	gint i;
+
+	set = g_slice_new0 (GeditFileBrowserGlobSet);
+	set->literals = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	set->suffixes = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	set->suffix_lengths = g_array_new (FALSE, FALSE, sizeof (gsize));
+	set->unichars = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+
+	complex = g_ptr_array_new_with_free_func (g_free);
+
+	for (i = 0; patterns != NULL && patterns[i] != NULL; i++)
+	{
+		gchar *pattern;
+		gchar *rest;
+
+		pattern = normalize_pattern (patterns[i]);
+		rest = pattern[0] == '*' ? pattern + 1 : pattern;
+
+		if (strpbrk (rest, "*?") != NULL)
+		{
+			g_ptr_array_add (complex, pattern);
+		}
+		else if (rest == pattern)
+		{
+			g_hash_table_add (set->literals, pattern);
+		}
+		else
+		{
+			gsize length = strlen (rest);
+			guint j;
+
+			if (!g_hash_table_contains (set->suffixes, rest))
+			{
+				g_hash_table_add (set->suffixes, g_strdup (rest));
+
+				for (j = 0; j < set->suffix_lengths->len; j++)
+				{
+					if (g_array_index (set->suffix_lengths, gsize, j) == length)
+						break;
+				}
+
+				if (j == set->suffix_lengths->len)
+					g_array_append_val (set->suffix_lengths, length);
+			}
+
+			g_free (pattern);
+		}
+	}
+
+	if (complex->len > 0)
+		compile_automaton (set, complex);
+
+	g_ptr_array_unref (complex);
+
+	return set;
+}
+
+void
+gedit_file_browser_glob_set_free (GeditFileBrowserGlobSet *set)
+{
+	if (set == NULL)
+		return;
+
+	g_hash_table_destroy (set->literals);
+	g_hash_table_destroy (set->suffixes);
+	g_array_unref (set->suffix_lengths);
+	g_hash_table_destroy (set->unichars);
+
+	g_free (set->start);
+	g_free (set->star);
+	g_free (set->accept);
+	g_free (set->ascii);
+	g_free (set->any);
+
+	g_slice_free (GeditFileBrowserGlobSet, set);
+}
+
+static gboolean
+run_automaton (GeditFileBrowserGlobSet *set,
+	       const gchar             *string,
+	       guint64                 *states,
+	       guint64                 *scratch)
+{
+	const gchar *p;
+	guint n_words = set->n_words;
+	guint i;
+
+	memcpy (states, set->start, n_words * sizeof (guint64));
+
+	for (p = string; *p != '\0'; p = g_utf8_next_char (p))
+	{
+		const guint64 *consuming;
+		guint64 alive = 0;
+		gunichar c;
+
+		c = (guchar) *p < 128 ? (guchar) *p : g_utf8_get_char (p);
+
+		if (c < 128)
+		{
+			consuming = set->ascii + c * n_words;
+		}
+		else
+		{
+			consuming = g_hash_table_lookup (set->unichars, GUINT_TO_POINTER (c));
+
+			if (consuming == NULL)
+				consuming = set->any;
+		}
+
+		/* Stars stay where they are, the other slots consuming
+		 * the character move to the next one.
+		 */
+		for (i = 0; i < n_words; i++)
+		{
+			scratch[i] = states[i] & ~set->star[i] & consuming[i];
+			states[i] &= set->star[i];
+		}
+
+		or_shifted (states, scratch, n_words);
+		close_stars (set, states, scratch);
+
+		for (i = 0; i < n_words; i++)
+			alive |= states[i];
+
+		if (alive == 0)
+			return FALSE;
+	}
+
+	for (i = 0; i < n_words; i++)
+	{
+		if (states[i] & set->accept[i])
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+gboolean
+gedit_file_browser_glob_set_match (GeditFileBrowserGlobSet *set,
+				   const gchar             *string)
+{
+	gsize length;
+	guint i;
+
+	g_return_val_if_fail (set != NULL, FALSE);
+	g_return_val_if_fail (string != NULL, FALSE);
+
+	if (g_hash_table_contains (set->literals, string))
+		return TRUE;
+
+	length = strlen (string);
+
+	for (i = 0; i < set->suffix_lengths->len; i++)
+	{
+		gsize suffix_length = g_array_index (set->suffix_lengths, gsize, i);
+
+		if (suffix_length <= length &&
+		    g_hash_table_contains (set->suffixes, string + length - suffix_length))
+		{
+			return TRUE;
+		}
+	}
+
+	if (set->n_words == 0)
+		return FALSE;
+
+	if (set->n_words <= STACK_WORDS)
+	{
+		guint64 states[STACK_WORDS];
+		guint64 scratch[STACK_WORDS];
+
+		return run_automaton (set, string, states, scratch);
+	}
+	else
+	{
+		guint64 *states = g_new (guint64, 2 * set->n_words);
+		gboolean result;
+
+		result = run_automaton (set, string, states, states + set->n_words);
+		g_free (states);
+
+		return result;
+	}
+}
+
+/* ex:set ts=8 noet: */
@@ -0,0 +1,38 @@
+/*
+ * gedit-file-browser-glob-set.h - Gedit plugin providing easy file access
+ * from the sidepanel
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GEDIT_FILE_BROWSER_GLOB_SET_H
+#define GEDIT_FILE_BROWSER_GLOB_SET_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GeditFileBrowserGlobSet GeditFileBrowserGlobSet;
+
+GeditFileBrowserGlobSet	*gedit_file_browser_glob_set_new	(const gchar * const     *patterns);
+
+void			 gedit_file_browser_glob_set_free	(GeditFileBrowserGlobSet *set);
+
+gboolean		 gedit_file_browser_glob_set_match	(GeditFileBrowserGlobSet *set,
+								 const gchar             *string);
+
+G_END_DECLS
+
+#endif /* GEDIT_FILE_BROWSER_GLOB_SET_H */
+/* ex:set ts=8 noet: */
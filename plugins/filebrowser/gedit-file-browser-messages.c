@@ -215,6 +215,16 @@ message_set_root_cb (GeditMessageBus *bus,
 	}
 }
 
+static GdkPixbuf *
+load_emblem (const gchar *emblem)
+{
+	return gtk_icon_theme_load_icon (gtk_icon_theme_get_default (),
+	                                 emblem,
+	                                 10,
+	                                 GTK_ICON_LOOKUP_FORCE_SIZE,
+	                                 NULL);
+}
+
 static void
 message_set_emblem_cb (GeditMessageBus *bus,
 		       GeditMessage    *message,
@@ -245,11 +255,7 @@ message_set_emblem_cb (GeditMessageBus *bus,
 
 		if (emblem != NULL)
 		{
-			pixbuf = gtk_icon_theme_load_icon (gtk_icon_theme_get_default (),
-			                                   emblem,
-			                                   10,
-			                                   GTK_ICON_LOOKUP_FORCE_SIZE,
-			                                   NULL);
+			pixbuf = load_emblem (emblem);
 		}
 
 		store = gedit_file_browser_widget_get_browser_store (data->widget);
@@ -277,6 +283,150 @@ message_set_emblem_cb (GeditMessageBus *bus,
 	g_free (emblem);
 }
 
+static void
+emblem_pixbuf_free (GdkPixbuf *pixbuf)
+{
+	if (pixbuf != NULL)
+	{
+		g_object_unref (pixbuf);
+	}
+}
+
+/* The batch variants of set_emblem and set_markup take the locations as
+ * URIs instead of ids, and an empty value to unset one.
+ */
+static void
+message_set_emblems_cb (GeditMessageBus *bus,
+			GeditMessage    *message,
+			WindowData      *data)
+{
+	gchar **locations = NULL;
+	gchar **emblems = NULL;
+	GHashTable *pixbufs;
+	GFile **files;
+	GValue *values;
+	GeditFileBrowserStore *store;
+	guint n;
+	guint i;
+
+	g_object_get (message, "locations", &locations, "emblems", &emblems, NULL);
+
+	if (locations == NULL || emblems == NULL)
+	{
+		g_strfreev (locations);
+		g_strfreev (emblems);
+
+		return;
+	}
+
+	n = MIN (g_strv_length (locations), g_strv_length (emblems));
+
+	files = g_new (GFile *, n);
+	values = g_new0 (GValue, n);
+
+	/* Only a few emblems are usually set on many files. The emblems
+	 * that fail to load are kept as NULL, so that they are not looked
+	 * up again for every file.
+	 */
+	pixbufs = g_hash_table_new_full (g_str_hash,
+					 g_str_equal,
+					 NULL,
+					 (GDestroyNotify) emblem_pixbuf_free);
+
+	for (i = 0; i < n; i++)
+	{
+		GdkPixbuf *pixbuf = NULL;
+
+		if (*emblems[i] != '\0' &&
+		    !g_hash_table_lookup_extended (pixbufs, emblems[i], NULL, (gpointer *) &pixbuf))
+		{
+			pixbuf = load_emblem (emblems[i]);
+			g_hash_table_insert (pixbufs, emblems[i], pixbuf);
+		}
+
+		files[i] = g_file_new_for_uri (locations[i]);
+
+		g_value_init (&values[i], GDK_TYPE_PIXBUF);
+		g_value_set_object (&values[i], pixbuf);
+	}
+
+	store = gedit_file_browser_widget_get_browser_store (data->widget);
+	gedit_file_browser_store_set_values (store,
+	                                     GEDIT_FILE_BROWSER_STORE_COLUMN_EMBLEM,
+	                                     files,
+	                                     values,
+	                                     n);
+
+	for (i = 0; i < n; i++)
+	{
+		g_object_unref (files[i]);
+		g_value_unset (&values[i]);
+	}
+
+	g_free (files);
+	g_free (values);
+	g_hash_table_destroy (pixbufs);
+	g_strfreev (locations);
+	g_strfreev (emblems);
+}
+
+static void
+message_set_markups_cb (GeditMessageBus *bus,
+			GeditMessage    *message,
+			WindowData      *data)
+{
+	gchar **locations = NULL;
+	gchar **markups = NULL;
+	GFile **files;
+	GValue *values;
+	GeditFileBrowserStore *store;
+	guint n;
+	guint i;
+
+	g_object_get (message, "locations", &locations, "markups", &markups, NULL);
+
+	if (locations == NULL || markups == NULL)
+	{
+		g_strfreev (locations);
+		g_strfreev (markups);
+
+		return;
+	}
+
+	n = MIN (g_strv_length (locations), g_strv_length (markups));
+
+	files = g_new (GFile *, n);
+	values = g_new0 (GValue, n);
+
+	for (i = 0; i < n; i++)
+	{
+		files[i] = g_file_new_for_uri (locations[i]);
+
+		/* The store escapes the name when unset */
+		g_value_init (&values[i], G_TYPE_STRING);
+		g_value_set_static_string (&values[i],
+		                           *markups[i] != '\0' ? markups[i] : NULL);
+	}
+
+	store = gedit_file_browser_widget_get_browser_store (data->widget);
+	gedit_file_browser_store_set_values (store,
+	                                     GEDIT_FILE_BROWSER_STORE_COLUMN_MARKUP,
+	                                     files,
+	                                     values,
+	                                     n);
+
+	for (i = 0; i < n; i++)
+	{
+		g_object_unref (files[i]);
+		g_value_unset (&values[i]);
+	}
+
+	g_free (files);
+	g_free (values);
+	g_strfreev (locations);
+	g_strfreev (markups);
+}
+
 static void
 message_set_markup_cb (GeditMessageBus *bus,
 		       GeditMessage    *message,
@@ -683,6 +833,16 @@ register_methods (GeditWindow            *window,
 	                            MESSAGE_OBJECT_PATH,
 	                            "set_markup");
 
+	gedit_message_bus_register (bus,
+	                            GEDIT_TYPE_FILE_BROWSER_MESSAGE_SET_EMBLEMS,
+	                            MESSAGE_OBJECT_PATH,
+	                            "set_emblems");
+
+	gedit_message_bus_register (bus,
+	                            GEDIT_TYPE_FILE_BROWSER_MESSAGE_SET_MARKUPS,
+	                            MESSAGE_OBJECT_PATH,
+	                            "set_markups");
+
 	gedit_message_bus_register (bus,
 	                            GEDIT_TYPE_FILE_BROWSER_MESSAGE_ADD_FILTER,
 	                            MESSAGE_OBJECT_PATH,
@@ -747,6 +907,8 @@ register_methods (GeditWindow            *window,
 	BUS_CONNECT (bus, set_root, data);
 	BUS_CONNECT (bus, set_emblem, data);
 	BUS_CONNECT (bus, set_markup, data);
+	BUS_CONNECT (bus, set_emblems, data);
+	BUS_CONNECT (bus, set_markups, data);
 	BUS_CONNECT (bus, add_filter, window);
 	BUS_CONNECT (bus, remove_filter, data);
 	BUS_CONNECT (bus, extend_context_menu, window);
@@ -1050,6 +1212,8 @@ gedit_file_browser_messages_unregister (GeditWindow *window)
 	BUS_DISCONNECT (bus, set_root, data);
 	BUS_DISCONNECT (bus, set_emblem, data);
 	BUS_DISCONNECT (bus, set_markup, data);
+	BUS_DISCONNECT (bus, set_emblems, data);
+	BUS_DISCONNECT (bus, set_markups, data);
 	BUS_DISCONNECT (bus, add_filter, window);
 	BUS_DISCONNECT (bus, remove_filter, data);
 
@@ -480,6 +480,9 @@ gedit_file_browser_plugin_activate (GeditWindowActivatable *activatable)
 
 	priv = plugin->priv;
 
+	/* Released once the widget is gone, see deactivate */
+	gedit_file_browser_utils_ref_caches ();
+
 	priv->tree_widget = GEDIT_FILE_BROWSER_WIDGET (gedit_file_browser_widget_new ());
 
 	g_signal_connect (priv->tree_widget,
@@ -598,6 +601,8 @@ gedit_file_browser_plugin_deactivate (GeditWindowActivatable *activatable)
 
 	panel = gedit_window_get_side_panel (priv->window);
 	gtk_container_remove (GTK_CONTAINER (panel), GTK_WIDGET (priv->tree_widget));
+
+	gedit_file_browser_utils_unref_caches ();
 }
 
 static void
@@ -31,6 +31,7 @@
 #include "gedit-file-browser-enum-types.h"
 #include "gedit-file-browser-error.h"
 #include "gedit-file-browser-utils.h"
+#include "gedit-file-browser-glob-set.h"
 
 #define NODE_IS_DIR(node)		(FILE_IS_DIR((node)->flags))
 #define NODE_IS_HIDDEN(node)		(FILE_IS_HIDDEN((node)->flags))
@@ -41,7 +42,20 @@
 
 #define FILE_BROWSER_NODE_DIR(node)	((FileBrowserNodeDir *)(node))
 
+/* The number of entries requested from the enumerator at once starts at
+ * DIRECTORY_LOAD_ITEMS_PER_CALLBACK and adapts to how long the requests
+ * take, see model_iterate_next_files_cb().
+ */
 #define DIRECTORY_LOAD_ITEMS_PER_CALLBACK 100
+#define DIRECTORY_LOAD_MIN_ITEMS 25
+#define DIRECTORY_LOAD_MAX_ITEMS 3200
+#define DIRECTORY_LOAD_TARGET_LATENCY 50000
+#define DIRECTORY_INSERT_BUDGET 8000
+#define MAX_INFO_QUERIES 8
+#define MONITOR_EVENTS_DELAY 100
+#define MONITOR_EVENTS_PER_FLUSH 200
+#define MAX_DELETE_OPERATIONS 8
+#define DELETE_FLUSH_DELAY 100
 #define STANDARD_ATTRIBUTE_TYPES G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
 				 G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN "," \
 			 	 G_FILE_ATTRIBUTE_STANDARD_IS_BACKUP "," \
@@ -53,6 +67,7 @@ typedef struct _FileBrowserNode    FileBrowserNode;
 typedef struct _FileBrowserNodeDir FileBrowserNodeDir;
 typedef struct _AsyncData	   AsyncData;
 typedef struct _AsyncNode	   AsyncNode;
+typedef struct _InfoQuery	   InfoQuery;
 
 typedef gint (*SortFunc) (FileBrowserNode *node1,
 			  FileBrowserNode *node2);
@@ -63,7 +78,22 @@ struct _AsyncData
 	GCancellable *cancellable;
 	gboolean trash;
 	GList *files;
-	GList *iter;
+
+	/* The files still to delete, those the trash refused while asking
+	 * whether to delete them instead, and those deleted but not yet
+	 * removed from the model. The files are owned by the files list.
+	 */
+	GQueue pending;
+	GQueue unsupported;
+	GSList *deleted;
+	guint flush_id;
+
+	guint n_running;
+	guint n_processed;
+	guint n_total;
+
+	gboolean asking;
+	gboolean declined;
 	gboolean removed;
 };
 
@@ -71,7 +101,23 @@ struct _AsyncNode
 {
 	FileBrowserNodeDir *dir;
 	GCancellable *cancellable;
-	GSList *original_children;
+
+	gint batch_size;
+	gint64 request_time;
+};
+
+struct _InfoQuery
+{
+	GeditFileBrowserStore *model;
+	GFile *file;
+	GCancellable *cancellable;
+
+	/* Add a node for the file if there is none yet */
+	guint create : 1;
+	guint running : 1;
+
+	/* Superseded by an event on the file, the result is dropped */
+	guint stale : 1;
 };
 
 typedef struct {
@@ -88,22 +134,59 @@ struct _FileBrowserNode
 	gchar *name;
 	gchar *markup;
 
+	/* Computed on the first comparison, see collate_nodes() */
+	gchar *collate_key;
+
+	/* The icon is only looked up from gicon when the row is first
+	 * shown, see model_node_get_icon().
+	 */
+	GIcon *gicon;
 	GdkPixbuf *icon;
 	GdkPixbuf *emblem;
 
 	FileBrowserNode *parent;
-	gint pos;
 	gboolean inserted;
+
+	/* Position in the children and in the visible_children of the
+	 * parent, or NULL when not in there.
+	 */
+	GSequenceIter *child_iter;
+	GSequenceIter *visible_iter;
 };
 
 struct _FileBrowserNodeDir
 {
 	FileBrowserNode node;
-	GSList *children;
+
+	/* All the children, sorted with the sort function of the model */
+	GSequence *children;
+
+	/* The children that are rows of the model, in the same order. This
+	 * gives the position of a row in its parent in logarithmic time.
+	 */
+	GSequence *visible_children;
+
+	/* GFile -> FileBrowserNode, for the children having a file */
+	GHashTable *children_by_file;
 
 	GCancellable *cancellable;
 	GFileMonitor *monitor;
 	GeditFileBrowserStore *model;
+
+	/* Monitor events not applied yet, GFile -> GFileMonitorEvent, and
+	 * the info of created files not added yet, GFile -> GFileInfo. Both
+	 * are created on the first event, see on_directory_monitor_event().
+	 */
+	GHashTable *monitor_events;
+	GHashTable *created_infos;
+	guint monitor_flush_id;
+
+	/* Loaded children not inserted yet, in sort order, and whether the
+	 * enumeration is over, see dir_insert_pending_children().
+	 */
+	GSequence *pending;
+	guint pending_id;
+	gboolean enumerated;
 };
 
 struct _GeditFileBrowserStorePrivate
@@ -117,12 +200,22 @@ struct _GeditFileBrowserStorePrivate
 	gpointer filter_user_data;
 
 	gchar **binary_patterns;
-	GPtrArray *binary_pattern_specs;
+	GeditFileBrowserGlobSet *binary_glob_set;
 
 	SortFunc sort_func;
 
 	GSList *async_handles;
 	MountInfo *mount_info;
+
+	/* File info queries waiting to be started, at most
+	 * MAX_INFO_QUERIES of them run at the same time.
+	 */
+	GQueue info_queue;
+	guint n_info_running;
+
+	/* GFile -> InfoQuery, the latest query for each file */
+	GHashTable *info_queries;
+	GCancellable *info_cancellable;
 };
 
 static FileBrowserNode *model_find_node 		    (GeditFileBrowserStore  *model,
@@ -194,6 +287,10 @@ static void next_files_async 				    (GFileEnumerator        *enumerator,
 							     AsyncNode              *async);
 
 static void delete_files                                    (AsyncData              *data);
+static void model_start_info_queries                        (GeditFileBrowserStore  *model);
+static void dir_schedule_monitor_flush                      (FileBrowserNodeDir     *dir);
+static GdkPixbuf *model_node_get_icon                       (FileBrowserNode        *node);
+static void model_node_clear_icons                          (FileBrowserNode        *node);
 
 G_DEFINE_DYNAMIC_TYPE_EXTENDED (GeditFileBrowserStore, gedit_file_browser_store,
 				G_TYPE_OBJECT,
@@ -226,11 +323,20 @@ enum
 	END_REFRESH,
 	UNLOAD,
 	BEFORE_ROW_DELETED,
+	DELETE_PROGRESS,
 	NUM_SIGNALS
 };
 
 static guint model_signals[NUM_SIGNALS] = { 0 };
 
+static void
+info_query_free (InfoQuery *query)
+{
+	g_object_unref (query->file);
+	g_object_unref (query->cancellable);
+	g_slice_free (InfoQuery, query);
+}
+
 static void
 cancel_mount_operation (GeditFileBrowserStore *obj)
 {
@@ -251,11 +357,8 @@ gedit_file_browser_store_finalize (GObject *object)
 	/* Free all the nodes */
 	file_browser_node_free (obj, obj->priv->root);
 
-	if (obj->priv->binary_patterns != NULL)
-	{
-		g_strfreev (obj->priv->binary_patterns);
-		g_ptr_array_unref (obj->priv->binary_pattern_specs);
-	}
+	g_strfreev (obj->priv->binary_patterns);
+	gedit_file_browser_glob_set_free (obj->priv->binary_glob_set);
 
 	/* Cancel any asynchronous operations */
 	for (item = obj->priv->async_handles; item; item = item->next)
@@ -263,11 +366,24 @@ gedit_file_browser_store_finalize (GObject *object)
 		AsyncData *data = (AsyncData *) (item->data);
 		g_cancellable_cancel (data->cancellable);
 
+		if (data->flush_id != 0)
+		{
+			g_source_remove (data->flush_id);
+			data->flush_id = 0;
+		}
+
 		data->removed = TRUE;
 	}
 
 	cancel_mount_operation (obj);
 
+	/* The running info queries free themselves once cancelled */
+	g_cancellable_cancel (obj->priv->info_cancellable);
+	g_object_unref (obj->priv->info_cancellable);
+	g_queue_foreach (&obj->priv->info_queue, (GFunc) info_query_free, NULL);
+	g_queue_clear (&obj->priv->info_queue);
+	g_hash_table_destroy (obj->priv->info_queries);
+
 	g_slist_free (obj->priv->async_handles);
 	G_OBJECT_CLASS (gedit_file_browser_store_parent_class)->finalize (object);
 }
@@ -442,6 +558,13 @@ gedit_file_browser_store_class_init (GeditFileBrowserStoreClass *klass)
 			  NULL, NULL, NULL,
 			  G_TYPE_NONE, 1,
 			  GTK_TYPE_TREE_PATH | G_SIGNAL_TYPE_STATIC_SCOPE);
+	model_signals[DELETE_PROGRESS] =
+	    g_signal_new ("delete-progress",
+			  G_OBJECT_CLASS_TYPE (object_class),
+			  G_SIGNAL_RUN_LAST,
+			  G_STRUCT_OFFSET (GeditFileBrowserStoreClass, delete_progress),
+			  NULL, NULL, NULL,
+			  G_TYPE_NONE, 2, G_TYPE_UINT, G_TYPE_UINT);
 }
 
 static void
@@ -475,6 +598,15 @@ gedit_file_browser_store_drag_source_init (GtkTreeDragSourceIface *iface)
 	iface->drag_data_get = gedit_file_browser_store_drag_data_get;
 }
 
+static void
+on_icon_theme_changed (GtkIconTheme          *theme,
+		       GeditFileBrowserStore *model)
+{
+	/* Looked up again from the new theme when the rows are drawn */
+	if (model->priv->root != NULL)
+		model_node_clear_icons (model->priv->root);
+}
+
 static void
 gedit_file_browser_store_init (GeditFileBrowserStore *obj)
 {
@@ -490,6 +622,18 @@ gedit_file_browser_store_init (GeditFileBrowserStore *obj)
 	/* Default filter mode is hiding the hidden files */
 	obj->priv->filter_mode = gedit_file_browser_store_filter_mode_get_default ();
 	obj->priv->sort_func = model_sort_default;
+
+	obj->priv->info_queries = g_hash_table_new_full (g_file_hash,
+							 (GEqualFunc) g_file_equal,
+							 g_object_unref,
+							 NULL);
+	obj->priv->info_cancellable = g_cancellable_new ();
+
+	g_signal_connect_object (gtk_icon_theme_get_default (),
+				 "changed",
+				 G_CALLBACK (on_icon_theme_changed),
+				 obj,
+				 0);
 }
 
 static gboolean
@@ -531,12 +675,199 @@ model_node_visibility (GeditFileBrowserStore *model,
 	return !NODE_IS_FILTERED (node);
 }
 
+/* Children storage */
+
+static gint
+compare_nodes (gconstpointer a,
+	       gconstpointer b,
+	       gpointer      user_data)
+{
+	GeditFileBrowserStore *model = GEDIT_FILE_BROWSER_STORE (user_data);
+
+	if (model->priv->sort_func == NULL)
+		return 0;
+
+	return model->priv->sort_func ((FileBrowserNode *) a,
+				       (FileBrowserNode *) b);
+}
+
+static gint
+compare_child_iters (GSequenceIter *a,
+		     GSequenceIter *b,
+		     gpointer       user_data)
+{
+	FileBrowserNode *node1 = g_sequence_get (a);
+	FileBrowserNode *node2 = g_sequence_get (b);
+
+	return g_sequence_iter_compare (node1->child_iter, node2->child_iter);
+}
+
+static FileBrowserNode *
+dir_first_child (FileBrowserNode *node)
+{
+	GSequenceIter *iter;
+
+	iter = g_sequence_get_begin_iter (FILE_BROWSER_NODE_DIR (node)->children);
+
+	return g_sequence_iter_is_end (iter) ? NULL : g_sequence_get (iter);
+}
+
+static GSList *
+dir_copy_children (FileBrowserNode *node)
+{
+	GSequenceIter *iter;
+	GSList *copy = NULL;
+
+	iter = g_sequence_get_end_iter (FILE_BROWSER_NODE_DIR (node)->children);
+
+	while (!g_sequence_iter_is_begin (iter))
+	{
+		iter = g_sequence_iter_prev (iter);
+		copy = g_slist_prepend (copy, g_sequence_get (iter));
+	}
+
+	return copy;
+}
+
+static FileBrowserNode *
+dir_lookup_file (FileBrowserNode *node,
+		 GFile           *file)
+{
+	return g_hash_table_lookup (FILE_BROWSER_NODE_DIR (node)->children_by_file, file);
+}
+
+static gint
+dir_n_visible_children (FileBrowserNode *node)
+{
+	return g_sequence_get_length (FILE_BROWSER_NODE_DIR (node)->visible_children);
+}
+
+static FileBrowserNode *
+dir_nth_visible_child (FileBrowserNode *node,
+		       gint             n)
+{
+	GSequenceIter *iter;
+
+	if (n < 0)
+		return NULL;
+
+	iter = g_sequence_get_iter_at_pos (FILE_BROWSER_NODE_DIR (node)->visible_children, n);
+
+	return g_sequence_iter_is_end (iter) ? NULL : g_sequence_get (iter);
+}
+
+/* Whether the node is a row of its parent, as far as the node itself is
+ * concerned: it is inserted and visible, leaving out the check on the
+ * ancestors, which is the same for all the siblings.
+ */
 static gboolean
-model_node_inserted (GeditFileBrowserStore *model,
-		     FileBrowserNode        *node)
+node_is_row (FileBrowserNode *node)
+{
+	if (!node->inserted)
+		return FALSE;
+
+	if (NODE_IS_DUMMY (node))
+		return !NODE_IS_HIDDEN (node);
+
+	return !NODE_IS_FILTERED (node);
+}
+
+/* Must be called whenever node_is_row() may have changed */
+static void
+node_sync_visible (FileBrowserNode *node)
+{
+	FileBrowserNodeDir *dir;
+	gboolean is_row;
+
+	if (node->parent == NULL || node->child_iter == NULL)
+		return;
+
+	is_row = node_is_row (node);
+
+	if (is_row == (node->visible_iter != NULL))
+		return;
+
+	dir = FILE_BROWSER_NODE_DIR (node->parent);
+
+	if (is_row)
+	{
+		node->visible_iter = g_sequence_insert_sorted_iter (dir->visible_children,
+								    node,
+								    compare_child_iters,
+								    NULL);
+	}
+	else
+	{
+		g_sequence_remove (node->visible_iter);
+		node->visible_iter = NULL;
+	}
+}
+
+/* Returns the first row after the node, or the position the node gets
+ * when it is inserted if it is not a row.
+ */
+static GSequenceIter *
+node_next_visible_iter (FileBrowserNode *node)
+{
+	if (node->visible_iter != NULL)
+		return g_sequence_iter_next (node->visible_iter);
+
+	return g_sequence_search_iter (FILE_BROWSER_NODE_DIR (node->parent)->visible_children,
+				       node,
+				       compare_child_iters,
+				       NULL);
+}
+
+static gint
+node_visible_position (FileBrowserNode *node)
+{
+	if (node->visible_iter != NULL)
+		return g_sequence_iter_get_position (node->visible_iter);
+
+	return g_sequence_iter_get_position (node_next_visible_iter (node));
+}
+
+static void
+dir_insert_child (GeditFileBrowserStore *model,
+		  FileBrowserNode       *parent,
+		  FileBrowserNode       *child)
+{
+	FileBrowserNodeDir *dir = FILE_BROWSER_NODE_DIR (parent);
+
+	child->child_iter = g_sequence_insert_sorted (dir->children,
+						      child,
+						      compare_nodes,
+						      model);
+
+	if (child->file != NULL)
+		g_hash_table_insert (dir->children_by_file, child->file, child);
+
+	node_sync_visible (child);
+}
+
+static void
+dir_remove_child (FileBrowserNode *parent,
+		  FileBrowserNode *child)
 {
-	return node == model->priv->virtual_root ||
-	       (model_node_visibility (model, node) && node->inserted);
+	FileBrowserNodeDir *dir = FILE_BROWSER_NODE_DIR (parent);
+
+	if (child->child_iter == NULL)
+		return;
+
+	if (child->visible_iter != NULL)
+	{
+		g_sequence_remove (child->visible_iter);
+		child->visible_iter = NULL;
+	}
+
+	if (child->file != NULL &&
+	    g_hash_table_lookup (dir->children_by_file, child->file) == child)
+	{
+		g_hash_table_remove (dir->children_by_file, child->file);
+	}
+
+	g_sequence_remove (child->child_iter);
+	child->child_iter = NULL;
 }
 
 /* Interface implementation */
@@ -589,36 +920,16 @@ gedit_file_browser_store_get_iter (GtkTreeModel *tree_model,
 
 	for (i = 0; i < depth; ++i)
 	{
-		GSList *item;
-		gint num = 0;
-
 		if (node == NULL)
 			return FALSE;
 
 		if (!NODE_IS_DIR (node))
 			return FALSE;
 
-		for (item = FILE_BROWSER_NODE_DIR (node)->children; item; item = item->next)
-		{
-			FileBrowserNode *child = (FileBrowserNode *) (item->data);
-
-			if (model_node_inserted (model, child))
-			{
-				if (num == indices[i])
-				{
-					break;
-				}
-
-				num++;
-			}
-		}
+		node = dir_nth_visible_child (node, indices[i]);
 
-		if (item == NULL)
-		{
+		if (node == NULL)
 			return FALSE;
-		}
-
-		node = (FileBrowserNode *) (item->data);
 	}
 
 	iter->user_data = node;
@@ -633,48 +944,27 @@ gedit_file_browser_store_get_path_real (GeditFileBrowserStore *model,
 					FileBrowserNode       *node)
 {
 	GtkTreePath *path;
-	gint num = 0;
 
 	path = gtk_tree_path_new ();
 
 	while (node != model->priv->virtual_root)
 	{
-		GSList *item;
-
-		if (node->parent == NULL) {
+		if (node->parent == NULL || node->child_iter == NULL) {
 			gtk_tree_path_free (path);
 			return NULL;
 		}
 
-		num = 0;
-
-		for (item = FILE_BROWSER_NODE_DIR (node->parent)->children; item; item = item->next)
+		if (!model_node_visibility (model, node))
 		{
-			FileBrowserNode *check;
-
-			check = (FileBrowserNode *) (item->data);
-
-			if (model_node_visibility (model, check) && (check == node || check->inserted))
-			{
-				if (check == node)
-				{
-					gtk_tree_path_prepend_index (path,
-								     num);
-					break;
-				}
-
-				++num;
-			}
-			else if (check == node)
-			{
-				if (NODE_IS_DUMMY (node))
-					g_warning ("Dummy not visible???");
+			if (NODE_IS_DUMMY (node))
+				g_warning ("Dummy not visible???");
 
-				gtk_tree_path_free (path);
-				return NULL;
-			}
+			gtk_tree_path_free (path);
+			return NULL;
 		}
 
+		gtk_tree_path_prepend_index (path, node_visible_position (node));
+
 		node = node->parent;
 	}
 
@@ -721,7 +1011,7 @@ gedit_file_browser_store_get_value (GtkTreeModel *tree_model,
 			g_value_set_uint (value, node->flags);
 			break;
 		case GEDIT_FILE_BROWSER_STORE_COLUMN_ICON:
-			g_value_set_object (value, node->icon);
+			g_value_set_object (value, model_node_get_icon (node));
 			break;
 		case GEDIT_FILE_BROWSER_STORE_COLUMN_NAME:
 			g_value_set_string (value, node->name);
@@ -738,34 +1028,26 @@ static gboolean
 gedit_file_browser_store_iter_next (GtkTreeModel *tree_model,
 				    GtkTreeIter  *iter)
 {
-	GeditFileBrowserStore *model;
 	FileBrowserNode *node;
-	GSList *item;
-	GSList *first;
+	GSequenceIter *next;
 
 	g_return_val_if_fail (GEDIT_IS_FILE_BROWSER_STORE (tree_model),
 			      FALSE);
 	g_return_val_if_fail (iter != NULL, FALSE);
 	g_return_val_if_fail (iter->user_data != NULL, FALSE);
 
-	model = GEDIT_FILE_BROWSER_STORE (tree_model);
 	node = (FileBrowserNode *) (iter->user_data);
 
-	if (node->parent == NULL)
+	if (node->parent == NULL || node->child_iter == NULL)
 		return FALSE;
 
-	first = g_slist_next (g_slist_find (FILE_BROWSER_NODE_DIR (node->parent)->children, node));
+	next = node_next_visible_iter (node);
 
-	for (item = first; item; item = item->next)
-	{
-		if (model_node_inserted (model, (FileBrowserNode *) (item->data)))
-		{
-			iter->user_data = item->data;
-			return TRUE;
-		}
-	}
+	if (g_sequence_iter_is_end (next))
+		return FALSE;
 
-	return FALSE;
+	iter->user_data = g_sequence_get (next);
+	return TRUE;
 }
 
 static gboolean
@@ -774,8 +1056,8 @@ gedit_file_browser_store_iter_children (GtkTreeModel *tree_model,
 					GtkTreeIter  *parent)
 {
 	FileBrowserNode *node;
+	FileBrowserNode *child;
 	GeditFileBrowserStore *model;
-	GSList *item;
 
 	g_return_val_if_fail (GEDIT_IS_FILE_BROWSER_STORE (tree_model), FALSE);
 	g_return_val_if_fail (parent == NULL || parent->user_data != NULL, FALSE);
@@ -793,34 +1075,23 @@ gedit_file_browser_store_iter_children (GtkTreeModel *tree_model,
 	if (!NODE_IS_DIR (node))
 		return FALSE;
 
-	for (item = FILE_BROWSER_NODE_DIR (node)->children; item; item = item->next)
-	{
-		if (model_node_inserted (model, (FileBrowserNode *) (item->data)))
-		{
-			iter->user_data = item->data;
-			return TRUE;
-		}
-	}
+	child = dir_nth_visible_child (node, 0);
 
-	return FALSE;
+	if (child == NULL)
+		return FALSE;
+
+	iter->user_data = child;
+	return TRUE;
 }
 
 static gboolean
 filter_tree_model_iter_has_child_real (GeditFileBrowserStore *model,
 				       FileBrowserNode       *node)
 {
-	GSList *item;
-
 	if (!NODE_IS_DIR (node))
 		return FALSE;
 
-	for (item = FILE_BROWSER_NODE_DIR (node)->children; item; item = item->next)
-	{
-		if (model_node_inserted (model, (FileBrowserNode *) (item->data)))
-			return TRUE;
-	}
-
-	return FALSE;
+	return dir_n_visible_children (node) > 0;
 }
 
 static gboolean
@@ -851,8 +1122,6 @@ gedit_file_browser_store_iter_n_children (GtkTreeModel *tree_model,
 {
 	FileBrowserNode *node;
 	GeditFileBrowserStore *model;
-	GSList *item;
-	gint num = 0;
 
 	g_return_val_if_fail (GEDIT_IS_FILE_BROWSER_STORE (tree_model),
 			      FALSE);
@@ -869,13 +1138,7 @@ gedit_file_browser_store_iter_n_children (GtkTreeModel *tree_model,
 	if (!NODE_IS_DIR (node))
 		return 0;
 
-	for (item = FILE_BROWSER_NODE_DIR (node)->children; item; item = item->next)
-	{
-		if (model_node_inserted (model, (FileBrowserNode *) (item->data)))
-			++num;
-	}
-
-	return num;
+	return dir_n_visible_children (node);
 }
 
 static gboolean
@@ -885,9 +1148,8 @@ gedit_file_browser_store_iter_nth_child (GtkTreeModel *tree_model,
 					 gint          n)
 {
 	FileBrowserNode *node;
+	FileBrowserNode *child;
 	GeditFileBrowserStore *model;
-	GSList *item;
-	gint num = 0;
 
 	g_return_val_if_fail (GEDIT_IS_FILE_BROWSER_STORE (tree_model), FALSE);
 	g_return_val_if_fail (parent == NULL || parent->user_data != NULL, FALSE);
@@ -902,21 +1164,13 @@ gedit_file_browser_store_iter_nth_child (GtkTreeModel *tree_model,
 	if (!NODE_IS_DIR (node))
 		return FALSE;
 
-	for (item = FILE_BROWSER_NODE_DIR (node)->children; item; item = item->next)
-	{
-		if (model_node_inserted (model, (FileBrowserNode *) (item->data)))
-		{
-			if (num == n)
-			{
-				iter->user_data = item->data;
-				return TRUE;
-			}
+	child = dir_nth_visible_child (node, n);
 
-			++num;
-		}
-	}
+	if (child == NULL)
+		return FALSE;
 
-	return FALSE;
+	iter->user_data = child;
+	return TRUE;
 }
 
 static gboolean
@@ -952,6 +1206,7 @@ gedit_file_browser_store_row_inserted (GtkTreeModel *tree_model,
 	FileBrowserNode *node = (FileBrowserNode *)(iter->user_data);
 
 	node->inserted = TRUE;
+	node_sync_visible (node);
 }
 
 static gboolean
@@ -1037,8 +1292,8 @@ model_end_loading (GeditFileBrowserStore *model,
 }
 
 static void
-model_node_update_visibility (GeditFileBrowserStore *model,
-			      FileBrowserNode       *node)
+model_node_update_filtered (GeditFileBrowserStore *model,
+			    FileBrowserNode       *node)
 {
 	GtkTreeIter iter;
 
@@ -1058,31 +1313,12 @@ model_node_update_visibility (GeditFileBrowserStore *model,
 			node->flags |= GEDIT_FILE_BROWSER_STORE_FLAG_IS_FILTERED;
 			return;
 		}
-		else if (model->priv->binary_patterns != NULL)
+		else if (model->priv->binary_glob_set != NULL &&
+			 gedit_file_browser_glob_set_match (model->priv->binary_glob_set,
+							    node->name))
 		{
-			gint i;
-			gssize name_length;
-			gchar *name_reversed;
-
-			name_length = strlen (node->name);
-			name_reversed = g_utf8_strreverse (node->name, name_length);
-
-			for (i = 0; i < model->priv->binary_pattern_specs->len; ++i)
-			{
-				GPatternSpec *spec;
-
-				spec = g_ptr_array_index (model->priv->binary_pattern_specs, i);
-
-				if (g_pattern_match (spec, name_length,
-				                     node->name, name_reversed))
-				{
-					node->flags |= GEDIT_FILE_BROWSER_STORE_FLAG_IS_FILTERED;
-					g_free (name_reversed);
-					return;
-				}
-			}
-
-			g_free (name_reversed);
+			node->flags |= GEDIT_FILE_BROWSER_STORE_FLAG_IS_FILTERED;
+			return;
 		}
 	}
 
@@ -1098,6 +1334,28 @@ model_node_update_visibility (GeditFileBrowserStore *model,
 	}
 }
 
+static void
+model_node_update_visibility (GeditFileBrowserStore *model,
+			      FileBrowserNode       *node)
+{
+	model_node_update_filtered (model, node);
+	node_sync_visible (node);
+}
+
+static const gchar *
+file_browser_node_get_collate_key (FileBrowserNode *node)
+{
+	/* Sorting a directory compares each node many times, computing
+	 * the key only once makes the comparison a plain strcmp().
+	 */
+	if (node->collate_key == NULL)
+	{
+		node->collate_key = g_utf8_collate_key_for_filename (node->name, -1);
+	}
+
+	return node->collate_key;
+}
+
 static gint
 collate_nodes (FileBrowserNode *node1,
 	       FileBrowserNode *node2)
@@ -1112,18 +1370,8 @@ collate_nodes (FileBrowserNode *node1,
 	}
 	else
 	{
-		gchar *k1, *k2;
-		gint result;
-
-		k1 = g_utf8_collate_key_for_filename (node1->name, -1);
-		k2 = g_utf8_collate_key_for_filename (node2->name, -1);
-
-		result = strcmp (k1, k2);
-
-		g_free (k1);
-		g_free (k2);
-
-		return result;
+		return strcmp (file_browser_node_get_collate_key (node1),
+			       file_browser_node_get_collate_key (node2));
 	}
 }
 
@@ -1155,56 +1403,54 @@ static void
 model_resort_node (GeditFileBrowserStore *model,
 		   FileBrowserNode       *node)
 {
-	FileBrowserNodeDir *dir;
-	GSList *item;
-	FileBrowserNode *child;
-	gint pos = 0;
 	GtkTreeIter iter;
 	GtkTreePath *path;
 	gint *neworder;
+	gint old_pos;
+	gint new_pos;
+	gint n_rows;
+	gint i;
 
-	dir = FILE_BROWSER_NODE_DIR (node->parent);
+	if (node->child_iter == NULL)
+		return;
 
-	if (!model_node_visibility (model, node->parent))
-	{
-		/* Just sort the children of the parent */
-		dir->children = g_slist_sort (dir->children,
-					      (GCompareFunc) (model->priv->sort_func));
-	}
-	else
-	{
-		/* Store current positions */
-		for (item = dir->children; item; item = item->next)
-		{
-			child = (FileBrowserNode *) (item->data);
+	old_pos = node->visible_iter != NULL ? g_sequence_iter_get_position (node->visible_iter) : -1;
 
-			if (model_node_visibility (model, child))
-				child->pos = pos++;
-		}
+	/* Only the node itself can be out of place */
+	g_sequence_sort_changed (node->child_iter, compare_nodes, model);
 
-		dir->children = g_slist_sort (dir->children,
-					      (GCompareFunc) (model->priv->sort_func));
-		neworder = g_new (gint, pos);
-		pos = 0;
+	if (node->visible_iter == NULL)
+		return;
 
-		/* Store the new positions */
-		for (item = dir->children; item; item = item->next)
-		{
-			child = (FileBrowserNode *) (item->data);
-
-			if (model_node_visibility (model, child))
-				neworder[pos++] = child->pos;
-		}
+	g_sequence_sort_changed_iter (node->visible_iter, compare_child_iters, NULL);
+	new_pos = g_sequence_iter_get_position (node->visible_iter);
 
-		iter.user_data = node->parent;
-		path = gedit_file_browser_store_get_path_real (model, node->parent);
+	if (old_pos == new_pos || !model_node_visibility (model, node->parent))
+		return;
 
-		gtk_tree_model_rows_reordered (GTK_TREE_MODEL (model),
-					       path, &iter, neworder);
+	n_rows = dir_n_visible_children (node->parent);
+	neworder = g_new (gint, n_rows);
 
-		g_free (neworder);
-		gtk_tree_path_free (path);
+	for (i = 0; i < n_rows; ++i)
+	{
+		if (i == new_pos)
+			neworder[i] = old_pos;
+		else if (old_pos < new_pos && i >= old_pos && i < new_pos)
+			neworder[i] = i + 1;
+		else if (old_pos > new_pos && i > new_pos && i <= old_pos)
+			neworder[i] = i - 1;
+		else
+			neworder[i] = i;
 	}
+
+	iter.user_data = node->parent;
+	path = gedit_file_browser_store_get_path_real (model, node->parent);
+
+	gtk_tree_model_rows_reordered (GTK_TREE_MODEL (model),
+				       path, &iter, neworder);
+
+	g_free (neworder);
+	gtk_tree_path_free (path);
 }
 
 static void
@@ -1281,6 +1527,8 @@ row_deleted (GeditFileBrowserStore *model,
 		node->flags |= GEDIT_FILE_BROWSER_STORE_FLAG_IS_HIDDEN;
 	}
 
+	node_sync_visible (node);
+
 	copy = gtk_tree_path_copy (path);
 	gtk_tree_model_row_deleted (GTK_TREE_MODEL (model), copy);
 	gtk_tree_path_free (copy);
@@ -1294,7 +1542,7 @@ model_refilter_node (GeditFileBrowserStore  *model,
 	gboolean old_visible;
 	gboolean new_visible;
 	FileBrowserNodeDir *dir;
-	GSList *item;
+	GSequenceIter *item;
 	GtkTreeIter iter;
 	GtkTreePath *tmppath = NULL;
 	gboolean in_tree;
@@ -1325,10 +1573,12 @@ model_refilter_node (GeditFileBrowserStore  *model,
 
 		dir = FILE_BROWSER_NODE_DIR (node);
 
-		for (item = dir->children; item; item = item->next)
+		for (item = g_sequence_get_begin_iter (dir->children);
+		     !g_sequence_iter_is_end (item);
+		     item = g_sequence_iter_next (item))
 		{
 			model_refilter_node (model,
-					     (FileBrowserNode *) (item->data),
+					     (FileBrowserNode *) g_sequence_get (item),
 					     path);
 		}
 
@@ -1376,6 +1626,9 @@ file_browser_node_set_name (FileBrowserNode *node)
 {
 	g_free (node->name);
 	g_free (node->markup);
+	g_free (node->collate_key);
+
+	node->collate_key = NULL;
 
 	if (node->file)
 		node->name = gedit_file_browser_utils_file_basename (node->file);
@@ -1424,26 +1677,86 @@ file_browser_node_dir_new (GeditFileBrowserStore *model,
 	node->flags |= GEDIT_FILE_BROWSER_STORE_FLAG_IS_DIRECTORY;
 
 	FILE_BROWSER_NODE_DIR (node)->model = model;
+	FILE_BROWSER_NODE_DIR (node)->children = g_sequence_new (NULL);
+	FILE_BROWSER_NODE_DIR (node)->visible_children = g_sequence_new (NULL);
+	FILE_BROWSER_NODE_DIR (node)->pending = g_sequence_new (NULL);
+	FILE_BROWSER_NODE_DIR (node)->children_by_file = g_hash_table_new (g_file_hash,
+									  (GEqualFunc) g_file_equal);
 
 	return node;
 }
 
+static void
+dir_clear_monitor_events (FileBrowserNodeDir *dir)
+{
+	if (dir->monitor_flush_id != 0)
+	{
+		g_source_remove (dir->monitor_flush_id);
+		dir->monitor_flush_id = 0;
+	}
+
+	if (dir->monitor_events != NULL)
+	{
+		g_hash_table_destroy (dir->monitor_events);
+		dir->monitor_events = NULL;
+	}
+
+	if (dir->created_infos != NULL)
+	{
+		g_hash_table_destroy (dir->created_infos);
+		dir->created_infos = NULL;
+	}
+}
+
+static void
+dir_clear_pending (GeditFileBrowserStore *model,
+		   FileBrowserNodeDir    *dir)
+{
+	GSequenceIter *item;
+
+	if (dir->pending_id != 0)
+	{
+		g_source_remove (dir->pending_id);
+		dir->pending_id = 0;
+	}
+
+	for (item = g_sequence_get_begin_iter (dir->pending);
+	     !g_sequence_iter_is_end (item);
+	     item = g_sequence_iter_next (item))
+	{
+		file_browser_node_free (model, (FileBrowserNode *) g_sequence_get (item));
+	}
+
+	g_sequence_remove_range (g_sequence_get_begin_iter (dir->pending),
+				 g_sequence_get_end_iter (dir->pending));
+
+	dir->enumerated = FALSE;
+}
+
 static void
 file_browser_node_free_children (GeditFileBrowserStore *model,
 				 FileBrowserNode       *node)
 {
-	GSList *item;
+	FileBrowserNodeDir *dir;
+	GSequenceIter *item;
 
 	if (node == NULL || !NODE_IS_DIR (node))
 		return;
 
-	for (item = FILE_BROWSER_NODE_DIR (node)->children; item; item = item->next)
+	dir = FILE_BROWSER_NODE_DIR (node);
+
+	for (item = g_sequence_get_begin_iter (dir->children);
+	     !g_sequence_iter_is_end (item);
+	     item = g_sequence_iter_next (item))
 	{
-		file_browser_node_free (model, (FileBrowserNode *) (item->data));
+		file_browser_node_free (model, (FileBrowserNode *) g_sequence_get (item));
 	}
 
-	g_slist_free (FILE_BROWSER_NODE_DIR (node)->children);
-	FILE_BROWSER_NODE_DIR (node)->children = NULL;
+	g_sequence_remove_range (g_sequence_get_begin_iter (dir->children),
+				 g_sequence_get_end_iter (dir->children));
+	g_sequence_remove_range (g_sequence_get_begin_iter (dir->visible_children),
+				 g_sequence_get_end_iter (dir->visible_children));
+	g_hash_table_remove_all (dir->children_by_file);
 
 	/* This node is no longer loaded */
 	node->flags &= ~GEDIT_FILE_BROWSER_STORE_FLAG_LOADED;
@@ -1471,12 +1784,20 @@ file_browser_node_free (GeditFileBrowserStore *model,
 		}
 
 		file_browser_node_free_children (model, node);
+		dir_clear_pending (model, dir);
+
+		g_sequence_free (dir->children);
+		g_sequence_free (dir->visible_children);
+		g_sequence_free (dir->pending);
+		g_hash_table_destroy (dir->children_by_file);
 
 		if (dir->monitor)
 		{
 			g_file_monitor_cancel (dir->monitor);
 			g_object_unref (dir->monitor);
 		}
+
+		dir_clear_monitor_events (dir);
 	}
 
 	if (node->file)
@@ -1485,6 +1806,9 @@ file_browser_node_free (GeditFileBrowserStore *model,
 		g_object_unref (node->file);
 	}
 
+	if (node->gicon)
+		g_object_unref (node->gicon);
+
 	if (node->icon)
 		g_object_unref (node->icon);
 
@@ -1493,6 +1817,7 @@ file_browser_node_free (GeditFileBrowserStore *model,
 
 	g_free (node->name);
 	g_free (node->markup);
+	g_free (node->collate_key);
 
 	if (NODE_IS_DIR (node))
 		g_slice_free (FileBrowserNodeDir, (FileBrowserNodeDir *)node);
@@ -1517,7 +1842,6 @@ model_remove_node_children (GeditFileBrowserStore *model,
 			    GtkTreePath           *path,
 			    gboolean               free_nodes)
 {
-	FileBrowserNodeDir *dir;
 	GtkTreePath *path_child;
 	GSList *list;
 	GSList *item;
@@ -1525,9 +1849,7 @@ model_remove_node_children (GeditFileBrowserStore *model,
 	if (node == NULL || !NODE_IS_DIR (node))
 		return;
 
-	dir = FILE_BROWSER_NODE_DIR (node);
-
-	if (dir->children == NULL)
+	if (dir_first_child (node) == NULL)
 		return;
 
 	if (!model_node_visibility (model, node))
@@ -1547,7 +1869,7 @@ model_remove_node_children (GeditFileBrowserStore *model,
 
 	gtk_tree_path_down (path_child);
 
-	list = g_slist_copy (dir->children);
+	list = dir_copy_children (node);
 
 	for (item = list; item; item = item->next)
 	{
@@ -1605,10 +1927,7 @@ model_remove_node (GeditFileBrowserStore *model,
 		/* Remove the node from the parents children list */
 		if (parent)
 		{
-			FILE_BROWSER_NODE_DIR (node->parent)->children =
-			    g_slist_remove (FILE_BROWSER_NODE_DIR
-					    (node->parent)->children,
-					    node);
+			dir_remove_child (parent, node);
 		}
 	}
 
@@ -1623,6 +1942,55 @@ model_remove_node (GeditFileBrowserStore *model,
 		file_browser_node_free (model, node);
 }
 
+/**
+ * model_remove_nodes_batch:
+ * @model: the #GeditFileBrowserStore
+ * @parent: the directory the nodes are children of
+ * @nodes: the FileBrowserNodes to remove
+ *
+ * Removes and frees the nodes like model_remove_node() does, checking the
+ * dummy of @parent only once all of them are gone.
+ */
+static void
+model_remove_nodes_batch (GeditFileBrowserStore *model,
+			  FileBrowserNode       *parent,
+			  GSList                *nodes)
+{
+	GSList *item;
+	FileBrowserNode *node;
+	GtkTreePath *path;
+	gboolean virtual_root_removed = FALSE;
+
+	for (item = nodes; item; item = item->next)
+	{
+		node = (FileBrowserNode *) (item->data);
+
+		/* Removed last, it changes the virtual root */
+		if (node == model->priv->virtual_root)
+		{
+			virtual_root_removed = TRUE;
+			continue;
+		}
+
+		model_remove_node_children (model, node, NULL, TRUE);
+
+		if (model_node_visibility (model, node))
+		{
+			path = gedit_file_browser_store_get_path_real (model, node);
+			row_deleted (model, node, path);
+			gtk_tree_path_free (path);
+		}
+
+		dir_remove_child (parent, node);
+		file_browser_node_free (model, node);
+	}
+
+	if (virtual_root_removed)
+		model_remove_node (model, model->priv->virtual_root, NULL, TRUE);
+	else if (model_node_visibility (model, parent))
+		model_check_dummy (model, parent);
+}
+
 /**
  * model_clear:
  * @model: the #GeditFileBrowserStore
@@ -1646,23 +2014,17 @@ model_clear (GeditFileBrowserStore *model,
 	/* Remove the dummy if there is one */
 	if (model->priv->virtual_root)
 	{
-		FileBrowserNodeDir *dir;
+		FileBrowserNode *dummy;
 
-		dir = FILE_BROWSER_NODE_DIR (model->priv->virtual_root);
+		dummy = dir_first_child (model->priv->virtual_root);
 
-		if (dir->children != NULL)
+		if (dummy != NULL &&
+		    NODE_IS_DUMMY (dummy) &&
+		    model_node_visibility (model, dummy))
 		{
-			FileBrowserNode *dummy;
-
-			dummy = (FileBrowserNode *) (dir->children->data);
-
-			if (NODE_IS_DUMMY (dummy) &&
-			    model_node_visibility (model, dummy))
-			{
-				path = gtk_tree_path_new_first ();
-				row_deleted (model, dummy, path);
-				gtk_tree_path_free (path);
-			}
+			path = gtk_tree_path_new_first ();
+			row_deleted (model, dummy, path);
+			gtk_tree_path_free (path);
 		}
 	}
 }
@@ -1694,6 +2056,8 @@ file_browser_node_unload (GeditFileBrowserStore *model,
 		dir->cancellable = NULL;
 	}
 
+	dir_clear_pending (model, dir);
+
 	if (dir->monitor)
 	{
 		g_file_monitor_cancel (dir->monitor);
@@ -1702,72 +2066,94 @@ file_browser_node_unload (GeditFileBrowserStore *model,
 		dir->monitor = NULL;
 	}
 
+	dir_clear_monitor_events (dir);
+
 	node->flags &= ~GEDIT_FILE_BROWSER_STORE_FLAG_LOADED;
 }
 
-static void
-model_recomposite_icon_real (GeditFileBrowserStore *tree_model,
-			     FileBrowserNode       *node,
-			     GFileInfo             *info)
+static GdkPixbuf *
+model_node_get_icon (FileBrowserNode *node)
 {
 	GdkPixbuf *icon;
 
-	g_return_if_fail (GEDIT_IS_FILE_BROWSER_STORE (tree_model));
-	g_return_if_fail (node != NULL);
+	if (node->icon != NULL || node->file == NULL)
+		return node->icon;
 
-	if (node->file == NULL)
-		return;
+	icon = gedit_file_browser_utils_pixbuf_from_icon (node->gicon, GTK_ICON_SIZE_MENU);
 
-	if (info)
+	/* Fallback to the same icon as the file browser */
+	if (!icon)
+		icon = gedit_file_browser_utils_pixbuf_from_theme ("text-x-generic", GTK_ICON_SIZE_MENU);
+
+	if (node->emblem)
 	{
-		GIcon *gicon = g_file_info_get_icon (info);
+		node->icon = gedit_file_browser_utils_pixbuf_with_emblem (icon,
+									  node->emblem,
+									  GTK_ICON_SIZE_MENU);
 
-		if (gicon != NULL)
-			icon = gedit_file_browser_utils_pixbuf_from_icon (gicon, GTK_ICON_SIZE_MENU);
-		else
-			icon = NULL;
+		if (icon)
+			g_object_unref (icon);
 	}
 	else
 	{
-		icon = gedit_file_browser_utils_pixbuf_from_file (node->file, GTK_ICON_SIZE_MENU, FALSE);
+		node->icon = icon;
 	}
 
-	/* Fallback to the same icon as the file browser */
-	if (!icon)
-		icon = gedit_file_browser_utils_pixbuf_from_theme ("text-x-generic", GTK_ICON_SIZE_MENU);
+	return node->icon;
+}
 
-	if (node->icon)
+static void
+model_node_clear_icons (FileBrowserNode *node)
+{
+	GSequenceIter *item;
+
+	if (node->icon != NULL)
+	{
 		g_object_unref (node->icon);
+		node->icon = NULL;
+	}
 
-	if (node->emblem)
+	if (!NODE_IS_DIR (node))
+		return;
+
+	for (item = g_sequence_get_begin_iter (FILE_BROWSER_NODE_DIR (node)->children);
+	     !g_sequence_iter_is_end (item);
+	     item = g_sequence_iter_next (item))
 	{
-		gint icon_size;
+		model_node_clear_icons ((FileBrowserNode *) g_sequence_get (item));
+	}
+}
+
+/* Takes the icon from info, if any, the pixbuf is looked up again when
+ * the row is shown.
+ */
+static void
+model_recomposite_icon_real (GeditFileBrowserStore *tree_model,
+			     FileBrowserNode       *node,
+			     GFileInfo             *info)
+{
+	GIcon *gicon;
 
-		gtk_icon_size_lookup (GTK_ICON_SIZE_MENU, NULL, &icon_size);
+	g_return_if_fail (GEDIT_IS_FILE_BROWSER_STORE (tree_model));
+	g_return_if_fail (node != NULL);
 
-		if (icon == NULL)
-		{
-			node->icon =
-			    gdk_pixbuf_new (gdk_pixbuf_get_colorspace (node->emblem),
-					    gdk_pixbuf_get_has_alpha (node->emblem),
-					    gdk_pixbuf_get_bits_per_sample (node->emblem),
-					    icon_size,
-					    icon_size);
-		}
-		else
-		{
-			node->icon = gdk_pixbuf_copy (icon);
-			g_object_unref (icon);
-		}
+	if (node->file == NULL)
+		return;
+
+	if (info)
+	{
+		gicon = g_file_info_get_icon (info);
+
+		if (node->gicon)
+			g_object_unref (node->gicon);
 
-		gdk_pixbuf_composite (node->emblem, node->icon,
-				      icon_size - 10, icon_size - 10, 10,
-				      10, icon_size - 10, icon_size - 10,
-				      1, 1, GDK_INTERP_NEAREST, 255);
+		node->gicon = gicon != NULL ? g_object_ref (gicon) : NULL;
 	}
-	else
+
+	if (node->icon)
 	{
-		node->icon = icon;
+		g_object_unref (node->icon);
+		node->icon = NULL;
 	}
 }
 
@@ -1827,36 +2213,40 @@ model_check_dummy (GeditFileBrowserStore *model,
 		GtkTreeIter iter;
 		GtkTreePath *path;
 		guint flags;
-		FileBrowserNodeDir *dir;
+		gint n_real;
 
-		dir = FILE_BROWSER_NODE_DIR (node);
+		dummy = dir_first_child (node);
 
-		if (dir->children == NULL)
+		if (dummy == NULL)
 		{
 			model_add_dummy_node (model, node);
 			return;
 		}
 
-		dummy = (FileBrowserNode *) (dir->children->data);
-
 		if (!NODE_IS_DUMMY (dummy))
 		{
 			dummy = model_create_dummy_node (model, node);
-			dir->children = g_slist_prepend (dir->children, dummy);
+			dir_insert_child (model, node, dummy);
 		}
 
 		if (!model_node_visibility (model, node))
 		{
 			dummy->flags |= GEDIT_FILE_BROWSER_STORE_FLAG_IS_HIDDEN;
+			node_sync_visible (dummy);
 			return;
 		}
 
-		/* Temporarily set the node to invisible to check
-		   for real children */
+		/* Count the real children, the dummy row is synced with its
+		   new state by row_inserted or row_deleted */
+		n_real = dir_n_visible_children (node);
+
+		if (dummy->visible_iter != NULL)
+			n_real--;
+
 		flags = dummy->flags;
 		dummy->flags |= GEDIT_FILE_BROWSER_STORE_FLAG_IS_HIDDEN;
 
-		if (!filter_tree_model_iter_has_child_real (model, node))
+		if (n_real == 0)
 		{
 			dummy->flags &= ~GEDIT_FILE_BROWSER_STORE_FLAG_IS_HIDDEN;
 
@@ -1887,34 +2277,13 @@ model_check_dummy (GeditFileBrowserStore *model,
 	}
 }
 
-static void
-insert_node_sorted (GeditFileBrowserStore *model,
-		    FileBrowserNode       *child,
-		    FileBrowserNode       *parent)
-{
-	FileBrowserNodeDir *dir;
-
-	dir = FILE_BROWSER_NODE_DIR (parent);
-
-	if (model->priv->sort_func == NULL)
-	{
-		dir->children = g_slist_append (dir->children, child);
-	}
-	else
-	{
-		dir->children =
-		    g_slist_insert_sorted (dir->children, child,
-					   (GCompareFunc) (model->priv->sort_func));
-	}
-}
-
 static void
 model_add_node (GeditFileBrowserStore *model,
 		FileBrowserNode       *child,
 		FileBrowserNode       *parent)
 {
 	/* Add child to parents children */
-	insert_node_sorted (model, child, parent);
+	dir_insert_child (model, parent, child);
 
 	if (model_node_visibility (model, parent) &&
 	    model_node_visibility (model, child))
@@ -1940,92 +2309,38 @@ model_add_nodes_batch (GeditFileBrowserStore *model,
 		       FileBrowserNode       *parent)
 {
 	GSList *sorted_children;
-	GSList *child;
-	GSList *prev;
 	GSList *l;
-	FileBrowserNodeDir *dir;
-
-	dir = FILE_BROWSER_NODE_DIR (parent);
 
 	sorted_children = g_slist_sort (children, (GCompareFunc) model->priv->sort_func);
 
-	child = sorted_children;
-	l = dir->children;
-	prev = NULL;
-
 	model_check_dummy (model, parent);
 
-	while (child)
+	for (l = sorted_children; l; l = l->next)
 	{
-		FileBrowserNode *node = child->data;
-		GtkTreeIter iter;
-		GtkTreePath *path;
-
-		/* Reached the end of the first list, just append the second */
-		if (l == NULL)
-		{
-			dir->children = g_slist_concat (dir->children, child);
+		FileBrowserNode *node = l->data;
 
-			for (l = child; l; l = l->next)
-			{
-				if (model_node_visibility (model, parent) &&
-				    model_node_visibility (model, l->data))
-				{
-					iter.user_data = l->data;
-					path = gedit_file_browser_store_get_path_real (model, l->data);
-
-					/* Emit row inserted */
-					row_inserted (model, &path, &iter);
-					gtk_tree_path_free (path);
-				}
-
-				model_check_dummy (model, l->data);
-			}
-
-			break;
-		}
+		dir_insert_child (model, parent, node);
 
-		if (model->priv->sort_func (l->data, node) > 0)
+		if (model_node_visibility (model, parent) &&
+		    model_node_visibility (model, node))
 		{
-			GSList *next_child;
-
-			if (prev == NULL)
-			{
-				/* Prepend to the list */
-				dir->children = g_slist_prepend (dir->children, child);
-			}
-			else
-			{
-				prev->next = child;
-			}
+			GtkTreeIter iter;
+			GtkTreePath *path;
 
-			next_child = child->next;
-			prev = child;
-			child->next = l;
-			child = next_child;
+			iter.user_data = node;
+			path = gedit_file_browser_store_get_path_real (model, node);
 
-			if (model_node_visibility (model, parent) &&
-			    model_node_visibility (model, node))
-			{
-				iter.user_data = node;
-				path = gedit_file_browser_store_get_path_real (model, node);
+			/* Emit row inserted */
+			row_inserted (model, &path, &iter);
+			gtk_tree_path_free (path);
+		}
 
-				/* Emit row inserted */
-				row_inserted (model, &path, &iter);
-				gtk_tree_path_free (path);
-			}
+		model_check_dummy (model, node);
+	}
 
-			model_check_dummy (model, node);
+	model_check_dummy (model, parent);
 
-			/* Try again at the same l position with the next child */
-		}
-		else
-		{
-			/* Move to the next item in the list */
-			prev = l;
-			l = l->next;
-		}
-	}
+	g_slist_free (sorted_children);
 }
 
 static gchar const *
@@ -2083,34 +2398,11 @@ file_browser_node_set_from_info (GeditFileBrowserStore *model,
 				 gboolean               isadded)
 {
 	gchar const *content;
-	gboolean free_info = FALSE;
 	GtkTreePath *path;
-	gchar *uri;
-	GError *error = NULL;
 
-	if (info == NULL)
-	{
-		info = g_file_query_info (node->file,
-					  STANDARD_ATTRIBUTE_TYPES,
-					  G_FILE_QUERY_INFO_NONE,
-					  NULL,
-					  &error);
-
-		if (!info)
-		{
-			if (!(error->domain == G_IO_ERROR && error->code == G_IO_ERROR_NOT_FOUND))
-			{
-				uri = g_file_get_uri (node->file);
-				g_warning ("Could not get info for %s: %s", uri, error->message);
-				g_free (uri);
-			}
-			g_error_free (error);
-
-			return;
-		}
-
-		free_info = TRUE;
-	}
+	/* The info may replace provisional info, see provisional_file_info_new() */
+	node->flags &= ~(GEDIT_FILE_BROWSER_STORE_FLAG_IS_HIDDEN |
+			 GEDIT_FILE_BROWSER_STORE_FLAG_IS_TEXT);
 
 	if (g_file_info_get_is_hidden (info) || g_file_info_get_is_backup (info))
 	{
@@ -2136,9 +2428,6 @@ file_browser_node_set_from_info (GeditFileBrowserStore *model,
 
 	model_recomposite_icon_real (model, node, info);
 
-	if (free_info)
-		g_object_unref (info);
-
 	if (isadded)
 	{
 		path = gedit_file_browser_store_get_path_real (model, node);
@@ -2153,26 +2442,40 @@ file_browser_node_set_from_info (GeditFileBrowserStore *model,
 	}
 }
 
-static FileBrowserNode *
-node_list_contains_file (GSList *children,
-			 GFile  *file)
+/* Info to show a node with until its actual info arrives, guessed from
+ * the name of the file the way GIO does it for local files.
+ */
+static GFileInfo *
+provisional_file_info_new (GFile     *file,
+			   GFileType  type)
 {
-	GSList *item;
+	GFileInfo *info;
+	gchar *basename;
+	gchar *content_type;
+	GIcon *icon;
 
-	for (item = children; item; item = item->next)
-	{
-		FileBrowserNode *node;
+	info = g_file_info_new ();
+	basename = g_file_get_basename (file);
 
-		node = (FileBrowserNode *) (item->data);
+	if (type == G_FILE_TYPE_DIRECTORY)
+		content_type = g_strdup ("inode/directory");
+	else
+		content_type = g_content_type_guess (basename, NULL, 0, NULL);
 
-		if (node->file != NULL &&
-		    g_file_equal (node->file, file))
-		{
-			return node;
-		}
-	}
+	icon = g_content_type_get_icon (content_type);
 
-	return NULL;
+	g_file_info_set_file_type (info, type);
+	g_file_info_set_name (info, basename);
+	g_file_info_set_is_hidden (info, basename[0] == '.');
+	g_file_info_set_is_backup (info, g_str_has_suffix (basename, "~"));
+	g_file_info_set_content_type (info, content_type);
+	g_file_info_set_icon (info, icon);
+
+	g_object_unref (icon);
+	g_free (content_type);
+	g_free (basename);
+
+	return info;
 }
 
 static FileBrowserNode *
@@ -2182,56 +2485,28 @@ model_add_node_from_file (GeditFileBrowserStore *model,
 			  GFileInfo             *info)
 {
 	FileBrowserNode *node;
-	gboolean free_info = FALSE;
-	GError *error = NULL;
 
-	if ((node = node_list_contains_file (FILE_BROWSER_NODE_DIR (parent)->children, file)) == NULL)
+	if ((node = dir_lookup_file (parent, file)) == NULL)
 	{
-		if (info == NULL)
-		{
-			info = g_file_query_info (file,
-						  STANDARD_ATTRIBUTE_TYPES,
-						  G_FILE_QUERY_INFO_NONE,
-						  NULL,
-						  &error);
-			free_info = TRUE;
-		}
-
-		if (!info)
-		{
-			g_warning ("Error querying file info: %s", error->message);
-			g_error_free (error);
-
-			/* FIXME: What to do now then... */
-			node = file_browser_node_new (file, parent);
-		}
-		else if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
-		{
+		if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
 			node = file_browser_node_dir_new (model, file, parent);
-		}
 		else
-		{
 			node = file_browser_node_new (file, parent);
-		}
 
 		file_browser_node_set_from_info (model, node, info, FALSE);
 		model_add_node (model, node, parent);
-
-		if (info && free_info)
-			g_object_unref (info);
 	}
 
 	return node;
 }
 
-/* We pass in a copy of the list of parent->children so that we do
- * not have to check if a file already exists among the ones we just
- * added */
-static void
-model_add_nodes_from_files (GeditFileBrowserStore *model,
-			    FileBrowserNode       *parent,
-			    GSList                *original_children,
-			    GList                 *files)
+/* Creates the nodes for the files that are not children of parent yet,
+ * without adding them. This consumes the infos in files.
+ */
+static GSList *
+model_nodes_from_files (GeditFileBrowserStore *model,
+			FileBrowserNode       *parent,
+			GList                 *files)
 {
 	GList *item;
 	GSList *nodes = NULL;
@@ -2267,7 +2542,7 @@ model_add_nodes_from_files (GeditFileBrowserStore *model,
 		}
 
 		file = g_file_get_child (parent->file, name);
-		node = node_list_contains_file (original_children, file);
+		node = dir_lookup_file (parent, file);
 		if (node == NULL)
 		{
 			if (type == G_FILE_TYPE_DIRECTORY)
@@ -2284,35 +2559,380 @@ model_add_nodes_from_files (GeditFileBrowserStore *model,
 		g_object_unref (info);
 	}
 
+	return nodes;
+}
+
+static void
+model_add_nodes_from_files (GeditFileBrowserStore *model,
+			    FileBrowserNode       *parent,
+			    GList                 *files)
+{
+	GSList *nodes;
+
+	nodes = model_nodes_from_files (model, parent, files);
+
 	if (nodes)
 		model_add_nodes_batch (model, nodes, parent);
 }
 
+static void
+model_node_set_info (GeditFileBrowserStore *model,
+		     FileBrowserNode       *node,
+		     GFileInfo             *info)
+{
+	GtkTreePath *path;
+	GtkTreeIter iter;
+
+	file_browser_node_set_from_info (model, node, info, node_in_tree (model, node));
+
+	if (model_node_visibility (model, node))
+	{
+		iter.user_data = node;
+		path = gedit_file_browser_store_get_path_real (model, node);
+		row_changed (model, &path, &iter);
+		gtk_tree_path_free (path);
+	}
+}
+
+static void
+dir_add_created_info (FileBrowserNodeDir *dir,
+		      GFile              *file,
+		      GFileInfo          *info)
+{
+	if (dir->created_infos == NULL)
+	{
+		dir->created_infos = g_hash_table_new_full (g_file_hash,
+							    (GEqualFunc) g_file_equal,
+							    g_object_unref,
+							    g_object_unref);
+	}
+
+	g_hash_table_replace (dir->created_infos,
+			      g_object_ref (file),
+			      g_object_ref (info));
+
+	dir_schedule_monitor_flush (dir);
+}
+
+static void
+model_apply_info (GeditFileBrowserStore *model,
+		  GFile                 *file,
+		  GFileInfo             *info,
+		  gboolean               create)
+{
+	FileBrowserNode *node;
+	FileBrowserNode *parent = NULL;
+	GFile *parent_file;
+	gboolean is_dir;
+
+	if (model->priv->root == NULL)
+		return;
+
+	node = model_find_node (model, NULL, file);
+
+	if (node != NULL)
+	{
+		is_dir = g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY;
+
+		if (is_dir == (NODE_IS_DIR (node) != 0))
+		{
+			model_node_set_info (model, node, info);
+			return;
+		}
+
+		/* The file was replaced by one of the other type, e.g. after
+		 * a deletion and a creation were coalesced. A directory node
+		 * is a different structure with children and a monitor, so
+		 * replace the node instead of updating it.
+		 */
+		parent = node->parent;
+
+		if (parent == NULL)
+			return;
+
+		model_remove_node (model, node, NULL, TRUE);
+	}
+	else
+	{
+		if (!create)
+			return;
+
+		parent_file = g_file_get_parent (file);
+
+		if (parent_file != NULL)
+		{
+			parent = model_find_node (model, NULL, parent_file);
+			g_object_unref (parent_file);
+		}
+	}
+
+	/* The directory may have been unloaded in the meantime. Otherwise
+	 * the node is added with the other files created around the same
+	 * time, see dir_flush_monitor_events().
+	 */
+	if (parent != NULL && NODE_IS_DIR (parent) && NODE_LOADED (parent))
+		dir_add_created_info (FILE_BROWSER_NODE_DIR (parent), file, info);
+}
+
+static void
+model_query_info_cb (GFile        *file,
+		     GAsyncResult *result,
+		     InfoQuery    *query)
+{
+	GeditFileBrowserStore *model;
+	GFileInfo *info;
+	GError *error = NULL;
+	gchar *uri;
+
+	info = g_file_query_info_finish (file, result, &error);
+
+	/* The model has been finalized */
+	if (g_cancellable_is_cancelled (query->cancellable))
+	{
+		g_clear_object (&info);
+		g_clear_error (&error);
+		info_query_free (query);
+		return;
+	}
+
+	model = query->model;
+	model->priv->n_info_running--;
+
+	if (g_hash_table_lookup (model->priv->info_queries, file) == query)
+		g_hash_table_remove (model->priv->info_queries, file);
+
+	if (info == NULL)
+	{
+		if (!query->stale &&
+		    !g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
+		{
+			uri = g_file_get_uri (file);
+			g_warning ("Could not get info for %s: %s", uri, error->message);
+			g_free (uri);
+		}
+
+		g_error_free (error);
+	}
+	else
+	{
+		if (!query->stale)
+			model_apply_info (model, file, info, query->create);
+
+		g_object_unref (info);
+	}
+
+	info_query_free (query);
+	model_start_info_queries (model);
+}
+
+static void
+model_start_info_queries (GeditFileBrowserStore *model)
+{
+	InfoQuery *query;
+
+	while (model->priv->n_info_running < MAX_INFO_QUERIES &&
+	       (query = g_queue_pop_head (&model->priv->info_queue)) != NULL)
+	{
+		if (query->stale)
+		{
+			info_query_free (query);
+			continue;
+		}
+
+		query->running = TRUE;
+		model->priv->n_info_running++;
+
+		g_file_query_info_async (query->file,
+					 STANDARD_ATTRIBUTE_TYPES,
+					 G_FILE_QUERY_INFO_NONE,
+					 G_PRIORITY_DEFAULT,
+					 query->cancellable,
+					 (GAsyncReadyCallback) model_query_info_cb,
+					 query);
+	}
+}
+
+/* Queries the info of file asynchronously and applies it to its node. If
+ * create is TRUE and there is no node for the file when the info arrives,
+ * a node is added to the node of its parent directory.
+ */
+static void
+model_query_info (GeditFileBrowserStore *model,
+		  GFile                 *file,
+		  gboolean               create)
+{
+	InfoQuery *query;
+
+	query = g_hash_table_lookup (model->priv->info_queries, file);
+
+	if (query != NULL)
+	{
+		if (!query->running)
+		{
+			query->create |= create;
+			return;
+		}
+
+		/* The file may have changed after the running query
+		 * read it, so query it again.
+		 */
+		query->stale = TRUE;
+		create |= query->create;
+	}
+
+	query = g_slice_new0 (InfoQuery);
+	query->model = model;
+	query->file = g_object_ref (file);
+	query->cancellable = g_object_ref (model->priv->info_cancellable);
+	query->create = create;
+
+	g_hash_table_insert (model->priv->info_queries, g_object_ref (file), query);
+	g_queue_push_tail (&model->priv->info_queue, query);
+
+	model_start_info_queries (model);
+}
+
+static void
+model_forget_info_query (GeditFileBrowserStore *model,
+			 GFile                 *file)
+{
+	InfoQuery *query;
+
+	query = g_hash_table_lookup (model->priv->info_queries, file);
+
+	if (query != NULL)
+	{
+		/* Queued queries are dropped when they come up */
+		query->stale = TRUE;
+		g_hash_table_remove (model->priv->info_queries, file);
+	}
+}
+
 static FileBrowserNode *
 model_add_node_from_dir (GeditFileBrowserStore *model,
 			 FileBrowserNode       *parent,
 			 GFile                 *file)
 {
 	FileBrowserNode *node;
+	GFileInfo *info;
 
 	/* Check if it already exists */
-	if ((node = node_list_contains_file (FILE_BROWSER_NODE_DIR (parent)->children, file)) == NULL)
+	if ((node = dir_lookup_file (parent, file)) == NULL)
 	{
 		node = file_browser_node_dir_new (model, file, parent);
-		file_browser_node_set_from_info (model, node, NULL, FALSE);
+
+		info = provisional_file_info_new (file, G_FILE_TYPE_DIRECTORY);
+		file_browser_node_set_from_info (model, node, info, FALSE);
+		g_object_unref (info);
 
 		if (node->name == NULL)
 			file_browser_node_set_name (node);
 
-		if (node->icon == NULL)
-			node->icon = gedit_file_browser_utils_pixbuf_from_theme ("folder-symbolic", GTK_ICON_SIZE_MENU);
-
 		model_add_node (model, node, parent);
+		model_query_info (model, file, FALSE);
 	}
 
 	return node;
 }
 
+/* Applies at most MONITOR_EVENTS_PER_FLUSH of the pending events and
+ * created files of dir, and keeps running until there are none left.
+ */
+static gboolean
+dir_flush_monitor_events (FileBrowserNodeDir *dir)
+{
+	FileBrowserNode *parent = (FileBrowserNode *) dir;
+	GeditFileBrowserStore *model = dir->model;
+	GHashTableIter iter;
+	gpointer key;
+	gpointer value;
+	GSList *deleted = NULL;
+	GList *infos = NULL;
+	FileBrowserNode *node;
+	GFile *file;
+	gint budget = MONITOR_EVENTS_PER_FLUSH;
+
+	if (dir->monitor_events != NULL)
+	{
+		g_hash_table_iter_init (&iter, dir->monitor_events);
+
+		while (budget > 0 && g_hash_table_iter_next (&iter, &key, &value))
+		{
+			file = G_FILE (key);
+
+			switch (GPOINTER_TO_INT (value))
+			{
+				case G_FILE_MONITOR_EVENT_DELETED:
+					node = dir_lookup_file (parent, file);
+
+					if (node != NULL)
+						deleted = g_slist_prepend (deleted, node);
+					break;
+				case G_FILE_MONITOR_EVENT_CREATED:
+					/* The node is added when the info
+					 * arrives, unless the file is gone
+					 * by then.
+					 */
+					model_query_info (model, file, TRUE);
+					break;
+				default:
+					if (dir_lookup_file (parent, file) != NULL)
+						model_query_info (model, file, FALSE);
+					break;
+			}
+
+			g_hash_table_iter_remove (&iter);
+			--budget;
+		}
+	}
+
+	if (deleted != NULL)
+	{
+		model_remove_nodes_batch (model, parent, deleted);
+		g_slist_free (deleted);
+	}
+
+	if (dir->created_infos != NULL)
+	{
+		g_hash_table_iter_init (&iter, dir->created_infos);
+
+		while (budget > 0 && g_hash_table_iter_next (&iter, &key, &value))
+		{
+			infos = g_list_prepend (infos, g_object_ref (value));
+
+			g_hash_table_iter_remove (&iter);
+			--budget;
+		}
+	}
+
+	if (infos != NULL)
+	{
+		/* This consumes the infos */
+		model_add_nodes_from_files (model, parent, infos);
+		g_list_free (infos);
+	}
+
+	if ((dir->monitor_events != NULL && g_hash_table_size (dir->monitor_events) > 0) ||
+	    (dir->created_infos != NULL && g_hash_table_size (dir->created_infos) > 0))
+	{
+		return G_SOURCE_CONTINUE;
+	}
+
+	dir->monitor_flush_id = 0;
+	return G_SOURCE_REMOVE;
+}
+
+static void
+dir_schedule_monitor_flush (FileBrowserNodeDir *dir)
+{
+	if (dir->monitor_flush_id == 0)
+	{
+		dir->monitor_flush_id = g_timeout_add (MONITOR_EVENTS_DELAY,
+						       (GSourceFunc) dir_flush_monitor_events,
+						       dir);
+	}
+}
+
 static void
 on_directory_monitor_event (GFileMonitor      *monitor,
 			    GFile             *file,
@@ -2320,35 +2940,203 @@ on_directory_monitor_event (GFileMonitor      *monitor,
 			    GFileMonitorEvent  event_type,
 			    FileBrowserNode   *parent)
 {
-	FileBrowserNode *node;
 	FileBrowserNodeDir *dir = FILE_BROWSER_NODE_DIR (parent);
+	GFileMonitorEvent previous;
+	gpointer value;
 
 	switch (event_type)
 	{
 		case G_FILE_MONITOR_EVENT_DELETED:
-			node = node_list_contains_file (dir->children, file);
+			/* A pending result would bring the file back */
+			model_forget_info_query (dir->model, file);
 
-			if (node != NULL)
-				model_remove_node (dir->model, node, NULL, TRUE);
+			if (dir->created_infos != NULL)
+				g_hash_table_remove (dir->created_infos, file);
 			break;
 		case G_FILE_MONITOR_EVENT_CREATED:
-			if (g_file_query_exists (file, NULL))
-				model_add_node_from_file (dir->model, parent, file, NULL);
-
 			break;
-		default:
+		case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+		case G_FILE_MONITOR_EVENT_ATTRIBUTE_CHANGED:
+			event_type = G_FILE_MONITOR_EVENT_CHANGED;
 			break;
+		default:
+			return;
+	}
+
+	/* Events are coalesced per file: a deletion or a creation replaces
+	 * any previous event, and a change does not replace a creation. A
+	 * change after a deletion means the file is back.
+	 */
+	if (dir->monitor_events == NULL)
+	{
+		dir->monitor_events = g_hash_table_new_full (g_file_hash,
+							     (GEqualFunc) g_file_equal,
+							     g_object_unref,
+							     NULL);
 	}
+	else if (event_type == G_FILE_MONITOR_EVENT_CHANGED &&
+		 g_hash_table_lookup_extended (dir->monitor_events, file, NULL, &value))
+	{
+		previous = GPOINTER_TO_INT (value);
+
+		if (previous == G_FILE_MONITOR_EVENT_CREATED ||
+		    previous == G_FILE_MONITOR_EVENT_CHANGED)
+		{
+			return;
+		}
+
+		event_type = G_FILE_MONITOR_EVENT_CREATED;
+	}
+
+	g_hash_table_replace (dir->monitor_events,
+			      g_object_ref (file),
+			      GINT_TO_POINTER (event_type));
+
+	dir_schedule_monitor_flush (dir);
 }
 
 static void
 async_node_free (AsyncNode *async)
 {
 	g_object_unref (async->cancellable);
-	g_slist_free (async->original_children);
 	g_slice_free (AsyncNode, async);
 }
 
+static void
+model_end_directory_load (FileBrowserNodeDir *dir)
+{
+	FileBrowserNode *parent = (FileBrowserNode *)dir;
+
+	/* We're done loading */
+	g_object_unref (dir->cancellable);
+	dir->cancellable = NULL;
+	dir->enumerated = FALSE;
+
+/*
+ * FIXME: This is temporarly, it is a bug in gio:
+ * http://bugzilla.gnome.org/show_bug.cgi?id=565924
+ */
+#ifndef G_OS_WIN32
+	if (g_file_is_native (parent->file) && dir->monitor == NULL)
+	{
+		dir->monitor = g_file_monitor_directory (parent->file,
+							 G_FILE_MONITOR_NONE,
+							 NULL,
+							 NULL);
+		if (dir->monitor != NULL)
+		{
+			g_signal_connect (dir->monitor,
+					  "changed",
+					  G_CALLBACK (on_directory_monitor_event),
+					  parent);
+		}
+	}
+#endif
+
+	model_check_dummy (dir->model, parent);
+	model_end_loading (dir->model, parent);
+}
+
+/* Inserts the pending children of dir for at most DIRECTORY_INSERT_BUDGET
+ * microseconds, and keeps going from an idle until there are none left,
+ * letting the tree view draw in between. They are inserted in sort order,
+ * so the rows at the top of the view come first.
+ */
+static gboolean
+dir_insert_pending_children (FileBrowserNodeDir *dir)
+{
+	FileBrowserNode *parent = (FileBrowserNode *)dir;
+	GeditFileBrowserStore *model = dir->model;
+	GSequenceIter *item;
+	FileBrowserNode *node;
+	gint64 start;
+	guint count = 0;
+
+	start = g_get_monotonic_time ();
+
+	model_check_dummy (model, parent);
+
+	while (!g_sequence_iter_is_end (item = g_sequence_get_begin_iter (dir->pending)))
+	{
+		node = (FileBrowserNode *) g_sequence_get (item);
+		g_sequence_remove (item);
+
+		/* Added by someone else in the meantime */
+		if (dir_lookup_file (parent, node->file) != NULL)
+		{
+			file_browser_node_free (model, node);
+			continue;
+		}
+
+		/* The filter may have changed since the node was created */
+		model_node_update_filtered (model, node);
+		dir_insert_child (model, parent, node);
+
+		if (model_node_visibility (model, parent) &&
+		    model_node_visibility (model, node))
+		{
+			GtkTreeIter iter;
+			GtkTreePath *path;
+
+			iter.user_data = node;
+			path = gedit_file_browser_store_get_path_real (model, node);
+
+			/* Emit row inserted */
+			row_inserted (model, &path, &iter);
+			gtk_tree_path_free (path);
+		}
+
+		model_check_dummy (model, node);
+
+		if ((++count % 32) == 0 &&
+		    g_get_monotonic_time () - start > DIRECTORY_INSERT_BUDGET)
+		{
+			break;
+		}
+	}
+
+	model_check_dummy (model, parent);
+
+	if (!g_sequence_iter_is_end (g_sequence_get_begin_iter (dir->pending)))
+	{
+		if (dir->pending_id == 0)
+		{
+			dir->pending_id = g_idle_add ((GSourceFunc) dir_insert_pending_children,
+						      dir);
+		}
+
+		return G_SOURCE_CONTINUE;
+	}
+
+	dir->pending_id = 0;
+
+	if (dir->enumerated)
+		model_end_directory_load (dir);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+dir_queue_pending_children (FileBrowserNodeDir *dir,
+			    GSList             *nodes)
+{
+	GSList *item;
+
+	for (item = nodes; item; item = item->next)
+	{
+		g_sequence_insert_sorted (dir->pending,
+					  item->data,
+					  compare_nodes,
+					  dir->model);
+	}
+
+	g_slist_free (nodes);
+
+	/* Show the first rows right away, the rest follows from an idle */
+	if (dir->pending_id == 0)
+		dir_insert_pending_children (dir);
+}
+
 static void
 model_iterate_next_files_cb (GFileEnumerator *enumerator,
 			     GAsyncResult    *result,
@@ -2358,44 +3146,23 @@ model_iterate_next_files_cb (GFileEnumerator *enumerator,
 	GError *error = NULL;
 	FileBrowserNodeDir *dir = async->dir;
 	FileBrowserNode *parent = (FileBrowserNode *)dir;
+	gint64 elapsed;
 
 	files = g_file_enumerator_next_files_finish (enumerator, result, &error);
 
 	if (files == NULL)
 	{
 		g_file_enumerator_close (enumerator, NULL, NULL);
-		g_object_unref (enumerator);
-		async_node_free (async);
-
-		if (!error)
-		{
-			/* We're done loading */
-			g_object_unref (dir->cancellable);
-			dir->cancellable = NULL;
-
-/*
- * FIXME: This is temporarly, it is a bug in gio:
- * http://bugzilla.gnome.org/show_bug.cgi?id=565924
- */
-#ifndef G_OS_WIN32
-			if (g_file_is_native (parent->file) && dir->monitor == NULL)
-			{
-				dir->monitor = g_file_monitor_directory (parent->file,
-									 G_FILE_MONITOR_NONE,
-									 NULL,
-									 NULL);
-				if (dir->monitor != NULL)
-				{
-					g_signal_connect (dir->monitor,
-							  "changed",
-							  G_CALLBACK (on_directory_monitor_event),
-							  parent);
-				}
-			}
-#endif
+		g_object_unref (enumerator);
+		async_node_free (async);
+
+		if (!error)
+		{
+			/* Wait for the pending children, if any */
+			dir->enumerated = TRUE;
 
-			model_check_dummy (dir->model, parent);
-			model_end_loading (dir->model, parent);
+			if (g_sequence_iter_is_end (g_sequence_get_begin_iter (dir->pending)))
+				model_end_directory_load (dir);
 		}
 		else
 		{
@@ -2423,10 +3190,27 @@ model_iterate_next_files_cb (GFileEnumerator *enumerator,
 	}
 	else
 	{
-		model_add_nodes_from_files (dir->model, parent, async->original_children, files);
+		/* Ask for more at once while the enumerator keeps up, and
+		 * for less when it is slow, so that the first rows still
+		 * show quickly.
+		 */
+		elapsed = g_get_monotonic_time () - async->request_time;
+
+		if (elapsed < DIRECTORY_LOAD_TARGET_LATENCY / 2 &&
+		    g_list_length (files) >= (guint) async->batch_size)
+		{
+			async->batch_size = MIN (async->batch_size * 2, DIRECTORY_LOAD_MAX_ITEMS);
+		}
+		else if (elapsed > DIRECTORY_LOAD_TARGET_LATENCY)
+		{
+			async->batch_size = MAX (async->batch_size / 2, DIRECTORY_LOAD_MIN_ITEMS);
+		}
 
-		g_list_free (files);
+		/* Request the next files while these are being inserted */
 		next_files_async (enumerator, async);
+
+		dir_queue_pending_children (dir, model_nodes_from_files (dir->model, parent, files));
+		g_list_free (files);
 	}
 }
 
@@ -2434,8 +3218,10 @@ static void
 next_files_async (GFileEnumerator *enumerator,
 		  AsyncNode       *async)
 {
+	async->request_time = g_get_monotonic_time ();
+
 	g_file_enumerator_next_files_async (enumerator,
-					    DIRECTORY_LOAD_ITEMS_PER_CALLBACK,
+					    async->batch_size,
 					    G_PRIORITY_DEFAULT,
 					    async->cancellable,
 					    (GAsyncReadyCallback)model_iterate_next_files_cb,
@@ -2503,7 +3289,7 @@ model_load_directory (GeditFileBrowserStore *model,
 	async = g_slice_new (AsyncNode);
 	async->dir = dir;
 	async->cancellable = g_object_ref (dir->cancellable);
-	async->original_children = g_slist_copy (dir->children);
+	async->batch_size = DIRECTORY_LOAD_ITEMS_PER_CALLBACK;
 
 	/* Start loading async */
 	g_file_enumerate_children_async (node->file,
@@ -2544,7 +3330,7 @@ model_fill (GeditFileBrowserStore  *model,
 {
 	gboolean free_path = FALSE;
 	GtkTreeIter iter = {0,};
-	GSList *item;
+	GSequenceIter *item;
 	FileBrowserNode *child;
 
 	if (node == NULL)
@@ -2580,9 +3366,11 @@ model_fill (GeditFileBrowserStore  *model,
 		/* Go to the first child */
 		gtk_tree_path_down (*path);
 
-		for (item = FILE_BROWSER_NODE_DIR (node)->children; item; item = item->next)
+		for (item = g_sequence_get_begin_iter (FILE_BROWSER_NODE_DIR (node)->children);
+		     !g_sequence_iter_is_end (item);
+		     item = g_sequence_iter_next (item))
 		{
-			child = (FileBrowserNode *) (item->data);
+			child = (FileBrowserNode *) g_sequence_get (item);
 
 			if (model_node_visibility (model, child))
 			{
@@ -2610,9 +3398,10 @@ set_virtual_root_from_node (GeditFileBrowserStore *model,
 	FileBrowserNode *next;
 	FileBrowserNode *prev;
 	FileBrowserNode *check;
-	FileBrowserNodeDir *dir;
 	GSList *item;
 	GSList *copy;
+	GSequenceIter *child;
+	GSequenceIter *grandchild;
 	GtkTreePath *empty = NULL;
 
 	prev = node;
@@ -2621,8 +3410,7 @@ set_virtual_root_from_node (GeditFileBrowserStore *model,
 	/* Free all the nodes below that we don't need in cache */
 	while (prev != model->priv->root)
 	{
-		dir = FILE_BROWSER_NODE_DIR (next);
-		copy = g_slist_copy (dir->children);
+		copy = dir_copy_children (next);
 
 		for (item = copy; item; item = item->next)
 		{
@@ -2642,7 +3430,7 @@ set_virtual_root_from_node (GeditFileBrowserStore *model,
 			else if (check != prev)
 			{
 				/* Only free when the node is not in the chain */
-				dir->children = g_slist_remove (dir->children, check);
+				dir_remove_child (next, check);
 				file_browser_node_free (model, check);
 			}
 		}
@@ -2656,24 +3444,29 @@ set_virtual_root_from_node (GeditFileBrowserStore *model,
 	}
 
 	/* Free all the nodes up that we don't need in cache */
-	for (item = FILE_BROWSER_NODE_DIR (node)->children; item; item = item->next)
+	for (child = g_sequence_get_begin_iter (FILE_BROWSER_NODE_DIR (node)->children);
+	     !g_sequence_iter_is_end (child);
+	     child = g_sequence_iter_next (child))
 	{
-		check = (FileBrowserNode *) (item->data);
+		check = (FileBrowserNode *) g_sequence_get (child);
 
 		if (NODE_IS_DIR (check))
 		{
-			for (copy = FILE_BROWSER_NODE_DIR (check)->children; copy; copy = copy->next)
+			for (grandchild = g_sequence_get_begin_iter (FILE_BROWSER_NODE_DIR (check)->children);
+			     !g_sequence_iter_is_end (grandchild);
+			     grandchild = g_sequence_iter_next (grandchild))
 			{
 				file_browser_node_free_children (model,
-								 (FileBrowserNode*) (copy->data));
+								 (FileBrowserNode*) g_sequence_get (grandchild));
 				file_browser_node_unload (model,
-							  (FileBrowserNode*) (copy->data),
+							  (FileBrowserNode*) g_sequence_get (grandchild),
 							  FALSE);
 			}
 		}
 		else if (NODE_IS_DUMMY (check))
 		{
 			check->flags |= GEDIT_FILE_BROWSER_STORE_FLAG_IS_HIDDEN;
+			node_sync_visible (check);
 		}
 	}
 
@@ -2723,27 +3516,39 @@ model_find_node_children (GeditFileBrowserStore *model,
 			  FileBrowserNode       *parent,
 			  GFile                 *file)
 {
-	FileBrowserNodeDir *dir;
 	FileBrowserNode *child;
-	FileBrowserNode *result;
-	GSList *children;
+	GFile *child_file;
+	gchar *relative;
+	gchar *p;
 
 	if (!NODE_IS_DIR (parent))
 		return NULL;
 
-	dir = FILE_BROWSER_NODE_DIR (parent);
+	relative = g_file_get_relative_path (parent->file, file);
 
-	for (children = dir->children; children; children = children->next)
+	if (relative == NULL)
+		return NULL;
+
+	/* Only the first component names a child of parent */
+	for (p = relative; *p != '\0'; ++p)
 	{
-		child = (FileBrowserNode *)(children->data);
+		if (G_IS_DIR_SEPARATOR (*p))
+		{
+			*p = '\0';
+			break;
+		}
+	}
 
-		result = model_find_node (model, child, file);
+	child_file = g_file_get_child (parent->file, relative);
+	child = dir_lookup_file (parent, child_file);
 
-		if (result)
-			return result;
-	}
+	g_object_unref (child_file);
+	g_free (relative);
 
-	return NULL;
+	if (child == NULL)
+		return NULL;
+
+	return model_find_node (model, child, file);
 }
 
 static FileBrowserNode *
@@ -2959,41 +3764,43 @@ gedit_file_browser_store_new (GFile *root)
 	                                               NULL));
 }
 
-void
-gedit_file_browser_store_set_value (GeditFileBrowserStore *tree_model,
-				    GtkTreeIter           *iter,
-				    gint                   column,
-				    GValue                *value)
+/* Returns whether the value of the node changed */
+static gboolean
+model_node_set_value (GeditFileBrowserStore *model,
+		      FileBrowserNode       *node,
+		      gint                   column,
+		      const GValue          *value)
 {
 	gpointer data;
-	FileBrowserNode *node;
-	GtkTreePath *path;
-
-	g_return_if_fail (GEDIT_IS_FILE_BROWSER_STORE (tree_model));
-	g_return_if_fail (iter != NULL);
-	g_return_if_fail (iter->user_data != NULL);
-
-	node = (FileBrowserNode *) (iter->user_data);
 
 	if (column == GEDIT_FILE_BROWSER_STORE_COLUMN_MARKUP)
 	{
-		g_return_if_fail (G_VALUE_HOLDS_STRING (value));
+		g_return_val_if_fail (G_VALUE_HOLDS_STRING (value), FALSE);
 
 		data = g_value_dup_string (value);
 
 		if (!data)
-			data = g_strdup (node->name);
+			data = g_markup_escape_text (node->name, -1);
+
+		if (g_strcmp0 (node->markup, data) == 0)
+		{
+			g_free (data);
+			return FALSE;
+		}
 
 		g_free (node->markup);
 		node->markup = data;
 	}
 	else if (column == GEDIT_FILE_BROWSER_STORE_COLUMN_EMBLEM)
 	{
-		g_return_if_fail (G_VALUE_HOLDS_OBJECT (value));
+		g_return_val_if_fail (G_VALUE_HOLDS_OBJECT (value), FALSE);
 
 		data = g_value_get_object (value);
 
-		g_return_if_fail (GDK_IS_PIXBUF (data) || data == NULL);
+		g_return_val_if_fail (GDK_IS_PIXBUF (data) || data == NULL, FALSE);
+
+		if (node->emblem == data)
+			return FALSE;
 
 		if (node->emblem)
 			g_object_unref (node->emblem);
@@ -3003,15 +3810,35 @@ gedit_file_browser_store_set_value (GeditFileBrowserStore *tree_model,
 		else
 			node->emblem = NULL;
 
-		model_recomposite_icon (tree_model, iter);
+		model_recomposite_icon_real (model, node, NULL);
 	}
 	else
 	{
-		g_return_if_fail (column == GEDIT_FILE_BROWSER_STORE_COLUMN_MARKUP ||
-		                  column == GEDIT_FILE_BROWSER_STORE_COLUMN_EMBLEM);
+		g_return_val_if_fail (column == GEDIT_FILE_BROWSER_STORE_COLUMN_MARKUP ||
+		                      column == GEDIT_FILE_BROWSER_STORE_COLUMN_EMBLEM,
+		                      FALSE);
 	}
 
-	if (model_node_visibility (tree_model, node))
+	return TRUE;
+}
+
+void
+gedit_file_browser_store_set_value (GeditFileBrowserStore *tree_model,
+				    GtkTreeIter           *iter,
+				    gint                   column,
+				    GValue                *value)
+{
+	FileBrowserNode *node;
+	GtkTreePath *path;
+
+	g_return_if_fail (GEDIT_IS_FILE_BROWSER_STORE (tree_model));
+	g_return_if_fail (iter != NULL);
+	g_return_if_fail (iter->user_data != NULL);
+
+	node = (FileBrowserNode *) (iter->user_data);
+
+	if (model_node_set_value (tree_model, node, column, value) &&
+	    model_node_visibility (tree_model, node))
 	{
 		path = gedit_file_browser_store_get_path (GTK_TREE_MODEL (tree_model),
 							  iter);
@@ -3020,6 +3847,69 @@ gedit_file_browser_store_set_value (GeditFileBrowserStore *tree_model,
 	}
 }
 
+/**
+ * gedit_file_browser_store_set_values:
+ * @model: the #GeditFileBrowserStore
+ * @column: %GEDIT_FILE_BROWSER_STORE_COLUMN_MARKUP or
+ * %GEDIT_FILE_BROWSER_STORE_COLUMN_EMBLEM
+ * @locations: the files to set the values of
+ * @values: the values, one per location
+ * @n_values: the number of values
+ *
+ * Sets the value of @column for many files at once. The locations not in
+ * the model are skipped, and a row is only reported as changed once, and
+ * only if its value did change.
+ */
+void
+gedit_file_browser_store_set_values (GeditFileBrowserStore  *model,
+				     gint                    column,
+				     GFile                 **locations,
+				     const GValue           *values,
+				     guint                   n_values)
+{
+	GHashTable *changed;
+	GHashTableIter hiter;
+	gpointer key;
+	FileBrowserNode *node;
+	GtkTreeIter iter;
+	GtkTreePath *path;
+	guint i;
+
+	g_return_if_fail (GEDIT_IS_FILE_BROWSER_STORE (model));
+	g_return_if_fail (locations != NULL || n_values == 0);
+	g_return_if_fail (values != NULL || n_values == 0);
+
+	changed = g_hash_table_new (NULL, NULL);
+
+	for (i = 0; i < n_values; i++)
+	{
+		node = model_find_node (model, NULL, locations[i]);
+
+		if (node == NULL || NODE_IS_DUMMY (node))
+			continue;
+
+		if (model_node_set_value (model, node, column, &values[i]) &&
+		    model_node_visibility (model, node))
+		{
+			g_hash_table_add (changed, node);
+		}
+	}
+
+	g_hash_table_iter_init (&hiter, changed);
+
+	while (g_hash_table_iter_next (&hiter, &key, NULL))
+	{
+		node = (FileBrowserNode *) key;
+		iter.user_data = node;
+
+		path = gedit_file_browser_store_get_path_real (model, node);
+		row_changed (model, &path, &iter);
+		gtk_tree_path_free (path);
+	}
+
+	g_hash_table_destroy (changed);
+}
+
 GeditFileBrowserStoreResult
 gedit_file_browser_store_set_virtual_root (GeditFileBrowserStore *model,
 					   GtkTreeIter           *iter)
@@ -3286,7 +4176,7 @@ _gedit_file_browser_store_iter_collapsed (GeditFileBrowserStore *model,
 					  GtkTreeIter           *iter)
 {
 	FileBrowserNode *node;
-	GSList *item;
+	GSequenceIter *item;
 
 	g_return_if_fail (GEDIT_IS_FILE_BROWSER_STORE (model));
 	g_return_if_fail (iter != NULL);
@@ -3298,9 +4188,11 @@ _gedit_file_browser_store_iter_collapsed (GeditFileBrowserStore *model,
 	{
 		/* Unload children of the children, keeping 1 depth in cache */
 
-		for (item = FILE_BROWSER_NODE_DIR (node)->children; item; item = item->next)
+		for (item = g_sequence_get_begin_iter (FILE_BROWSER_NODE_DIR (node)->children);
+		     !g_sequence_iter_is_end (item);
+		     item = g_sequence_iter_next (item))
 		{
-			node = (FileBrowserNode *) (item->data);
+			node = (FileBrowserNode *) g_sequence_get (item);
 
 			if (NODE_IS_DIR (node) && NODE_LOADED (node))
 			{
@@ -3357,35 +4249,16 @@ gedit_file_browser_store_set_binary_patterns (GeditFileBrowserStore  *model,
 {
 	g_return_if_fail (GEDIT_IS_FILE_BROWSER_STORE (model));
 
-	if (model->priv->binary_patterns != NULL)
-	{
-		g_strfreev (model->priv->binary_patterns);
-		g_ptr_array_unref (model->priv->binary_pattern_specs);
-	}
+	g_strfreev (model->priv->binary_patterns);
+	gedit_file_browser_glob_set_free (model->priv->binary_glob_set);
 
 	model->priv->binary_patterns = g_strdupv ((gchar **) binary_patterns);
 
+	/* All the patterns are matched at once */
 	if (binary_patterns == NULL)
-	{
-		model->priv->binary_pattern_specs = NULL;
-	}
+		model->priv->binary_glob_set = NULL;
 	else
-	{
-		gint i;
-		gssize n_patterns;
-
-		n_patterns = g_strv_length ((gchar **) binary_patterns);
-
-		model->priv->binary_pattern_specs = g_ptr_array_sized_new (n_patterns);
-		g_ptr_array_set_free_func (model->priv->binary_pattern_specs,
-			                   (GDestroyNotify) g_pattern_spec_free);
-
-		for (i = 0; binary_patterns[i] != NULL; ++i)
-		{
-			g_ptr_array_add (model->priv->binary_pattern_specs,
-				         g_pattern_spec_new (binary_patterns[i]));
-		}
-	}
+		model->priv->binary_glob_set = gedit_file_browser_glob_set_new (binary_patterns);
 
 	model_refilter (model);
 
@@ -3398,6 +4271,34 @@ gedit_file_browser_store_refilter (GeditFileBrowserStore *model)
 	model_refilter (model);
 }
 
+/**
+ * gedit_file_browser_store_refilter_location:
+ * @model: a #GeditFileBrowserStore
+ * @location: the directory whose subtree to refilter
+ *
+ * Like gedit_file_browser_store_refilter(), but only for the loaded
+ * subtree of @location.
+ */
+void
+gedit_file_browser_store_refilter_location (GeditFileBrowserStore *model,
+					    GFile                 *location)
+{
+	FileBrowserNode *node;
+
+	g_return_if_fail (GEDIT_IS_FILE_BROWSER_STORE (model));
+	g_return_if_fail (G_IS_FILE (location));
+
+	node = model_find_node (model, NULL, location);
+
+	/* A node that is not loaded yet is filtered when it is, and the
+	 * subtree of a hidden node along with it once it shows up.
+	 */
+	if (node == NULL || !model_node_visibility (model, node))
+		return;
+
+	model_refilter_node (model, node, NULL);
+}
+
 GeditFileBrowserStoreFilterMode
 gedit_file_browser_store_filter_mode_get_default (void)
 {
@@ -3442,13 +4343,23 @@ reparent_node (FileBrowserNode *node,
 	if (NODE_IS_DIR (node))
 	{
 		FileBrowserNodeDir *dir;
-		GSList *child;
+		GSequenceIter *item;
 
 		dir = FILE_BROWSER_NODE_DIR (node);
 
-		for (child = dir->children; child; child = child->next)
+		/* The children get new files, index them again */
+		g_hash_table_remove_all (dir->children_by_file);
+
+		for (item = g_sequence_get_begin_iter (dir->children);
+		     !g_sequence_iter_is_end (item);
+		     item = g_sequence_iter_next (item))
 		{
-			reparent_node ((FileBrowserNode *)child->data, TRUE);
+			FileBrowserNode *child = g_sequence_get (item);
+
+			reparent_node (child, TRUE);
+
+			if (child->file != NULL)
+				g_hash_table_insert (dir->children_by_file, child->file, child);
 		}
 	}
 }
@@ -3463,6 +4374,7 @@ gedit_file_browser_store_rename (GeditFileBrowserStore  *model,
 	GFile *file;
 	GFile *parent;
 	GFile *previous;
+	GFileInfo *info;
 	GError *err = NULL;
 	GtkTreePath *path;
 
@@ -3489,9 +4401,26 @@ gedit_file_browser_store_rename (GeditFileBrowserStore  *model,
 		previous = node->file;
 		node->file = file;
 
-		/* This makes sure the actual info for the node is requeried */
+		if (node->parent != NULL)
+		{
+			FileBrowserNodeDir *dir = FILE_BROWSER_NODE_DIR (node->parent);
+
+			g_hash_table_remove (dir->children_by_file, previous);
+			g_hash_table_insert (dir->children_by_file, node->file, node);
+		}
+
+		/* Guess the info from the new name for now, the actual
+		 * info for the node is requeried in the background.
+		 */
 		file_browser_node_set_name (node);
-		file_browser_node_set_from_info (model, node, NULL, TRUE);
+
+		info = provisional_file_info_new (node->file,
+						  NODE_IS_DIR (node) ? G_FILE_TYPE_DIRECTORY
+								     : G_FILE_TYPE_REGULAR);
+		file_browser_node_set_from_info (model, node, info, TRUE);
+		g_object_unref (info);
+
+		model_query_info (model, node->file, FALSE);
 
 		reparent_node (node, FALSE);
 
@@ -3549,7 +4478,13 @@ gedit_file_browser_store_rename (GeditFileBrowserStore  *model,
 static void
 async_data_free (AsyncData *data)
 {
+	if (data->flush_id != 0)
+		g_source_remove (data->flush_id);
+
 	g_object_unref (data->cancellable);
+	g_queue_clear (&data->pending);
+	g_queue_clear (&data->unsupported);
+	g_slist_free (data->deleted);
 	g_list_free_full (data->files, g_object_unref);
 
 	if (!data->removed)
@@ -3569,100 +4504,237 @@ emit_no_trash (AsyncData *data)
 	return ret;
 }
 
+/* Removes the deleted files from the model, one batch per parent so that
+ * each directory is only checked for emptiness once.
+ */
 static void
-delete_file_finished (GFile        *file,
-		      GAsyncResult *res,
-		      AsyncData    *data)
+delete_files_remove_deleted (AsyncData *data)
 {
-	GError *error = NULL;
-	gboolean ok;
+	GeditFileBrowserStore *model = data->model;
+	GHashTable *batches;
+	GHashTableIter iter;
+	gpointer parent;
+	gpointer nodes;
+	GSList *deleted;
+	GSList *later = NULL;
+	GSList *item;
+	FileBrowserNode *node;
 
-	if (data->trash)
+	deleted = data->deleted;
+	data->deleted = NULL;
+
+	batches = g_hash_table_new (NULL, NULL);
+
+	for (item = deleted; item; item = item->next)
 	{
-		ok = g_file_trash_finish (file, res, &error);
+		node = model_find_node (model, NULL, G_FILE (item->data));
+
+		/* Already removed, when the monitor was faster */
+		if (node == NULL)
+			continue;
+
+		/* Removing these changes the virtual root, do it last */
+		if (node == model->priv->virtual_root || node->parent == NULL)
+		{
+			later = g_slist_prepend (later, item->data);
+			continue;
+		}
+
+		nodes = g_hash_table_lookup (batches, node->parent);
+		g_hash_table_insert (batches,
+				     node->parent,
+				     g_slist_prepend (nodes, node));
 	}
-	else
+
+	g_hash_table_iter_init (&iter, batches);
+
+	while (g_hash_table_iter_next (&iter, &parent, &nodes))
 	{
-		ok = g_file_delete_finish (file, res, &error);
+		model_remove_nodes_batch (model, parent, nodes);
+		g_slist_free (nodes);
 	}
 
-	if (ok)
+	g_hash_table_destroy (batches);
+
+	for (item = later; item; item = item->next)
 	{
-		/* Remove the file from the model */
-		FileBrowserNode *node = model_find_node (data->model, NULL, file);
+		node = model_find_node (model, NULL, G_FILE (item->data));
 
 		if (node != NULL)
+			model_remove_node (model, node, NULL, TRUE);
+	}
+
+	g_slist_free (later);
+	g_slist_free (deleted);
+
+	g_signal_emit (model, model_signals[DELETE_PROGRESS], 0,
+		       data->n_processed, data->n_total);
+}
+
+static gboolean
+delete_files_flush (AsyncData *data)
+{
+	data->flush_id = 0;
+	delete_files_remove_deleted (data);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+delete_file_done (AsyncData *data,
+		  GFile     *file,
+		  gboolean   trashed,
+		  GError    *error)
+{
+	data->n_running--;
+
+	if (error == NULL)
+	{
+		data->n_processed++;
+		data->deleted = g_slist_prepend (data->deleted, file);
+
+		/* Batch the removals from the model */
+		if (!data->removed && data->flush_id == 0)
 		{
-			model_remove_node (data->model, node, NULL, TRUE);
+			data->flush_id = g_timeout_add (DELETE_FLUSH_DELAY,
+							(GSourceFunc) delete_files_flush,
+							data);
 		}
-
-		/* Process the next file */
-		data->iter = data->iter->next;
 	}
-	else if (!ok && error != NULL)
+	else if (trashed && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED))
 	{
-		gint code = error->code;
-		g_error_free (error);
-
-		if (data->trash && code == G_IO_ERROR_NOT_SUPPORTED)
+		if (!data->trash)
+		{
+			/* Already turned into a delete job */
+			g_queue_push_head (&data->pending, file);
+		}
+		else if (data->declined ||
+			 g_cancellable_is_cancelled (data->cancellable))
+		{
+			/* An operation that was running while the user
+			 * declined, do not ask again */
+			data->n_processed++;
+		}
+		else
 		{
+			g_queue_push_tail (&data->unsupported, file);
+
 			/* Trash is not supported on this system. Ask the user
-			 * if he wants to delete completely the files instead.
+			 * once whether to delete the files completely instead,
+			 * the operations still running end in the meantime.
 			 */
-			if (emit_no_trash (data))
-			{
-				/* Changes this into a delete job */
-				data->trash = FALSE;
-				data->iter = data->files;
-			}
-			else
+			if (!data->asking && !data->removed)
 			{
-				/* End the job */
-				async_data_free (data);
-				return;
+				gboolean delete_anyway;
+
+				data->asking = TRUE;
+				delete_anyway = emit_no_trash (data);
+				data->asking = FALSE;
+
+				if (delete_anyway)
+				{
+					/* Changes this into a delete job */
+					data->trash = FALSE;
+
+					while ((file = g_queue_pop_tail (&data->unsupported)) != NULL)
+						g_queue_push_head (&data->pending, file);
+				}
+				else
+				{
+					/* End the job */
+					data->declined = TRUE;
+					g_cancellable_cancel (data->cancellable);
+				}
 			}
 		}
-		else if (code == G_IO_ERROR_CANCELLED)
-		{
-			/* Job has been cancelled, end the job */
-			async_data_free (data);
-			return;
-		}
 	}
+	else
+	{
+		/* Skip the files that cannot be deleted */
+		data->n_processed++;
+	}
+}
+
+static void
+trash_file_finished (GFile        *file,
+		     GAsyncResult *res,
+		     AsyncData    *data)
+{
+	GError *error = NULL;
+
+	g_file_trash_finish (file, res, &error);
+	delete_file_done (data, file, TRUE, error);
+	g_clear_error (&error);
+
+	/* Continue the job */
+	delete_files (data);
+}
+
+static void
+delete_file_finished (GFile        *file,
+		      GAsyncResult *res,
+		      AsyncData    *data)
+{
+	GError *error = NULL;
+
+	g_file_delete_finish (file, res, &error);
+	delete_file_done (data, file, FALSE, error);
+	g_clear_error (&error);
 
 	/* Continue the job */
 	delete_files (data);
 }
 
+/* Keeps up to MAX_DELETE_OPERATIONS files being deleted at the same time */
 static void
 delete_files (AsyncData *data)
 {
 	GFile *file;
 
-	/* Check if our job is done */
-	if (data->iter == NULL)
-	{
-		async_data_free (data);
+	/* Wait for the answer, the operations ending meanwhile come back here */
+	if (data->asking)
 		return;
-	}
 
-	file = G_FILE (data->iter->data);
+	if (g_cancellable_is_cancelled (data->cancellable))
+	{
+		g_queue_clear (&data->pending);
+		g_queue_clear (&data->unsupported);
+	}
 
-	if (data->trash)
+	while (data->n_running < MAX_DELETE_OPERATIONS &&
+	       (file = g_queue_pop_head (&data->pending)) != NULL)
 	{
-		g_file_trash_async (file,
-				    G_PRIORITY_DEFAULT,
-				    data->cancellable,
-				    (GAsyncReadyCallback)delete_file_finished,
-				    data);
+		data->n_running++;
+
+		if (data->trash)
+		{
+			g_file_trash_async (file,
+					    G_PRIORITY_DEFAULT,
+					    data->cancellable,
+					    (GAsyncReadyCallback)trash_file_finished,
+					    data);
+		}
+		else
+		{
+			g_file_delete_async (file,
+					     G_PRIORITY_DEFAULT,
+					     data->cancellable,
+					     (GAsyncReadyCallback)delete_file_finished,
+					     data);
+		}
 	}
-	else
+
+	/* Check if our job is done */
+	if (data->n_running == 0)
 	{
-		g_file_delete_async (file,
-				     G_PRIORITY_DEFAULT,
-				     data->cancellable,
-				     (GAsyncReadyCallback)delete_file_finished,
-				     data);
+		if (!data->removed)
+		{
+			/* The cancelled and the refused files count too */
+			data->n_processed = data->n_total;
+			delete_files_remove_deleted (data);
+		}
+
+		async_data_free (data);
 	}
 }
 
@@ -3706,23 +4778,48 @@ gedit_file_browser_store_delete_all (GeditFileBrowserStore *model,
 		files = g_list_prepend (files, g_object_ref (node->file));
 	}
 
-	data = g_slice_new (AsyncData);
+	data = g_slice_new0 (AsyncData);
 
 	data->model = model;
 	data->cancellable = g_cancellable_new ();
-	data->files = files;
+	data->files = g_list_reverse (files);
 	data->trash = trash;
-	data->iter = files;
-	data->removed = FALSE;
+	data->n_total = g_list_length (data->files);
+
+	for (row = data->files; row; row = row->next)
+		g_queue_push_tail (&data->pending, row->data);
 
 	model->priv->async_handles = g_slist_prepend (model->priv->async_handles, data);
 
+	g_signal_emit (model, model_signals[DELETE_PROGRESS], 0, 0, data->n_total);
+
 	delete_files (data);
 	g_list_free (rows);
 
 	return GEDIT_FILE_BROWSER_STORE_RESULT_OK;
 }
 
+/**
+ * gedit_file_browser_store_cancel_delete:
+ * @model: the #GeditFileBrowserStore
+ *
+ * Stops the running delete jobs. The files already deleted stay deleted.
+ *
+ * Returns: whether there was any job to stop
+ */
+gboolean
+gedit_file_browser_store_cancel_delete (GeditFileBrowserStore *model)
+{
+	GSList *item;
+
+	g_return_val_if_fail (GEDIT_IS_FILE_BROWSER_STORE (model), FALSE);
+
+	for (item = model->priv->async_handles; item; item = item->next)
+		g_cancellable_cancel (((AsyncData *) (item->data))->cancellable);
+
+	return model->priv->async_handles != NULL;
+}
+
 GeditFileBrowserStoreResult
 gedit_file_browser_store_delete (GeditFileBrowserStore *model,
 				 GtkTreeIter           *iter,
@@ -3756,6 +4853,7 @@ gedit_file_browser_store_new_file (GeditFileBrowserStore *model,
 {
 	GFile *file;
 	GFileOutputStream *stream;
+	GFileInfo *info;
 	FileBrowserNodeDir *parent_node;
 	gboolean result = FALSE;
 	FileBrowserNode *node;
@@ -3783,10 +4881,15 @@ gedit_file_browser_store_new_file (GeditFileBrowserStore *model,
 	else
 	{
 		g_object_unref (stream);
+
+		info = provisional_file_info_new (file, G_FILE_TYPE_REGULAR);
 		node = model_add_node_from_file (model,
 						 (FileBrowserNode *)parent_node,
 						 file,
-						 NULL);
+						 info);
+		g_object_unref (info);
+
+		model_query_info (model, file, FALSE);
 
 		if (model_node_visibility (model, node))
 		{
@@ -3813,6 +4916,7 @@ gedit_file_browser_store_new_directory (GeditFileBrowserStore *model,
 					GtkTreeIter           *iter)
 {
 	GFile *file;
+	GFileInfo *info;
 	FileBrowserNodeDir *parent_node;
 	GError *error = NULL;
 	FileBrowserNode *node;
@@ -3839,10 +4943,14 @@ gedit_file_browser_store_new_directory (GeditFileBrowserStore *model,
 	}
 	else
 	{
+		info = provisional_file_info_new (file, G_FILE_TYPE_DIRECTORY);
 		node = model_add_node_from_file (model,
 						 (FileBrowserNode *)parent_node,
 						 file,
-						 NULL);
+						 info);
+		g_object_unref (info);
+
+		model_query_info (model, file, FALSE);
 
 		if (model_node_visibility (model, node))
 		{
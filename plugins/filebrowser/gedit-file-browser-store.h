@@ -116,6 +116,9 @@ struct _GeditFileBrowserStoreClass {
 	                             GFile                 *location);
 	void (* before_row_deleted) (GeditFileBrowserStore *model,
 	                             GtkTreePath           *path);
+	void (* delete_progress)    (GeditFileBrowserStore *model,
+	                             guint                  n_processed,
+	                             guint                  n_total);
 };
 
 GType		 gedit_file_browser_store_get_type		(void) G_GNUC_CONST;
@@ -155,6 +158,11 @@ void		 gedit_file_browser_store_set_value		(GeditFileBrowserStore            *tr
 								 GtkTreeIter                      *iter,
 								 gint                              column,
 								 GValue                           *value);
+void		 gedit_file_browser_store_set_values		(GeditFileBrowserStore            *model,
+								 gint                              column,
+								 GFile                           **locations,
+								 const GValue                     *values,
+								 guint                             n_values);
 
 void		 _gedit_file_browser_store_iter_expanded	(GeditFileBrowserStore            *model,
 								 GtkTreeIter                      *iter);
@@ -175,6 +183,8 @@ void		 gedit_file_browser_store_set_binary_patterns	(GeditFileBrowserStore
 								 const gchar                     **binary_patterns);
 
 void		 gedit_file_browser_store_refilter		(GeditFileBrowserStore            *model);
+void		 gedit_file_browser_store_refilter_location	(GeditFileBrowserStore            *model,
+								 GFile                            *location);
 GeditFileBrowserStoreFilterMode
 gedit_file_browser_store_filter_mode_get_default		(void);
 
@@ -191,6 +201,7 @@ GeditFileBrowserStoreResult
 gedit_file_browser_store_delete_all				(GeditFileBrowserStore            *model,
 								 GList                            *rows,
 								 gboolean                          trash);
+gboolean	 gedit_file_browser_store_cancel_delete		(GeditFileBrowserStore            *model);
 
 gboolean	 gedit_file_browser_store_new_file		(GeditFileBrowserStore            *model,
 								 GtkTreeIter                      *parent,
@@ -27,6 +27,172 @@
 
 #include "gedit-file-browser-utils.h"
 
+typedef struct
+{
+	GIcon *icon;
+	gint size;
+} IconKey;
+
+typedef struct
+{
+	GdkPixbuf *icon;
+	GdkPixbuf *emblem;
+	gint size;
+} EmblemKey;
+
+/* Thousands of files share a handful of icons, so the pixbufs are shared
+ * too. The caches hold failed lookups as NULL and are cleared when the
+ * icon theme changes. They only exist while the plugin is active on a
+ * window, see gedit_file_browser_utils_ref_caches().
+ */
+static GHashTable *icon_cache = NULL;
+static GHashTable *theme_cache = NULL;
+static GHashTable *emblem_cache = NULL;
+static guint caches_ref_count = 0;
+static gulong theme_changed_id = 0;
+
+static guint
+icon_key_hash (gconstpointer data)
+{
+	const IconKey *key = data;
+
+	return g_icon_hash ((gpointer) key->icon) ^ (guint) key->size;
+}
+
+static gboolean
+icon_key_equal (gconstpointer a,
+		gconstpointer b)
+{
+	const IconKey *key_a = a;
+	const IconKey *key_b = b;
+
+	return key_a->size == key_b->size &&
+	       g_icon_equal (key_a->icon, key_b->icon);
+}
+
+static void
+icon_key_free (IconKey *key)
+{
+	g_object_unref (key->icon);
+	g_slice_free (IconKey, key);
+}
+
+static guint
+emblem_key_hash (gconstpointer data)
+{
+	const EmblemKey *key = data;
+
+	return (g_direct_hash (key->icon) * 31 + g_direct_hash (key->emblem)) ^ (guint) key->size;
+}
+
+static gboolean
+emblem_key_equal (gconstpointer a,
+		  gconstpointer b)
+{
+	const EmblemKey *key_a = a;
+	const EmblemKey *key_b = b;
+
+	return key_a->icon == key_b->icon &&
+	       key_a->emblem == key_b->emblem &&
+	       key_a->size == key_b->size;
+}
+
+static void
+emblem_key_free (EmblemKey *key)
+{
+	if (key->icon != NULL)
+		g_object_unref (key->icon);
+
+	g_object_unref (key->emblem);
+	g_slice_free (EmblemKey, key);
+}
+
+static void
+cached_pixbuf_free (GdkPixbuf *pixbuf)
+{
+	if (pixbuf != NULL)
+		g_object_unref (pixbuf);
+}
+
+static void
+on_icon_theme_changed (GtkIconTheme *theme,
+		       gpointer      user_data)
+{
+	g_hash_table_remove_all (icon_cache);
+	g_hash_table_remove_all (theme_cache);
+	g_hash_table_remove_all (emblem_cache);
+}
+
+/**
+ * gedit_file_browser_utils_ref_caches:
+ *
+ * Creates the icon caches if needed. Each window the plugin is active on
+ * holds a reference, and the caches are freed with the last one, see
+ * gedit_file_browser_utils_unref_caches(). Icons looked up while there
+ * are no caches are loaded every time.
+ */
+void
+gedit_file_browser_utils_ref_caches (void)
+{
+	if (caches_ref_count++ > 0)
+		return;
+
+	icon_cache = g_hash_table_new_full (icon_key_hash,
+					    icon_key_equal,
+					    (GDestroyNotify) icon_key_free,
+					    (GDestroyNotify) cached_pixbuf_free);
+
+	theme_cache = g_hash_table_new_full (g_str_hash,
+					     g_str_equal,
+					     g_free,
+					     (GDestroyNotify) cached_pixbuf_free);
+
+	emblem_cache = g_hash_table_new_full (emblem_key_hash,
+					      emblem_key_equal,
+					      (GDestroyNotify) emblem_key_free,
+					      (GDestroyNotify) cached_pixbuf_free);
+
+	theme_changed_id = g_signal_connect (gtk_icon_theme_get_default (),
+					     "changed",
+					     G_CALLBACK (on_icon_theme_changed),
+					     NULL);
+}
+
+void
+gedit_file_browser_utils_unref_caches (void)
+{
+	g_return_if_fail (caches_ref_count > 0);
+
+	if (--caches_ref_count > 0)
+		return;
+
+	g_signal_handler_disconnect (gtk_icon_theme_get_default (),
+				     theme_changed_id);
+	theme_changed_id = 0;
+
+	g_clear_pointer (&icon_cache, g_hash_table_unref);
+	g_clear_pointer (&theme_cache, g_hash_table_unref);
+	g_clear_pointer (&emblem_cache, g_hash_table_unref);
+}
+
+/* Returns TRUE if key is in the cache, with a new reference to the
+ * cached pixbuf (if any) in pixbuf.
+ */
+static gboolean
+lookup_cached_pixbuf (GHashTable    *cache,
+		      gconstpointer  key,
+		      GdkPixbuf    **pixbuf)
+{
+	gpointer value;
+
+	if (cache == NULL ||
+	    !g_hash_table_lookup_extended (cache, key, NULL, &value))
+		return FALSE;
+
+	*pixbuf = value != NULL ? g_object_ref (value) : NULL;
+	return TRUE;
+}
+
 static GdkPixbuf *
 process_icon_pixbuf (GdkPixbuf   *pixbuf,
 		     gchar const *name,
@@ -63,9 +229,18 @@ gedit_file_browser_utils_pixbuf_from_theme (gchar const *name,
 	gint width;
 	GError *error = NULL;
 	GdkPixbuf *pixbuf;
+	gchar *key;
 
 	gtk_icon_size_lookup (size, &width, NULL);
 
+	key = g_strdup_printf ("%d:%s", width, name);
+
+	if (lookup_cached_pixbuf (theme_cache, key, &pixbuf))
+	{
+		g_free (key);
+		return pixbuf;
+	}
+
 	pixbuf = gtk_icon_theme_load_icon (gtk_icon_theme_get_default (),
 					   name,
 					   width,
@@ -74,6 +249,17 @@ gedit_file_browser_utils_pixbuf_from_theme (gchar const *name,
 
 	pixbuf = process_icon_pixbuf (pixbuf, name, width, error);
 
+	if (theme_cache != NULL)
+	{
+		g_hash_table_insert (theme_cache,
+				     key,
+				     pixbuf != NULL ? g_object_ref (pixbuf) : NULL);
+	}
+	else
+	{
+		g_free (key);
+	}
+
 	return pixbuf;
 }
 
@@ -84,6 +270,8 @@ gedit_file_browser_utils_pixbuf_from_icon (GIcon       *icon,
 	GdkPixbuf *ret = NULL;
 	GtkIconTheme *theme;
 	GtkIconInfo *info;
+	IconKey lookup;
+	IconKey *key;
 	gint width;
 
 	if (!icon)
@@ -92,16 +280,92 @@ gedit_file_browser_utils_pixbuf_from_icon (GIcon       *icon,
 	theme = gtk_icon_theme_get_default ();
 	gtk_icon_size_lookup (size, &width, NULL);
 
+	lookup.icon = icon;
+	lookup.size = width;
+
+	if (lookup_cached_pixbuf (icon_cache, &lookup, &ret))
+		return ret;
+
 	info = gtk_icon_theme_lookup_by_gicon (theme,
 					       icon,
 					       width,
 					       GTK_ICON_LOOKUP_USE_BUILTIN);
 
-	if (!info)
-		return NULL;
+	if (info)
+	{
+		ret = gtk_icon_info_load_icon (info, NULL);
+		g_object_unref (info);
+	}
 
-	ret = gtk_icon_info_load_icon (info, NULL);
-	g_object_unref (info);
+	if (icon_cache != NULL)
+	{
+		key = g_slice_new (IconKey);
+		key->icon = g_object_ref (icon);
+		key->size = width;
+
+		g_hash_table_insert (icon_cache,
+				     key,
+				     ret != NULL ? g_object_ref (ret) : NULL);
+	}
+
+	return ret;
+}
+
+/* Returns icon with emblem drawn in its bottom right corner. The result
+ * is shared and must not be modified.
+ */
+GdkPixbuf *
+gedit_file_browser_utils_pixbuf_with_emblem (GdkPixbuf   *icon,
+                                             GdkPixbuf   *emblem,
+                                             GtkIconSize  size)
+{
+	GdkPixbuf *ret;
+	EmblemKey lookup;
+	EmblemKey *key;
+	gint icon_size;
+
+	g_return_val_if_fail (GDK_IS_PIXBUF (emblem), NULL);
+
+	gtk_icon_size_lookup (size, NULL, &icon_size);
+
+	lookup.icon = icon;
+	lookup.emblem = emblem;
+	lookup.size = icon_size;
+
+	if (lookup_cached_pixbuf (emblem_cache, &lookup, &ret))
+		return ret;
+
+	if (icon == NULL)
+	{
+		ret = gdk_pixbuf_new (gdk_pixbuf_get_colorspace (emblem),
+				      gdk_pixbuf_get_has_alpha (emblem),
+				      gdk_pixbuf_get_bits_per_sample (emblem),
+				      icon_size,
+				      icon_size);
+		gdk_pixbuf_fill (ret, 0);
+	}
+	else
+	{
+		ret = gdk_pixbuf_copy (icon);
+	}
+
+	gdk_pixbuf_composite (emblem, ret,
+			      icon_size - 10, icon_size - 10, 10,
+			      10, icon_size - 10, icon_size - 10,
+			      1, 1, GDK_INTERP_NEAREST, 255);
+
+	if (emblem_cache != NULL)
+	{
+		/* The key keeps the pixbufs alive, so their addresses
+		 * stay unique.
+		 */
+		key = g_slice_new (EmblemKey);
+		key->icon = icon != NULL ? g_object_ref (icon) : NULL;
+		key->emblem = g_object_ref (emblem);
+		key->size = icon_size;
+
+		g_hash_table_insert (emblem_cache, key, g_object_ref (ret));
+	}
 
 	return ret;
 }
@@ -24,6 +24,9 @@
 #include <gedit/gedit-window.h>
 #include <gio/gio.h>
 
+void		 gedit_file_browser_utils_ref_caches		(void);
+void		 gedit_file_browser_utils_unref_caches		(void);
+
 GdkPixbuf	*gedit_file_browser_utils_pixbuf_from_theme	(gchar const    *name,
 								 GtkIconSize     size);
 
@@ -32,6 +35,9 @@ GdkPixbuf	*gedit_file_browser_utils_pixbuf_from_icon	(GIcon          *icon,
 GdkPixbuf	*gedit_file_browser_utils_pixbuf_from_file	(GFile          *file,
 								 GtkIconSize     size,
 								 gboolean        use_symbolic);
+GdkPixbuf	*gedit_file_browser_utils_pixbuf_with_emblem	(GdkPixbuf      *icon,
+								 GdkPixbuf      *emblem,
+								 GtkIconSize     size);
 
 gchar		*gedit_file_browser_utils_file_basename		(GFile          *file);
 
@@ -31,6 +31,8 @@
 #include <gedit/gedit-utils.h>
 
 #include "gedit-file-browser-utils.h"
+#include "gedit-file-browser-crawler.h"
+#include "gedit-file-browser-glob-set.h"
 #include "gedit-file-browser-error.h"
 #include "gedit-file-browser-widget.h"
 #include "gedit-file-browser-view.h"
@@ -40,6 +42,13 @@
 
 #define LOCATION_DATA_KEY "gedit-file-browser-widget-location"
 
+/* A filter pattern starting with this matches anywhere below the root */
+#define RECURSIVE_FILTER_PREFIX "**/"
+
+/* Directories expanded by a recursive filter, in total and per idle */
+#define RECURSIVE_EXPAND_MAX 64
+#define RECURSIVE_EXPAND_BATCH 4
+
 enum
 {
 	BOOKMARKS_ID,
@@ -140,9 +149,28 @@ struct _GeditFileBrowserWidgetPrivate
 	GSList *filter_funcs;
 	gulong filter_id;
 	gulong glob_filter_id;
-	GPatternSpec *filter_pattern;
+	GeditFileBrowserGlobSet *filter_pattern;
 	gchar *filter_pattern_str;
 
+	/* For a recursive filter pattern: the index of the virtual root,
+	 * and the paths in there of the matching files and of their
+	 * ancestors, see recursive_filter_update(). The files the store
+	 * shows but the index missed are added to it, see
+	 * recursive_filter_match().
+	 */
+	gboolean filter_recursive;
+	gboolean filter_match_path;
+	GeditFileBrowserCrawler *crawler;
+	GHashTable *recursive_matches;
+	GHashTable *recursive_ancestors;
+	GHashTable *recursive_dirs;
+	GHashTable *recursive_added;
+	GHashTable *recursive_refilter;
+	guint refilter_id;
+	GQueue *expand_rows;
+	guint expand_id;
+	guint n_expanded;
+
 	GList *locations;
 	GList *current_location;
 	gboolean changing_location;
@@ -169,6 +197,10 @@ static void on_file_store_error                (GeditFileBrowserStore  *store,
 static gboolean on_file_store_no_trash 	       (GeditFileBrowserStore  *store,
 						GList                  *files,
 						GeditFileBrowserWidget *obj);
+static void on_file_store_delete_progress      (GeditFileBrowserStore  *store,
+						guint                   n_processed,
+						guint                   n_total,
+						GeditFileBrowserWidget *obj);
 static gboolean on_location_button_press_event (GtkWidget              *button,
 						GdkEventButton         *event,
 						GeditFileBrowserWidget *obj);
@@ -368,6 +400,7 @@ gedit_file_browser_widget_finalize (GObject *object)
 	GeditFileBrowserWidgetPrivate *priv = GEDIT_FILE_BROWSER_WIDGET (object)->priv;
 
 	g_free (priv->filter_pattern_str);
+	gedit_file_browser_glob_set_free (priv->filter_pattern);
 
 	G_OBJECT_CLASS (gedit_file_browser_widget_parent_class)->finalize (object);
 }
@@ -391,6 +424,545 @@ clear_signals (GeditFileBrowserWidget *obj)
 	obj->priv->signal_pool = NULL;
 }
 
+static void
+recursive_filter_clear_expand (GeditFileBrowserWidget *obj)
+{
+	if (obj->priv->expand_id != 0)
+	{
+		g_source_remove (obj->priv->expand_id);
+		obj->priv->expand_id = 0;
+	}
+
+	if (obj->priv->expand_rows != NULL)
+	{
+		g_queue_free_full (obj->priv->expand_rows,
+				   (GDestroyNotify) gtk_tree_row_reference_free);
+		obj->priv->expand_rows = NULL;
+	}
+
+	obj->priv->n_expanded = 0;
+}
+
+static void
+recursive_filter_stop (GeditFileBrowserWidget *obj)
+{
+	gedit_file_browser_crawler_free (obj->priv->crawler);
+	obj->priv->crawler = NULL;
+
+	recursive_filter_clear_expand (obj);
+
+	if (obj->priv->refilter_id != 0)
+	{
+		g_source_remove (obj->priv->refilter_id);
+		obj->priv->refilter_id = 0;
+	}
+
+	if (obj->priv->recursive_refilter != NULL)
+	{
+		g_hash_table_destroy (obj->priv->recursive_refilter);
+		obj->priv->recursive_refilter = NULL;
+	}
+
+	if (obj->priv->recursive_matches != NULL)
+	{
+		g_hash_table_destroy (obj->priv->recursive_matches);
+		obj->priv->recursive_matches = NULL;
+	}
+
+	if (obj->priv->recursive_ancestors != NULL)
+	{
+		g_hash_table_destroy (obj->priv->recursive_ancestors);
+		obj->priv->recursive_ancestors = NULL;
+	}
+
+	if (obj->priv->recursive_dirs != NULL)
+	{
+		g_hash_table_destroy (obj->priv->recursive_dirs);
+		obj->priv->recursive_dirs = NULL;
+	}
+
+	if (obj->priv->recursive_added != NULL)
+	{
+		g_hash_table_destroy (obj->priv->recursive_added);
+		obj->priv->recursive_added = NULL;
+	}
+}
+
+static gboolean
+recursive_filter_glob (GeditFileBrowserWidget *obj,
+		       const gchar            *path)
+{
+	const gchar *subject = path;
+	const gchar *end;
+
+	if (!obj->priv->filter_match_path)
+	{
+		end = strrchr (path, '/');
+
+		if (end != NULL)
+			subject = end + 1;
+	}
+
+	return gedit_file_browser_glob_set_match (obj->priv->filter_pattern, subject);
+}
+
+/* Adds the directories in which the paths changed what is shown to
+ * @refilter, when not %NULL: the closest known ancestor of every new
+ * match, "" being the root.
+ */
+static void
+recursive_filter_add_paths (GeditFileBrowserWidget *obj,
+			    const gchar * const    *paths,
+			    guint                   n_paths,
+			    GHashTable             *refilter)
+{
+	const gchar *path;
+	const gchar *end;
+	gchar *ancestor = NULL;
+	gsize len;
+	guint i;
+
+	for (i = 0; i < n_paths; i++)
+	{
+		path = paths[i];
+		len = strlen (path);
+
+		if (len == 0)
+			continue;
+
+		/* Directories only show as ancestors of the matches */
+		if (path[len - 1] == '/')
+		{
+			g_hash_table_add (obj->priv->recursive_dirs, (gpointer) path);
+			continue;
+		}
+
+		if (!recursive_filter_glob (obj, path))
+			continue;
+
+		g_hash_table_add (obj->priv->recursive_matches, (gpointer) path);
+
+		/* Add the ancestors up to the first one that is known */
+		for (end = strrchr (path, '/'); end != NULL; )
+		{
+			ancestor = g_strndup (path, end - path + 1);
+
+			if (g_hash_table_contains (obj->priv->recursive_ancestors, ancestor))
+				break;
+
+			g_hash_table_add (obj->priv->recursive_ancestors, ancestor);
+
+			while (end > path && *(--end) != '/')
+				;
+
+			if (*end != '/')
+				end = NULL;
+		}
+
+		if (refilter == NULL)
+		{
+			if (end != NULL)
+				g_free (ancestor);
+		}
+		else
+		{
+			g_hash_table_add (refilter, end != NULL ? ancestor : g_strdup (""));
+		}
+	}
+}
+
+static gboolean
+has_refilter_ancestor (GHashTable  *refilter,
+		       const gchar *dir)
+{
+	const gchar *end;
+	gchar *ancestor;
+	gboolean found = FALSE;
+
+	if (*dir == '\0')
+		return FALSE;
+
+	if (g_hash_table_contains (refilter, ""))
+		return TRUE;
+
+	/* dir ends with a '/', skip it */
+	for (end = dir + strlen (dir) - 1; !found && end > dir; )
+	{
+		while (end > dir && *(--end) != '/')
+			;
+
+		if (end == dir)
+			break;
+
+		ancestor = g_strndup (dir, end - dir + 1);
+		found = g_hash_table_contains (refilter, ancestor);
+		g_free (ancestor);
+	}
+
+	return found;
+}
+
+/* Only the subtrees of the directories that got new matches are
+ * refiltered, the rest of the store is unchanged.
+ */
+static void
+refilter_dirs (GeditFileBrowserWidget *obj,
+	       GHashTable             *refilter)
+{
+	GHashTableIter iter;
+	const gchar *dir;
+	GFile *root;
+	GFile *location;
+
+	root = gedit_file_browser_crawler_get_root (obj->priv->crawler);
+	g_hash_table_iter_init (&iter, refilter);
+
+	while (g_hash_table_iter_next (&iter, (gpointer *) &dir, NULL))
+	{
+		if (has_refilter_ancestor (refilter, dir))
+			continue;
+
+		if (*dir == '\0')
+			location = g_object_ref (root);
+		else
+			location = g_file_resolve_relative_path (root, dir);
+
+		gedit_file_browser_store_refilter_location (obj->priv->file_store,
+							    location);
+		g_object_unref (location);
+	}
+}
+
+static void
+on_crawler_paths (GeditFileBrowserCrawler *crawler,
+		  const gchar * const     *paths,
+		  guint                    n_paths,
+		  GeditFileBrowserWidget  *obj)
+{
+	GHashTable *refilter;
+
+	refilter = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	recursive_filter_add_paths (obj, paths, n_paths, refilter);
+	refilter_dirs (obj, refilter);
+	g_hash_table_destroy (refilter);
+}
+
+static gboolean
+refilter_added_cb (GeditFileBrowserWidget *obj)
+{
+	GHashTable *refilter;
+
+	obj->priv->refilter_id = 0;
+
+	refilter = obj->priv->recursive_refilter;
+	obj->priv->recursive_refilter = NULL;
+
+	if (refilter != NULL)
+	{
+		refilter_dirs (obj, refilter);
+		g_hash_table_destroy (refilter);
+	}
+
+	return G_SOURCE_REMOVE;
+}
+
+/* A file created or loaded after the crawl got there: it joins the
+ * index, and its ancestors are shown from an idle, as the store is
+ * filtering.
+ */
+static void
+recursive_filter_add_file (GeditFileBrowserWidget *obj,
+			   gchar                  *relative)
+{
+	const gchar *path = relative;
+
+	g_hash_table_add (obj->priv->recursive_added, relative);
+
+	if (obj->priv->recursive_refilter == NULL)
+	{
+		obj->priv->recursive_refilter = g_hash_table_new_full (g_str_hash,
+								       g_str_equal,
+								       g_free,
+								       NULL);
+	}
+
+	recursive_filter_add_paths (obj, &path, 1, obj->priv->recursive_refilter);
+
+	if (obj->priv->refilter_id == 0)
+	{
+		obj->priv->refilter_id = g_idle_add ((GSourceFunc) refilter_added_cb, obj);
+	}
+}
+
+/* Indexes the virtual root, unless it already is, and collects the files
+ * matching the filter pattern from the index. More follow as the index
+ * grows.
+ */
+static void
+recursive_filter_update (GeditFileBrowserWidget *obj)
+{
+	GFile *root;
+	const gchar * const *paths;
+	guint n_paths;
+
+	root = gedit_file_browser_store_get_virtual_root (obj->priv->file_store);
+
+	if (root == NULL)
+	{
+		recursive_filter_stop (obj);
+		return;
+	}
+
+	if (obj->priv->crawler == NULL ||
+	    !g_file_equal (root, gedit_file_browser_crawler_get_root (obj->priv->crawler)))
+	{
+		recursive_filter_stop (obj);
+
+		obj->priv->crawler = gedit_file_browser_crawler_new (root,
+								     (GeditFileBrowserCrawlerFunc) on_crawler_paths,
+								     obj);
+	}
+
+	g_object_unref (root);
+
+	/* The keys of the matches are the strings of the index, or the
+	 * ones of the files added to it.
+	 */
+	if (obj->priv->recursive_matches == NULL)
+	{
+		obj->priv->recursive_matches = g_hash_table_new (g_str_hash, g_str_equal);
+		obj->priv->recursive_ancestors = g_hash_table_new_full (g_str_hash,
+									g_str_equal,
+									g_free,
+									NULL);
+		obj->priv->recursive_dirs = g_hash_table_new (g_str_hash, g_str_equal);
+		obj->priv->recursive_added = g_hash_table_new_full (g_str_hash,
+								    g_str_equal,
+								    g_free,
+								    NULL);
+	}
+	else
+	{
+		g_hash_table_remove_all (obj->priv->recursive_matches);
+		g_hash_table_remove_all (obj->priv->recursive_ancestors);
+	}
+
+	/* A new pattern gets its own share of expanded directories */
+	recursive_filter_clear_expand (obj);
+
+	/* The caller refilters the whole store */
+	paths = gedit_file_browser_crawler_get_paths (obj->priv->crawler, &n_paths);
+	recursive_filter_add_paths (obj, paths, n_paths, NULL);
+
+	paths = (const gchar * const *) g_hash_table_get_keys_as_array (obj->priv->recursive_added,
+									 &n_paths);
+	recursive_filter_add_paths (obj, paths, n_paths, NULL);
+	g_free ((gpointer) paths);
+}
+
+static gboolean
+recursive_filter_match (GeditFileBrowserWidget *obj,
+			GtkTreeModel           *model,
+			GtkTreeIter            *iter,
+			gboolean                is_dir)
+{
+	GFile *location;
+	gchar *relative;
+	gchar *key;
+	gboolean result;
+
+	if (obj->priv->crawler == NULL)
+		return TRUE;
+
+	gtk_tree_model_get (model, iter,
+			    GEDIT_FILE_BROWSER_STORE_COLUMN_LOCATION, &location,
+			    -1);
+
+	if (location == NULL)
+		return TRUE;
+
+	relative = g_file_get_relative_path (gedit_file_browser_crawler_get_root (obj->priv->crawler),
+					     location);
+	g_object_unref (location);
+
+	if (relative == NULL)
+		return TRUE;
+
+	if (is_dir)
+	{
+		key = g_strconcat (relative, "/", NULL);
+
+		/* Once crawled, a directory the crawl did not see is new:
+		 * it is shown, its files are matched when it is expanded.
+		 */
+		result = g_hash_table_contains (obj->priv->recursive_ancestors, key) ||
+			 (gedit_file_browser_crawler_is_done (obj->priv->crawler) &&
+			  !g_hash_table_contains (obj->priv->recursive_dirs, key));
+
+		g_free (key);
+	}
+	else if (g_hash_table_contains (obj->priv->recursive_matches, relative))
+	{
+		result = TRUE;
+	}
+	else if (recursive_filter_glob (obj, relative))
+	{
+		recursive_filter_add_file (obj, relative);
+		return TRUE;
+	}
+	else
+	{
+		result = FALSE;
+	}
+
+	g_free (relative);
+
+	return result;
+}
+
+static gboolean
+expand_rows_cb (GeditFileBrowserWidget *obj)
+{
+	GtkTreeRowReference *ref;
+	GtkTreePath *path;
+	guint n;
+
+	for (n = 0; n < RECURSIVE_EXPAND_BATCH; )
+	{
+		ref = g_queue_pop_head (obj->priv->expand_rows);
+
+		if (ref == NULL)
+			break;
+
+		/* The bookmarks may be shown in the meantime */
+		if (gtk_tree_row_reference_get_model (ref) ==
+		    gtk_tree_view_get_model (GTK_TREE_VIEW (obj->priv->treeview)))
+		{
+			path = gtk_tree_row_reference_get_path (ref);
+		}
+		else
+		{
+			path = NULL;
+		}
+
+		gtk_tree_row_reference_free (ref);
+
+		if (path == NULL)
+			continue;
+
+		if (!gtk_tree_view_row_expanded (GTK_TREE_VIEW (obj->priv->treeview), path) &&
+		    obj->priv->n_expanded < RECURSIVE_EXPAND_MAX)
+		{
+			gtk_tree_view_expand_row (GTK_TREE_VIEW (obj->priv->treeview), path, FALSE);
+			obj->priv->n_expanded++;
+			n++;
+		}
+
+		gtk_tree_path_free (path);
+	}
+
+	if (g_queue_is_empty (obj->priv->expand_rows))
+	{
+		obj->priv->expand_id = 0;
+		return G_SOURCE_REMOVE;
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+
+/* Queues the expansion of a matching directory: a few directories are
+ * expanded, and so loaded, per idle, and only so many in total.
+ */
+static void
+recursive_filter_expand (GeditFileBrowserWidget *obj,
+			 GtkTreeModel           *model,
+			 GtkTreeIter            *iter)
+{
+	GtkTreePath *path;
+	GtkTreePath *last;
+	guint flags;
+
+	if (obj->priv->n_expanded >= RECURSIVE_EXPAND_MAX)
+		return;
+
+	gtk_tree_model_get (model, iter,
+			    GEDIT_FILE_BROWSER_STORE_COLUMN_FLAGS, &flags,
+			    -1);
+
+	if (!FILE_IS_DIR (flags) || !recursive_filter_match (obj, model, iter, TRUE))
+		return;
+
+	path = gtk_tree_model_get_path (model, iter);
+
+	if (gtk_tree_view_row_expanded (GTK_TREE_VIEW (obj->priv->treeview), path))
+	{
+		gtk_tree_path_free (path);
+		return;
+	}
+
+	if (obj->priv->expand_rows == NULL)
+		obj->priv->expand_rows = g_queue_new ();
+
+	/* The children of a directory are inserted one after another */
+	last = NULL;
+
+	if (!g_queue_is_empty (obj->priv->expand_rows))
+		last = gtk_tree_row_reference_get_path (g_queue_peek_tail (obj->priv->expand_rows));
+
+	if (last == NULL || gtk_tree_path_compare (last, path) != 0)
+	{
+		g_queue_push_tail (obj->priv->expand_rows,
+				   gtk_tree_row_reference_new (model, path));
+	}
+
+	if (obj->priv->expand_id == 0)
+	{
+		obj->priv->expand_id = g_idle_add_full (G_PRIORITY_LOW,
+							(GSourceFunc) expand_rows_cb,
+							obj,
+							NULL);
+	}
+
+	if (last != NULL)
+		gtk_tree_path_free (last);
+
+	gtk_tree_path_free (path);
+}
+
+/* Expands the ancestors of the matching files as they show up, which
+ * loads them in turn, see recursive_filter_expand().
+ */
+static void
+on_file_store_row_inserted (GtkTreeModel           *model,
+			    GtkTreePath            *path,
+			    GtkTreeIter            *iter,
+			    GeditFileBrowserWidget *obj)
+{
+	GtkTreePath *copy;
+	GtkTreeIter parent;
+
+	if (!obj->priv->filter_recursive ||
+	    gtk_tree_view_get_model (GTK_TREE_VIEW (obj->priv->treeview)) != model)
+	{
+		return;
+	}
+
+	if (gtk_tree_model_iter_has_child (model, iter))
+		recursive_filter_expand (obj, model, iter);
+
+	/* A directory can only be expanded once it has a child */
+	copy = gtk_tree_path_copy (path);
+
+	if (gtk_tree_path_up (copy) &&
+	    gtk_tree_path_get_depth (copy) != 0 &&
+	    gtk_tree_model_get_iter (model, &parent, copy))
+	{
+		recursive_filter_expand (obj, model, &parent);
+	}
+
+	gtk_tree_path_free (copy);
+}
+
 static void
 gedit_file_browser_widget_dispose (GObject *object)
 {
@@ -411,6 +983,7 @@ gedit_file_browser_widget_dispose (GObject *object)
 	}
 
 	cancel_async_operation (obj);
+	recursive_filter_stop (obj);
 
 	g_clear_object (&obj->priv->current_location_menu_item);
 	g_clear_object (&priv->busy_cursor);
@@ -1051,6 +1624,9 @@ gedit_file_browser_widget_init (GeditFileBrowserWidget *obj)
 	g_signal_connect (obj->priv->file_store, "error",
 			  G_CALLBACK (on_file_store_error), obj);
 
+	g_signal_connect_after (obj->priv->file_store, "row-inserted",
+				G_CALLBACK (on_file_store_row_inserted), obj);
+
 	init_bookmarks_hash (obj);
 
 	/* filter */
@@ -1225,14 +1801,25 @@ filter_glob (GeditFileBrowserWidget *obj,
 			    GEDIT_FILE_BROWSER_STORE_COLUMN_FLAGS, &flags,
 			    -1);
 
-	if (FILE_IS_DIR (flags) || FILE_IS_DUMMY (flags))
+	if (FILE_IS_DUMMY (flags))
+	{
+		result = TRUE;
+	}
+	else if (obj->priv->filter_recursive)
+	{
+		result = recursive_filter_match (obj,
+						 GTK_TREE_MODEL (store),
+						 iter,
+						 FILE_IS_DIR (flags));
+	}
+	else if (FILE_IS_DIR (flags))
 	{
 		result = TRUE;
 	}
 	else
 	{
-		result = g_pattern_match_string (obj->priv->filter_pattern,
-						 name);
+		result = gedit_file_browser_glob_set_match (obj->priv->filter_pattern,
+							    name);
 	}
 
 	g_free (name);
@@ -1577,6 +2164,9 @@ set_filter_pattern_real (GeditFileBrowserWidget *obj,
                         gboolean                 update_entry)
 {
 	GtkTreeModel *model;
+	gchar const *glob;
+	gchar const *globs[] = { NULL, NULL };
+	gboolean recursive = FALSE;
 
 	model = gtk_tree_view_get_model (GTK_TREE_VIEW (obj->priv->treeview));
 
@@ -1603,11 +2193,8 @@ set_filter_pattern_real (GeditFileBrowserWidget *obj,
 		obj->priv->filter_pattern_str = g_strdup (pattern);
 	}
 
-	if (obj->priv->filter_pattern)
-	{
-		g_pattern_spec_free (obj->priv->filter_pattern);
-		obj->priv->filter_pattern = NULL;
-	}
+	gedit_file_browser_glob_set_free (obj->priv->filter_pattern);
+	obj->priv->filter_pattern = NULL;
 
 	if (pattern == NULL)
 	{
@@ -1620,7 +2207,15 @@ set_filter_pattern_real (GeditFileBrowserWidget *obj,
 	}
 	else
 	{
-		obj->priv->filter_pattern = g_pattern_spec_new (pattern);
+		recursive = g_str_has_prefix (pattern, RECURSIVE_FILTER_PREFIX);
+		glob = recursive ? pattern + strlen (RECURSIVE_FILTER_PREFIX) : pattern;
+
+		if (*glob == '\0')
+			glob = "*";
+
+		globs[0] = glob;
+		obj->priv->filter_pattern = gedit_file_browser_glob_set_new (globs);
+		obj->priv->filter_match_path = strchr (glob, '/') != NULL;
 
 		if (obj->priv->glob_filter_id == 0)
 		{
@@ -1632,6 +2227,13 @@ set_filter_pattern_real (GeditFileBrowserWidget *obj,
 		}
 	}
 
+	obj->priv->filter_recursive = recursive;
+
+	if (recursive)
+		recursive_filter_update (obj);
+	else
+		recursive_filter_stop (obj);
+
 	if (update_entry)
 	{
 		gtk_entry_set_text (GTK_ENTRY (obj->priv->filter_entry),
@@ -1977,6 +2579,15 @@ set_busy (GeditFileBrowserWidget *obj,
 	}
 }
 
+static void
+on_file_store_delete_progress (GeditFileBrowserStore  *store,
+			       guint                   n_processed,
+			       guint                   n_total,
+			       GeditFileBrowserWidget *obj)
+{
+	set_busy (obj, n_processed < n_total);
+}
+
 static void try_mount_volume (GeditFileBrowserWidget *widget, GVolume *volume);
 
 static void
@@ -2429,6 +3040,10 @@ on_virtual_root_changed (GeditFileBrowserStore  *model,
 {
 	GtkTreeIter iter;
 
+	/* Index the new virtual root */
+	if (obj->priv->filter_recursive)
+		recursive_filter_update (obj);
+
 	if (gtk_tree_view_get_model (GTK_TREE_VIEW (obj->priv->treeview)) !=
 	    GTK_TREE_MODEL (obj->priv->file_store))
 	{
@@ -2565,6 +3180,11 @@ on_model_set (GObject *gobject, GParamSpec *arg1,
 		                              G_CALLBACK (on_file_store_no_trash),
 		                              obj));
 
+		add_signal (obj, model,
+		            g_signal_connect (model, "delete-progress",
+		                              G_CALLBACK (on_file_store_delete_progress),
+		                              obj));
+
 		gtk_widget_show (obj->priv->filter_entry_revealer);
 	}
 
@@ -2910,6 +3530,14 @@ on_treeview_key_press_event (GeditFileBrowserView   *treeview,
 
 	modifiers = gtk_accelerator_get_default_mod_mask ();
 
+	/* Stop deleting the files */
+	if (event->keyval == GDK_KEY_Escape &&
+	    (event->state & modifiers) == 0 &&
+	    gedit_file_browser_store_cancel_delete (GEDIT_FILE_BROWSER_STORE (model)))
+	{
+		return TRUE;
+	}
+
 	if (event->keyval == GDK_KEY_Delete ||
 	    event->keyval == GDK_KEY_KP_Delete)
 	{
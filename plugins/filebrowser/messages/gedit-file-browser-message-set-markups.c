@@ -0,0 +1,154 @@
+
+/*
+ * gedit-file-browser-message-set-markups.c
+ * This file is part of gedit
+ *
+ * gedit is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * gedit is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gedit; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA  02110-1301  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "gedit-file-browser-message-set-markups.h"
+
+enum
+{
+	PROP_0,
+
+	PROP_LOCATIONS,
+	PROP_MARKUPS,
+};
+
+struct _GeditFileBrowserMessageSetMarkupsPrivate
+{
+	gchar **locations;
+	gchar **markups;
+};
+
+G_DEFINE_TYPE_EXTENDED (GeditFileBrowserMessageSetMarkups,
+                        gedit_file_browser_message_set_markups,
+                        GEDIT_TYPE_MESSAGE,
+                        0,
+                        G_ADD_PRIVATE (GeditFileBrowserMessageSetMarkups))
+
+static void
+gedit_file_browser_message_set_markups_finalize (GObject *obj)
+{
+	GeditFileBrowserMessageSetMarkups *msg = GEDIT_FILE_BROWSER_MESSAGE_SET_MARKUPS (obj);
+
+	if (msg->priv->locations != NULL)
+	{
+		g_boxed_free (G_TYPE_STRV, msg->priv->locations);
+	}
+	if (msg->priv->markups != NULL)
+	{
+		g_boxed_free (G_TYPE_STRV, msg->priv->markups);
+	}
+
+	G_OBJECT_CLASS (gedit_file_browser_message_set_markups_parent_class)->finalize (obj);
+}
+
+static void
+gedit_file_browser_message_set_markups_get_property (GObject    *obj,
+                                                     guint       prop_id,
+                                                     GValue     *value,
+                                                     GParamSpec *pspec)
+{
+	GeditFileBrowserMessageSetMarkups *msg;
+
+	msg = GEDIT_FILE_BROWSER_MESSAGE_SET_MARKUPS (obj);
+
+	switch (prop_id)
+	{
+		case PROP_LOCATIONS:
+			g_value_set_boxed (value, msg->priv->locations);
+			break;
+		case PROP_MARKUPS:
+			g_value_set_boxed (value, msg->priv->markups);
+			break;
+	}
+}
+
+static void
+gedit_file_browser_message_set_markups_set_property (GObject      *obj,
+                                                     guint         prop_id,
+                                                     GValue const *value,
+                                                     GParamSpec   *pspec)
+{
+	GeditFileBrowserMessageSetMarkups *msg;
+
+	msg = GEDIT_FILE_BROWSER_MESSAGE_SET_MARKUPS (obj);
+
+	switch (prop_id)
+	{
+		case PROP_LOCATIONS:
+		{
+			if (msg->priv->locations != NULL)
+			{
+				g_boxed_free (G_TYPE_STRV, msg->priv->locations);
+			}
+			msg->priv->locations = g_value_dup_boxed (value);
+			break;
+		}
+		case PROP_MARKUPS:
+		{
+			if (msg->priv->markups != NULL)
+			{
+				g_boxed_free (G_TYPE_STRV, msg->priv->markups);
+			}
+			msg->priv->markups = g_value_dup_boxed (value);
+			break;
+		}
+	}
+}
+
+static void
+gedit_file_browser_message_set_markups_class_init (GeditFileBrowserMessageSetMarkupsClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS(klass);
+
+	object_class->finalize = gedit_file_browser_message_set_markups_finalize;
+
+	object_class->get_property = gedit_file_browser_message_set_markups_get_property;
+	object_class->set_property = gedit_file_browser_message_set_markups_set_property;
+
+	g_object_class_install_property (object_class,
+	                                 PROP_LOCATIONS,
+	                                 g_param_spec_boxed ("locations",
+	                                                     "Locations",
+	                                                     "Locations",
+	                                                     G_TYPE_STRV,
+	                                                     G_PARAM_READWRITE |
+	                                                     G_PARAM_CONSTRUCT |
+	                                                     G_PARAM_STATIC_STRINGS));
+
+	g_object_class_install_property (object_class,
+	                                 PROP_MARKUPS,
+	                                 g_param_spec_boxed ("markups",
+	                                                     "Markups",
+	                                                     "Markups",
+	                                                     G_TYPE_STRV,
+	                                                     G_PARAM_READWRITE |
+	                                                     G_PARAM_CONSTRUCT |
+	                                                     G_PARAM_STATIC_STRINGS));
+}
+
+static void
+gedit_file_browser_message_set_markups_init (GeditFileBrowserMessageSetMarkups *message)
+{
+	message->priv = gedit_file_browser_message_set_markups_get_instance_private (message);
+}
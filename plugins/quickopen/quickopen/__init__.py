@@ -72,6 +72,10 @@ class QuickOpenPlugin(GObject.Object, Gedit.WindowActivatable):
     def _create_popup(self):
         paths = []
 
+        # Only the directories the user works in are indexed, the index
+        # keeps a few roots and would evict them on each popup otherwise
+        indexed = []
+
         # Open documents
         paths.append(CurrentDocumentsDirectory(self.window))
 
@@ -81,6 +85,7 @@ class QuickOpenPlugin(GObject.Object, Gedit.WindowActivatable):
         if doc and doc.get_file().is_local():
             gfile = doc.get_file().get_location()
             paths.append(gfile.get_parent())
+            indexed.append(gfile.get_parent())
 
         # File browser root directory
         bus = self.window.get_message_bus()
@@ -93,6 +98,7 @@ class QuickOpenPlugin(GObject.Object, Gedit.WindowActivatable):
 
                 if gfile and gfile.is_native():
                     paths.append(gfile)
+                    indexed.append(gfile)
 
         # Recent documents
         paths.append(RecentDocumentsDirectory())
@@ -110,7 +116,7 @@ class QuickOpenPlugin(GObject.Object, Gedit.WindowActivatable):
         # Home directory
         paths.append(Gio.file_new_for_path(os.path.expanduser('~')))
 
-        self._popup = Popup(self.window, paths, self.on_activated)
+        self._popup = Popup(self.window, paths, self.on_activated, indexed)
         self.window.get_group().add_window(self._popup)
 
         self._popup.set_default_size(*self.get_popup_size())
@@ -25,10 +25,20 @@ import xml.sax.saxutils
 from .virtualdirs import VirtualDirectory
 
 
+class Search(object):
+    def __init__(self, parts, n_dirs):
+        self.parts = parts
+        self.results = [None] * n_dirs
+        self.pending = n_dirs
+        self.cancellable = Gio.Cancellable()
+
+
 class Popup(Gtk.Dialog):
     __gtype_name__ = "QuickOpenPopup"
 
-    def __init__(self, window, paths, handler):
+    MAX_INDEX_RESULTS = 500
+
+    def __init__(self, window, paths, handler, indexed=()):
         Gtk.Dialog.__init__(self,
                             title=_('Quick Open'),
                             transient_for=window,
@@ -45,11 +55,15 @@ class Popup(Gtk.Dialog):
         self._size = (0, 0)
         self._dirs = []
         self._cache = {}
+        self._search = None
         self._theme = None
         self._cursor = None
         self._shift_start = None
 
         self._busy_cursor = Gdk.Cursor(Gdk.CursorType.WATCH)
+        self._folder_icon = Gio.ThemedIcon.new('folder')
+        self._index = Gedit.FileIndex.get_default()
+        self._indexed = [path.get_uri() for path in indexed]
 
         accel_group = Gtk.AccelGroup()
         accel_group.connect(Gdk.KEY_l,
@@ -66,11 +80,32 @@ class Popup(Gtk.Dialog):
                 self._dirs.append(path)
                 unique.append(path.get_uri())
 
+                # Searched through the index once it is ready, the
+                # directories are walked in the meantime
+                if self._should_index(path):
+                    self._index.add_root(path)
+
+        self._root_ready_id = self._index.connect('root-ready', self.on_root_ready)
+
         self.connect('show', self.on_show)
+        self.connect('destroy', self.on_destroy)
 
     def get_final_size(self):
         return self._size
 
+    def _should_index(self, path):
+        if isinstance(path, VirtualDirectory) or not path.is_native():
+            return False
+
+        if not path.get_uri() in self._indexed:
+            return False
+
+        # The whole home directory is far too big to be indexed, it is
+        # only walked
+        home = Gio.file_new_for_path(os.path.expanduser('~'))
+
+        return not path.equal(home) and not home.has_prefix(path)
+
     def _build_ui(self):
         self.set_border_width(5)
         vbox = self.get_content_area()
@@ -269,6 +304,28 @@ class Popup(Gtk.Dialog):
 
         return found
 
+    def _index_entries(self, d, matches):
+        found = []
+
+        for match in matches:
+            gfile = d.resolve_relative_path(match.get_path())
+
+            if match.is_dir():
+                file_type = Gio.FileType.DIRECTORY
+                icon = self._folder_icon
+            else:
+                file_type = Gio.FileType.REGULAR
+                content_type, uncertain = Gio.content_type_guess(gfile.get_basename(), None)
+                icon = Gio.content_type_get_icon(content_type)
+
+            found.append((gfile,
+                          gfile.get_basename(),
+                          file_type,
+                          icon,
+                          match.get_offsets()))
+
+        return found
+
     def _replace_insensitive(self, s, find, rep):
         out = ''
         l = s.lower()
@@ -289,6 +346,23 @@ class Popup(Gtk.Dialog):
 
         return out + xml.sax.saxutils.escape(s[last:])
 
+    def make_offsets_markup(self, path, offsets):
+        offsets = set(offsets)
+        out = ''
+        bold = False
+
+        for i, c in enumerate(path):
+            if (i in offsets) != bold:
+                out += '</b>' if bold else '<b>'
+                bold = not bold
+
+            out += xml.sax.saxutils.escape(c)
+
+        if bold:
+            out += '</b>'
+
+        return out
+
     def make_markup(self, parts, path):
         out = []
 
@@ -374,32 +448,89 @@ class Popup(Gtk.Dialog):
 
             self._store.row_changed(path, self._store.get_iter(path))
 
+    def _select_first(self):
+        piter = self._store.get_iter_first()
+        if piter:
+            path = self._store.get_path(piter)
+            self._treeview.get_selection().select_path(path)
+
+    def _cancel_search(self):
+        if self._search:
+            self._search.cancellable.cancel()
+            self._search = None
+
     def do_search(self):
-        self._set_busy(True)
         self._remove_cursor()
+        self._cancel_search()
 
         text = self._entry.get_text().strip()
-        self._clear_store()
 
         if text == '':
+            self._clear_store()
             self._show_virtuals()
-        else:
-            parts = self.normalize_relative(text.split(os.sep))
-            files = []
-
-            for d in self._dirs:
-                for entry in self.do_search_dir(parts, d):
-                    pathparts = self._make_parts(d, entry[0], parts)
-                    self._append_to_store((entry[3],
-                                          self.make_markup(parts, pathparts),
-                                          entry[0],
-                                          entry[2]))
+            self._select_first()
+            self._set_busy(False)
+            return
 
-        piter = self._store.get_iter_first()
-        if piter:
-            path = self._store.get_path(piter)
-            self._treeview.get_selection().select_path(path)
+        self._set_busy(True)
+
+        parts = self.normalize_relative(text.split(os.sep))
+        search = Search(parts, len(self._dirs))
+        self._search = search
+
+        # The indexed directories are scored in threads, the query
+        # is cancelled when the text changes again
+        for i, d in enumerate(self._dirs):
+            if self._should_index(d):
+                self._index.query_async(d,
+                                        parts,
+                                        self.MAX_INDEX_RESULTS,
+                                        search.cancellable,
+                                        self.on_index_query_ready,
+                                        (search, i))
+            else:
+                self._search_done(search, i, self.do_search_dir(parts, d))
+
+    def on_index_query_ready(self, index, result, data):
+        search, i = data
+
+        try:
+            found = self._index_entries(self._dirs[i], index.query_finish(result))
+        except GLib.Error as e:
+            if e.matches(Gio.io_error_quark(), Gio.IOErrorEnum.CANCELLED):
+                return
+
+            # Not indexed (deep enough) yet
+            found = self.do_search_dir(search.parts, self._dirs[i])
 
+        self._search_done(search, i, found)
+
+    def _search_done(self, search, i, found):
+        if search is not self._search:
+            return
+
+        search.results[i] = found
+        search.pending -= 1
+
+        if search.pending > 0:
+            return
+
+        self._search = None
+        self._clear_store()
+
+        for d, results in zip(self._dirs, search.results):
+            for entry in results:
+                pathparts = self._make_parts(d, entry[0], search.parts)
+
+                if len(entry) > 4:
+                    markup = self.make_offsets_markup(os.sep.join(pathparts), entry[4])
+                else:
+                    markup = self.make_markup(search.parts, pathparts)
+
+                self._append_to_store((entry[3], markup, entry[0], entry[2]))
+
+        self._select_first()
+        self.on_selection_changed(self._treeview.get_selection())
         self._set_busy(False)
 
     # FIXME: override doesn't work anymore for some reason, if we override
@@ -412,6 +543,15 @@ class Popup(Gtk.Dialog):
 
         self.do_search()
 
+    def on_root_ready(self, index, root):
+        if self._entry.get_text().strip() != '':
+            self.do_search()
+            self.on_selection_changed(self._treeview.get_selection())
+
+    def on_destroy(self, widget):
+        self._cancel_search()
+        self._index.disconnect(self._root_ready_id)
+
     def on_changed(self, editable):
         self.do_search()
         self.on_selection_changed(self._treeview.get_selection())
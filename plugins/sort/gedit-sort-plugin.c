@@ -23,14 +23,17 @@
 #endif
 
 #include "gedit-sort-plugin.h"
+#include "sort-engine.h"
 
 #include <string.h>
 #include <glib/gi18n.h>
 
 #include <gedit/gedit-debug.h>
+#include <gedit/gedit-commands.h>
 #include <gedit/gedit-utils.h>
 #include <gedit/gedit-app.h>
 #include <gedit/gedit-window.h>
+#include <gedit/gedit-statusbar.h>
 #include <gedit/gedit-app-activatable.h>
 #include <gedit/gedit-window-activatable.h>
 
@@ -47,13 +50,35 @@ struct _GeditSortPluginPrivate
 	GtkWidget *reverse_order_checkbutton;
 	GtkWidget *case_checkbutton;
 	GtkWidget *remove_dups_checkbutton;
+	GtkWidget *sort_mode_combo;
+	GtkWidget *options_box;
+	GtkWidget *progress_bar;
+	GtkWidget *error_info_bar;
+	GtkWidget *error_label;
+	GtkWidget *file_checkbutton;
+	GtkWidget *file_chooser_button;
 
 	GeditApp *app;
 	GeditMenuExtension *menu_ext;
 
 	GtkTextIter start, end; /* selection */
+
+	/* Sort in progress */
+	GeditDocument *doc;
+	GtkTextMark *start_mark;
+	GtkTextMark *end_mark;
+	GCancellable *cancellable;
+	SortJob *job;
+	SortFileJob *file_job;
+	guint progress_id;
 };
 
+/* Interval in ms between updates of the progress bar */
+#define PROGRESS_UPDATE_INTERVAL 100
+
+/* Sorted files bigger than this are not opened automatically */
+#define SORT_FILE_OPEN_MAX_SIZE (32 * 1024 * 1024)
+
 enum
 {
 	PROP_0,
@@ -71,13 +96,428 @@ G_DEFINE_DYNAMIC_TYPE_EXTENDED (GeditSortPlugin,
 							       gedit_window_activatable_iface_init)
 				G_ADD_PRIVATE_DYNAMIC (GeditSortPlugin))
 
+static void
+get_sort_options (GeditSortPlugin *plugin,
+		  SortOptions     *options)
+{
+	GeditSortPluginPrivate *priv;
+	const gchar *mode;
+
+	priv = plugin->priv;
+
+	options->case_sensitive = gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (priv->case_checkbutton));
+	options->reverse = gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (priv->reverse_order_checkbutton));
+	options->remove_duplicates = gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (priv->remove_dups_checkbutton));
+	options->starting_column = gtk_spin_button_get_value_as_int (GTK_SPIN_BUTTON (priv->col_num_spinbutton)) - 1;
+
+	mode = gtk_combo_box_get_active_id (GTK_COMBO_BOX (priv->sort_mode_combo));
+
+	if (g_strcmp0 (mode, "numeric") == 0)
+	{
+		options->mode = SORT_MODE_NUMERIC;
+	}
+	else if (g_strcmp0 (mode, "natural") == 0)
+	{
+		options->mode = SORT_MODE_NATURAL;
+	}
+	else if (g_strcmp0 (mode, "version") == 0)
+	{
+		options->mode = SORT_MODE_VERSION;
+	}
+	else
+	{
+		options->mode = SORT_MODE_ALPHABETICAL;
+	}
+}
+
+static void
+clear_sort (GeditSortPlugin *plugin)
+{
+	GeditSortPluginPrivate *priv;
+
+	priv = plugin->priv;
+
+	if (priv->cancellable != NULL)
+	{
+		g_cancellable_cancel (priv->cancellable);
+		g_clear_object (&priv->cancellable);
+	}
+
+	if (priv->progress_id != 0)
+	{
+		g_source_remove (priv->progress_id);
+		priv->progress_id = 0;
+	}
+
+	if (priv->doc != NULL)
+	{
+		gtk_text_buffer_delete_mark (GTK_TEXT_BUFFER (priv->doc), priv->start_mark);
+		gtk_text_buffer_delete_mark (GTK_TEXT_BUFFER (priv->doc), priv->end_mark);
+		priv->start_mark = NULL;
+		priv->end_mark = NULL;
+
+		g_clear_object (&priv->doc);
+	}
+
+	priv->job = NULL;
+	priv->file_job = NULL;
+}
+
+static gboolean
+update_progress_cb (GeditSortPlugin *plugin)
+{
+	GeditSortPluginPrivate *priv;
+
+	priv = plugin->priv;
+
+	if (priv->job != NULL && priv->progress_bar != NULL)
+	{
+		gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (priv->progress_bar),
+					       sort_job_get_progress (priv->job));
+	}
+	else if (priv->file_job != NULL && priv->progress_bar != NULL)
+	{
+		gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (priv->progress_bar),
+					       sort_file_job_get_progress (priv->file_job));
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+
+static void
+sort_thread (GTask        *task,
+	     gpointer      source_object,
+	     gpointer      task_data,
+	     GCancellable *cancellable)
+{
+	if (sort_job_run (task_data, cancellable))
+	{
+		g_task_return_boolean (task, TRUE);
+	}
+	else
+	{
+		g_task_return_error_if_cancelled (task);
+	}
+}
+
+static void
+sort_ready_cb (GObject      *source_object,
+	       GAsyncResult *result,
+	       gpointer      user_data)
+{
+	GeditSortPlugin *plugin;
+	GeditSortPluginPrivate *priv;
+	GtkTextBuffer *buffer;
+	GtkTextIter start, end;
+	gchar *sorted;
+	GError *error = NULL;
+
+	if (!g_task_propagate_boolean (G_TASK (result), &error))
+	{
+		/* Cancelled: the dialog or the plugin is gone */
+		g_error_free (error);
+		return;
+	}
+
+	plugin = GEDIT_SORT_PLUGIN (user_data);
+	priv = plugin->priv;
+
+	sorted = sort_job_steal_result (g_task_get_task_data (G_TASK (result)));
+
+	buffer = GTK_TEXT_BUFFER (priv->doc);
+	gtk_text_buffer_get_iter_at_mark (buffer, &start, priv->start_mark);
+	gtk_text_buffer_get_iter_at_mark (buffer, &end, priv->end_mark);
+
+	/* Replace the lines in one go, so it is also a single undo step */
+	gtk_text_buffer_begin_user_action (buffer);
+	gtk_text_buffer_delete (buffer, &start, &end);
+	gtk_text_buffer_insert (buffer, &start, sorted, -1);
+	gtk_text_buffer_end_user_action (buffer);
+
+	g_free (sorted);
+
+	clear_sort (plugin);
+
+	gedit_debug_message (DEBUG_PLUGINS, "Done.");
+
+	if (priv->dialog != NULL)
+	{
+		gtk_widget_destroy (priv->dialog);
+	}
+}
+
+static void
+set_sort_running (GeditSortPlugin *plugin,
+		  gboolean         running)
+{
+	GeditSortPluginPrivate *priv;
+
+	priv = plugin->priv;
+
+	gtk_widget_set_sensitive (priv->options_box, !running);
+	gtk_dialog_set_response_sensitive (GTK_DIALOG (priv->dialog),
+					   GTK_RESPONSE_OK,
+					   !running);
+	gtk_widget_set_visible (priv->progress_bar, running);
+
+	if (running)
+	{
+		gtk_widget_hide (priv->error_info_bar);
+	}
+}
+
+static void
+show_sort_error (GeditSortPlugin *plugin,
+		 const gchar     *message)
+{
+	GeditSortPluginPrivate *priv;
+
+	priv = plugin->priv;
+
+	gtk_label_set_text (GTK_LABEL (priv->error_label), message);
+	gtk_widget_show (priv->error_info_bar);
+}
+
+static void
+sort_file_thread (GTask        *task,
+		  gpointer      source_object,
+		  gpointer      task_data,
+		  GCancellable *cancellable)
+{
+	GFileInfo *info;
+	GError *error = NULL;
+
+	if (!sort_file_job_run (task_data, cancellable, &error))
+	{
+		g_task_return_error (task, error);
+		return;
+	}
+
+	/* The size decides whether the result is opened in a tab */
+	info = g_file_query_info (G_FILE (source_object),
+				  G_FILE_ATTRIBUTE_STANDARD_SIZE,
+				  G_FILE_QUERY_INFO_NONE,
+				  cancellable,
+				  NULL);
+
+	g_task_return_int (task, info != NULL ? g_file_info_get_size (info) : 0);
+	g_clear_object (&info);
+}
+
+static void
+sort_file_ready_cb (GObject      *source_object,
+		    GAsyncResult *result,
+		    gpointer      user_data)
+{
+	GeditSortPlugin *plugin;
+	GeditSortPluginPrivate *priv;
+	GFile *output;
+	gssize size;
+	GError *error = NULL;
+
+	size = g_task_propagate_int (G_TASK (result), &error);
+
+	if (error != NULL)
+	{
+		/* Cancelled: the dialog or the plugin is gone */
+		if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+		{
+			gchar *message;
+
+			plugin = GEDIT_SORT_PLUGIN (user_data);
+			clear_sort (plugin);
+
+			if (plugin->priv->dialog != NULL)
+			{
+				/* Leave the dialog open so that another file
+				 * or destination can be chosen.
+				 */
+				set_sort_running (plugin, FALSE);
+
+				message = g_strdup_printf (_("Could not sort the file: %s"),
+							   error->message);
+				show_sort_error (plugin, message);
+				g_free (message);
+			}
+		}
+
+		g_error_free (error);
+		return;
+	}
+
+	plugin = GEDIT_SORT_PLUGIN (user_data);
+	priv = plugin->priv;
+
+	output = G_FILE (source_object);
+
+	if (size <= SORT_FILE_OPEN_MAX_SIZE)
+	{
+		gedit_commands_load_location (priv->window, output, NULL, 0, 0);
+	}
+	else
+	{
+		GtkWidget *statusbar;
+		gchar *name;
+
+		statusbar = gedit_window_get_statusbar (priv->window);
+		name = g_file_get_parse_name (output);
+
+		gedit_statusbar_flash_message (GEDIT_STATUSBAR (statusbar),
+					       gtk_statusbar_get_context_id (GTK_STATUSBAR (statusbar),
+									     "sort_plugin_message"),
+					       _("The sorted lines were saved to “%s”"),
+					       name);
+		g_free (name);
+	}
+
+	clear_sort (plugin);
+
+	gedit_debug_message (DEBUG_PLUGINS, "Done.");
+
+	if (priv->dialog != NULL)
+	{
+		gtk_widget_destroy (priv->dialog);
+	}
+}
+
+static void
+start_sort_file (GeditSortPlugin *plugin,
+		 GFile           *input,
+		 GFile           *output)
+{
+	GeditSortPluginPrivate *priv;
+	SortOptions options;
+	GTask *task;
+
+	gedit_debug (DEBUG_PLUGINS);
+
+	priv = plugin->priv;
+
+	get_sort_options (plugin, &options);
+
+	priv->cancellable = g_cancellable_new ();
+	priv->file_job = sort_file_job_new (input, output, &options);
+
+	set_sort_running (plugin, TRUE);
+
+	priv->progress_id = g_timeout_add (PROGRESS_UPDATE_INTERVAL,
+					   (GSourceFunc) update_progress_cb,
+					   plugin);
+
+	task = g_task_new (output, priv->cancellable, sort_file_ready_cb, plugin);
+	g_task_set_task_data (task, priv->file_job, (GDestroyNotify) sort_file_job_free);
+	g_task_run_in_thread (task, sort_file_thread);
+	g_object_unref (task);
+}
+
+static void
+output_chooser_response_cb (GtkDialog       *chooser,
+			    gint             response,
+			    GeditSortPlugin *plugin)
+{
+	GeditSortPluginPrivate *priv;
+	GFile *input;
+	GFile *output;
+
+	priv = plugin->priv;
+
+	if (response != GTK_RESPONSE_ACCEPT || priv->dialog == NULL)
+	{
+		gtk_widget_destroy (GTK_WIDGET (chooser));
+		return;
+	}
+
+	output = gtk_file_chooser_get_file (GTK_FILE_CHOOSER (chooser));
+	gtk_widget_destroy (GTK_WIDGET (chooser));
+
+	input = gtk_file_chooser_get_file (GTK_FILE_CHOOSER (priv->file_chooser_button));
+
+	if (input == NULL || output == NULL)
+	{
+		/* Nothing to do */
+	}
+	else if (g_file_equal (input, output))
+	{
+		/* The input is still read while the output is written */
+		show_sort_error (plugin,
+				 _("The sorted lines cannot be saved to the file being sorted."));
+	}
+	else
+	{
+		start_sort_file (plugin, input, output);
+	}
+
+	g_clear_object (&input);
+	g_clear_object (&output);
+}
+
+static void
+do_sort_file (GeditSortPlugin *plugin)
+{
+	GeditSortPluginPrivate *priv;
+	GtkWidget *chooser;
+	GFile *input;
+	GFile *parent;
+	gchar *basename;
+	gchar *name;
+
+	gedit_debug (DEBUG_PLUGINS);
+
+	priv = plugin->priv;
+
+	input = gtk_file_chooser_get_file (GTK_FILE_CHOOSER (priv->file_chooser_button));
+	g_return_if_fail (input != NULL);
+
+	chooser = gtk_file_chooser_dialog_new (_("Save Sorted Lines As"),
+					       GTK_WINDOW (priv->dialog),
+					       GTK_FILE_CHOOSER_ACTION_SAVE,
+					       _("_Cancel"), GTK_RESPONSE_CANCEL,
+					       _("_Save"), GTK_RESPONSE_ACCEPT,
+					       NULL);
+
+	gtk_dialog_set_default_response (GTK_DIALOG (chooser), GTK_RESPONSE_ACCEPT);
+	gtk_window_set_modal (GTK_WINDOW (chooser), TRUE);
+	gtk_window_set_destroy_with_parent (GTK_WINDOW (chooser), TRUE);
+
+	/* Existing files are only replaced once the user agreed to it */
+	gtk_file_chooser_set_do_overwrite_confirmation (GTK_FILE_CHOOSER (chooser), TRUE);
+
+	/* Suggest a name next to the input file */
+	parent = g_file_get_parent (input);
+	if (parent != NULL)
+	{
+		gtk_file_chooser_set_current_folder_file (GTK_FILE_CHOOSER (chooser),
+							  parent,
+							  NULL);
+		g_object_unref (parent);
+	}
+
+	basename = g_file_get_basename (input);
+	name = g_strconcat (basename, ".sorted", NULL);
+	gtk_file_chooser_set_current_name (GTK_FILE_CHOOSER (chooser), name);
+	g_free (basename);
+	g_free (name);
+
+	g_signal_connect (chooser,
+			  "response",
+			  G_CALLBACK (output_chooser_response_cb),
+			  plugin);
+
+	gtk_widget_show (chooser);
+
+	g_object_unref (input);
+}
+
 static void
 do_sort (GeditSortPlugin *plugin)
 {
 	GeditSortPluginPrivate *priv;
 	GeditDocument *doc;
-	GtkSourceSortFlags sort_flags = 0;
-	gint starting_column;
+	GtkTextBuffer *buffer;
+	SortOptions options;
+	GtkTextIter start, end;
+	gint start_line, end_line;
+	GTask *task;
 
 	gedit_debug (DEBUG_PLUGINS);
 
@@ -86,30 +526,50 @@ do_sort (GeditSortPlugin *plugin)
 	doc = gedit_window_get_active_document (priv->window);
 	g_return_if_fail (doc != NULL);
 
-	if (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (priv->case_checkbutton)))
-	{
-		sort_flags |= GTK_SOURCE_SORT_FLAGS_CASE_SENSITIVE;
-	}
+	buffer = GTK_TEXT_BUFFER (doc);
 
-	if (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (priv->reverse_order_checkbutton)))
+	get_sort_options (plugin, &options);
+
+	/* Like gtk_source_buffer_sort_lines(), sort whole lines and do not
+	 * include the line the selection ends at if it ends at its start.
+	 */
+	start = priv->start;
+	end = priv->end;
+
+	start_line = gtk_text_iter_get_line (&start);
+	end_line = gtk_text_iter_get_line (&end);
+
+	if (start_line < end_line && gtk_text_iter_starts_line (&end))
 	{
-		sort_flags |= GTK_SOURCE_SORT_FLAGS_REVERSE_ORDER;
+		end_line--;
 	}
 
-	if (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (priv->remove_dups_checkbutton)))
+	gtk_text_buffer_get_iter_at_line (buffer, &start, start_line);
+	gtk_text_buffer_get_iter_at_line (buffer, &end, end_line);
+
+	if (!gtk_text_iter_ends_line (&end))
 	{
-		sort_flags |= GTK_SOURCE_SORT_FLAGS_REMOVE_DUPLICATES;
+		gtk_text_iter_forward_to_line_end (&end);
 	}
 
-	starting_column = gtk_spin_button_get_value_as_int (GTK_SPIN_BUTTON (priv->col_num_spinbutton)) - 1;
+	priv->doc = g_object_ref (doc);
+	priv->start_mark = gtk_text_buffer_create_mark (buffer, NULL, &start, TRUE);
+	priv->end_mark = gtk_text_buffer_create_mark (buffer, NULL, &end, FALSE);
+	priv->cancellable = g_cancellable_new ();
 
-	gtk_source_buffer_sort_lines (GTK_SOURCE_BUFFER (doc),
-	                              &priv->start,
-	                              &priv->end,
-	                              sort_flags,
-	                              starting_column);
+	priv->job = sort_job_new (gtk_text_buffer_get_slice (buffer, &start, &end, TRUE),
+				  &options);
 
-	gedit_debug_message (DEBUG_PLUGINS, "Done.");
+	set_sort_running (plugin, TRUE);
+
+	priv->progress_id = g_timeout_add (PROGRESS_UPDATE_INTERVAL,
+					   (GSourceFunc) update_progress_cb,
+					   plugin);
+
+	task = g_task_new (NULL, priv->cancellable, sort_ready_cb, plugin);
+	g_task_set_task_data (task, priv->job, (GDestroyNotify) sort_job_free);
+	g_task_run_in_thread (task, sort_thread);
+	g_object_unref (task);
 }
 
 static void
@@ -121,12 +581,55 @@ sort_dialog_response_handler (GtkDialog       *dlg,
 
 	if (response == GTK_RESPONSE_OK)
 	{
-		do_sort (plugin);
+		GeditSortPluginPrivate *priv = plugin->priv;
+
+		/* The dialog is destroyed when the sort is done */
+		if (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (priv->file_checkbutton)))
+		{
+			do_sort_file (plugin);
+		}
+		else
+		{
+			do_sort (plugin);
+		}
+
+		return;
 	}
 
 	gtk_widget_destroy (GTK_WIDGET (dlg));
 }
 
+static void
+sort_dialog_destroy_cb (GtkWidget       *widget,
+			GeditSortPlugin *plugin)
+{
+	/* Closing the dialog cancels the sort in progress */
+	clear_sort (plugin);
+}
+
+static void
+file_mode_changed_cb (GtkWidget       *widget,
+		      GeditSortPlugin *plugin)
+{
+	GeditSortPluginPrivate *priv;
+	GFile *file;
+	gboolean sensitive = TRUE;
+
+	priv = plugin->priv;
+
+	/* A file has to be chosen to sort a file on disk */
+	if (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (priv->file_checkbutton)))
+	{
+		file = gtk_file_chooser_get_file (GTK_FILE_CHOOSER (priv->file_chooser_button));
+		sensitive = file != NULL;
+		g_clear_object (&file);
+	}
+
+	gtk_dialog_set_response_sensitive (GTK_DIALOG (priv->dialog),
+					   GTK_RESPONSE_OK,
+					   sensitive);
+}
+
 /* NOTE: we store the current selection in the dialog since focusing
  * the text field (like the combo box) looses the documnent selection.
  * Storing the selection ONLY works because the dialog is modal */
@@ -170,8 +673,27 @@ create_sort_dialog (GeditSortPlugin *plugin)
 	priv->col_num_spinbutton = GTK_WIDGET (gtk_builder_get_object (builder, "col_num_spinbutton"));
 	priv->case_checkbutton = GTK_WIDGET (gtk_builder_get_object (builder, "case_checkbutton"));
 	priv->remove_dups_checkbutton = GTK_WIDGET (gtk_builder_get_object (builder, "remove_dups_checkbutton"));
+	priv->sort_mode_combo = GTK_WIDGET (gtk_builder_get_object (builder, "sort_mode_combo"));
+	priv->options_box = GTK_WIDGET (gtk_builder_get_object (builder, "vbox5"));
+	priv->progress_bar = GTK_WIDGET (gtk_builder_get_object (builder, "progress_bar"));
+	priv->error_info_bar = GTK_WIDGET (gtk_builder_get_object (builder, "error_info_bar"));
+	priv->error_label = GTK_WIDGET (gtk_builder_get_object (builder, "error_label"));
+	priv->file_checkbutton = GTK_WIDGET (gtk_builder_get_object (builder, "file_checkbutton"));
+	priv->file_chooser_button = GTK_WIDGET (gtk_builder_get_object (builder, "file_chooser_button"));
 	g_object_unref (builder);
 
+	g_object_bind_property (priv->file_checkbutton, "active",
+				priv->file_chooser_button, "sensitive",
+				G_BINDING_SYNC_CREATE);
+	g_signal_connect (priv->file_checkbutton,
+			  "toggled",
+			  G_CALLBACK (file_mode_changed_cb),
+			  plugin);
+	g_signal_connect (priv->file_chooser_button,
+			  "file-set",
+			  G_CALLBACK (file_mode_changed_cb),
+			  plugin);
+
 	gtk_dialog_set_default_response (GTK_DIALOG (priv->dialog),
 					 GTK_RESPONSE_OK);
 
@@ -180,6 +702,11 @@ create_sort_dialog (GeditSortPlugin *plugin)
 			  G_CALLBACK (gtk_widget_destroyed),
 			  &priv->dialog);
 
+	g_signal_connect (priv->dialog,
+			  "destroy",
+			  G_CALLBACK (sort_dialog_destroy_cb),
+			  plugin);
+
 	g_signal_connect (priv->dialog,
 			  "response",
 			  G_CALLBACK (sort_dialog_response_handler),
@@ -283,6 +810,12 @@ gedit_sort_plugin_window_deactivate (GeditWindowActivatable *activatable)
 	gedit_debug (DEBUG_PLUGINS);
 
 	priv = GEDIT_SORT_PLUGIN (activatable)->priv;
+
+	if (priv->dialog != NULL)
+	{
+		gtk_widget_destroy (priv->dialog);
+	}
+
 	g_action_map_remove_action (G_ACTION_MAP (priv->window), "sort");
 }
 
@@ -309,6 +842,8 @@ gedit_sort_plugin_dispose (GObject *object)
 
 	gedit_debug_message (DEBUG_PLUGINS, "GeditSortPlugin disposing");
 
+	clear_sort (plugin);
+
 	g_clear_object (&plugin->priv->action);
 	g_clear_object (&plugin->priv->window);
 	g_clear_object (&plugin->priv->menu_ext);
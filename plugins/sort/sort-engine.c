@@ -0,0 +1,1135 @@
+/*
+ * sort-engine.c
+ * This file is part of gedit
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* The sort engine sorts the lines of a text without touching any GTK+
+ * object, so that it can run on a worker thread. The text is split into
+ * lines once, a sort key is computed for every line (in parallel), the
+ * lines are sorted in parallel chunks and the chunks are then merged
+ * pairwise, again in parallel, until a single sorted run is left.
+ *
+ * Files too large to be loaded are sorted by SortFileJob: the file is
+ * read in chunks of bounded size, every chunk is sorted as above and
+ * spilled to a temporary file, and the runs are then k-way merged into
+ * the output file.
+ */
+
+#include "sort-engine.h"
+
+#include <math.h>
+#include <string.h>
+
+typedef struct _SortLine  SortLine;
+typedef struct _SortChunk SortChunk;
+typedef struct _MergeRun  MergeRun;
+
+struct _SortLine
+{
+	const gchar *line;
+	gint len;
+
+	/* strcmp() comparable key of the line from the starting column */
+	gchar *key;
+
+	/* Only used by SORT_MODE_NUMERIC */
+	gdouble number;
+};
+
+struct _SortJob
+{
+	SortOptions options;
+
+	gchar *text;
+	gsize text_len;
+
+	SortLine *lines;
+	guint n_lines;
+
+	gchar *result;
+
+	/* Work units, updated from several threads */
+	volatile gint work_done;
+	gint work_total;
+};
+
+struct _SortFileJob
+{
+	SortOptions options;
+
+	GFile *input;
+	GFile *output;
+
+	/* Temporary files holding the sorted runs */
+	GPtrArray *runs;
+
+	/* In bytes, read while spilling runs and written while merging */
+	volatile gint64 progress;
+	gint64 total;
+};
+
+struct _MergeRun
+{
+	GDataInputStream *stream;
+	SortLine line;
+	guint index;
+};
+
+typedef void (* SortChunkFunc) (SortChunk *chunk);
+
+struct _SortChunk
+{
+	SortJob *job;
+	GCancellable *cancellable;
+	SortChunkFunc func;
+
+	guint begin;
+	guint mid;
+	guint end;
+
+	SortLine *src;
+	SortLine *dst;
+};
+
+/* Below this number of lines threads are not worth it */
+#define MIN_LINES_PER_CHUNK 16384
+
+#define MAX_CHUNKS 16
+
+/* Number of lines processed between cancellation checks */
+#define CHECK_INTERVAL 4096
+
+/* Amount of the file sorted in memory at once */
+#define SORT_FILE_CHUNK_SIZE (64 * 1024 * 1024)
+
+#define SORT_FILE_BUFFER_SIZE (256 * 1024)
+
+/* Digit runs in version keys are encoded as VERSION_DIGITS_MARK, a length
+ * byte and the digits without leading zeros, so that strcmp() orders them
+ * numerically and before any text.
+ */
+#define VERSION_DIGITS_MARK '\001'
+
+static gchar *
+version_collate_key (const gchar *str,
+		     gssize       len)
+{
+	GString *key;
+	const gchar *p;
+	const gchar *end;
+
+	if (len < 0)
+	{
+		len = strlen (str);
+	}
+
+	key = g_string_sized_new (len + 8);
+	p = str;
+	end = str + len;
+
+	while (p < end)
+	{
+		const gchar *digits;
+
+		if (!g_ascii_isdigit (*p))
+		{
+			g_string_append_c (key, *p);
+			p++;
+			continue;
+		}
+
+		while (p < end - 1 && *p == '0' && g_ascii_isdigit (p[1]))
+		{
+			p++;
+		}
+
+		digits = p;
+		while (p < end && g_ascii_isdigit (*p))
+		{
+			p++;
+		}
+
+		g_string_append_c (key, VERSION_DIGITS_MARK);
+		g_string_append_c (key, (gchar) (1 + MIN (p - digits, 254)));
+		g_string_append_len (key, digits, p - digits);
+	}
+
+	return g_string_free (key, FALSE);
+}
+
+static void
+compute_key (SortLine          *line,
+	     const SortOptions *options)
+{
+	const gchar *str;
+	const gchar *end;
+	gchar *folded = NULL;
+	gint i;
+
+	str = line->line;
+	end = line->line + line->len;
+
+	for (i = 0; i < options->starting_column && str < end; i++)
+	{
+		str = g_utf8_next_char (str);
+	}
+
+	if (str > end)
+	{
+		str = end;
+	}
+
+	if (options->mode == SORT_MODE_NUMERIC)
+	{
+		gchar *num_end;
+
+		/* The line is nul-terminated, see split_lines() */
+		line->number = g_ascii_strtod (str, &num_end);
+
+		/* Lines without a number come first */
+		if (num_end == str || isnan (line->number))
+		{
+			line->number = -HUGE_VAL;
+		}
+	}
+
+	if (!options->case_sensitive)
+	{
+		folded = g_utf8_casefold (str, end - str);
+		str = folded;
+		end = folded + strlen (folded);
+	}
+
+	switch (options->mode)
+	{
+		case SORT_MODE_NATURAL:
+			line->key = g_utf8_collate_key_for_filename (str, end - str);
+			break;
+
+		case SORT_MODE_VERSION:
+			line->key = version_collate_key (str, end - str);
+			break;
+
+		case SORT_MODE_ALPHABETICAL:
+		case SORT_MODE_NUMERIC:
+		default:
+			line->key = g_utf8_collate_key (str, end - str);
+			break;
+	}
+
+	g_free (folded);
+}
+
+static gint
+compare_lines (gconstpointer a,
+	       gconstpointer b,
+	       gpointer      user_data)
+{
+	const SortLine *line_a = a;
+	const SortLine *line_b = b;
+	const SortOptions *options = user_data;
+	gint ret;
+
+	if (options->mode == SORT_MODE_NUMERIC &&
+	    line_a->number != line_b->number)
+	{
+		ret = line_a->number < line_b->number ? -1 : 1;
+	}
+	else
+	{
+		ret = strcmp (line_a->key, line_b->key);
+	}
+
+	return options->reverse ? -ret : ret;
+}
+
+static void
+add_work (SortJob *job,
+	  gint     units)
+{
+	g_atomic_int_add (&job->work_done, units);
+}
+
+static gpointer
+chunk_thread (gpointer data)
+{
+	SortChunk *chunk = data;
+
+	chunk->func (chunk);
+
+	return NULL;
+}
+
+static void
+run_chunks (SortChunk *chunks,
+	    guint      n_chunks)
+{
+	GThread *threads[MAX_CHUNKS];
+	guint i;
+
+	for (i = 1; i < n_chunks; i++)
+	{
+		threads[i] = g_thread_new ("gedit-sort", chunk_thread, &chunks[i]);
+	}
+
+	/* The calling thread takes the first chunk */
+	chunk_thread (&chunks[0]);
+
+	for (i = 1; i < n_chunks; i++)
+	{
+		g_thread_join (threads[i]);
+	}
+}
+
+static void
+compute_keys_chunk (SortChunk *chunk)
+{
+	SortJob *job = chunk->job;
+	guint i;
+
+	for (i = chunk->begin; i < chunk->end; i++)
+	{
+		if ((i - chunk->begin) % CHECK_INTERVAL == 0 && i != chunk->begin)
+		{
+			add_work (job, CHECK_INTERVAL);
+
+			if (g_cancellable_is_cancelled (chunk->cancellable))
+			{
+				return;
+			}
+		}
+
+		compute_key (&job->lines[i], &job->options);
+	}
+
+	add_work (job, (chunk->end - chunk->begin) % CHECK_INTERVAL);
+}
+
+static void
+sort_chunk (SortChunk *chunk)
+{
+	SortJob *job = chunk->job;
+
+	g_qsort_with_data (job->lines + chunk->begin,
+			   chunk->end - chunk->begin,
+			   sizeof (SortLine),
+			   compare_lines,
+			   &job->options);
+
+	add_work (job, chunk->end - chunk->begin);
+}
+
+static void
+merge_chunk (SortChunk *chunk)
+{
+	SortJob *job = chunk->job;
+	SortLine *dst;
+	guint i, j;
+	guint n = 0;
+
+	i = chunk->begin;
+	j = chunk->mid;
+	dst = chunk->dst + chunk->begin;
+
+	while (i < chunk->mid && j < chunk->end)
+	{
+		/* Take from the left run on ties to keep the sort stable */
+		if (compare_lines (&chunk->src[j], &chunk->src[i], &job->options) < 0)
+		{
+			*dst++ = chunk->src[j++];
+		}
+		else
+		{
+			*dst++ = chunk->src[i++];
+		}
+
+		if (++n % CHECK_INTERVAL == 0)
+		{
+			add_work (job, CHECK_INTERVAL);
+
+			if (g_cancellable_is_cancelled (chunk->cancellable))
+			{
+				return;
+			}
+		}
+	}
+
+	memcpy (dst, chunk->src + i, (chunk->mid - i) * sizeof (SortLine));
+	dst += chunk->mid - i;
+	memcpy (dst, chunk->src + j, (chunk->end - j) * sizeof (SortLine));
+
+	add_work (job, (chunk->end - chunk->begin) - (n - n % CHECK_INTERVAL));
+}
+
+static void
+split_lines (SortJob *job)
+{
+	gchar *p;
+	gchar *end;
+	guint n;
+
+	end = job->text + job->text_len;
+
+	n = 1;
+	for (p = job->text; (p = memchr (p, '\n', end - p)) != NULL; p++)
+	{
+		n++;
+	}
+
+	job->n_lines = n;
+	job->lines = g_new0 (SortLine, n);
+
+	p = job->text;
+	for (n = 0; n < job->n_lines; n++)
+	{
+		gchar *nl;
+		gchar *line_end;
+
+		nl = memchr (p, '\n', end - p);
+		line_end = nl != NULL ? nl : end;
+
+		job->lines[n].line = p;
+		job->lines[n].len = line_end - p;
+
+		/* Like gtk_text_iter_forward_to_line_end(), drop the \r of \r\n */
+		if (job->lines[n].len > 0 && line_end[-1] == '\r')
+		{
+			job->lines[n].len--;
+		}
+
+		/* Terminate every line so that strtod() stops at its end */
+		p[job->lines[n].len] = '\0';
+
+		p = line_end + 1;
+	}
+}
+
+static guint
+get_n_chunks (SortJob *job)
+{
+	guint n_chunks;
+
+	n_chunks = CLAMP (g_get_num_processors (), 1, MAX_CHUNKS);
+	n_chunks = MIN (n_chunks, job->n_lines / MIN_LINES_PER_CHUNK);
+
+	return MAX (n_chunks, 1);
+}
+
+static guint
+count_merge_passes (guint n_runs)
+{
+	guint passes = 0;
+
+	while (n_runs > 1)
+	{
+		n_runs = (n_runs + 1) / 2;
+		passes++;
+	}
+
+	return passes;
+}
+
+static gboolean
+parallel_sort (SortJob      *job,
+	       GCancellable *cancellable)
+{
+	SortChunk chunks[MAX_CHUNKS];
+	guint bounds[MAX_CHUNKS + 1];
+	guint n_runs;
+	SortLine *src;
+	SortLine *dst;
+	guint i;
+
+	n_runs = get_n_chunks (job);
+
+	g_atomic_int_set (&job->work_total,
+			  job->n_lines * (2 + count_merge_passes (n_runs)));
+
+	for (i = 0; i <= n_runs; i++)
+	{
+		bounds[i] = (guint64) job->n_lines * i / n_runs;
+	}
+
+	for (i = 0; i < n_runs; i++)
+	{
+		chunks[i].job = job;
+		chunks[i].cancellable = cancellable;
+		chunks[i].begin = bounds[i];
+		chunks[i].end = bounds[i + 1];
+		chunks[i].func = compute_keys_chunk;
+	}
+
+	run_chunks (chunks, n_runs);
+
+	if (g_cancellable_is_cancelled (cancellable))
+	{
+		return FALSE;
+	}
+
+	for (i = 0; i < n_runs; i++)
+	{
+		chunks[i].func = sort_chunk;
+	}
+
+	run_chunks (chunks, n_runs);
+
+	if (n_runs == 1)
+	{
+		return !g_cancellable_is_cancelled (cancellable);
+	}
+
+	src = job->lines;
+	dst = g_new (SortLine, job->n_lines);
+
+	while (n_runs > 1)
+	{
+		guint n_merges = (n_runs + 1) / 2;
+
+		for (i = 0; i < n_merges; i++)
+		{
+			chunks[i].begin = bounds[2 * i];
+			chunks[i].mid = bounds[MIN (2 * i + 1, n_runs)];
+			chunks[i].end = bounds[MIN (2 * i + 2, n_runs)];
+			chunks[i].src = src;
+			chunks[i].dst = dst;
+			chunks[i].func = merge_chunk;
+		}
+
+		run_chunks (chunks, n_merges);
+
+		/* A cancelled merge leaves @dst incomplete, keep @src */
+		if (g_cancellable_is_cancelled (cancellable))
+		{
+			break;
+		}
+
+		for (i = 0; i <= n_merges; i++)
+		{
+			bounds[i] = bounds[MIN (2 * i, n_runs)];
+		}
+
+		n_runs = n_merges;
+
+		job->lines = dst;
+		dst = src;
+		src = job->lines;
+	}
+
+	g_free (dst);
+
+	return !g_cancellable_is_cancelled (cancellable);
+}
+
+static void
+build_result (SortJob *job)
+{
+	GString *str;
+	const SortLine *prev = NULL;
+	guint i;
+
+	str = g_string_sized_new (job->text_len + 1);
+
+	for (i = 0; i < job->n_lines; i++)
+	{
+		const SortLine *line = &job->lines[i];
+
+		if (job->options.remove_duplicates &&
+		    prev != NULL &&
+		    compare_lines (prev, line, &job->options) == 0)
+		{
+			continue;
+		}
+
+		if (prev != NULL)
+		{
+			g_string_append_c (str, '\n');
+		}
+
+		g_string_append_len (str, line->line, line->len);
+		prev = line;
+	}
+
+	job->result = g_string_free (str, FALSE);
+}
+
+/**
+ * sort_job_new:
+ * @text: (transfer full): the text to sort, it is modified in place.
+ * @options: the #SortOptions.
+ *
+ * Returns: a new #SortJob, free it with sort_job_free().
+ */
+SortJob *
+sort_job_new (gchar             *text,
+	      const SortOptions *options)
+{
+	SortJob *job;
+
+	g_return_val_if_fail (text != NULL, NULL);
+	g_return_val_if_fail (options != NULL, NULL);
+
+	job = g_slice_new0 (SortJob);
+	job->options = *options;
+	job->text = text;
+	job->text_len = strlen (text);
+
+	return job;
+}
+
+void
+sort_job_free (SortJob *job)
+{
+	guint i;
+
+	if (job == NULL)
+	{
+		return;
+	}
+
+	for (i = 0; i < job->n_lines; i++)
+	{
+		g_free (job->lines[i].key);
+	}
+
+	g_free (job->lines);
+	g_free (job->text);
+	g_free (job->result);
+
+	g_slice_free (SortJob, job);
+}
+
+/**
+ * sort_job_run:
+ * @job: a #SortJob.
+ * @cancellable: (nullable): a #GCancellable.
+ *
+ * Sorts the lines of the text. This blocks, so it is meant to be called
+ * from a worker thread, while sort_job_get_progress() can be called from
+ * any thread.
+ *
+ * Returns: %FALSE if the job was cancelled.
+ */
+gboolean
+sort_job_run (SortJob      *job,
+	      GCancellable *cancellable)
+{
+	g_return_val_if_fail (job != NULL, FALSE);
+	g_return_val_if_fail (job->lines == NULL, FALSE);
+
+	split_lines (job);
+
+	if (!parallel_sort (job, cancellable))
+	{
+		return FALSE;
+	}
+
+	build_result (job);
+
+	return TRUE;
+}
+
+/**
+ * sort_job_get_progress:
+ * @job: a #SortJob.
+ *
+ * Returns: the fraction of the work done, between 0.0 and 1.0.
+ */
+gdouble
+sort_job_get_progress (SortJob *job)
+{
+	gint total;
+
+	total = g_atomic_int_get (&job->work_total);
+
+	if (total == 0)
+	{
+		return 0.0;
+	}
+
+	return CLAMP ((gdouble) g_atomic_int_get (&job->work_done) / total, 0.0, 1.0);
+}
+
+/**
+ * sort_job_steal_result:
+ * @job: a #SortJob.
+ *
+ * Returns: (transfer full): the sorted lines, joined by newlines.
+ */
+gchar *
+sort_job_steal_result (SortJob *job)
+{
+	gchar *result;
+
+	result = job->result;
+	job->result = NULL;
+
+	return result;
+}
+
+static gboolean
+spill_run (SortFileJob   *job,
+	   gchar         *text,
+	   GCancellable  *cancellable,
+	   GError       **error)
+{
+	SortJob *sort_job;
+	GFile *file;
+	GFileIOStream *iostream;
+	GOutputStream *out;
+	gchar *sorted;
+	gboolean ok;
+
+	sort_job = sort_job_new (text, &job->options);
+
+	if (!sort_job_run (sort_job, cancellable))
+	{
+		sort_job_free (sort_job);
+		g_cancellable_set_error_if_cancelled (cancellable, error);
+		return FALSE;
+	}
+
+	sorted = sort_job_steal_result (sort_job);
+	sort_job_free (sort_job);
+
+	file = g_file_new_tmp ("gedit-sort-XXXXXX", &iostream, error);
+
+	if (file == NULL)
+	{
+		g_free (sorted);
+		return FALSE;
+	}
+
+	g_ptr_array_add (job->runs, file);
+
+	out = g_io_stream_get_output_stream (G_IO_STREAM (iostream));
+
+	ok = g_output_stream_write_all (out, sorted, strlen (sorted), NULL, cancellable, error) &&
+	     g_output_stream_write_all (out, "\n", 1, NULL, cancellable, error) &&
+	     g_io_stream_close (G_IO_STREAM (iostream), cancellable, error);
+
+	g_object_unref (iostream);
+	g_free (sorted);
+
+	return ok;
+}
+
+static gboolean
+spill_runs (SortFileJob   *job,
+	    GCancellable  *cancellable,
+	    GError       **error)
+{
+	GFileInputStream *in;
+	gchar *buf;
+	gsize buf_size;
+	gsize filled = 0;
+	gboolean eof = FALSE;
+	gboolean ok = TRUE;
+
+	in = g_file_read (job->input, cancellable, error);
+
+	if (in == NULL)
+	{
+		return FALSE;
+	}
+
+	buf_size = SORT_FILE_CHUNK_SIZE;
+	buf = g_malloc (buf_size + 1);
+
+	while (ok && !eof)
+	{
+		gsize n_read;
+		gsize cut;
+		gchar *nl;
+		gchar *next;
+
+		ok = g_input_stream_read_all (G_INPUT_STREAM (in),
+					      buf + filled,
+					      buf_size - filled,
+					      &n_read,
+					      cancellable,
+					      error);
+
+		if (!ok)
+		{
+			break;
+		}
+
+		eof = n_read < buf_size - filled;
+		filled += n_read;
+
+		job->progress += n_read;
+
+		if (filled == 0)
+		{
+			break;
+		}
+
+		if (eof)
+		{
+			cut = filled;
+		}
+		else
+		{
+			nl = g_strrstr_len (buf, filled, "\n");
+
+			if (nl == NULL)
+			{
+				/* A single line longer than the chunk */
+				buf_size *= 2;
+				buf = g_realloc (buf, buf_size + 1);
+				continue;
+			}
+
+			cut = nl - buf + 1;
+		}
+
+		/* The remainder starts the next chunk */
+		next = g_malloc (buf_size + 1);
+		memcpy (next, buf + cut, filled - cut);
+		filled -= cut;
+
+		if (buf[cut - 1] == '\n')
+		{
+			cut--;
+		}
+
+		buf[cut] = '\0';
+
+		/* spill_run() takes ownership of the buffer */
+		ok = spill_run (job, buf, cancellable, error);
+		buf = next;
+	}
+
+	g_free (buf);
+	g_object_unref (in);
+
+	return ok;
+}
+
+static gboolean
+merge_run_next (MergeRun      *run,
+		SortFileJob   *job,
+		GCancellable  *cancellable,
+		GError       **error)
+{
+	GError *read_error = NULL;
+	gchar *line;
+	gsize len;
+
+	g_free ((gchar *) run->line.line);
+	g_free (run->line.key);
+	run->line.line = NULL;
+	run->line.key = NULL;
+
+	line = g_data_input_stream_read_line (run->stream, &len, cancellable, &read_error);
+
+	if (read_error != NULL)
+	{
+		g_propagate_error (error, read_error);
+		return FALSE;
+	}
+
+	if (line != NULL)
+	{
+		run->line.line = line;
+		run->line.len = len;
+		compute_key (&run->line, &job->options);
+	}
+
+	return TRUE;
+}
+
+static gint
+compare_runs (MergeRun          *a,
+	      MergeRun          *b,
+	      const SortOptions *options)
+{
+	gint ret;
+
+	ret = compare_lines (&a->line, &b->line, (gpointer) options);
+
+	/* Runs come from consecutive chunks, this keeps the sort stable */
+	return ret != 0 ? ret : (gint) a->index - (gint) b->index;
+}
+
+static void
+heap_sift_down (MergeRun          **heap,
+		guint               n,
+		guint               i,
+		const SortOptions  *options)
+{
+	while (TRUE)
+	{
+		guint smallest = i;
+		guint left = 2 * i + 1;
+		guint right = 2 * i + 2;
+		MergeRun *tmp;
+
+		if (left < n && compare_runs (heap[left], heap[smallest], options) < 0)
+			smallest = left;
+
+		if (right < n && compare_runs (heap[right], heap[smallest], options) < 0)
+			smallest = right;
+
+		if (smallest == i)
+			break;
+
+		tmp = heap[i];
+		heap[i] = heap[smallest];
+		heap[smallest] = tmp;
+
+		i = smallest;
+	}
+}
+
+static gboolean
+merge_runs (SortFileJob   *job,
+	    GCancellable  *cancellable,
+	    GError       **error)
+{
+	GFileOutputStream *file_out;
+	GOutputStream *out;
+	MergeRun *runs;
+	MergeRun **heap;
+	SortLine last = { NULL, 0, NULL, 0.0 };
+	guint n_runs;
+	guint n = 0;
+	guint i;
+	gboolean ok = TRUE;
+
+	file_out = g_file_replace (job->output,
+				   NULL,
+				   FALSE,
+				   G_FILE_CREATE_NONE,
+				   cancellable,
+				   error);
+
+	if (file_out == NULL)
+	{
+		return FALSE;
+	}
+
+	out = g_buffered_output_stream_new_sized (G_OUTPUT_STREAM (file_out),
+						  SORT_FILE_BUFFER_SIZE);
+	g_object_unref (file_out);
+
+	n_runs = job->runs->len;
+	runs = g_new0 (MergeRun, n_runs);
+	heap = g_new (MergeRun *, n_runs);
+
+	for (i = 0; i < n_runs && ok; i++)
+	{
+		GFileInputStream *in;
+
+		runs[i].index = i;
+
+		in = g_file_read (g_ptr_array_index (job->runs, i), cancellable, error);
+		if (in == NULL)
+		{
+			ok = FALSE;
+			break;
+		}
+
+		runs[i].stream = g_data_input_stream_new (G_INPUT_STREAM (in));
+		g_buffered_input_stream_set_buffer_size (G_BUFFERED_INPUT_STREAM (runs[i].stream),
+							 SORT_FILE_BUFFER_SIZE);
+		g_object_unref (in);
+
+		ok = merge_run_next (&runs[i], job, cancellable, error);
+
+		if (ok && runs[i].line.line != NULL)
+		{
+			heap[n++] = &runs[i];
+		}
+	}
+
+	for (i = n / 2; ok && i-- > 0;)
+	{
+		heap_sift_down (heap, n, i, &job->options);
+	}
+
+	while (ok && n > 0)
+	{
+		MergeRun *top = heap[0];
+
+		if (!job->options.remove_duplicates ||
+		    last.key == NULL ||
+		    compare_lines (&last, &top->line, &job->options) != 0)
+		{
+			ok = g_output_stream_write_all (out, top->line.line, top->line.len, NULL, cancellable, error) &&
+			     g_output_stream_write_all (out, "\n", 1, NULL, cancellable, error);
+
+			job->progress += top->line.len + 1;
+
+			/* Keep the line around to detect duplicates */
+			g_free ((gchar *) last.line);
+			g_free (last.key);
+			last = top->line;
+			top->line.line = NULL;
+			top->line.key = NULL;
+		}
+
+		ok = ok && merge_run_next (top, job, cancellable, error);
+
+		if (ok && top->line.line == NULL)
+		{
+			heap[0] = heap[--n];
+		}
+
+		heap_sift_down (heap, n, 0, &job->options);
+	}
+
+	g_free ((gchar *) last.line);
+	g_free (last.key);
+
+	for (i = 0; i < n_runs; i++)
+	{
+		g_free ((gchar *) runs[i].line.line);
+		g_free (runs[i].line.key);
+		g_clear_object (&runs[i].stream);
+	}
+
+	g_free (runs);
+	g_free (heap);
+
+	ok = g_output_stream_close (out, cancellable, ok ? error : NULL) && ok;
+	g_object_unref (out);
+
+	return ok;
+}
+
+static void
+delete_runs (SortFileJob *job)
+{
+	guint i;
+
+	for (i = 0; i < job->runs->len; i++)
+	{
+		g_file_delete (g_ptr_array_index (job->runs, i), NULL, NULL);
+	}
+
+	g_ptr_array_set_size (job->runs, 0);
+}
+
+/**
+ * sort_file_job_new:
+ * @input: the file to sort.
+ * @output: the file to write the sorted lines to.
+ * @options: the #SortOptions.
+ *
+ * Returns: a new #SortFileJob, free it with sort_file_job_free().
+ */
+SortFileJob *
+sort_file_job_new (GFile             *input,
+		   GFile             *output,
+		   const SortOptions *options)
+{
+	SortFileJob *job;
+
+	g_return_val_if_fail (G_IS_FILE (input), NULL);
+	g_return_val_if_fail (G_IS_FILE (output), NULL);
+	g_return_val_if_fail (options != NULL, NULL);
+
+	job = g_slice_new0 (SortFileJob);
+	job->options = *options;
+	job->input = g_object_ref (input);
+	job->output = g_object_ref (output);
+	job->runs = g_ptr_array_new_with_free_func (g_object_unref);
+
+	return job;
+}
+
+void
+sort_file_job_free (SortFileJob *job)
+{
+	if (job == NULL)
+	{
+		return;
+	}
+
+	delete_runs (job);
+
+	g_ptr_array_unref (job->runs);
+	g_object_unref (job->input);
+	g_object_unref (job->output);
+
+	g_slice_free (SortFileJob, job);
+}
+
+/**
+ * sort_file_job_run:
+ * @job: a #SortFileJob.
+ * @cancellable: (nullable): a #GCancellable.
+ * @error: return location for a #GError.
+ *
+ * Sorts the input file into the output file, using memory bounded by
+ * the chunk size and temporary files for the sorted runs. This blocks,
+ * so it is meant to be called from a worker thread.
+ *
+ * Returns: %TRUE on success.
+ */
+gboolean
+sort_file_job_run (SortFileJob   *job,
+		   GCancellable  *cancellable,
+		   GError       **error)
+{
+	GFileInfo *info;
+	gboolean ok;
+
+	g_return_val_if_fail (job != NULL, FALSE);
+
+	info = g_file_query_info (job->input,
+				  G_FILE_ATTRIBUTE_STANDARD_SIZE,
+				  G_FILE_QUERY_INFO_NONE,
+				  cancellable,
+				  error);
+
+	if (info == NULL)
+	{
+		return FALSE;
+	}
+
+	/* Every byte is read once and written once */
+	job->total = 2 * g_file_info_get_size (info);
+	g_object_unref (info);
+
+	ok = spill_runs (job, cancellable, error) &&
+	     merge_runs (job, cancellable, error);
+
+	/* The runs are not needed anymore */
+	delete_runs (job);
+
+	return ok;
+}
+
+/**
+ * sort_file_job_get_progress:
+ * @job: a #SortFileJob.
+ *
+ * Returns: the fraction of the work done, between 0.0 and 1.0.
+ */
+gdouble
+sort_file_job_get_progress (SortFileJob *job)
+{
+	if (job->total == 0)
+	{
+		return 0.0;
+	}
+
+	return CLAMP ((gdouble) job->progress / job->total, 0.0, 1.0);
+}
+
+/* ex:set ts=8 noet: */
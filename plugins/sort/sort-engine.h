@@ -0,0 +1,78 @@
+/*
+ * sort-engine.h
+ * This file is part of gedit
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SORT_ENGINE_H
+#define SORT_ENGINE_H
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+	SORT_MODE_ALPHABETICAL,
+	SORT_MODE_NUMERIC,
+	SORT_MODE_NATURAL,
+	SORT_MODE_VERSION
+} SortMode;
+
+typedef struct _SortOptions SortOptions;
+typedef struct _SortJob     SortJob;
+typedef struct _SortFileJob SortFileJob;
+
+struct _SortOptions
+{
+	SortMode mode;
+
+	/* 0-based, in characters */
+	gint starting_column;
+
+	guint case_sensitive : 1;
+	guint reverse : 1;
+	guint remove_duplicates : 1;
+};
+
+SortJob		*sort_job_new			(gchar             *text,
+						 const SortOptions *options);
+
+void		 sort_job_free			(SortJob           *job);
+
+gboolean	 sort_job_run			(SortJob           *job,
+						 GCancellable      *cancellable);
+
+gdouble		 sort_job_get_progress		(SortJob           *job);
+
+gchar		*sort_job_steal_result		(SortJob           *job);
+
+SortFileJob	*sort_file_job_new		(GFile             *input,
+						 GFile             *output,
+						 const SortOptions *options);
+
+void		 sort_file_job_free		(SortFileJob       *job);
+
+gboolean	 sort_file_job_run		(SortFileJob       *job,
+						 GCancellable      *cancellable,
+						 GError           **error);
+
+gdouble		 sort_file_job_get_progress	(SortFileJob       *job);
+
+G_END_DECLS
+
+#endif /* SORT_ENGINE_H */
+
+/* ex:set ts=8 noet: */
@@ -123,7 +123,7 @@ class ParamSpecBoxed(ParamSpecTyped):
         ParamSpecTyped.__init__(self, name, nick, desc, flags, **kwargs)
 
     def finalizer(self, container):
-        return 'if (%s->%s != NULL)\n{\n\tg_boxed_free (%s->%s);\n}' % (container, self.cname(), container, self.cname())
+        return 'if (%s->%s != NULL)\n{\n\tg_boxed_free (%s, %s->%s);\n}' % (container, self.cname(), self.args[0], container, self.cname())
 
     def get_value(self, val, container):
         return 'g_value_set_boxed (%s, %s->%s);' % (val, container, self.cname())